@@ -0,0 +1,140 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    calibrate.c
+
+Abstract:
+
+    Per-axis calibration: centre offset, inner and outer deadzones and a
+    response curve, applied to each report as input is merged into it.
+    Nothing here touches the framework or the device, so it can run
+    anywhere a report is built.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+// The scale axis values are worked on, as a 16.16 fixed point numerator
+#define AXIS_SCALE_ONE		((ULONG) JS_MAX_VALUE << 16)
+
+// 16.16 factor that takes 0..Range to 0..JS_MAX_VALUE, rounded up
+#define scaleTo(Range)		((AXIS_SCALE_ONE + (Range) - 1) / (Range))
+
+BOOLEAN
+dpBuildAxisTransform(
+    IN PAXIS_CALIBRATION Calibration,
+    OUT PAXIS_TRANSFORM  Transform
+    )
+/**
+ * Checks a calibration from userland and precomputes what applying it
+ * needs. Returns FALSE if the calibration doesn't make sense.
+ */
+{
+	ULONG i;
+	LONG x, cubic, curve = Calibration->curve;
+
+	RtlZeroMemory(Transform, sizeof(AXIS_TRANSFORM));
+	if (!(Calibration->flags & AXIS_CALIBRATION_ENABLED))
+		return TRUE;
+
+	if (Calibration->centre == 0 || Calibration->centre >= JS_MAX_VALUE ||
+		(ULONG) Calibration->innerDeadzone + Calibration->outerDeadzone >= JS_MAX_VALUE ||
+		Calibration->curve > JS_MAX_VALUE)
+		return FALSE;
+
+	Transform->Enabled = TRUE;
+	Transform->Centre = Calibration->centre;
+	// Rounded up, so the ends of the travel reach the ends of the scale
+	Transform->Scale[0] = scaleTo(Calibration->centre);
+	Transform->Scale[1] = scaleTo(JS_MAX_VALUE - Calibration->centre);
+	Transform->Inner = Calibration->innerDeadzone;
+	Transform->Outer = JS_MAX_VALUE - Calibration->outerDeadzone;
+	Transform->DeadzoneScale = scaleTo(Transform->Outer - Transform->Inner);
+
+	// x + curve * (x^3 - x), all on the 0 to JS_MAX_VALUE scale
+	for (i = 0; i < AXIS_CURVE_POINTS; i++) {
+		x = min(i << AXIS_CURVE_SHIFT, JS_MAX_VALUE);
+		cubic = x * x / JS_MAX_VALUE * x / JS_MAX_VALUE;
+		Transform->Curve[i] = (USHORT) (x + curve * (cubic - x) / JS_MAX_VALUE);
+	}
+	return TRUE;
+}
+
+static __forceinline LONG
+transformAxis(
+    IN PAXIS_TRANSFORM Transform,
+    IN LONG            Value
+    )
+{
+	LONG offset = Value - Transform->Centre;
+	ULONG above = offset >= 0;
+	ULONG travel, i, fraction;
+	LONG out;
+
+	// How far from centre, as a fraction of the travel on this side
+	travel = (ULONG) (above ? offset : -offset);
+	travel = (ULONG) min((ULONGLONG) travel * Transform->Scale[above] >> 16, JS_MAX_VALUE);
+
+	if (travel <= Transform->Inner)
+		return JS_RESTING_PLACE;
+	if (travel >= Transform->Outer) {
+		out = JS_MAX_VALUE;
+	} else {
+		travel = (ULONG) min((ULONGLONG) (travel - Transform->Inner) * Transform->DeadzoneScale >> 16, JS_MAX_VALUE);
+
+		i = travel >> AXIS_CURVE_SHIFT;
+		fraction = travel & ((1 << AXIS_CURVE_SHIFT) - 1);
+		out = Transform->Curve[i] +
+			(((LONG) Transform->Curve[i + 1] - Transform->Curve[i]) * (LONG) fraction >> AXIS_CURVE_SHIFT);
+	}
+
+	// Halve onto each side of JS_RESTING_PLACE, so both ends are reached exactly
+	return above ? JS_RESTING_PLACE + (out >> 1) : JS_RESTING_PLACE - ((out + 1) >> 1);
+}
+
+VOID
+dpTransformAxes(
+    IN PAXIS_TRANSFORM       Transforms,
+    IN OUT PHID_INPUT_REPORT Report
+    )
+/**
+ * Applies each axis's calibration to a report's axes.
+ */
+{
+	PLONG axes = &Report->inputs.axisX;	// The six axes are consecutive LONGs
+	ULONG i;
+
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		if (Transforms[i].Enabled)
+			axes[i] = transformAxis(&Transforms[i], axes[i]);
+	}
+}
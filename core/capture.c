@@ -0,0 +1,115 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    capture.c
+
+Abstract:
+
+    Capture of a pad's input and reports, so a session can be logged and
+    replayed later. Records are kept in a ring until the client reads them;
+    see CAPTURE_RECORD in defs.h for what they hold and how they're logged.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+VOID
+dpCaptureRecord(
+    IN OUT PCAPTURE_RING Ring,
+    IN USHORT            Type,
+    IN LONGLONG          Timestamp,
+    IN PINPUT_DATA       Data
+    )
+/**
+ * Appends a record, or counts it as dropped if the ring is full.
+ */
+{
+	PCAPTURE_RECORD record;
+
+	if (Ring->Count == CAPTURE_RING_SIZE) {
+		Ring->Dropped++;
+		return;
+	}
+
+	record = &Ring->Records[(Ring->Head + Ring->Count) % CAPTURE_RING_SIZE];
+	RtlZeroMemory(record, sizeof(CAPTURE_RECORD));
+	record->timestamp = Timestamp;
+	record->type = Type;
+	record->dropped = Ring->Dropped;
+	record->data = *Data;
+	Ring->Dropped = 0;
+	Ring->Count++;
+}
+
+VOID
+dpCaptureReport(
+    IN OUT PCAPTURE_RING Ring,
+    IN LONGLONG          Timestamp,
+    IN PHID_INPUT_REPORT Report
+    )
+/**
+ * Appends a report, in the INPUT_DATA form copyInputData would make it from.
+ */
+{
+	INPUT_DATA data;
+
+	data.axisX = Report->inputs.axisX;
+	data.axisY = Report->inputs.axisY;
+	data.axisZ = Report->inputs.axisZ;
+	data.axisRX = Report->inputs.axisRX;
+	data.axisRY = Report->inputs.axisRY;
+	data.axisRZ = Report->inputs.axisRZ;
+	data.buttons = (LONG) (Report->inputs.buttons | ((ULONG) Report->inputs.hats << 16));
+	dpCaptureRecord(Ring, CAPTURE_REPORT, Timestamp, &data);
+}
+
+ULONG
+dpCaptureDrain(
+    IN OUT PCAPTURE_RING Ring,
+    OUT PCAPTURE_RECORD  Records,
+    IN ULONG             MaxRecords
+    )
+/**
+ * Moves up to MaxRecords records out of the ring, oldest first.
+ * Returns how many were moved.
+ */
+{
+	ULONG count = min(Ring->Count, MaxRecords);
+	ULONG first = min(count, CAPTURE_RING_SIZE - Ring->Head);
+
+	// In at most two pieces, as the ring wraps
+	RtlCopyMemory(Records, &Ring->Records[Ring->Head], first * sizeof(CAPTURE_RECORD));
+	RtlCopyMemory(Records + first, Ring->Records, (count - first) * sizeof(CAPTURE_RECORD));
+	Ring->Head = (Ring->Head + count) % CAPTURE_RING_SIZE;
+	Ring->Count -= count;
+	return count;
+}
@@ -0,0 +1,208 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    filter.c
+
+Abstract:
+
+    Per-axis smoothing of raw input: a low-pass filter whose cutoff rises
+    with the axis's speed (the "1 euro" filter), in fixed point. Applied as
+    input is merged into a report, before calibration. Nothing here touches
+    the framework or the device.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+// Interrupt time runs in 100ns units
+#define TICKS_PER_SECOND	10000000
+
+// Time between samples is taken to be at least 1 ms, which keeps speeds
+// in range, and at most a second, after which the filter starts again.
+#define FILTER_MIN_ELAPSED	(TICKS_PER_SECOND / 1000)
+#define FILTER_MAX_ELAPSED	TICKS_PER_SECOND
+
+// Highest cutoff, in 1/100 Hz; well past the point of smoothing anything
+#define FILTER_MAX_CUTOFF	1000000
+
+// 2 pi in 16.16 fixed point, over 100 (cutoffs are in 1/100 Hz) and
+// TICKS_PER_SECOND
+#define TWO_PI_16_16		411775
+#define CUTOFF_TICK_SCALE	(100 * (ULONGLONG) TICKS_PER_SECOND)
+
+static ULONG
+smoothingFactor(
+    IN ULONG    Cutoff,
+    IN LONGLONG Elapsed
+    )
+/**
+ * The weight, in 16.16 fixed point, given to a new sample Elapsed ticks
+ * after the last one by a low-pass filter with the given cutoff:
+ * 1 / (1 + tau / Elapsed), where tau = 1 / (2 pi Cutoff).
+ */
+{
+	ULONGLONG w = (ULONGLONG) Cutoff * Elapsed * TWO_PI_16_16 / CUTOFF_TICK_SCALE;
+
+	return (ULONG) ((w << 16) / (w + 0x10000));
+}
+
+BOOLEAN
+dpCheckAxisFilter(
+    IN PAXIS_FILTER_CONFIG Config
+    )
+/**
+ * Returns FALSE if a filter configuration from userland doesn't make sense.
+ */
+{
+	return !(Config->flags & AXIS_FILTER_ENABLED) ||
+		(Config->minCutoff != 0 && Config->speedCutoff != 0);
+}
+
+VOID
+dpInitAxisFilter(
+    IN PAXIS_FILTER_CONFIG Config,
+    OUT PAXIS_FILTER       Filter
+    )
+/**
+ * Sets up a filter from a checked configuration, with no history.
+ */
+{
+	RtlZeroMemory(Filter, sizeof(AXIS_FILTER));
+	Filter->Enabled = (Config->flags & AXIS_FILTER_ENABLED) != 0;
+	Filter->MinCutoff = Config->minCutoff;
+	Filter->Beta = Config->beta;
+	Filter->SpeedCutoff = Config->speedCutoff;
+}
+
+static __forceinline LONG
+filterAxis(
+    IN OUT PAXIS_FILTER Filter,
+    IN LONG             Value,
+    IN LONGLONG         Timestamp
+    )
+{
+	LONGLONG elapsed = Timestamp - Filter->Timestamp;
+	LONG speed;
+	ULONG cutoff;
+
+	// Keeps the fixed point sums in range; nothing outside it can be reported
+	Value = min(max(Value, 0), JS_MAX_VALUE);
+
+	if (!Filter->Primed || elapsed > FILTER_MAX_ELAPSED) {
+		Filter->Primed = TRUE;
+		Filter->Value = Value << 8;
+		Filter->Speed = 0;
+		Filter->Timestamp = Timestamp;
+		return Value;
+	}
+	elapsed = max(elapsed, FILTER_MIN_ELAPSED);
+
+	// Speed towards the new sample, smoothed with its own fixed cutoff
+	speed = (LONG) (((LONGLONG) (Value << 8) - Filter->Value) * (TICKS_PER_SECOND >> 8) / elapsed);
+	Filter->Speed += (LONG) ((LONGLONG) (speed - Filter->Speed) *
+		smoothingFactor(Filter->SpeedCutoff, elapsed) >> 16);
+
+	// The faster the axis moves, the less it's smoothed
+	cutoff = (ULONG) min(Filter->MinCutoff +
+		(ULONGLONG) Filter->Beta * (ULONG) abs(Filter->Speed) / 1000, FILTER_MAX_CUTOFF);
+	Filter->Value += (LONG) ((LONGLONG) ((Value << 8) - Filter->Value) *
+		smoothingFactor(cutoff, elapsed) >> 16);
+	Filter->Timestamp = Timestamp;
+
+	return (Filter->Value + 0x80) >> 8;
+}
+
+VOID
+dpFilterAxes(
+    IN OUT PAXIS_FILTER      Filters,
+    IN OUT PHID_INPUT_REPORT Report,
+    IN LONGLONG              Timestamp
+    )
+/**
+ * Smooths a report's axes with each axis's filter, if it has one.
+ */
+{
+	PLONG axes = &Report->inputs.axisX;	// The six axes are consecutive LONGs
+	ULONG i;
+
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		if (Filters[i].Enabled)
+			axes[i] = filterAxis(&Filters[i], axes[i], Timestamp);
+	}
+}
+
+BOOLEAN
+dpAxisFiltersSettled(
+    IN PAXIS_FILTER      Filters,
+    IN PHID_INPUT_REPORT Raw
+    )
+/**
+ * Whether every filtered axis reads as the raw value it was last given, in
+ * Raw, so running the filters again on it could change nothing.
+ */
+{
+	const LONG *axes = &Raw->inputs.axisX;	// The six axes are consecutive LONGs
+	ULONG i;
+
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		if (Filters[i].Enabled && Filters[i].Primed &&
+			(Filters[i].Value + 0x80) >> 8 != min(max(axes[i], 0), JS_MAX_VALUE))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+BOOLEAN
+dpSettleAxisFilters(
+    IN OUT PAXIS_FILTER      Filters,
+    IN OUT PHID_INPUT_REPORT Report,
+    IN LONGLONG              Timestamp
+    )
+/**
+ * Runs the filters again on the raw axes they were last given, in Report,
+ * as if those had been sent again at Timestamp. Does nothing, and returns
+ * FALSE, if the filters already read as those axes, or if they last ran
+ * less than the shortest time between samples before, so reports made
+ * together don't each move them on.
+ */
+{
+	ULONG i;
+
+	if (dpAxisFiltersSettled(Filters, Report))
+		return FALSE;
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		if (Filters[i].Enabled && Filters[i].Primed && Timestamp - Filters[i].Timestamp < FILTER_MIN_ELAPSED)
+			return FALSE;
+	}
+	dpFilterAxes(Filters, Report, Timestamp);
+	return TRUE;
+}
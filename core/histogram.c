@@ -0,0 +1,119 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    histogram.c
+
+Abstract:
+
+    Histograms with power of 2 buckets, for the latencies and queue depths
+    IOCTL_DP_GET_PERF_STATS reports. Adding to one is an interlocked
+    increment, so it's cheap enough for every read.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+ULONG
+dpHistogramBucket(
+    IN ULONG Value
+    )
+/**
+ * Returns the bucket Value is counted in: the number of bits needed to
+ * hold it, up to the last bucket.
+ */
+{
+	ULONG bucket = 0;
+
+	// Halve the search each time, as a bit scan would
+	if (Value >= 1UL << 16) { Value >>= 16; bucket += 16; }
+	if (Value >= 1UL << 8) { Value >>= 8; bucket += 8; }
+	if (Value >= 1UL << 4) { Value >>= 4; bucket += 4; }
+	if (Value >= 1UL << 2) { Value >>= 2; bucket += 2; }
+	if (Value >= 1UL << 1) { Value >>= 1; bucket += 1; }
+	bucket += Value;
+
+	return min(bucket, DP_HISTOGRAM_BUCKETS - 1);
+}
+
+VOID
+dpHistogramAdd(
+    IN OUT PDP_HISTOGRAM Histogram,
+    IN ULONG             Value
+    )
+{
+	InterlockedIncrement(&Histogram->Buckets[dpHistogramBucket(Value)]);
+}
+
+VOID
+dpHistogramRead(
+    IN PDP_HISTOGRAM Histogram,
+    OUT PULONG       Buckets
+    )
+/**
+ * Copies out the counts. Each is read on its own, so with callers still
+ * adding the total may be off by a few.
+ */
+{
+	ULONG i;
+
+	for (i = 0; i < DP_HISTOGRAM_BUCKETS; i++)
+		Buckets[i] = (ULONG) Histogram->Buckets[i];
+}
+
+ULONG
+dpHistogramPercentile(
+    IN PULONG Buckets,
+    IN ULONG  Percent
+    )
+/**
+ * Returns the largest value in the bucket holding the given percentile of
+ * the counts dpHistogramRead copied out, or MAXULONG if it's the last
+ * bucket. An empty histogram gives 0.
+ */
+{
+	ULONGLONG total = 0, wanted, seen = 0;
+	ULONG i;
+
+	for (i = 0; i < DP_HISTOGRAM_BUCKETS; i++)
+		total += Buckets[i];
+	if (total == 0)
+		return 0;
+
+	// The count at or below the percentile, rounding up, but at least 1
+	wanted = max((total * min(Percent, 100) + 99) / 100, 1);
+	for (i = 0; i < DP_HISTOGRAM_BUCKETS - 1; i++) {
+		seen += Buckets[i];
+		if (seen >= wanted)
+			return i == 0 ? 0 : (ULONG) ((1ULL << i) - 1);
+	}
+	return MAXULONG;
+}
@@ -0,0 +1,156 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    interpolate.c
+
+Abstract:
+
+    Builds the axes of a report for a given time from the last few samples
+    of input, interpolating between them or carrying the last movement on
+    past the newest one, so sparse input (say 30 Hz over Wi-Fi) still moves
+    smoothly at the rate reports are read. Buttons are never touched.
+    Nothing here touches the framework or the device.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+#define HISTORY_INDEX(history, age)	(((history)->Latest + INPUT_HISTORY_SIZE - (age)) % INPUT_HISTORY_SIZE)
+
+VOID
+dpRecordSample(
+    IN OUT PINPUT_HISTORY History,
+    IN PHID_INPUT_REPORT  Report,
+    IN LONGLONG           Timestamp
+    )
+/**
+ * Adds a report's axes to the history, replacing the oldest sample if it's full.
+ */
+{
+	PINPUT_SAMPLE sample;
+
+	History->Latest = History->Count == 0 ? 0 : (History->Latest + 1) % INPUT_HISTORY_SIZE;
+	if (History->Count < INPUT_HISTORY_SIZE)
+		History->Count++;
+
+	sample = &History->Samples[History->Latest];
+	sample->Timestamp = Timestamp;
+	RtlCopyMemory(sample->Axes, &Report->inputs.axisX, sizeof(sample->Axes));
+}
+
+BOOLEAN
+dpInterpolationActive(
+    IN PINPUT_HISTORY History,
+    IN LONGLONG       RenderTime,
+    IN LONGLONG       ExtrapolateLimit
+    )
+/**
+ * Whether reports built for RenderTime onwards would still be moving, so
+ * are worth sending even though no new input has arrived.
+ */
+{
+	return History->Count != 0 &&
+		RenderTime < History->Samples[History->Latest].Timestamp + ExtrapolateLimit;
+}
+
+static VOID
+copySampleAxes(
+    IN PINPUT_SAMPLE         Sample,
+    OUT PHID_INPUT_REPORT    Report
+    )
+{
+	RtlCopyMemory(&Report->inputs.axisX, Sample->Axes, sizeof(Sample->Axes));
+}
+
+VOID
+dpInterpolateAxes(
+    IN PINPUT_HISTORY        History,
+    IN LONGLONG              RenderTime,
+    IN LONGLONG              ExtrapolateLimit,
+    IN OUT PHID_INPUT_REPORT Report
+    )
+/**
+ * Replaces a report's axes with their values at RenderTime: on the line
+ * between the samples either side of it, or if it's after the newest
+ * sample, on the line through the newest two, up to ExtrapolateLimit past
+ * the newest. Samples further apart than INTERPOLATE_MAX_GAP aren't joined up.
+ */
+{
+	PLONG axes = &Report->inputs.axisX;	// The six axes are consecutive LONGs
+	PINPUT_SAMPLE newer, older;
+	LONGLONG span, offset, fraction;
+	ULONG i, age;
+
+	if (History->Count == 0)
+		return;
+
+	newer = &History->Samples[History->Latest];
+	if (RenderTime >= newer->Timestamp) {
+		if (History->Count < 2 || ExtrapolateLimit == 0) {
+			copySampleAxes(newer, Report);
+			return;
+		}
+		older = &History->Samples[HISTORY_INDEX(History, 1)];
+		span = newer->Timestamp - older->Timestamp;
+		if (span <= 0 || span > INTERPOLATE_MAX_GAP) {
+			copySampleAxes(newer, Report);
+			return;
+		}
+		offset = min(RenderTime, newer->Timestamp + ExtrapolateLimit) - older->Timestamp;
+	} else {
+		// Walk back to the newest sample at or before RenderTime
+		for (age = 1; age < History->Count; age++) {
+			older = &History->Samples[HISTORY_INDEX(History, age)];
+			if (older->Timestamp <= RenderTime)
+				break;
+			newer = older;
+		}
+		if (age == History->Count) {
+			// Before everything kept
+			copySampleAxes(newer, Report);
+			return;
+		}
+		span = newer->Timestamp - older->Timestamp;
+		if (span <= 0 || span > INTERPOLATE_MAX_GAP) {
+			copySampleAxes(older, Report);
+			return;
+		}
+		offset = RenderTime - older->Timestamp;
+	}
+
+	// 16.16 fraction of the way from older to newer; above 1 when extrapolating
+	fraction = (offset << 16) / span;
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		axes[i] = (LONG) min(max(older->Axes[i] +
+			((LONGLONG) (newer->Axes[i] - older->Axes[i]) * fraction >> 16), 0), JS_MAX_VALUE);
+	}
+}
@@ -0,0 +1,141 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    jitter.c
+
+Abstract:
+
+    Jitter buffer for input sent with the sender's timestamps. Network
+    input arrives unevenly spaced; holding each frame for a playout delay
+    picked from how much the spacing varies lets frames be applied as
+    evenly as they were sampled, for a few milliseconds of latency.
+    Nothing here touches the framework or the device.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+// A gap in the sender's timestamps longer than this (or going backwards by
+// as much) starts the estimates again: the sender has paused or restarted.
+#define JITTER_RESET_GAP	10000000
+
+// Playout delay, in mean deviations of the transit time. About 2.5 standard
+// deviations, so few frames arrive after their playout time.
+#define JITTER_DELAY_FACTOR	3
+
+#define JITTER_INDEX(buffer, i)	(((buffer)->Head + (i)) % JITTER_BUFFER_SIZE)
+
+BOOLEAN
+dpJitterPush(
+    IN OUT PJITTER_BUFFER Buffer,
+    IN PINPUT_DATA        Data,
+    IN LONGLONG           Timestamp,
+    IN LONGLONG           Arrival
+    )
+/**
+ * Updates the delay estimates with a frame that arrived at Arrival, and
+ * queues it to be played out. The buffer mustn't be full.
+ * Returns FALSE, dropping the frame, if it's no newer than one already taken.
+ */
+{
+	LONGLONG transit = Arrival - Timestamp;
+	LONGLONG deviation, playout;
+	PJITTER_FRAME frame;
+
+	ASSERT(Buffer->Count < JITTER_BUFFER_SIZE);
+
+	if (!Buffer->Primed || Timestamp - Buffer->LastTimestamp > JITTER_RESET_GAP ||
+		Buffer->LastTimestamp - Timestamp > JITTER_RESET_GAP) {
+		Buffer->Primed = TRUE;
+		Buffer->BaseTransit = transit;
+		Buffer->LastTransit = transit;
+		Buffer->Jitter16 = 0;
+		Buffer->Delay = 0;
+	} else {
+		if (Timestamp <= Buffer->LastTimestamp)
+			return FALSE;
+
+		// Running mean of how much the transit time changes, as in RFC 3550
+		deviation = transit - Buffer->LastTransit;
+		Buffer->Jitter16 += (deviation < 0 ? -deviation : deviation) - ((Buffer->Jitter16 + 8) >> 4);
+		Buffer->LastTransit = transit;
+
+		// Follow the smallest transit time down at once, and back up slowly
+		// so the two clocks drifting apart doesn't leave it behind
+		if (transit < Buffer->BaseTransit)
+			Buffer->BaseTransit = transit;
+		else
+			Buffer->BaseTransit += (transit - Buffer->BaseTransit) >> 8;
+
+		Buffer->Delay = min(JITTER_DELAY_FACTOR * (Buffer->Jitter16 >> 4), Buffer->MaxDelay);
+	}
+	Buffer->LastTimestamp = Timestamp;
+
+	// Never ahead of a frame already queued; a frame that's late anyway is
+	// played out as soon as it's looked at
+	playout = max(Timestamp + Buffer->BaseTransit + Buffer->Delay, Buffer->LastPlayoutTime);
+	Buffer->LastPlayoutTime = playout;
+
+	frame = &Buffer->Frames[JITTER_INDEX(Buffer, Buffer->Count)];
+	frame->PlayoutTime = playout;
+	frame->Data = *Data;
+	Buffer->Count++;
+	return TRUE;
+}
+
+PJITTER_FRAME
+dpJitterPeek(
+    IN PJITTER_BUFFER Buffer,
+    IN LONGLONG       Now
+    )
+/**
+ * Returns the oldest frame if it's due to be played out by Now, or NULL.
+ */
+{
+	if (Buffer->Count == 0 || Buffer->Frames[Buffer->Head].PlayoutTime > Now)
+		return NULL;
+	return &Buffer->Frames[Buffer->Head];
+}
+
+VOID
+dpJitterDrop(
+    IN OUT PJITTER_BUFFER Buffer
+    )
+/**
+ * Removes the oldest frame.
+ */
+{
+	ASSERT(Buffer->Count > 0);
+
+	Buffer->Head = JITTER_INDEX(Buffer, 1);
+	Buffer->Count--;
+}
@@ -0,0 +1,339 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    layout.c
+
+Abstract:
+
+    Code for building a device's HID report descriptor and the matching
+    report layout, and for packing reports into that layout.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#define USE_HARDCODED_HID_REPORT_DESCRIPTOR
+
+#include <dpcore.h>
+
+#ifdef ALLOC_PRAGMA
+    #pragma alloc_text( PAGE, dpLegacyReportLayout)
+    #pragma alloc_text( PAGE, dpBuildReportLayout)
+    #pragma alloc_text( PAGE, dpCompactReportLayout)
+#endif
+
+static VOID
+fillHidDescriptor(
+    IN OUT PREPORT_LAYOUT Layout
+    )
+{
+    // Same as G_DefaultHidDescriptor apart from the report descriptor's length
+    Layout->HidDescriptor = G_DefaultHidDescriptor;
+    Layout->HidDescriptor.DescriptorList[0].wReportLength = (USHORT) Layout->ReportDescriptorLength;
+}
+
+VOID
+dpLegacyReportLayout(
+    OUT PREPORT_LAYOUT Layout
+    )
+/**
+ * Fills in the original 6-axis 12-button layout, sent as a whole
+ * HID_INPUT_REPORT.
+ */
+{
+    PAGED_CODE();
+
+    RtlZeroMemory(Layout, sizeof(REPORT_LAYOUT));
+    Layout->Type = ReportLayoutLegacy;
+    Layout->Spec.Axes = 6;
+    Layout->Spec.AxisBits = 32;
+    Layout->Spec.Buttons = 12;
+    Layout->Spec.Hats = 0;
+    Layout->ButtonBitOffset = 8 * FIELD_OFFSET(HID_INPUT_REPORT, inputs.buttons);
+    Layout->HatBitOffset = Layout->ButtonBitOffset + 16;
+    Layout->ReportLength = sizeof(HID_INPUT_REPORT);
+
+    RtlCopyMemory(Layout->ReportDescriptor, G_DefaultReportDescriptor, sizeof(G_DefaultReportDescriptor));
+    Layout->ReportDescriptorLength = sizeof(G_DefaultReportDescriptor);
+    Layout->HidDescriptor = G_DefaultHidDescriptor;
+}
+
+//
+// Writes one short item (a prefix byte and up to 4 bytes of data, little
+// endian) to the descriptor being built.
+//
+static VOID
+putItem(
+    IN OUT PREPORT_LAYOUT Layout,
+    IN UCHAR              Prefix,
+    IN ULONG              Size,
+    IN ULONG              Data
+    )
+{
+    PHID_REPORT_DESCRIPTOR p = &Layout->ReportDescriptor[Layout->ReportDescriptorLength];
+    ULONG i;
+
+    ASSERT(Layout->ReportDescriptorLength + 1 + Size <= MAX_REPORT_DESCRIPTOR_LENGTH);
+
+    // The low two bits of the prefix give the data size: 0, 1, 2 or 4 bytes
+    *p++ = (UCHAR) (Prefix | (Size == 4 ? 3 : Size));
+    for (i = 0; i < Size; i++) {
+        *p++ = (UCHAR) (Data >> (8 * i));
+    }
+    Layout->ReportDescriptorLength += 1 + Size;
+}
+
+#define USAGE_PAGE(l, v)		putItem(l, 0x04, 1, v)
+#define LOGICAL_MINIMUM(l, v)	putItem(l, 0x14, 1, v)
+#define LOGICAL_MAXIMUM(l, v)	putItem(l, 0x24, (v) < 0x80 ? 1 : 2, v)
+#define PHYSICAL_MINIMUM(l, v)	putItem(l, 0x34, 1, v)
+#define PHYSICAL_MAXIMUM(l, v)	putItem(l, 0x44, (v) < 0x80 ? 1 : 2, v)
+#define UNIT(l, v)				putItem(l, 0x64, 1, v)
+#define REPORT_SIZE(l, v)		putItem(l, 0x74, 1, v)
+#define REPORT_COUNT(l, v)		putItem(l, 0x94, 1, v)
+#define USAGE(l, v)				putItem(l, 0x08, 1, v)
+#define USAGE_MINIMUM(l, v)		putItem(l, 0x18, 1, v)
+#define USAGE_MAXIMUM(l, v)		putItem(l, 0x28, 1, v)
+#define INPUT(l, v)				putItem(l, 0x80, 1, v)
+#define COLLECTION(l, v)		putItem(l, 0xa0, 1, v)
+#define END_COLLECTION(l)		putItem(l, 0xc0, 0, 0)
+
+#define INPUT_DATA_VAR_ABS		0x02
+#define INPUT_DATA_VAR_ABS_NULL	0x42
+#define INPUT_CNST				0x01
+
+#if DBG
+static ULONG
+countInputBits(
+    IN PREPORT_LAYOUT Layout
+    )
+/**
+ * Walks a generated descriptor and adds up the bits of every INPUT item,
+ * to check it against the layout it was built with.
+ */
+{
+    ULONG i = 0, size = 0, count = 0, bits = 0, data, n, j;
+    UCHAR prefix;
+
+    while (i < Layout->ReportDescriptorLength) {
+        prefix = Layout->ReportDescriptor[i++];
+        n = (prefix & 3) == 3 ? 4 : (prefix & 3);
+        for (data = 0, j = 0; j < n; j++) {
+            data |= (ULONG) Layout->ReportDescriptor[i++] << (8 * j);
+        }
+        switch (prefix & 0xfc) {
+        case 0x74: size = data; break;
+        case 0x94: count = data; break;
+        case 0x80: bits += size * count; break;
+        }
+    }
+    return bits;
+}
+#endif
+
+NTSTATUS
+dpBuildReportLayout(
+    IN PREPORT_SPEC    Spec,
+    OUT PREPORT_LAYOUT Layout
+    )
+/**
+ * Generates a report descriptor for the given number of axes, buttons and
+ * hat switches, and the layout of the reports it describes. Axes come first,
+ * then buttons, then hats (4 bits each), padded to a whole byte.
+ */
+{
+    ULONG i, bits, logicalMaximum;
+
+    PAGED_CODE();
+
+    if (Spec->Axes > MAX_REPORT_AXES || Spec->Buttons > MAX_REPORT_BUTTONS || Spec->Hats > MAX_REPORT_HATS ||
+        (Spec->AxisBits != 8 && Spec->AxisBits != 16 && Spec->AxisBits != 32) ||
+        Spec->Axes + Spec->Buttons + Spec->Hats == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    RtlZeroMemory(Layout, sizeof(REPORT_LAYOUT));
+    Layout->Type = ReportLayoutCustom;
+    Layout->Spec = *Spec;
+
+    // 8 bit axes are scaled down; wider ones carry DroidPad's values as they are
+    logicalMaximum = Spec->AxisBits == 8 ? 255 : JS_MAX_VALUE;
+
+    USAGE_PAGE(Layout, 0x01);           // Generic Desktop
+    USAGE(Layout, 0x04);                // Joystick
+    COLLECTION(Layout, 0x01);           // Application
+
+    if (Spec->Axes > 0) {
+        USAGE(Layout, 0x01);            //   Pointer
+        COLLECTION(Layout, 0x00);       //   Physical
+        LOGICAL_MINIMUM(Layout, 0);
+        LOGICAL_MAXIMUM(Layout, logicalMaximum);
+        REPORT_SIZE(Layout, Spec->AxisBits);
+        REPORT_COUNT(Layout, Spec->Axes);
+        for (i = 0; i < Spec->Axes; i++) {
+            USAGE(Layout, 0x30 + i);    //     X, Y, Z, Rx, Ry, Rz
+        }
+        INPUT(Layout, INPUT_DATA_VAR_ABS);
+        END_COLLECTION(Layout);
+    }
+
+    if (Spec->Buttons > 0) {
+        USAGE_PAGE(Layout, 0x09);       //   Button
+        LOGICAL_MINIMUM(Layout, 0);
+        LOGICAL_MAXIMUM(Layout, 1);
+        REPORT_SIZE(Layout, 1);
+        REPORT_COUNT(Layout, Spec->Buttons);
+        USAGE_MINIMUM(Layout, 1);
+        USAGE_MAXIMUM(Layout, Spec->Buttons);
+        INPUT(Layout, INPUT_DATA_VAR_ABS);
+    }
+
+    if (Spec->Hats > 0) {
+        USAGE_PAGE(Layout, 0x01);       //   Generic Desktop
+        LOGICAL_MINIMUM(Layout, 1);     //   1 = N, clockwise to 8 = NW; 0 is out of range, so centred
+        LOGICAL_MAXIMUM(Layout, 8);
+        PHYSICAL_MINIMUM(Layout, 0);
+        PHYSICAL_MAXIMUM(Layout, 315);
+        UNIT(Layout, 0x14);             //   Degrees
+        REPORT_SIZE(Layout, 4);
+        REPORT_COUNT(Layout, 1);
+        for (i = 0; i < Spec->Hats; i++) {
+            USAGE(Layout, 0x39);        //   Hat switch
+            INPUT(Layout, INPUT_DATA_VAR_ABS_NULL);
+        }
+        UNIT(Layout, 0x00);
+    }
+
+    Layout->ButtonBitOffset = Spec->Axes * Spec->AxisBits;
+    Layout->HatBitOffset = Layout->ButtonBitOffset + Spec->Buttons;
+    bits = Layout->HatBitOffset + 4 * Spec->Hats;
+
+    if (bits % 8 != 0) {
+        REPORT_SIZE(Layout, 8 - bits % 8);
+        REPORT_COUNT(Layout, 1);
+        INPUT(Layout, INPUT_CNST);
+        bits += 8 - bits % 8;
+    }
+
+    END_COLLECTION(Layout);
+
+    Layout->ReportLength = bits / 8;
+    fillHidDescriptor(Layout);
+
+    ASSERT(countInputBits(Layout) == bits);
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+dpCompactReportLayout(
+    OUT PREPORT_LAYOUT Layout
+    )
+/**
+ * Fills in the compact layout: a generated descriptor for 6 16-bit axes
+ * and 16 buttons, whose reports are exactly a COMPACT_HID_INPUT_REPORT and
+ * are packed with a plain copy rather than bit by bit.
+ */
+{
+    REPORT_SPEC spec = { 6, 16, 16, 0 };
+    NTSTATUS status;
+
+    PAGED_CODE();
+
+    status = dpBuildReportLayout(&spec, Layout);
+    ASSERT(NT_SUCCESS(status) && Layout->ReportLength == sizeof(COMPACT_HID_INPUT_REPORT));
+    UNREFERENCED_PARAMETER(status);
+    Layout->Type = ReportLayoutCompact;
+}
+
+//
+// ORs Bits bits of Value into a zeroed buffer, starting at BitOffset,
+// least significant bit first as HID reports are laid out.
+//
+static VOID
+putBits(
+    IN OUT PUCHAR Buffer,
+    IN ULONG      BitOffset,
+    IN ULONG      Bits,
+    IN ULONG      Value
+    )
+{
+    ULONG shift, n;
+
+    while (Bits > 0) {
+        shift = BitOffset % 8;
+        n = min(8 - shift, Bits);
+        Buffer[BitOffset / 8] |= (UCHAR) ((Value & ((1 << n) - 1)) << shift);
+        Value >>= n;
+        BitOffset += n;
+        Bits -= n;
+    }
+}
+
+VOID
+dpPackReport(
+    IN PREPORT_LAYOUT    Layout,
+    IN PHID_INPUT_REPORT Report,
+    OUT PUCHAR           Buffer
+    )
+/**
+ * Writes a report into an IOCTL_HID_READ_REPORT buffer of at least
+ * Layout->ReportLength bytes, in the device's layout.
+ */
+{
+    PLONG axes = &Report->inputs.axisX;	// The six axes are consecutive LONGs
+    ULONG i, value;
+
+    switch (Layout->Type) {
+    case ReportLayoutLegacy:
+        copyHidReport(Report, (PHID_INPUT_REPORT) Buffer);
+        return;
+    case ReportLayoutCompact:
+        copyCompactReport(Report, (PCOMPACT_HID_INPUT_REPORT) Buffer);
+        return;
+    default:
+        break;
+    }
+
+    RtlZeroMemory(Buffer, Layout->ReportLength);
+
+    for (i = 0; i < Layout->Spec.Axes; i++) {
+        value = (ULONG) min(max(axes[i], 0), JS_MAX_VALUE);
+        if (Layout->Spec.AxisBits == 8)
+            value >>= 7;
+        putBits(Buffer, i * Layout->Spec.AxisBits, Layout->Spec.AxisBits, value);
+    }
+
+    putBits(Buffer, Layout->ButtonBitOffset, Layout->Spec.Buttons, Report->inputs.buttons);
+
+    for (i = 0; i < Layout->Spec.Hats; i++) {
+        putBits(Buffer, Layout->HatBitOffset + 4 * i, 4, Report->inputs.hats >> (4 * i));
+    }
+}
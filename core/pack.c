@@ -0,0 +1,170 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    pack.c
+
+Abstract:
+
+    Code for moving input between the forms it takes: INPUT_DATA as sent
+    from userland (whole or as a partial update), HID_INPUT_REPORT as
+    merged and kept by the driver, and the compact report sent to HIDCLASS.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+VOID
+copyInputData(
+    IN PINPUT_DATA from,
+    OUT PHID_INPUT_REPORT to
+     )
+/**
+ * Copies input data from the given input data into the HID input report.
+ * Currently these data structures are the same, but they may change in the future.
+ */
+{
+	if(!from || !to)
+		return;
+	to->inputs.axisX = from->axisX;
+	to->inputs.axisY = from->axisY;
+	to->inputs.axisZ = from->axisZ;
+	to->inputs.axisRX = from->axisRX;
+	to->inputs.axisRY = from->axisRY;
+	to->inputs.axisRZ = from->axisRZ;
+	to->inputs.buttons = from->buttons & 0xFFFF; // First 16 buttons only
+	to->inputs.hats = (USHORT) ((ULONG) from->buttons >> 16);
+	return;
+}
+
+NTSTATUS
+dpDecodeInputUpdate(
+    IN PINPUT_UPDATE   Update,
+    IN size_t          Size,
+    IN OUT PINPUT_DATA Data
+    )
+/**
+ * Applies a partial update (IOCTL_DP_SEND_INPUT_UPDATE) to a frame of input.
+ * The update is checked in full first, so a bad one leaves Data alone.
+ */
+{
+	PLONG axes = &Data->axisX;	// The six axes are consecutive LONGs
+	const LONG *value = Update->values;
+	ULONG mask, bits, count = 0;
+	int i;
+
+	if (Size < INPUT_UPDATE_SIZE(0))
+		return STATUS_INVALID_PARAMETER;
+	mask = Update->mask;
+	if (mask == 0 || (mask & ~INPUT_UPDATE_ALL) != 0)
+		return STATUS_INVALID_PARAMETER;
+	for (bits = mask; bits != 0; bits &= bits - 1)
+		count++;
+	if (Size < INPUT_UPDATE_SIZE(count))
+		return STATUS_INVALID_PARAMETER;
+
+	for (i = 0; i < 6; i++) {
+		if (mask & (INPUT_UPDATE_AXIS_X << i))
+			axes[i] = *value++;
+	}
+	if (mask & INPUT_UPDATE_BUTTONS)
+		Data->buttons = *value++;
+	if (mask & INPUT_UPDATE_BUTTONS_SET)
+		Data->buttons |= *value++;
+	if (mask & INPUT_UPDATE_BUTTONS_CLEAR)
+		Data->buttons &= ~*value++;
+	return STATUS_SUCCESS;
+}
+
+VOID
+resetHidReport(
+				OUT PHID_INPUT_REPORT report
+			  )
+{
+	report->inputs.axisX = JS_RESTING_PLACE;
+	report->inputs.axisY = JS_RESTING_PLACE;
+	report->inputs.axisZ = JS_RESTING_PLACE;
+	report->inputs.axisRX = JS_RESTING_PLACE;
+	report->inputs.axisRY = JS_RESTING_PLACE;
+	report->inputs.axisRZ = JS_RESTING_PLACE;
+	report->inputs.buttons = 0x0;
+	report->inputs.hats = 0x0;
+}
+
+VOID
+resetInputData(
+				OUT PINPUT_DATA data
+			  )
+{
+	data->axisX = JS_RESTING_PLACE;
+	data->axisY = JS_RESTING_PLACE;
+	data->axisZ = JS_RESTING_PLACE;
+	data->axisRX = JS_RESTING_PLACE;
+	data->axisRY = JS_RESTING_PLACE;
+	data->axisRZ = JS_RESTING_PLACE;
+	data->buttons = 0x0;
+}
+
+/**
+ * Copies the value of an hid report.
+ */
+VOID copyHidReport(
+				IN PHID_INPUT_REPORT from,
+				OUT PHID_INPUT_REPORT to)
+{
+		if(from == NULL || to == NULL)
+				return;
+		to->inputs.axisX = from->inputs.axisX;
+		to->inputs.axisY = from->inputs.axisY;
+		to->inputs.axisZ = from->inputs.axisZ;
+		to->inputs.axisRX = from->inputs.axisRX;
+		to->inputs.axisRY = from->inputs.axisRY;
+		to->inputs.axisRZ = from->inputs.axisRZ;
+		to->inputs.buttons = from->inputs.buttons;
+		return;
+}
+
+/**
+ * Copies an hid report into the compact layout. Axes are clamped to the
+ * compact descriptor's logical range rather than truncated.
+ */
+VOID copyCompactReport(
+				IN PHID_INPUT_REPORT from,
+				OUT PCOMPACT_HID_INPUT_REPORT to)
+{
+		to->axisX = (USHORT) min(max(from->inputs.axisX, 0), JS_MAX_VALUE);
+		to->axisY = (USHORT) min(max(from->inputs.axisY, 0), JS_MAX_VALUE);
+		to->axisZ = (USHORT) min(max(from->inputs.axisZ, 0), JS_MAX_VALUE);
+		to->axisRX = (USHORT) min(max(from->inputs.axisRX, 0), JS_MAX_VALUE);
+		to->axisRY = (USHORT) min(max(from->inputs.axisRY, 0), JS_MAX_VALUE);
+		to->axisRZ = (USHORT) min(max(from->inputs.axisRZ, 0), JS_MAX_VALUE);
+		to->buttons = from->inputs.buttons;
+}
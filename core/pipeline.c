@@ -0,0 +1,391 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    pipeline.c
+
+Abstract:
+
+    The path input takes into a report: merging each frame into the
+    current state, smoothing, calibrating and remapping it, queueing the
+    result for the report path and publishing it, and then building each
+    report sent from the queue or the current state. Also holds timed input
+    until it's due. None of it locks; the driver holds RingLock around every
+    call, and anything else driving it has to do the same.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+#define RING_INDEX(ring, i)	(((ring)->Head + (i)) % REPORT_RING_SIZE)
+
+// Whether two reports have the same buttons and hat switches
+#define SAME_BUTTONS(a, b)	((a)->inputs.buttons == (b)->inputs.buttons && (a)->inputs.hats == (b)->inputs.hats)
+
+static BOOLEAN
+ringPush(
+    IN OUT PREPORT_RING Ring,
+    IN PHID_INPUT_REPORT Report,
+    IN LONGLONG          Timestamp
+    )
+/**
+ * Appends a report to the ring. If the ring is full, an axis-only change is
+ * merged into the newest entry, otherwise the oldest entry whose buttons
+ * match the entry after it is dropped (only its axis values are lost).
+ * Returns FALSE if every entry carries a button change, so nothing can go.
+ */
+{
+	PREPORT_RING_ENTRY entry;
+	ULONG i;
+
+	if (Ring->Count == REPORT_RING_SIZE) {
+		entry = &Ring->Entries[RING_INDEX(Ring, Ring->Count - 1)];
+		if (SAME_BUTTONS(&entry->Report, Report)) {
+			// Keep the older timestamp; it's when this entry started waiting
+			RtlCopyMemory(&entry->Report, Report, sizeof(HID_INPUT_REPORT));
+			return TRUE;
+		}
+
+		for (i = 0; i + 1 < Ring->Count; i++) {
+			if (SAME_BUTTONS(&Ring->Entries[RING_INDEX(Ring, i)].Report,
+				&Ring->Entries[RING_INDEX(Ring, i + 1)].Report))
+				break;
+		}
+		if (i + 1 == Ring->Count)
+			return FALSE;
+
+		// Close the gap at i by moving everything older up one place
+		for (; i > 0; i--) {
+			Ring->Entries[RING_INDEX(Ring, i)] = Ring->Entries[RING_INDEX(Ring, i - 1)];
+		}
+		Ring->Head = RING_INDEX(Ring, 1);
+		Ring->Count--;
+	}
+
+	entry = &Ring->Entries[RING_INDEX(Ring, Ring->Count)];
+	entry->Timestamp = Timestamp;
+	RtlCopyMemory(&entry->Report, Report, sizeof(HID_INPUT_REPORT));
+	Ring->Count++;
+	return TRUE;
+}
+
+VOID
+dpInitPipeline(
+    OUT PREPORT_PIPELINE Pipeline
+    )
+/**
+ * Puts the joystick at rest and publishes that. Settings already in the
+ * pipeline (InterpolateDelay, Jitter.MaxDelay and so on) are left alone.
+ */
+{
+	resetHidReport(&Pipeline->inputs);
+	resetInputData(&Pipeline->lastInput);
+	Pipeline->Buttons.NextEdge = NO_BUTTON_EDGE;
+	dpPublishReport(&Pipeline->State, &Pipeline->inputs);
+}
+
+BOOLEAN
+dpApplyPadSettings(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN PPAD_SETTINGS        Settings,
+    IN LONGLONG             Now
+    )
+/**
+ * Sets the pipeline up as IOCTL_DP_GET_PAD_SETTINGS says a pad is, for
+ * replaying its input. Returns FALSE, leaving the pipeline as it was, if any
+ * part doesn't make sense.
+ */
+{
+	AXIS_TRANSFORM transforms[AXIS_TRANSFORM_COUNT];
+	REMAP remap;
+	ULONG i;
+
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		if (!dpBuildAxisTransform(&Settings->calibration.axes[i], &transforms[i]) ||
+			!dpCheckAxisFilter(&Settings->filter.axes[i]))
+			return FALSE;
+	}
+	if (!dpBuildRemap(&Settings->remap, &remap))
+		return FALSE;
+
+	RtlCopyMemory(Pipeline->Transforms, transforms, sizeof(transforms));
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++)
+		dpInitAxisFilter(&Settings->filter.axes[i], &Pipeline->Filters[i]);
+	Pipeline->Remap = remap;
+	dpButtonEngineSetTurbo(&Pipeline->Buttons, &Settings->turbo, Pipeline->inputs.inputs.buttons, Now);
+	Pipeline->InterpolateDelay = (LONGLONG) Settings->interpolateDelayMillis * 10000;
+	Pipeline->ExtrapolateLimit = (LONGLONG) Settings->extrapolateMillis * 10000;
+	return TRUE;
+}
+
+NTSTATUS
+dpPipelineSubmit(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN PINPUT_DATA          Data,
+    IN LONGLONG             Timestamp
+    )
+/**
+ * Merges input into the state, queues the resulting report and publishes
+ * it. Returns STATUS_DEVICE_BUSY, leaving the whole pipeline as it was
+ * (filters and turbo buttons included), if the ring is full of button
+ * changes that haven't been read yet.
+ */
+{
+	HID_INPUT_REPORT report = Pipeline->inputs;
+	AXIS_FILTER filters[AXIS_TRANSFORM_COUNT];
+	PAXIS_FILTER filtered = Pipeline->Filters;
+
+	// Only a full ring can turn the frame away, so only then filter a copy
+	// until the frame is in
+	if (Pipeline->Ring.Count == REPORT_RING_SIZE) {
+		RtlCopyMemory(filters, Pipeline->Filters, sizeof(filters));
+		filtered = filters;
+	}
+
+	copyInputData(Data, &report);
+	dpFilterAxes(filtered, &report, Timestamp);
+	dpTransformAxes(Pipeline->Transforms, &report);
+	if (Pipeline->Remap.Enabled)
+		dpRemapReport(&Pipeline->Remap, &report);
+	if (!ringPush(&Pipeline->Ring, &report, Timestamp))
+		return STATUS_DEVICE_BUSY;
+
+	if (filtered != Pipeline->Filters)
+		RtlCopyMemory(Pipeline->Filters, filters, sizeof(filters));
+	dpButtonEngineInput(&Pipeline->Buttons, report.inputs.buttons, Timestamp);
+
+	dpRecordSample(&Pipeline->History, &report, Timestamp);
+	if (Pipeline->Capture != NULL)
+		dpCaptureRecord(Pipeline->Capture, CAPTURE_INPUT, Timestamp, Data);
+
+	// Published under the lock so a reader that finds the ring empty
+	// never falls back to a state older than the last entry it took
+	dpPublishReport(&Pipeline->State, &report);
+	Pipeline->inputs = report;
+	Pipeline->lastInput = *Data;
+	return STATUS_SUCCESS;
+}
+
+static BOOLEAN
+settleStep(
+    IN PREPORT_PIPELINE   Pipeline,
+    IN LONGLONG           Now,
+    OUT PAXIS_FILTER      Filters,
+    OUT PHID_INPUT_REPORT Report
+    )
+/**
+ * Whether running the filters again on the last input at Now, as if it had
+ * been sent again, would change the report. If so, Filters and Report are
+ * set to what the pipeline's filters and report would become. Safe without
+ * the lock, as it only writes to its own copies.
+ */
+{
+	RtlCopyMemory(Filters, Pipeline->Filters, sizeof(AXIS_FILTER) * AXIS_TRANSFORM_COUNT);
+	*Report = Pipeline->inputs;
+	copyInputData(&Pipeline->lastInput, Report);
+	if (!dpSettleAxisFilters(Filters, Report, Now))
+		return FALSE;
+	dpTransformAxes(Pipeline->Transforms, Report);
+	if (Pipeline->Remap.Enabled)
+		dpRemapReport(&Pipeline->Remap, Report);
+	return !RtlEqualMemory(Report, &Pipeline->inputs, sizeof(HID_INPUT_REPORT));
+}
+
+static VOID
+settleFilters(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN LONGLONG             Now
+    )
+/**
+ * Lets smoothed axes go on towards where the input stopped, without the
+ * client having to send it again, by publishing a step of that whenever it
+ * would change the report. The filters reach the input within a second of
+ * the last step, when they start again from it.
+ */
+{
+	AXIS_FILTER filters[AXIS_TRANSFORM_COUNT];
+	HID_INPUT_REPORT report;
+
+	if (!settleStep(Pipeline, Now, filters, &report))
+		return;
+	RtlCopyMemory(Pipeline->Filters, filters, sizeof(filters));
+	dpRecordSample(&Pipeline->History, &report, Now);
+	dpPublishReport(&Pipeline->State, &report);
+	Pipeline->inputs = report;
+}
+
+static VOID
+releaseTimedInput(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN LONGLONG             Now
+    )
+/**
+ * Applies the frames in the jitter buffer that are due by Now. A frame that
+ * can't be applied yet is left for next time.
+ */
+{
+	PJITTER_FRAME frame;
+
+	while ((frame = dpJitterPeek(&Pipeline->Jitter, Now)) != NULL) {
+		if (!NT_SUCCESS(dpPipelineSubmit(Pipeline, &frame->Data, frame->PlayoutTime)))
+			return;
+		dpJitterDrop(&Pipeline->Jitter);
+	}
+}
+
+NTSTATUS
+dpPipelineSubmitTimed(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN PTIMED_INPUT_DATA    Input,
+    IN LONGLONG             Arrival
+    )
+/**
+ * Applies a frame of timestamped input, through the jitter buffer if there
+ * is one, otherwise like dpPipelineSubmit. A frame older than one already
+ * taken is dropped.
+ */
+{
+	NTSTATUS status = STATUS_SUCCESS;
+	PJITTER_FRAME frame;
+
+	if (Pipeline->Jitter.MaxDelay == 0)
+		return dpPipelineSubmit(Pipeline, &Input->data, Arrival);
+
+	if (Pipeline->Jitter.Count == JITTER_BUFFER_SIZE) {
+		// Make room by applying the oldest frame early
+		frame = &Pipeline->Jitter.Frames[Pipeline->Jitter.Head];
+		status = dpPipelineSubmit(Pipeline, &frame->Data, Arrival);
+		if (!NT_SUCCESS(status))
+			return status;
+		dpJitterDrop(&Pipeline->Jitter);
+	}
+	dpJitterPush(&Pipeline->Jitter, &Input->data, Input->timestamp, Arrival);
+	releaseTimedInput(Pipeline, Arrival);
+	return status;
+}
+
+BOOLEAN
+dpPipelineNext(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN LONGLONG             Now,
+    OUT PHID_INPUT_REPORT   Report
+    )
+/**
+ * Applies the timed input due by Now, then takes the oldest undelivered
+ * report from the ring, or the current state if everything has been
+ * delivered already, with its filters run up to Now and its axes
+ * interpolated if the pipeline is set up to. Turbo and macro buttons go on
+ * whichever it is.
+ * Returns TRUE if the report came from the ring, and sets LastArrival to
+ * when its input arrived.
+ */
+{
+	PREPORT_RING ring = &Pipeline->Ring;
+	BOOLEAN found = FALSE;
+
+	releaseTimedInput(Pipeline, Now);
+	if (ring->Count > 0) {
+		RtlCopyMemory(Report, &ring->Entries[ring->Head].Report, sizeof(HID_INPUT_REPORT));
+		Pipeline->LastArrival = ring->Entries[ring->Head].Timestamp;
+		ring->Head = RING_INDEX(ring, 1);
+		ring->Count--;
+		found = TRUE;
+	} else {
+		settleFilters(Pipeline, Now);
+		dpReadReport(&Pipeline->State, Report);
+		if (Pipeline->InterpolateDelay != 0 || Pipeline->ExtrapolateLimit != 0)
+			dpInterpolateAxes(&Pipeline->History, Now - Pipeline->InterpolateDelay,
+				Pipeline->ExtrapolateLimit, Report);
+	}
+
+	if (Pipeline->Buttons.TurboButtons != 0 || Pipeline->Buttons.MacroSteps != 0)
+		Report->inputs.buttons = (USHORT) dpButtonEngineApply(&Pipeline->Buttons, Report->inputs.buttons, Now);
+	else
+		Pipeline->Buttons.NextEdge = NO_BUTTON_EDGE;
+
+	if (Pipeline->Capture != NULL)
+		dpCaptureReport(Pipeline->Capture, Now, Report);
+	return found;
+}
+
+BOOLEAN
+dpPipelineInterpolating(
+    IN PREPORT_PIPELINE Pipeline,
+    IN LONGLONG         Now
+    )
+/**
+ * Whether reports are being interpolated and would still be moving at Now,
+ * even without new input.
+ */
+{
+	if (Pipeline->InterpolateDelay == 0 && Pipeline->ExtrapolateLimit == 0)
+		return FALSE;
+	return dpInterpolationActive(&Pipeline->History, Now - Pipeline->InterpolateDelay, Pipeline->ExtrapolateLimit);
+}
+
+BOOLEAN
+dpPipelineSettling(
+    IN PREPORT_PIPELINE Pipeline
+    )
+/**
+ * Whether smoothed axes haven't yet reached the last input, so the report
+ * may still move without new input.
+ */
+{
+	HID_INPUT_REPORT raw;
+
+	copyInputData(&Pipeline->lastInput, &raw);
+	return !dpAxisFiltersSettled(Pipeline->Filters, &raw);
+}
+
+BOOLEAN
+dpPipelineReportDue(
+    IN PREPORT_PIPELINE Pipeline,
+    IN LONG             Sequence,
+    IN LONGLONG         Now
+    )
+/**
+ * Whether the next report would differ from the one sent at State sequence
+ * Sequence: the state has moved on, reports are queued, interpolated or
+ * smoothed axes are still moving, or a timed frame or a turbo or macro edge
+ * is due by Now.
+ */
+{
+	AXIS_FILTER filters[AXIS_TRANSFORM_COUNT];
+	HID_INPUT_REPORT report;
+
+	if (Pipeline->State.Sequence != Sequence || Pipeline->Ring.Count != 0 ||
+		dpPipelineInterpolating(Pipeline, Now) || settleStep(Pipeline, Now, filters, &report))
+		return TRUE;
+	if (Pipeline->Jitter.Count != 0 && Pipeline->Jitter.Frames[Pipeline->Jitter.Head].PlayoutTime <= Now)
+		return TRUE;
+	return Pipeline->Buttons.NextEdge <= Now;
+}
@@ -0,0 +1,132 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    remap.c
+
+Abstract:
+
+    Mixing of the axes and buttons sent into the ones reported: a small
+    fixed point matrix over the axes, buttons that push axes to either end
+    and axes that press buttons past a threshold, all in one pass over the
+    report. Nothing here touches the framework or the device.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+BOOLEAN
+dpBuildRemap(
+    IN PREMAP_CONFIG Config,
+    OUT PREMAP       Remap
+    )
+/**
+ * Checks a remapping from userland and widens it for dpRemapReport.
+ * Returns FALSE if it doesn't make sense.
+ */
+{
+	ULONG i, j;
+
+	RtlZeroMemory(Remap, sizeof(REMAP));
+	if (!(Config->flags & REMAP_ENABLED))
+		return TRUE;
+
+	for (i = 0; i < 16; i++) {
+		if (Config->buttonAxes[i].axis >= AXIS_TRANSFORM_COUNT && Config->buttonAxes[i].axis != REMAP_NO_AXIS)
+			return FALSE;
+		Remap->ButtonAxis[i] = Config->buttonAxes[i].axis;
+		Remap->ButtonThreshold[i] = Config->buttonAxes[i].threshold;
+	}
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		for (j = 0; j < AXIS_TRANSFORM_COUNT; j++) {
+			// Keeps a row's sum within 32 bits
+			if (Config->matrix[i][j] > REMAP_MAX_WEIGHT || Config->matrix[i][j] < -REMAP_MAX_WEIGHT)
+				return FALSE;
+			Remap->Matrix[i][j] = Config->matrix[i][j];
+		}
+		Remap->AxisButtonsHigh[i] = Config->axisButtonsHigh[i];
+		Remap->AxisButtonsLow[i] = Config->axisButtonsLow[i];
+	}
+	Remap->ButtonPassMask = Config->buttonPassMask;
+	Remap->Enabled = TRUE;
+	return TRUE;
+}
+
+VOID
+dpRemapReport(
+    IN PREMAP                Remap,
+    IN OUT PHID_INPUT_REPORT Report
+    )
+/**
+ * Replaces a report's axes and buttons with their remapped values.
+ */
+{
+	PLONG axes = &Report->inputs.axisX;	// The six axes are consecutive LONGs
+	ULONG buttons = Report->inputs.buttons;
+	ULONG outButtons;
+	LONG in[AXIS_TRANSFORM_COUNT], out[AXIS_TRANSFORM_COUNT];
+	LONG sum;
+	ULONG i, j;
+
+	// Clamped first, so the sums below can't overflow
+	for (j = 0; j < AXIS_TRANSFORM_COUNT; j++) {
+		in[j] = min(max(axes[j], 0), JS_MAX_VALUE) - JS_RESTING_PLACE;
+	}
+
+	// Fixed trip counts and no branches in the inner loop, so the compiler
+	// can unroll and vectorise it
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		sum = 0;
+		for (j = 0; j < AXIS_TRANSFORM_COUNT; j++) {
+			sum += Remap->Matrix[i][j] * in[j];
+		}
+		sum /= REMAP_ONE;
+		if (buttons & Remap->AxisButtonsHigh[i])
+			sum += JS_MAX_VALUE - JS_RESTING_PLACE;
+		if (buttons & Remap->AxisButtonsLow[i])
+			sum -= JS_RESTING_PLACE;
+		out[i] = min(max(sum, -JS_RESTING_PLACE), JS_MAX_VALUE - JS_RESTING_PLACE);
+	}
+
+	outButtons = buttons & Remap->ButtonPassMask;
+	for (i = 0; i < 16; i++) {
+		j = Remap->ButtonAxis[i];
+		if (j == REMAP_NO_AXIS)
+			continue;
+		if (Remap->ButtonThreshold[i] >= 0 ? out[j] > Remap->ButtonThreshold[i] : out[j] < Remap->ButtonThreshold[i])
+			outButtons |= 1 << i;
+	}
+
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		axes[i] = out[i] + JS_RESTING_PLACE;
+	}
+	Report->inputs.buttons = (USHORT) outButtons;
+}
@@ -0,0 +1,70 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    state.c
+
+Abstract:
+
+    The latest input state, handed from the input sources to the report
+    path. It lives in the REPORT_PIPELINE and is guarded by the same lock.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+VOID
+dpPublishReport(
+    IN OUT PREPORT_STATE State,
+    IN PHID_INPUT_REPORT Report
+    )
+/**
+ * Publishes a new report and moves the sequence on. The caller holds the
+ * lock guarding the pipeline the state belongs to.
+ */
+{
+	RtlCopyMemory(&State->Report, Report, sizeof(HID_INPUT_REPORT));
+	// Wraps rather than overflowing
+	InterlockedIncrement(&State->Sequence);
+}
+
+VOID
+dpReadReport(
+    IN PREPORT_STATE State,
+    OUT PHID_INPUT_REPORT Report
+    )
+/**
+ * Copies out the last published report. The caller holds the lock guarding
+ * the pipeline the state belongs to.
+ */
+{
+	RtlCopyMemory(Report, &State->Report, sizeof(HID_INPUT_REPORT));
+}
@@ -0,0 +1,155 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    trace.c
+
+Abstract:
+
+    The binary trace ring. The driver keeps one per CPU and writes a
+    DP_TRACE_RECORD to it for each message in dptrace.h, unformatted, so
+    tracing can stay on without slowing the report path. A ring never
+    blocks its writers: they take slots with an interlocked increment, and
+    publish each record by writing its sequence number last. The reader
+    checks that number before and after copying a record, and skips any
+    that a writer has lapped.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+#define RECORD_SEQUENCE(Record)	(*(volatile ULONG *) &(Record)->sequence)
+
+VOID
+dpInitTraceRing(
+    OUT PDP_TRACE_RING Ring,
+    IN UCHAR           Cpu
+    )
+{
+	RtlZeroMemory(Ring, sizeof(DP_TRACE_RING));
+	Ring->Cpu = Cpu;
+}
+
+VOID
+dpTraceWrite(
+    IN OUT PDP_TRACE_RING Ring,
+    IN USHORT             Message,
+    IN LONGLONG           Timestamp,
+    IN ULONG              Arg0,
+    IN ULONG              Arg1,
+    IN ULONG              Arg2
+    )
+/**
+ * Appends a record, overwriting the oldest if the reader is a lap behind.
+ * Safe to call from any number of writers at once, at up to DISPATCH_LEVEL.
+ */
+{
+	ULONG slot = (ULONG) InterlockedIncrement(&Ring->Head) - 1;
+	PDP_TRACE_RECORD record = &Ring->Records[slot % DP_TRACE_RING_SIZE];
+
+	// A slot's sequence is one more than its slot number once it's written,
+	// so marking it with the slot number itself hides it from the reader.
+	RECORD_SEQUENCE(record) = slot;
+	KeMemoryBarrier();
+
+	record->message = Message;
+	record->cpu = Ring->Cpu;
+	record->reserved = 0;
+	record->timestamp = Timestamp;
+	record->args[0] = Arg0;
+	record->args[1] = Arg1;
+	record->args[2] = Arg2;
+	record->reserved2 = 0;
+
+	KeMemoryBarrier();
+	RECORD_SEQUENCE(record) = slot + 1;
+}
+
+ULONG
+dpTraceDrain(
+    IN OUT PDP_TRACE_RING Ring,
+    OUT PDP_TRACE_RECORD  Records,
+    IN ULONG              MaxRecords
+    )
+/**
+ * Copies up to MaxRecords records out of the ring, oldest first, with a
+ * DPT_LOST record in front of any that follow lost ones. Stops early at a
+ * record that's still being written. Only one caller may drain a ring at
+ * a time.
+ * Returns how many records were copied.
+ */
+{
+	ULONG head, expected, sequence, count = 0;
+	PDP_TRACE_RECORD record;
+	DP_TRACE_RECORD copy;
+
+	head = (ULONG) Ring->Head;
+	KeMemoryBarrier();
+
+	// Anything more than a lap behind has been overwritten already
+	if (head - Ring->Tail > DP_TRACE_RING_SIZE) {
+		Ring->Lost += head - Ring->Tail - DP_TRACE_RING_SIZE;
+		Ring->Tail = head - DP_TRACE_RING_SIZE;
+	}
+
+	while (Ring->Tail != head && count + (Ring->Lost != 0) < MaxRecords) {
+		record = &Ring->Records[Ring->Tail % DP_TRACE_RING_SIZE];
+		expected = Ring->Tail + 1;
+
+		sequence = RECORD_SEQUENCE(record);
+		if ((LONG) (sequence - expected) < 0)
+			break;
+
+		KeMemoryBarrier();
+		copy = *record;
+		KeMemoryBarrier();
+
+		Ring->Tail++;
+		if (sequence != expected || RECORD_SEQUENCE(record) != expected) {
+			// Lapped before or while it was copied
+			Ring->Lost++;
+			continue;
+		}
+
+		if (Ring->Lost != 0) {
+			RtlZeroMemory(&Records[count], sizeof(DP_TRACE_RECORD));
+			Records[count].message = DPT_LOST;
+			Records[count].cpu = Ring->Cpu;
+			Records[count].timestamp = copy.timestamp;
+			Records[count].args[0] = Ring->Lost;
+			Ring->Lost = 0;
+			count++;
+		}
+		Records[count++] = copy;
+	}
+
+	return count;
+}
@@ -0,0 +1,165 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    turbo.c
+
+Abstract:
+
+    Turbo buttons and button macros, generated in the driver against the
+    time each report is built, instead of by a client toggling buttons
+    with an IOCTL per edge. Nothing here touches the framework or the
+    device.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+// Interrupt time runs in 100ns units
+#define TICKS_PER_MILLI		10000
+
+VOID
+dpButtonEngineSetTurbo(
+    IN OUT PBUTTON_ENGINE Engine,
+    IN PTURBO_CONFIG      Config,
+    IN ULONG              Buttons,
+    IN LONGLONG           Now
+    )
+/**
+ * Replaces the turbo periods. Turbo buttons already held start their cycle
+ * again from Now, pressed.
+ */
+{
+	ULONG i;
+
+	Engine->TurboButtons = 0;
+	for (i = 0; i < BUTTON_COUNT; i++) {
+		if (Config->periodMillis[i] == 0)
+			continue;
+		Engine->TurboButtons |= 1 << i;
+		Engine->TurboHalfPeriod[i] = max((LONGLONG) Config->periodMillis[i] * TICKS_PER_MILLI / 2, 1);
+		Engine->PressTime[i] = Now;
+	}
+	Engine->Held = Buttons & Engine->TurboButtons;
+
+	// Whatever was being reported may have changed
+	Engine->NextEdge = Now;
+}
+
+VOID
+dpButtonEngineRunMacro(
+    IN OUT PBUTTON_ENGINE Engine,
+    IN PMACRO             Macro,
+    IN LONGLONG           Now
+    )
+/**
+ * Starts a checked macro from Now, replacing any that's running.
+ */
+{
+	LONGLONG end = 0;
+	ULONG i;
+
+	ASSERT(Macro->stepCount <= MACRO_MAX_STEPS);
+
+	for (i = 0; i < Macro->stepCount; i++) {
+		end += (LONGLONG) Macro->steps[i].durationMillis * TICKS_PER_MILLI;
+		Engine->MacroButtons[i] = Macro->steps[i].buttons;
+		Engine->MacroStepEnd[i] = end;
+	}
+	Engine->MacroSteps = Macro->stepCount;
+	Engine->MacroStart = Now;
+	Engine->NextEdge = Now;
+}
+
+VOID
+dpButtonEngineInput(
+    IN OUT PBUTTON_ENGINE Engine,
+    IN ULONG              Buttons,
+    IN LONGLONG           Timestamp
+    )
+/**
+ * Notes the buttons of a new frame of input, so a turbo button's cycle
+ * starts when it's pressed.
+ */
+{
+	ULONG pressed = Buttons & Engine->TurboButtons & ~Engine->Held;
+	ULONG i;
+
+	for (i = 0; pressed != 0; i++, pressed >>= 1) {
+		if (pressed & 1)
+			Engine->PressTime[i] = Timestamp;
+	}
+	Engine->Held = Buttons & Engine->TurboButtons;
+}
+
+ULONG
+dpButtonEngineApply(
+    IN OUT PBUTTON_ENGINE Engine,
+    IN ULONG              Buttons,
+    IN LONGLONG           Now
+    )
+/**
+ * Works out the buttons to report at Now, given the ones held, and when
+ * they next change.
+ */
+{
+	ULONG out = Buttons & ~Engine->TurboButtons;
+	ULONG turbo = Buttons & Engine->TurboButtons;
+	LONGLONG next = NO_BUTTON_EDGE;
+	LONGLONG elapsed, phase;
+	ULONG i;
+
+	// Pressed for the even half periods since the press, released for the odd ones
+	for (i = 0; turbo != 0; i++, turbo >>= 1) {
+		if (!(turbo & 1))
+			continue;
+		elapsed = max(Now - Engine->PressTime[i], 0);
+		phase = elapsed / Engine->TurboHalfPeriod[i];
+		if (!(phase & 1))
+			out |= 1 << i;
+		next = min(next, Engine->PressTime[i] + (phase + 1) * Engine->TurboHalfPeriod[i]);
+	}
+
+	if (Engine->MacroSteps != 0) {
+		elapsed = Now - Engine->MacroStart;
+		for (i = 0; i < Engine->MacroSteps && Engine->MacroStepEnd[i] <= elapsed; i++)
+			;
+		if (i == Engine->MacroSteps) {
+			Engine->MacroSteps = 0;
+		} else {
+			out |= Engine->MacroButtons[i];
+			next = min(next, Engine->MacroStart + Engine->MacroStepEnd[i]);
+		}
+	}
+
+	Engine->NextEdge = next;
+	return out;
+}
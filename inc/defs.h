@@ -1,55 +1,420 @@
-/*
- * This file is part of DroidPad.
- * DroidPad lets you use an Android mobile to control a joystick or mouse
- * on a Windows or Linux computer.
- * This program is the driver for DroidPad's Joystick.
- *
- * DroidPad is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * DroidPad is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with DroidPad, in the file COPYING.
- * If not, see <http://www.gnu.org/licenses/>.
- */
-
-// Definitions etc. for DroidPad driver
-
-// Device Attributes
-//
-// VID_D801&PID_D6AD - sort of looks like droidpad?!?
-#define VENDOR_N_ID		0xD801
-#define	PRODUCT_N_ID		0xD6AD
-#define	VERSION_N		0x0001
-
-#define SEND_INPUT_DATA		0x789
-#define IOCTL_DP_SEND_INPUT_DATA	CTL_CODE (FILE_DEVICE_UNKNOWN, SEND_INPUT_DATA, METHOD_BUFFERED, FILE_WRITE_ACCESS)
-
-#define DEVICENAME_STRING	"droidpad"
-
-#define NTDEVICE_NAME_STRING		"\\Device\\"DEVICENAME_STRING
-#define SYMBOLIC_NAME_STRING		"\\DosDevices\\"DEVICENAME_STRING
-#define	DOS_FILE_NAME				"\\\\.\\"DEVICENAME_STRING
-
-
-// Input data, as fed to the driver from userland. This is different to the HID descriptor as one may change but not the other
-#include <pshpack1.h>
-typedef struct _INPUT_DATA {
-    LONG	axisX;
-    LONG	axisY;
-    LONG	axisZ;
-    LONG	axisRX;
-    LONG	axisRY;
-    LONG	axisRZ;
-    LONG	buttons;	// 16 Buttons (12 used). This is a long type so that less packing issues are run in to (hopefully!)
-} INPUT_DATA, *PINPUT_DATA;
-#include <poppack.h>
-
-// Error levels for status report
-enum ERRLEVEL {INFO, WARN, ERR, FATAL, APP};
+/*
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Definitions etc. for DroidPad driver
+
+// Device Attributes
+//
+// VID_D801&PID_D6AD - sort of looks like droidpad?!?
+#define VENDOR_N_ID		0xD801
+#define	PRODUCT_N_ID		0xD6AD
+#define	VERSION_N		0x0001
+
+#define SEND_INPUT_DATA		0x789
+#define IOCTL_DP_SEND_INPUT_DATA	CTL_CODE (FILE_DEVICE_UNKNOWN, SEND_INPUT_DATA, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define SEND_INPUT_BATCH	0x78A
+#define IOCTL_DP_SEND_INPUT_BATCH	CTL_CODE (FILE_DEVICE_UNKNOWN, SEND_INPUT_BATCH, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define MAP_SHARED_INPUT	0x78B
+#define IOCTL_DP_MAP_SHARED_INPUT	CTL_CODE (FILE_DEVICE_UNKNOWN, MAP_SHARED_INPUT, METHOD_BUFFERED, FILE_READ_ACCESS | FILE_WRITE_ACCESS)
+#define SEND_INPUT_UPDATE	0x78C
+#define IOCTL_DP_SEND_INPUT_UPDATE	CTL_CODE (FILE_DEVICE_UNKNOWN, SEND_INPUT_UPDATE, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define SEND_PAD_INPUT_DATA	0x78D
+#define IOCTL_DP_SEND_PAD_INPUT_DATA	CTL_CODE (FILE_DEVICE_UNKNOWN, SEND_PAD_INPUT_DATA, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define GET_STATS		0x78E
+#define IOCTL_DP_GET_STATS	CTL_CODE (FILE_DEVICE_UNKNOWN, GET_STATS, METHOD_BUFFERED, FILE_READ_ACCESS)
+#define SET_CALIBRATION		0x78F
+#define IOCTL_DP_SET_CALIBRATION	CTL_CODE (FILE_DEVICE_UNKNOWN, SET_CALIBRATION, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define SET_FILTER		0x790
+#define IOCTL_DP_SET_FILTER	CTL_CODE (FILE_DEVICE_UNKNOWN, SET_FILTER, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define SEND_TIMED_INPUT_DATA	0x791
+#define IOCTL_DP_SEND_TIMED_INPUT_DATA	CTL_CODE (FILE_DEVICE_UNKNOWN, SEND_TIMED_INPUT_DATA, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define SET_TURBO		0x792
+#define IOCTL_DP_SET_TURBO	CTL_CODE (FILE_DEVICE_UNKNOWN, SET_TURBO, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define RUN_MACRO		0x793
+#define IOCTL_DP_RUN_MACRO	CTL_CODE (FILE_DEVICE_UNKNOWN, RUN_MACRO, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define SET_REMAP		0x794
+#define IOCTL_DP_SET_REMAP	CTL_CODE (FILE_DEVICE_UNKNOWN, SET_REMAP, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define SET_CAPTURE		0x795
+#define IOCTL_DP_SET_CAPTURE	CTL_CODE (FILE_DEVICE_UNKNOWN, SET_CAPTURE, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define READ_CAPTURE		0x796
+#define IOCTL_DP_READ_CAPTURE	CTL_CODE (FILE_DEVICE_UNKNOWN, READ_CAPTURE, METHOD_BUFFERED, FILE_READ_ACCESS)
+#define READ_TRACE		0x797
+#define IOCTL_DP_READ_TRACE	CTL_CODE (FILE_DEVICE_UNKNOWN, READ_TRACE, METHOD_BUFFERED, FILE_READ_ACCESS)
+#define GET_PERF_STATS		0x798
+#define IOCTL_DP_GET_PERF_STATS	CTL_CODE (FILE_DEVICE_UNKNOWN, GET_PERF_STATS, METHOD_BUFFERED, FILE_READ_ACCESS)
+#define GET_PAD_SETTINGS	0x799
+#define IOCTL_DP_GET_PAD_SETTINGS	CTL_CODE (FILE_DEVICE_UNKNOWN, GET_PAD_SETTINGS, METHOD_BUFFERED, FILE_READ_ACCESS)
+
+// Number of joysticks one driver instance can provide. Each IOCTL below says
+// which one it's for; IOCTL_DP_SEND_INPUT_DATA always goes to pad 0.
+#define DP_MAX_PADS		16
+
+#define DEVICENAME_STRING	"droidpad"
+
+#define NTDEVICE_NAME_STRING		"\\Device\\"DEVICENAME_STRING
+#define SYMBOLIC_NAME_STRING		"\\DosDevices\\"DEVICENAME_STRING
+#define	DOS_FILE_NAME				"\\\\.\\"DEVICENAME_STRING
+
+
+// Input data, as fed to the driver from userland. This is different to the HID descriptor as one may change but not the other
+#include <pshpack1.h>
+typedef struct _INPUT_DATA {
+    LONG	axisX;
+    LONG	axisY;
+    LONG	axisZ;
+    LONG	axisRX;
+    LONG	axisRY;
+    LONG	axisRZ;
+    LONG	buttons;	// 16 Buttons (12 used). This is a long type so that less packing issues are run in to (hopefully!)
+				// The top 16 bits are 4 bits for each hat switch, if the device has any:
+				// 0 is centred, 1 to 8 are N, NE, E, ..., NW.
+} INPUT_DATA, *PINPUT_DATA;
+
+// Input for one pad, sent with IOCTL_DP_SEND_PAD_INPUT_DATA.
+typedef struct _PAD_INPUT_DATA {
+    ULONG	pad;	// 0 to DP_MAX_PADS - 1
+    INPUT_DATA	data;
+} PAD_INPUT_DATA, *PPAD_INPUT_DATA;
+
+// Input for one pad stamped with when it was sampled, sent with
+// IOCTL_DP_SEND_TIMED_INPUT_DATA. If the pad has a jitter buffer (see
+// JitterBufferMaxMillis) it's applied on the sender's schedule rather than
+// as it arrives.
+typedef struct _TIMED_INPUT_DATA {
+    ULONG	pad;		// 0 to DP_MAX_PADS - 1
+    ULONG	reserved;
+    LONGLONG	timestamp;	// When the frame was sampled, in the sender's clock in 100ns units
+    INPUT_DATA	data;
+} TIMED_INPUT_DATA, *PTIMED_INPUT_DATA;
+
+// One frame of an IOCTL_DP_SEND_INPUT_BATCH.
+typedef struct _INPUT_FRAME {
+    LONGLONG	timestamp;	// When the frame was sampled, in the sender's clock in 100ns units. 0 if not known.
+    INPUT_DATA	data;
+} INPUT_FRAME, *PINPUT_FRAME;
+
+// Several frames sent in one IOCTL, applied in order as if each had been sent on its own.
+typedef struct _INPUT_BATCH {
+    ULONG	frameCount;	// 1 to INPUT_BATCH_MAX_FRAMES
+    ULONG	pad;		// 0 to DP_MAX_PADS - 1
+    INPUT_FRAME	frames[1];	// frameCount frames follow
+} INPUT_BATCH, *PINPUT_BATCH;
+#include <poppack.h>
+
+#define INPUT_BATCH_MAX_FRAMES	256
+#define INPUT_BATCH_SIZE(frameCount)	(FIELD_OFFSET(INPUT_BATCH, frames) + (frameCount) * sizeof(INPUT_FRAME))
+
+// Bits of INPUT_UPDATE.mask, one for each value that follows it
+#define INPUT_UPDATE_AXIS_X		0x0001
+#define INPUT_UPDATE_AXIS_Y		0x0002
+#define INPUT_UPDATE_AXIS_Z		0x0004
+#define INPUT_UPDATE_AXIS_RX		0x0008
+#define INPUT_UPDATE_AXIS_RY		0x0010
+#define INPUT_UPDATE_AXIS_RZ		0x0020
+#define INPUT_UPDATE_BUTTONS		0x0040	// Replaces the whole button word
+#define INPUT_UPDATE_BUTTONS_SET	0x0080	// Buttons to press
+#define INPUT_UPDATE_BUTTONS_CLEAR	0x0100	// Buttons to release
+#define INPUT_UPDATE_AXES		0x003F
+#define INPUT_UPDATE_ALL		0x01FF
+
+// Changes some fields of the last INPUT_DATA sent and leaves the rest alone.
+// mask is followed by one LONG for each bit set in it, lowest bit first.
+// Buttons are replaced, then set, then cleared.
+#include <pshpack1.h>
+typedef struct _INPUT_UPDATE {
+    ULONG	pad;	// 0 to DP_MAX_PADS - 1
+    ULONG	mask;
+    LONG	values[1];
+} INPUT_UPDATE, *PINPUT_UPDATE;
+#include <poppack.h>
+
+#define INPUT_UPDATE_SIZE(valueCount)	(FIELD_OFFSET(INPUT_UPDATE, values) + (valueCount) * sizeof(LONG))
+
+// Page of memory shared between the driver and one client, mapped into the
+// client's process by IOCTL_DP_MAP_SHARED_INPUT, whose optional input is the
+// ULONG index of the pad the page is for. The client publishes input
+// with plain memory writes, and the driver picks it up when it next builds
+// a report. The mapping lasts until the handle it was made on is closed.
+//
+// To publish a frame the client does:
+//     InterlockedIncrement(&sequence);	// now odd
+//     slots[0] = frame;
+//     InterlockedIncrement(&sequence);	// now even
+//     slots[1] = frame;
+// The driver only reads slots[0] while sequence is even and unchanged.
+// dpshared.h has both sides.
+#define SHARED_INPUT_MAGIC	0x50645044	// "DPdP"
+#define SHARED_INPUT_VERSION	1
+
+#include <pshpack1.h>
+typedef struct _SHARED_INPUT {
+    ULONG	magic;		// Set by the driver
+    ULONG	version;	// Set by the driver
+    volatile LONG	sequence;	// Written by the client only
+    ULONG	reserved;
+    INPUT_DATA	slots[2];
+} SHARED_INPUT, *PSHARED_INPUT;
+
+// Output of IOCTL_DP_MAP_SHARED_INPUT
+typedef struct _SHARED_INPUT_MAPPING {
+    ULONGLONG	address;	// Address of the SHARED_INPUT in the caller's process
+    ULONG	size;		// Size of the mapping in bytes
+    ULONG	reserved;
+} SHARED_INPUT_MAPPING, *PSHARED_INPUT_MAPPING;
+#include <poppack.h>
+
+// How the driver corrects one axis before it is reported. Axis values run
+// from 0 to 32767. The raw value is measured from centre as a fraction of
+// the travel on that side; inner and outer deadzones are cut from that, and
+// what's left is shaped by the curve and mapped onto the full output range.
+#define AXIS_CALIBRATION_ENABLED	0x0001	// Otherwise the axis is reported as it is
+
+#include <pshpack1.h>
+typedef struct _AXIS_CALIBRATION {
+    USHORT	flags;
+    USHORT	centre;		// Raw value the axis rests at, 1 to 32766
+    USHORT	innerDeadzone;	// Travel either side of centre that reads as centred, out of 32767
+    USHORT	outerDeadzone;	// Travel at each end that reads as fully deflected, out of 32767
+    USHORT	curve;		// 0 is linear, up to 32767 for a cubic curve that's gentler near centre
+    USHORT	reserved;
+} AXIS_CALIBRATION, *PAXIS_CALIBRATION;
+
+// Input of IOCTL_DP_SET_CALIBRATION. Replaces the calibration of all six axes.
+typedef struct _CALIBRATION {
+    ULONG	pad;		// 0 to DP_MAX_PADS - 1
+    AXIS_CALIBRATION	axes[6];	// X, Y, Z, Rx, Ry, Rz
+} CALIBRATION, *PCALIBRATION;
+#include <poppack.h>
+
+// Smoothing of one axis's raw input, before calibration. A low-pass filter
+// whose cutoff frequency rises with the speed the axis is moving at (the
+// "1 euro" filter), so it's smooth when still and doesn't lag when moving.
+// With a beta of 0 it's a plain exponential moving average.
+#define AXIS_FILTER_ENABLED	0x0001
+
+#include <pshpack1.h>
+typedef struct _AXIS_FILTER_CONFIG {
+    USHORT	flags;
+    USHORT	minCutoff;	// Cutoff when still, in 1/100 Hz. Not 0.
+    USHORT	beta;		// Cutoff added per 1000 units/second of speed, in 1/100 Hz
+    USHORT	speedCutoff;	// Cutoff for the speed estimate, in 1/100 Hz. Not 0.
+} AXIS_FILTER_CONFIG, *PAXIS_FILTER_CONFIG;
+
+// Input of IOCTL_DP_SET_FILTER. Replaces the filters of all six axes.
+typedef struct _FILTER_CONFIG {
+    ULONG	pad;		// 0 to DP_MAX_PADS - 1
+    AXIS_FILTER_CONFIG	axes[6];	// X, Y, Z, Rx, Ry, Rz
+} FILTER_CONFIG, *PFILTER_CONFIG;
+#include <poppack.h>
+
+// Input of IOCTL_DP_SET_REMAP: how the axes and buttons sent are turned into
+// the ones reported, after calibration. Each reported axis is a mix of the
+// axes sent, measured from centre, plus full travel either way while some
+// buttons are held. Each reported button is the button sent, if it passes
+// through, or pressed while an axis is past a threshold.
+#define REMAP_ENABLED		0x0001	// Otherwise axes and buttons are reported as they are
+#define REMAP_ONE		256	// A matrix weight of 1
+#define REMAP_MAX_WEIGHT	(16 * REMAP_ONE)	// Largest weight either way
+#define REMAP_NO_AXIS		0xFF
+
+#include <pshpack1.h>
+typedef struct _BUTTON_AXIS_MAP {
+    UCHAR	axis;		// Reported axis (0 to 5) that presses this button, or REMAP_NO_AXIS
+    UCHAR	reserved;
+    SHORT	threshold;	// From centre; pressed above it if positive, below it if negative
+} BUTTON_AXIS_MAP, *PBUTTON_AXIS_MAP;
+
+typedef struct _REMAP_CONFIG {
+    ULONG	pad;		// 0 to DP_MAX_PADS - 1
+    ULONG	flags;
+    SHORT	matrix[6][6];	// [reported axis][axis sent], in 1/REMAP_ONE, up to REMAP_MAX_WEIGHT either way
+    USHORT	axisButtonsHigh[6];	// Buttons sent that push each reported axis to its maximum
+    USHORT	axisButtonsLow[6];	// Likewise to its minimum
+    USHORT	buttonPassMask;	// Buttons sent that are reported as they are
+    USHORT	reserved;
+    BUTTON_AXIS_MAP	buttonAxes[16];	// For each reported button
+} REMAP_CONFIG, *PREMAP_CONFIG;
+#include <poppack.h>
+
+// Input of IOCTL_DP_SET_TURBO. While a button with a turbo period is held,
+// the driver reports it pressed and released in turn, starting pressed, for
+// half the period each.
+#include <pshpack1.h>
+typedef struct _TURBO_CONFIG {
+    ULONG	pad;		// 0 to DP_MAX_PADS - 1
+    USHORT	periodMillis[16];	// For each button; 0 for no turbo
+} TURBO_CONFIG, *PTURBO_CONFIG;
+
+// Input of IOCTL_DP_RUN_MACRO. Each step's buttons are reported pressed, on
+// top of the ones actually held, for its duration, one step after another.
+// Replaces any macro already running; no steps just stops it.
+typedef struct _MACRO_STEP {
+    USHORT	buttons;
+    USHORT	durationMillis;
+} MACRO_STEP, *PMACRO_STEP;
+
+typedef struct _MACRO {
+    ULONG	pad;		// 0 to DP_MAX_PADS - 1
+    ULONG	stepCount;	// 0 to MACRO_MAX_STEPS
+    MACRO_STEP	steps[1];	// stepCount steps follow
+} MACRO, *PMACRO;
+#include <poppack.h>
+
+#define MACRO_MAX_STEPS		32
+#define MACRO_SIZE(stepCount)	(FIELD_OFFSET(MACRO, steps) + (stepCount) * sizeof(MACRO_STEP))
+
+// Output of IOCTL_DP_GET_STATS, whose optional input is the ULONG index of
+// the pad to report on (pad 0 without one). Counts since the pad was added.
+#include <pshpack1.h>
+typedef struct _DP_STATS {
+    ULONG	pad;
+    ULONG	reportsDelivered;	// HID reads completed
+    ULONG	reportsSuppressed;	// HID reads held back because nothing had changed, once each
+    ULONG	readsTimedOut;		// HID reads completed unchanged after MaxStaleMillis
+} DP_STATS, *PDP_STATS;
+#include <poppack.h>
+
+// Output of IOCTL_DP_GET_PERF_STATS, with the same input. It starts with
+// DP_STATS and goes on with more counts, for telling whether lag comes from
+// the client, the reports queued in the driver or the report timer.
+//
+// The histograms count values in buckets of powers of 2: bucket 0 holds 0,
+// and bucket n values from 2^(n-1) to 2^n - 1. The last bucket also holds
+// everything larger.
+#define DP_HISTOGRAM_BUCKETS	32
+
+#include <pshpack1.h>
+typedef struct _DP_PERF_STATS {
+    ULONG	pad;			// The DP_STATS fields
+    ULONG	reportsDelivered;
+    ULONG	reportsSuppressed;
+    ULONG	readsTimedOut;
+    ULONG	inputsReceived;		// Frames of input taken, from any source
+    ULONG	inputsRejected;		// Frames turned away: malformed, or the ring was full
+    ULONG	readsParked;		// HID reads queued to wait for a report
+    ULONG	outputBufferFailures;	// HID reads failed for want of a big enough buffer
+    ULONG	latency[DP_HISTOGRAM_BUCKETS];		// Microseconds from input arriving to its report being read
+    ULONG	queueDepth[DP_HISTOGRAM_BUCKETS];	// Reports queued, including the one read, at each read
+} DP_PERF_STATS, *PDP_PERF_STATS;
+#include <poppack.h>
+
+// Output of IOCTL_DP_GET_PAD_SETTINGS, whose optional input is the ULONG
+// index of the pad (pad 0 without one): everything that shapes the pad's
+// reports, as last set. Each part is as it was sent to set it (all zeros if
+// it never was), so it can be sent again as it is. Macros aren't included,
+// as they only run once.
+#include <pshpack1.h>
+typedef struct _PAD_SETTINGS {
+    ULONG	pad;
+    ULONG	interpolateDelayMillis;	// InterpolateDelayMillis in the registry
+    ULONG	extrapolateMillis;	// ExtrapolateMillis in the registry
+    ULONG	reserved;
+    CALIBRATION	calibration;
+    FILTER_CONFIG	filter;
+    REMAP_CONFIG	remap;
+    TURBO_CONFIG	turbo;
+} PAD_SETTINGS, *PPAD_SETTINGS;
+#include <poppack.h>
+
+// Input of IOCTL_DP_SET_CAPTURE. While capture is on, the driver keeps every
+// frame of input the pad takes and every report it sends, as
+// CAPTURE_RECORDs, until they're read with IOCTL_DP_READ_CAPTURE. Turning it
+// off throws away anything not yet read.
+#include <pshpack1.h>
+typedef struct _CAPTURE_CONFIG {
+    ULONG	pad;		// 0 to DP_MAX_PADS - 1
+    ULONG	enable;
+} CAPTURE_CONFIG, *PCAPTURE_CONFIG;
+
+//
+// Output of IOCTL_DP_READ_CAPTURE, whose optional input is the ULONG index of
+// the pad to read from (pad 0 without one): as many records as fit, oldest
+// first. If the client falls behind, records are dropped rather than
+// overwritten, and the next one kept says how many.
+//
+// A capture log is a CAPTURE_FILE_HEADER followed by these records back to
+// back, as read. Records are fixed size so a log can be appended to as it's
+// captured, and read in place or from any record on. The header holds the
+// pad's settings from IOCTL_DP_GET_PAD_SETTINGS, read just before capture
+// was turned on, so the log replays as it was captured; any change after
+// that is marked with a CAPTURE_SETTINGS record.
+//
+#define CAPTURE_INPUT		1	// A frame of input, as merged into the pad's state
+#define CAPTURE_REPORT		2	// A report sent to HIDCLASS, before packing
+#define CAPTURE_SETTINGS	3	// The pad's settings changed; data is the last input
+
+typedef struct _CAPTURE_RECORD {
+    LONGLONG	timestamp;	// Interrupt time (100ns units)
+    USHORT	type;		// CAPTURE_INPUT or CAPTURE_REPORT
+    USHORT	reserved;
+    ULONG	dropped;	// Records lost just before this one
+    INPUT_DATA	data;		// Reports are in the same form: hats in the top of buttons
+    ULONG	reserved2;
+} CAPTURE_RECORD, *PCAPTURE_RECORD;
+
+#define CAPTURE_MAGIC		0x50434450	// "DPCP"
+#define CAPTURE_VERSION		1
+
+typedef struct _CAPTURE_FILE_HEADER {
+    ULONG	magic;		// CAPTURE_MAGIC
+    USHORT	version;	// CAPTURE_VERSION
+    USHORT	recordSize;	// sizeof(CAPTURE_RECORD); readers step by this
+    ULONG	pad;		// Which pad was captured
+    ULONG	reserved;
+    PAD_SETTINGS	settings;	// The pad's settings as capture started
+} CAPTURE_FILE_HEADER, *PCAPTURE_FILE_HEADER;
+
+//
+// Output of IOCTL_DP_READ_TRACE: as many of the driver's trace records as
+// fit. Each CPU's records come out oldest first, one CPU after another, so
+// sort by timestamp to interleave them. Records are never formatted in the
+// driver; message is an index into DP_TRACE_MESSAGES in dptrace.h, which
+// gives the level and the printf format the args go into. If the client
+// falls behind, the oldest records are overwritten and a DPT_LOST record
+// says how many.
+//
+// A trace log is a DP_TRACE_FILE_HEADER followed by these records back to
+// back, as read. DP_TRACE_VERSION goes up whenever the message table
+// changes other than by adding to the end.
+//
+typedef struct _DP_TRACE_RECORD {
+    ULONG	sequence;	// Per CPU, for the driver's use
+    USHORT	message;	// DPT_*
+    UCHAR	cpu;
+    UCHAR	reserved;
+    LONGLONG	timestamp;	// Interrupt time (100ns units)
+    ULONG	args[3];
+    ULONG	reserved2;
+} DP_TRACE_RECORD, *PDP_TRACE_RECORD;
+
+#define DP_TRACE_MAGIC		0x52544450	// "DPTR"
+#define DP_TRACE_VERSION	1
+
+typedef struct _DP_TRACE_FILE_HEADER {
+    ULONG	magic;		// DP_TRACE_MAGIC
+    USHORT	version;	// DP_TRACE_VERSION
+    USHORT	recordSize;	// sizeof(DP_TRACE_RECORD); readers step by this
+    ULONG	reserved[2];
+} DP_TRACE_FILE_HEADER, *PDP_TRACE_FILE_HEADER;
+#include <poppack.h>
+
+// Error levels for status report
+enum ERRLEVEL {INFO, WARN, ERR, FATAL, APP};
@@ -0,0 +1,773 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dpcore.h
+
+Abstract:
+
+    Report state, report packing and descriptors, and the axis and button
+    processing applied to input on its way into a report. None of it
+    depends on WDF, so it is built as a library of its own (core\) which
+    the driver links against.
+
+    Built with the WDK, it only needs the DDK headers. Built anywhere else,
+    DP_PORTABLE must be defined and inc\portable put on the include path,
+    which stands in for the few DDK definitions the core uses.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Notes:
+
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_CORE_H_
+
+#define _DROIDPAD_CORE_H_
+
+#ifdef DP_PORTABLE
+#include <dpport.h>
+#else
+#include <wdm.h>
+#pragma warning(disable:4201)  // suppress nameless struct/union warning
+#pragma warning(disable:4214)  // suppress bit field types other than int warning
+#include <hidport.h>
+#endif
+
+#include "defs.h"
+#include "dptrace.h"
+#include "dpshared.h"
+
+typedef UCHAR HID_REPORT_DESCRIPTOR, *PHID_REPORT_DESCRIPTOR;
+
+// HID descriptor of a 6-axis 12-button JS, which DroidPad uses.
+
+// Halfway on each axis
+#define JS_RESTING_PLACE 16384
+// Largest axis value DroidPad sends
+#define JS_MAX_VALUE 32767
+
+#ifdef USE_HARDCODED_HID_REPORT_DESCRIPTOR 
+
+CONST  HID_REPORT_DESCRIPTOR       G_DefaultReportDescriptor[79] = {
+    0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
+    0x15, 0x00,                    // LOGICAL_MINIMUM (0)
+    0x09, 0x04,                    // USAGE (Joystick)
+    0xa1, 0x01,                    // COLLECTION (Application)
+    0x05, 0x01,                    //   USAGE_PAGE (Generic Desktop)
+    0x09, 0x01,                    //   USAGE (Pointer)
+    0x15, 0x00, 	               //   LOGICAL_MINIMUM (0)
+    0x26, 0xff, 0x7f,              //   LOGICAL_MAXIMUM (32767)
+    0x75, 0x20,                    //   REPORT_SIZE (32)
+    0x95, 0x01,                    //   REPORT_COUNT (1)
+    0xa1, 0x00,                    //   COLLECTION (Physical)
+    0x09, 0x30,                    //     USAGE (X)
+    0x81, 0x02,                    //     INPUT (Data,Var,Abs) -- CHANGED TO SEQUENTIAL
+    0x09, 0x31,                    //     USAGE (Y)
+    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
+    0x09, 0x32,                    //     USAGE (Rx)
+    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
+    0x09, 0x33,                    //     USAGE (Ry)
+    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
+    0x09, 0x34,                    //     USAGE (Slider)
+    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
+    0x09, 0x35,                    //     USAGE (Dial)
+    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
+    0x81, 0x01,                    //     INPUT (Cnst,Ary,Abs)
+    0x81, 0x01,                    //     INPUT (Cnst,Ary,Abs)
+    0xc0,                          //   END_COLLECTION
+    0x05, 0x09,                    //   USAGE_PAGE (Button)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x25, 0x01,                    //   LOGICAL_MAXIMUM (1)
+    0x75, 0x01,                    //   REPORT_SIZE (1)
+    0x55, 0x00,                    //   UNIT_EXPONENT (0)
+    0x65, 0x00,                    //   UNIT (None)
+    0x19, 0x01,                    //   USAGE_MINIMUM (Button 1)
+    0x29, 0x0c,                    //   USAGE_MAXIMUM (Button 12)
+    0x95, 0x0c,                    //   REPORT_COUNT (12)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+    0x95, 0x01,                    //   REPORT_COUNT (1)
+    0x75, 0x14,                    //   REPORT_SIZE (20)
+    0x81, 0x01,                    //   INPUT (Cnst,Ary,Abs)
+    0xc0                           // END_COLLECTION
+};
+
+//
+// This is the default HID descriptor returned by the mini driver
+// in response to IOCTL_HID_GET_DEVICE_DESCRIPTOR. The size
+// of report descriptor is currently the size of G_DefaultReportDescriptor.
+//
+CONST HID_DESCRIPTOR G_DefaultHidDescriptor = {
+    0x09,   // length of HID descriptor
+    0x21,   // descriptor type == HID  0x21
+    0x0100, // hid spec release
+    0x00,   // country code == Not Specified
+    0x01,   // number of HID class descriptors
+    { { 0x22,   // descriptor type 
+    sizeof(G_DefaultReportDescriptor) } }  // total length of report descriptor
+};
+
+#endif  // USE_HARDCODED_HID_REPORT_DESCRIPTOR
+
+#include <pshpack1.h>
+typedef struct _HID_INPUT_REPORT {
+	union {
+		struct {
+			LONG	axisX;
+			LONG	axisY;
+			LONG	axisZ;
+			LONG	axisRX;
+			LONG	axisRY;
+			LONG	axisRZ;
+			LONG	_u1; // Unused
+			LONG	_u2;
+			USHORT	buttons;	// 16 Buttons (12 used)
+			USHORT	hats;		// 4 bits per hat switch; not sent in the original report
+		} inputs;
+		UCHAR raw[36];
+	};
+} HID_INPUT_REPORT, *PHID_INPUT_REPORT;
+
+//
+// The compact report: the same six axes and 16 buttons as HID_INPUT_REPORT,
+// but with 16 bit axes (DroidPad's values never go above 32767) and none of
+// the padding, so 14 bytes instead of 36.
+//
+typedef struct _COMPACT_HID_INPUT_REPORT {
+	USHORT	axisX;
+	USHORT	axisY;
+	USHORT	axisZ;
+	USHORT	axisRX;
+	USHORT	axisRY;
+	USHORT	axisRZ;
+	USHORT	buttons;
+} COMPACT_HID_INPUT_REPORT, *PCOMPACT_HID_INPUT_REPORT;
+#include <poppack.h>
+
+C_ASSERT(sizeof(COMPACT_HID_INPUT_REPORT) == 14);
+
+
+//
+// Shape of the report a device sends, and the HID descriptors that describe
+// it. Either the original hand-written 36 byte report, or one generated at
+// dpEvtDeviceAdd from a REPORT_SPEC read from the registry.
+//
+#define MAX_REPORT_AXES			6	// X, Y, Z, Rx, Ry, Rz, in that order
+#define MAX_REPORT_BUTTONS		16
+#define MAX_REPORT_HATS			4
+#define MAX_REPORT_DESCRIPTOR_LENGTH	128
+
+typedef enum _REPORT_LAYOUT_TYPE {
+    ReportLayoutLegacy = 0,	// G_DefaultReportDescriptor
+    ReportLayoutCustom = 1,	// Built from the ReportAxes, ReportAxisBits, ReportButtons and ReportHats values
+    ReportLayoutCompact = 2	// COMPACT_HID_INPUT_REPORT
+} REPORT_LAYOUT_TYPE;
+
+typedef struct _REPORT_SPEC {
+    ULONG Axes;			// 0 to MAX_REPORT_AXES
+    ULONG AxisBits;		// 8, 16 or 32
+    ULONG Buttons;		// 0 to MAX_REPORT_BUTTONS
+    ULONG Hats;			// 0 to MAX_REPORT_HATS
+} REPORT_SPEC, *PREPORT_SPEC;
+
+typedef struct _REPORT_LAYOUT {
+    REPORT_LAYOUT_TYPE Type;
+    REPORT_SPEC    Spec;
+    ULONG          ButtonBitOffset;	// Axes start at bit 0
+    ULONG          HatBitOffset;
+    ULONG          ReportLength;	// Bytes returned by IOCTL_HID_READ_REPORT
+    HID_DESCRIPTOR HidDescriptor;
+    ULONG          ReportDescriptorLength;
+    HID_REPORT_DESCRIPTOR ReportDescriptor[MAX_REPORT_DESCRIPTOR_LENGTH];
+} REPORT_LAYOUT, *PREPORT_LAYOUT;
+
+//
+// An AXIS_CALIBRATION turned into the form it's applied in: fixed point
+// scales instead of divisions, and the curve as a lookup table, which is
+// interpolated between its points. Values are measured from centre on a
+// 0 to JS_MAX_VALUE scale. Built by dpBuildAxisTransform.
+//
+#define AXIS_CURVE_SHIFT	7	// Bits of the value between two curve points
+#define AXIS_CURVE_POINTS	((JS_MAX_VALUE >> AXIS_CURVE_SHIFT) + 2)
+
+typedef struct _AXIS_TRANSFORM {
+    BOOLEAN  Enabled;
+    LONG     Centre;
+    ULONG    Scale[2];		// 16.16, for values below and above Centre
+    ULONG    Inner;		// Values up to here are centred
+    ULONG    Outer;		// Values from here on are fully deflected
+    ULONG    DeadzoneScale;	// 16.16, from Inner..Outer to the whole scale
+    USHORT   Curve[AXIS_CURVE_POINTS];
+} AXIS_TRANSFORM, *PAXIS_TRANSFORM;
+
+#define AXIS_TRANSFORM_COUNT	6
+
+//
+// Settings and state of one axis's smoothing filter. Value is in 24.8 fixed
+// point and Speed in units per second; both are only meaningful once
+// Primed, and Timestamp is when they were last updated (interrupt time).
+//
+typedef struct _AXIS_FILTER {
+    BOOLEAN  Enabled;
+    BOOLEAN  Primed;
+    ULONG    MinCutoff;		// 1/100 Hz
+    ULONG    Beta;
+    ULONG    SpeedCutoff;	// 1/100 Hz
+    LONG     Value;
+    LONG     Speed;
+    LONGLONG Timestamp;
+} AXIS_FILTER, *PAXIS_FILTER;
+
+//
+// The last few values of the axes, as reported, and when they arrived, so
+// reports can be built for the times in between (or a little after).
+//
+#define INPUT_HISTORY_SIZE	4
+
+// Samples further apart than this are a jump, not a movement to smooth over
+#define INTERPOLATE_MAX_GAP	(250 * 10000)
+
+typedef struct _INPUT_SAMPLE {
+    LONGLONG Timestamp;		// Interrupt time
+    LONG     Axes[AXIS_TRANSFORM_COUNT];
+} INPUT_SAMPLE, *PINPUT_SAMPLE;
+
+typedef struct _INPUT_HISTORY {
+    ULONG    Count;
+    ULONG    Latest;		// Index of the newest sample
+    INPUT_SAMPLE Samples[INPUT_HISTORY_SIZE];
+} INPUT_HISTORY, *PINPUT_HISTORY;
+
+//
+// Frames sent with a sender timestamp, held until it's time to apply them so
+// they're applied as evenly spaced as they were sampled. Each frame is played
+// out at its timestamp plus the smallest recent transit time (arrival minus
+// sender timestamp, which also takes up the difference between the clocks)
+// plus a playout delay that follows the jitter in the transit time, up to
+// MaxDelay. Times are in interrupt time units. See jitter.c.
+//
+#define JITTER_BUFFER_SIZE	16
+
+typedef struct _JITTER_FRAME {
+    LONGLONG   PlayoutTime;
+    INPUT_DATA Data;
+} JITTER_FRAME, *PJITTER_FRAME;
+
+typedef struct _JITTER_BUFFER {
+    LONGLONG   MaxDelay;	// 0 if frames are applied as they arrive
+    BOOLEAN    Primed;
+    LONGLONG   BaseTransit;
+    LONGLONG   LastTransit;
+    LONGLONG   Jitter16;	// Mean transit time deviation, times 16
+    LONGLONG   Delay;
+    LONGLONG   LastTimestamp;	// Newest sender timestamp accepted
+    LONGLONG   LastPlayoutTime;
+    ULONG      Head;
+    ULONG      Count;
+    JITTER_FRAME Frames[JITTER_BUFFER_SIZE];
+} JITTER_BUFFER, *PJITTER_BUFFER;
+
+//
+// A checked REMAP_CONFIG, widened so the mix is plain 32 bit arithmetic over
+// fixed size arrays. ButtonAxis is REMAP_NO_AXIS for buttons no axis
+// presses. See remap.c.
+//
+typedef struct _REMAP {
+    BOOLEAN  Enabled;
+    LONG     Matrix[AXIS_TRANSFORM_COUNT][AXIS_TRANSFORM_COUNT];
+    ULONG    AxisButtonsHigh[AXIS_TRANSFORM_COUNT];
+    ULONG    AxisButtonsLow[AXIS_TRANSFORM_COUNT];
+    ULONG    ButtonPassMask;
+    ULONG    ButtonAxis[16];
+    LONG     ButtonThreshold[16];
+} REMAP, *PREMAP;
+
+//
+// Turbo buttons and macros, worked out against the time each report is
+// built. NextEdge is when the buttons it reports next change, so the report
+// path knows when a report is due even though the input hasn't changed.
+// Times are in interrupt time units. See turbo.c.
+//
+#define BUTTON_COUNT		16
+#define NO_BUTTON_EDGE		MAXLONGLONG
+
+typedef struct _BUTTON_ENGINE {
+    ULONG      TurboButtons;		// Buttons with a turbo period
+    ULONG      Held;			// Of those, the ones held as of the last input
+    LONGLONG   TurboHalfPeriod[BUTTON_COUNT];
+    LONGLONG   PressTime[BUTTON_COUNT];
+    ULONG      MacroSteps;		// 0 if no macro is running
+    LONGLONG   MacroStart;
+    USHORT     MacroButtons[MACRO_MAX_STEPS];
+    LONGLONG   MacroStepEnd[MACRO_MAX_STEPS];	// From MacroStart
+    LONGLONG   NextEdge;
+} BUTTON_ENGINE, *PBUTTON_ENGINE;
+
+//
+// Input state handed from the input sources to the report path. Like the
+// rest of the REPORT_PIPELINE it is only touched under the driver's
+// RingLock: input IOCTLs, the shared page poll and settling steps on the
+// report timer all publish, and reads copy it out. Sequence moves on with
+// each report published, so the report path can tell whether anything has
+// changed since it last looked. It may be read without the lock where a
+// stale value only costs a timer tick.
+//
+typedef struct _REPORT_STATE {
+    volatile LONG    Sequence;
+    HID_INPUT_REPORT Report;
+} REPORT_STATE, *PREPORT_STATE;
+
+//
+// Reports waiting to be read, oldest first, so that a button pressed and
+// released between two reads still shows up as two reports. When it fills
+// up, updates that only move axes are merged into their neighbours; button
+// changes are never dropped.
+//
+#define REPORT_RING_SIZE	32
+
+typedef struct _REPORT_RING_ENTRY {
+    LONGLONG         Timestamp;	// KeQueryInterruptTime() when the input arrived
+    HID_INPUT_REPORT Report;
+} REPORT_RING_ENTRY, *PREPORT_RING_ENTRY;
+
+typedef struct _REPORT_RING {
+    ULONG             Head;		// Index of the oldest entry
+    ULONG             Count;
+    REPORT_RING_ENTRY Entries[REPORT_RING_SIZE];
+} REPORT_RING, *PREPORT_RING;
+
+//
+// Input and reports captured for IOCTL_DP_READ_CAPTURE, oldest first. When
+// it fills up new records are dropped, and counted against the next one
+// kept. See capture.c.
+//
+#define CAPTURE_RING_SIZE	1024
+
+typedef struct _CAPTURE_RING {
+    ULONG          Head;		// Index of the oldest record
+    ULONG          Count;
+    ULONG          Dropped;		// Since the newest record
+    CAPTURE_RECORD Records[CAPTURE_RING_SIZE];
+} CAPTURE_RING, *PCAPTURE_RING;
+
+//
+// One CPU's share of the binary trace, see trace.c. Writers take slots with
+// an interlocked increment of Head and never wait; the one reader follows
+// behind from Tail, and once writers lap it the oldest records are lost.
+//
+#define DP_TRACE_RING_SIZE	256	// Must be a power of 2
+
+typedef struct _DP_TRACE_RING {
+    volatile LONG   Head;		// Slots taken by writers
+    ULONG           Tail;		// Next slot for the reader
+    ULONG           Lost;		// Not yet reported to the reader
+    UCHAR           Cpu;
+    UCHAR           Reserved[3];	// Keeps Records aligned; they are packed
+    DP_TRACE_RECORD Records[DP_TRACE_RING_SIZE];
+} DP_TRACE_RING, *PDP_TRACE_RING;
+C_ASSERT(FIELD_OFFSET(DP_TRACE_RING, Records) % sizeof(LONGLONG) == 0);
+
+//
+// Counts of values in power of 2 buckets, as described by
+// DP_HISTOGRAM_BUCKETS in defs.h. Buckets are incremented with interlocked
+// operations, so any number of callers can add to one without a lock.
+//
+typedef struct _DP_HISTOGRAM {
+    volatile LONG Buckets[DP_HISTOGRAM_BUCKETS];
+} DP_HISTOGRAM, *PDP_HISTOGRAM;
+
+//
+// Everything input goes through on its way into a report, from the last
+// frame received to the reports waiting to be sent. Not locked itself: the
+// driver holds DEVICE_EXTENSION.RingLock around every call that takes one.
+// See pipeline.c.
+//
+typedef struct _REPORT_PIPELINE {
+
+    // Last report submitted by any input source, published to the report
+    // path through State.
+    HID_INPUT_REPORT inputs;
+
+    // Last full frame of input, which partial updates are applied to.
+    INPUT_DATA lastInput;
+
+    // Last report published, read by the report path.
+    REPORT_STATE State;
+
+    // Smoothing and then calibration of each axis, applied as input is
+    // merged into a report.
+    AXIS_FILTER    Filters[AXIS_TRANSFORM_COUNT];
+    AXIS_TRANSFORM Transforms[AXIS_TRANSFORM_COUNT];
+
+    //
+    // If either is set, reports built from the current state have their axes
+    // worked out from History for InterpolateDelay ago, carrying the last
+    // movement on for up to ExtrapolateLimit past the newest sample. Both are
+    // in interrupt time units.
+    //
+    LONGLONG   InterpolateDelay;
+    LONGLONG   ExtrapolateLimit;
+    INPUT_HISTORY History;
+
+    // Mixing of the calibrated axes and buttons into the reported ones.
+    REMAP      Remap;
+
+    // Timed input waiting to be applied.
+    JITTER_BUFFER Jitter;
+
+    // Turbo and macro buttons.
+    BUTTON_ENGINE Buttons;
+
+    // Reports not yet delivered to a read.
+    REPORT_RING  Ring;
+
+    // When the input in the last report taken from Ring arrived.
+    LONGLONG     LastArrival;
+
+    // Where input and reports are captured to, or NULL if capture is off.
+    PCAPTURE_RING Capture;
+
+} REPORT_PIPELINE, *PREPORT_PIPELINE;
+
+//
+// core routine declarations
+//
+
+VOID copyHidReport(
+    IN PHID_INPUT_REPORT from,
+    OUT PHID_INPUT_REPORT to);
+
+VOID
+copyInputData(
+    IN PINPUT_DATA from,
+    OUT PHID_INPUT_REPORT to
+     );
+VOID
+resetHidReport(
+				OUT PHID_INPUT_REPORT report
+			  );
+VOID
+resetInputData(
+				OUT PINPUT_DATA data
+			  );
+
+VOID
+copyCompactReport(
+    IN PHID_INPUT_REPORT          from,
+    OUT PCOMPACT_HID_INPUT_REPORT to
+    );
+
+VOID
+dpLegacyReportLayout(
+    OUT PREPORT_LAYOUT Layout
+    );
+
+VOID
+dpCompactReportLayout(
+    OUT PREPORT_LAYOUT Layout
+    );
+
+NTSTATUS
+dpBuildReportLayout(
+    IN PREPORT_SPEC    Spec,
+    OUT PREPORT_LAYOUT Layout
+    );
+
+VOID
+dpPackReport(
+    IN PREPORT_LAYOUT    Layout,
+    IN PHID_INPUT_REPORT Report,
+    OUT PUCHAR           Buffer
+    );
+
+NTSTATUS
+dpDecodeInputUpdate(
+    IN PINPUT_UPDATE   Update,
+    IN size_t          Size,
+    IN OUT PINPUT_DATA Data
+    );
+
+VOID
+dpPublishReport(
+    IN OUT PREPORT_STATE State,
+    IN PHID_INPUT_REPORT Report
+    );
+
+VOID
+dpReadReport(
+    IN PREPORT_STATE State,
+    OUT PHID_INPUT_REPORT Report
+    );
+
+BOOLEAN
+dpBuildAxisTransform(
+    IN PAXIS_CALIBRATION Calibration,
+    OUT PAXIS_TRANSFORM  Transform
+    );
+
+BOOLEAN
+dpCheckAxisFilter(
+    IN PAXIS_FILTER_CONFIG Config
+    );
+
+VOID
+dpInitAxisFilter(
+    IN PAXIS_FILTER_CONFIG Config,
+    OUT PAXIS_FILTER       Filter
+    );
+
+VOID
+dpFilterAxes(
+    IN OUT PAXIS_FILTER      Filters,
+    IN OUT PHID_INPUT_REPORT Report,
+    IN LONGLONG              Timestamp
+    );
+
+BOOLEAN
+dpAxisFiltersSettled(
+    IN PAXIS_FILTER      Filters,
+    IN PHID_INPUT_REPORT Raw
+    );
+
+BOOLEAN
+dpSettleAxisFilters(
+    IN OUT PAXIS_FILTER      Filters,
+    IN OUT PHID_INPUT_REPORT Report,
+    IN LONGLONG              Timestamp
+    );
+
+VOID
+dpRecordSample(
+    IN OUT PINPUT_HISTORY History,
+    IN PHID_INPUT_REPORT  Report,
+    IN LONGLONG           Timestamp
+    );
+
+BOOLEAN
+dpInterpolationActive(
+    IN PINPUT_HISTORY History,
+    IN LONGLONG       RenderTime,
+    IN LONGLONG       ExtrapolateLimit
+    );
+
+VOID
+dpInterpolateAxes(
+    IN PINPUT_HISTORY        History,
+    IN LONGLONG              RenderTime,
+    IN LONGLONG              ExtrapolateLimit,
+    IN OUT PHID_INPUT_REPORT Report
+    );
+
+VOID
+dpTransformAxes(
+    IN PAXIS_TRANSFORM       Transforms,
+    IN OUT PHID_INPUT_REPORT Report
+    );
+
+BOOLEAN
+dpJitterPush(
+    IN OUT PJITTER_BUFFER Buffer,
+    IN PINPUT_DATA        Data,
+    IN LONGLONG           Timestamp,
+    IN LONGLONG           Arrival
+    );
+
+PJITTER_FRAME
+dpJitterPeek(
+    IN PJITTER_BUFFER Buffer,
+    IN LONGLONG       Now
+    );
+
+VOID
+dpJitterDrop(
+    IN OUT PJITTER_BUFFER Buffer
+    );
+
+BOOLEAN
+dpBuildRemap(
+    IN PREMAP_CONFIG Config,
+    OUT PREMAP       Remap
+    );
+
+VOID
+dpRemapReport(
+    IN PREMAP                Remap,
+    IN OUT PHID_INPUT_REPORT Report
+    );
+
+VOID
+dpButtonEngineSetTurbo(
+    IN OUT PBUTTON_ENGINE Engine,
+    IN PTURBO_CONFIG      Config,
+    IN ULONG              Buttons,
+    IN LONGLONG           Now
+    );
+
+VOID
+dpButtonEngineRunMacro(
+    IN OUT PBUTTON_ENGINE Engine,
+    IN PMACRO             Macro,
+    IN LONGLONG           Now
+    );
+
+VOID
+dpButtonEngineInput(
+    IN OUT PBUTTON_ENGINE Engine,
+    IN ULONG              Buttons,
+    IN LONGLONG           Timestamp
+    );
+
+ULONG
+dpButtonEngineApply(
+    IN OUT PBUTTON_ENGINE Engine,
+    IN ULONG              Buttons,
+    IN LONGLONG           Now
+    );
+
+VOID
+dpInitPipeline(
+    OUT PREPORT_PIPELINE Pipeline
+    );
+
+BOOLEAN
+dpApplyPadSettings(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN PPAD_SETTINGS        Settings,
+    IN LONGLONG             Now
+    );
+
+NTSTATUS
+dpPipelineSubmit(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN PINPUT_DATA          Data,
+    IN LONGLONG             Timestamp
+    );
+
+NTSTATUS
+dpPipelineSubmitTimed(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN PTIMED_INPUT_DATA    Input,
+    IN LONGLONG             Arrival
+    );
+
+BOOLEAN
+dpPipelineNext(
+    IN OUT PREPORT_PIPELINE Pipeline,
+    IN LONGLONG             Now,
+    OUT PHID_INPUT_REPORT   Report
+    );
+
+BOOLEAN
+dpPipelineInterpolating(
+    IN PREPORT_PIPELINE Pipeline,
+    IN LONGLONG         Now
+    );
+
+BOOLEAN
+dpPipelineSettling(
+    IN PREPORT_PIPELINE Pipeline
+    );
+
+BOOLEAN
+dpPipelineReportDue(
+    IN PREPORT_PIPELINE Pipeline,
+    IN LONG             Sequence,
+    IN LONGLONG         Now
+    );
+
+VOID
+dpCaptureRecord(
+    IN OUT PCAPTURE_RING Ring,
+    IN USHORT            Type,
+    IN LONGLONG          Timestamp,
+    IN PINPUT_DATA       Data
+    );
+
+VOID
+dpCaptureReport(
+    IN OUT PCAPTURE_RING Ring,
+    IN LONGLONG          Timestamp,
+    IN PHID_INPUT_REPORT Report
+    );
+
+ULONG
+dpCaptureDrain(
+    IN OUT PCAPTURE_RING Ring,
+    OUT PCAPTURE_RECORD  Records,
+    IN ULONG             MaxRecords
+    );
+
+VOID
+dpInitTraceRing(
+    OUT PDP_TRACE_RING Ring,
+    IN UCHAR           Cpu
+    );
+
+VOID
+dpTraceWrite(
+    IN OUT PDP_TRACE_RING Ring,
+    IN USHORT             Message,
+    IN LONGLONG           Timestamp,
+    IN ULONG              Arg0,
+    IN ULONG              Arg1,
+    IN ULONG              Arg2
+    );
+
+ULONG
+dpTraceDrain(
+    IN OUT PDP_TRACE_RING Ring,
+    OUT PDP_TRACE_RECORD  Records,
+    IN ULONG              MaxRecords
+    );
+
+ULONG
+dpHistogramBucket(
+    IN ULONG Value
+    );
+
+VOID
+dpHistogramAdd(
+    IN OUT PDP_HISTOGRAM Histogram,
+    IN ULONG             Value
+    );
+
+VOID
+dpHistogramRead(
+    IN PDP_HISTOGRAM Histogram,
+    OUT PULONG       Buckets
+    );
+
+ULONG
+dpHistogramPercentile(
+    IN PULONG Buckets,
+    IN ULONG  Percent
+    );
+
+#endif   //_DROIDPAD_CORE_H_
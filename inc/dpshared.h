@@ -0,0 +1,103 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dpshared.h
+
+Abstract:
+
+    Both sides of the shared input page's protocol (see SHARED_INPUT in
+    defs.h): the client publishing frames with plain memory writes, and the
+    driver picking up the newest settled one. There is one writer per page.
+    linux/dpshared.c runs both sides against each other.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_SHARED_H_
+
+#define _DROIDPAD_SHARED_H_
+
+// How many times the reader tries to read the page before giving up until
+// the next report, if the client keeps writing to it.
+#define SHARED_INPUT_MAX_TRIES		4
+
+static __forceinline VOID
+dpSharedInputPublish(
+    IN OUT PSHARED_INPUT Shared,
+    IN PINPUT_DATA       Data
+    )
+/**
+ * The client's side: writes a frame to the page. The sequence is odd while
+ * slots[0] is being written, so the reader knows to leave it.
+ */
+{
+	InterlockedIncrement(&Shared->sequence);
+	RtlCopyMemory((PVOID) &Shared->slots[0], Data, sizeof(INPUT_DATA));
+	InterlockedIncrement(&Shared->sequence);
+	RtlCopyMemory((PVOID) &Shared->slots[1], Data, sizeof(INPUT_DATA));
+}
+
+static __forceinline BOOLEAN
+dpSharedInputRead(
+    IN PSHARED_INPUT Shared,
+    IN LONG          Last,
+    OUT PINPUT_DATA  Data,
+    OUT PLONG        Sequence
+    )
+/**
+ * The driver's side: copies out the frame on the page if it was written
+ * after the one at sequence Last, and sets Sequence to its sequence.
+ * Returns FALSE if there's no new frame, or if one was being written on
+ * every try; it's picked up by a later call.
+ */
+{
+	LONG sequence;
+	ULONG tries;
+
+	// The page is written by the client, so don't trust it to ever settle
+	for (tries = 0; tries < SHARED_INPUT_MAX_TRIES; tries++) {
+		sequence = Shared->sequence;
+		if (sequence == Last || (sequence & 1))
+			return FALSE;
+
+		KeMemoryBarrier();
+		RtlCopyMemory(Data, (PVOID) &Shared->slots[0], sizeof(INPUT_DATA));
+		KeMemoryBarrier();
+
+		if (sequence == Shared->sequence) {
+			*Sequence = sequence;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+#endif   //_DROIDPAD_SHARED_H_
@@ -0,0 +1,73 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dptrace.h
+
+Abstract:
+
+    The messages the driver writes to its binary trace ring. The driver
+    records a message's index, the time and up to three ULONG arguments,
+    and leaves formatting to whoever reads the ring (linux/dptrace.c), so
+    tracing costs a few stores rather than a printf.
+
+    Each entry gives the name, the TRACE_LEVEL_* it's logged at and the
+    format, whose arguments may only be %u, %d or %x conversions. Add new
+    messages to the end, so older logs still decode.
+
+Author:
+
+
+Environment:
+
+    kernel mode, or user mode with DP_PORTABLE
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_TRACE_H_
+
+#define _DROIDPAD_TRACE_H_
+
+#define DP_TRACE_MESSAGES(MESSAGE) \
+	MESSAGE(DPT_LOST,		TRACE_LEVEL_WARNING,	"%u trace records lost\n") \
+	MESSAGE(DPT_INTERNAL_IOCTL,	TRACE_LEVEL_VERBOSE,	"HID internal IOCTL 0x%x\n") \
+	MESSAGE(DPT_INPUT_REJECTED,	TRACE_LEVEL_WARNING,	"Report ring full of button changes, rejecting input for pad %u\n") \
+	MESSAGE(DPT_INVALID_BATCH,	TRACE_LEVEL_ERROR,	"Invalid input batch of %u frames (%u bytes)\n") \
+	MESSAGE(DPT_INVALID_CALIBRATION, TRACE_LEVEL_ERROR,	"Invalid calibration for axis %u\n") \
+	MESSAGE(DPT_INVALID_FILTER,	TRACE_LEVEL_ERROR,	"Invalid filter for axis %u\n") \
+	MESSAGE(DPT_INVALID_REMAP,	TRACE_LEVEL_ERROR,	"Invalid remapping\n") \
+	MESSAGE(DPT_READ_COMPLETED,	TRACE_LEVEL_VERBOSE,	"Completed read for pad %u with state %u\n") \
+	MESSAGE(DPT_READ_BUFFER_FAILED,	TRACE_LEVEL_ERROR,	"WdfRequestRetrieveOutputBuffer failed with status: 0x%x\n") \
+	MESSAGE(DPT_READ_RETRIEVE_FAILED, TRACE_LEVEL_ERROR,	"WdfIoQueueRetrieveNextRequest status %08x\n")
+
+#define DP_TRACE_MESSAGE_ID(Name, Level, Format)	Name,
+
+typedef enum _DP_TRACE_MESSAGE {
+	DP_TRACE_MESSAGES(DP_TRACE_MESSAGE_ID)
+	DP_TRACE_MESSAGE_COUNT
+} DP_TRACE_MESSAGE;
+
+#undef DP_TRACE_MESSAGE_ID
+
+#endif   //_DROIDPAD_TRACE_H_
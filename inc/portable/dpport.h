@@ -0,0 +1,133 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dpport.h
+
+Abstract:
+
+    The DDK types and routines dpcore.h and the core library use, for
+    building them with a compiler other than the WDK's (GCC or Clang on
+    Linux, or a user mode MSVC build). Included by dpcore.h when DP_PORTABLE
+    is defined. This directory also stands in for pshpack1.h and poppack.h,
+    so it must be on the include path.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Notes:
+
+    The interlocked routines and barriers use the GCC/Clang __atomic
+    builtins. Only what the core uses is defined here; anything else the
+    core starts to use has to be added.
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_PORT_H_
+
+#define _DROIDPAD_PORT_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+typedef void VOID, *PVOID;
+typedef char CHAR, *PCHAR;
+typedef unsigned char UCHAR, *PUCHAR;
+typedef short SHORT, *PSHORT;
+typedef unsigned short USHORT, *PUSHORT;
+typedef int LONG, *PLONG;
+typedef unsigned int ULONG, *PULONG;
+typedef long long LONGLONG, *PLONGLONG;
+typedef unsigned long long ULONGLONG, *PULONGLONG;
+typedef UCHAR BOOLEAN, *PBOOLEAN;
+typedef LONG NTSTATUS;
+
+#define IN
+#define OUT
+#define CONST				const
+#define __forceinline			inline __attribute__((always_inline))
+#define TRUE				1
+#define FALSE				0
+#define MAXLONG				0x7fffffff
+#define MAXULONG			0xffffffff
+#define MAXLONGLONG			0x7fffffffffffffffLL
+
+#define STATUS_SUCCESS			((NTSTATUS) 0x00000000L)
+#define STATUS_INVALID_PARAMETER	((NTSTATUS) 0xC000000DL)
+#define STATUS_DEVICE_BUSY		((NTSTATUS) 0x80000011L)
+#define NT_SUCCESS(Status)		(((NTSTATUS) (Status)) >= 0)
+
+// From evntrace.h, for the levels in dptrace.h
+#define TRACE_LEVEL_NONE		0
+#define TRACE_LEVEL_CRITICAL		1
+#define TRACE_LEVEL_ERROR		2
+#define TRACE_LEVEL_WARNING		3
+#define TRACE_LEVEL_INFORMATION		4
+#define TRACE_LEVEL_VERBOSE		5
+
+#define FIELD_OFFSET(type, field)	((LONG) offsetof(type, field))
+#define C_ASSERT(e)			typedef char __C_ASSERT__[(e) ? 1 : -1]
+#if DBG
+#define ASSERT(e)			assert(e)
+#else
+#define ASSERT(e)			((void) 0)
+#endif
+#define UNREFERENCED_PARAMETER(P)	((void) (P))
+#define PAGED_CODE()
+
+#ifndef min
+#define min(a, b)			(((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b)			(((a) > (b)) ? (a) : (b))
+#endif
+
+#define RtlZeroMemory(Destination, Length)		memset((Destination), 0, (Length))
+#define RtlCopyMemory(Destination, Source, Length)	memcpy((Destination), (Source), (Length))
+#define RtlEqualMemory(Destination, Source, Length)	(!memcmp((Destination), (Source), (Length)))
+
+#define InterlockedIncrement(Addend)	__atomic_add_fetch((Addend), 1, __ATOMIC_SEQ_CST)
+#define KeMemoryBarrier()		__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#pragma pack(push, 1)
+typedef struct _HID_DESCRIPTOR {
+    UCHAR   bLength;
+    UCHAR   bDescriptorType;
+    USHORT  bcdHID;
+    UCHAR   bCountry;
+    UCHAR   bNumDescriptors;
+    struct _HID_DESCRIPTOR_DESC_LIST {
+       UCHAR   bReportType;
+       USHORT  wReportLength;
+    } DescriptorList [1];
+} HID_DESCRIPTOR, *PHID_DESCRIPTOR;
+#pragma pack(pop)
+
+#endif   //_DROIDPAD_PORT_H_
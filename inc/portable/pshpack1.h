@@ -0,0 +1,4 @@
+/*
+ * Stand-in for the DDK's pshpack1.h in builds with DP_PORTABLE. See dpport.h.
+ */
+#pragma pack(push, 1)
@@ -0,0 +1,538 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dpbench.c
+
+Abstract:
+
+    Benchmark of the path from input arriving to the HID read it's sent on.
+    Drives the core's report pipeline the way the driver does: a writer
+    submitting frames under a lock (IOCTL_DP_SEND_INPUT_DATA), HIDCLASS-like
+    readers that each keep a read parked and park another as soon as one
+    completes, and completion of the parked reads on new input
+    (CompleteOnInput) and on a fixed period timer. Reports are packed into
+    the legacy layout as they're completed.
+
+    Each frame carries its number in the Z and Rz axes, so the read that
+    delivers it can work out how long it took. Frames merged into newer
+    ones before being read are counted, but have no latency. Latency
+    percentiles, frames and reports per second and the process's CPU time
+    per frame are printed as JSON, or CSV for collecting many runs.
+
+    The driver's report timer backs off while the input is idle and the
+    benchmark's doesn't, so with CompleteOnInput off, latency is that of a
+    timer that stays at its shortest period. tests/padsim.c runs the
+    driver's own timer on the WDF shim, and counts how often it wakes up.
+
+    With -i the writer goes quiet for part of every 100ms, as a pad held
+    still does, so reads are held rather than completed unchanged. A read
+    is counted as suppressed once, when it is parked with no report due, as
+    the driver counts it; with -s, held reads are completed unchanged once
+    the last report is that old, and counted as timed out.
+
+    Build from the top of the tree with
+
+        cc -std=gnu99 -O2 -pthread -DDP_PORTABLE -Iinc -Iinc/portable \
+            -o dpbench linux/dpbench.c core/state.c core/pipeline.c \
+            core/pack.c core/layout.c core/calibrate.c core/filter.c \
+            core/interpolate.c core/jitter.c core/turbo.c core/remap.c \
+            core/capture.c
+
+    dpbench [-r rate] [-n readers] [-t millis] [-c 0|1] [-p 0|1] [-i percent]
+            [-s millis] [-d seconds] [-f json|csv] [-H]
+
+        -r  Frames per second from the writer, 0 for as fast as it can
+            (default 1000).
+        -n  Reads kept parked, 1 to 16 (default 2, as HIDCLASS does).
+        -t  Report timer period in milliseconds, 0 for no timer (default 2).
+        -c  CompleteOnInput (default 1).
+        -p  ReadPolicy: 0 completes every parked read on a tick, 1 just one
+            (default 0).
+        -i  Share of each 100ms with no input, 0 to 99 (default 0). Needs a
+            rate.
+        -s  MaxStaleMillis (default 0, hold unchanged reads for ever).
+        -d  How long to run for (default 5).
+        -f  Output format (default json). csv prints a header line first
+            unless -H is also given.
+        -H  Leave out the csv header line, for appending to a file.
+
+Author:
+
+
+Environment:
+
+    user mode, Linux
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_READERS		16
+
+// Frames numbers go in two 15 bit axes
+#define MAX_FRAMES		(1 << 24)
+#define FRAME_ID(report)	((ULONG) (report)->inputs.axisZ | ((ULONG) (report)->inputs.axisRZ << 15))
+
+typedef struct _BENCH_READER {
+    pthread_t  Thread;
+    ULONG      Index;
+    BOOLEAN    Completed;
+} BENCH_READER, *PBENCH_READER;
+
+typedef struct _BENCH {
+    // Settings
+    ULONG      Rate;
+    ULONG      Readers;
+    ULONG      TimerMillis;
+    BOOLEAN    CompleteOnInput;
+    BOOLEAN    Freshest;
+    ULONG      IdlePercent;
+    ULONG      MaxStaleMillis;
+    ULONG      Seconds;
+
+    // Stand-ins for RingLock and the device's pipeline and layout
+    pthread_mutex_t RingLock;
+    REPORT_PIPELINE Pipeline;
+    REPORT_LAYOUT   Layout;
+
+    // Stand-in for TimerMsgQueue: parked readers, oldest first
+    pthread_mutex_t QueueLock;
+    pthread_cond_t  Completion;
+    ULONG      Parked[MAX_READERS];
+    ULONG      ParkedHead;
+    ULONG      ParkedCount;
+    BENCH_READER ReaderState[MAX_READERS];
+
+    LONG       DeliveredSequence;
+    LONGLONG   DeliveredTime;
+    volatile int Stop;
+
+    // When each frame was submitted, and the latencies of the ones delivered.
+    // Both protected by QueueLock once the writer has started.
+    LONGLONG   *SubmitTimes;
+    LONGLONG   *Latencies;
+    ULONG      LatencyCount;
+    ULONG      NextUnseen;		// Frames before this have been delivered or merged
+    volatile ULONG Submitted;
+    ULONG      Rejected;
+    ULONG      Merged;
+    ULONG      ReportsDelivered;
+    ULONG      ReportsSuppressed;
+    ULONG      ReadsParked;
+    ULONG      ReadsTimedOut;
+} BENCH, *PBENCH;
+
+static BENCH bench;
+
+static LONGLONG
+interruptTime(
+    VOID
+    )
+/**
+ * The monotonic clock in the driver's units, 100ns.
+ */
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (LONGLONG) now.tv_sec * 10000000 + now.tv_nsec / 100;
+}
+
+static BOOLEAN
+takeParkedRead(
+    OUT PULONG Reader
+    )
+{
+	BOOLEAN found = FALSE;
+
+	pthread_mutex_lock(&bench.QueueLock);
+	if (bench.ParkedCount > 0) {
+		*Reader = bench.Parked[bench.ParkedHead];
+		bench.ParkedHead = (bench.ParkedHead + 1) % MAX_READERS;
+		bench.ParkedCount--;
+		found = TRUE;
+	}
+	pthread_mutex_unlock(&bench.QueueLock);
+	return found;
+}
+
+static VOID
+completeRead(
+    IN ULONG             Reader,
+    IN PHID_INPUT_REPORT Report,
+    IN LONGLONG          Now
+    )
+/**
+ * Hands a report to a parked reader, and works out the latency of the
+ * frame it carries if that frame hasn't been delivered before.
+ */
+{
+	ULONG id = FRAME_ID(Report);
+
+	pthread_mutex_lock(&bench.QueueLock);
+	bench.ReportsDelivered++;
+	if (id < bench.Submitted && id >= bench.NextUnseen) {
+		bench.Merged += id - bench.NextUnseen;
+		bench.Latencies[bench.LatencyCount++] = Now - bench.SubmitTimes[id];
+		bench.NextUnseen = id + 1;
+	}
+	bench.ReaderState[Reader].Completed = TRUE;
+	pthread_cond_broadcast(&bench.Completion);
+	pthread_mutex_unlock(&bench.QueueLock);
+}
+
+static BOOLEAN
+reportDue(
+    OUT PBOOLEAN Stale
+    )
+/**
+ * dpReportDue, without the shared input page.
+ */
+{
+	LONGLONG now = interruptTime();
+	BOOLEAN due;
+
+	*Stale = FALSE;
+	pthread_mutex_lock(&bench.RingLock);
+	due = dpPipelineReportDue(&bench.Pipeline, bench.DeliveredSequence, now);
+	pthread_mutex_unlock(&bench.RingLock);
+	if (due)
+		return TRUE;
+	if (bench.MaxStaleMillis != 0 && now - bench.DeliveredTime >= (LONGLONG) bench.MaxStaleMillis * 10000) {
+		*Stale = TRUE;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static VOID
+completeReadReport(
+    IN BOOLEAN DrainAll
+    )
+/**
+ * dpCompleteReadReport, with the reads parked in the benchmark's queue.
+ */
+{
+	HID_INPUT_REPORT report;
+	UCHAR buffer[sizeof(HID_INPUT_REPORT)];
+	LONG sequence;
+	ULONG reader, toComplete, completed;
+	LONGLONG now;
+	BOOLEAN stale;
+
+	if (!reportDue(&stale))
+		return;
+
+	pthread_mutex_lock(&bench.QueueLock);
+	toComplete = DrainAll ? bench.ParkedCount : 1;
+	pthread_mutex_unlock(&bench.QueueLock);
+	for (completed = 0; completed < toComplete && takeParkedRead(&reader); completed++) {
+		now = interruptTime();
+		pthread_mutex_lock(&bench.RingLock);
+		dpPipelineNext(&bench.Pipeline, now, &report);
+		sequence = bench.Pipeline.State.Sequence;
+		pthread_mutex_unlock(&bench.RingLock);
+		dpPackReport(&bench.Layout, &report, buffer);
+		bench.DeliveredSequence = sequence;
+		bench.DeliveredTime = now;
+
+		completeRead(reader, &report, interruptTime());
+		if (stale) {
+			pthread_mutex_lock(&bench.QueueLock);
+			bench.ReadsTimedOut++;
+			pthread_mutex_unlock(&bench.QueueLock);
+		}
+	}
+}
+
+static void *
+readerThread(
+    void *Context
+    )
+/**
+ * HIDCLASS's side: keeps one read parked, parking the next as soon as the
+ * last one completes.
+ */
+{
+	PBENCH_READER reader = Context;
+	BOOLEAN stale;
+
+	pthread_mutex_lock(&bench.QueueLock);
+	while (!bench.Stop) {
+		reader->Completed = FALSE;
+		bench.Parked[(bench.ParkedHead + bench.ParkedCount) % MAX_READERS] = reader->Index;
+		bench.ParkedCount++;
+		bench.ReadsParked++;
+		if (!reportDue(&stale))
+			bench.ReportsSuppressed++;
+		while (!reader->Completed && !bench.Stop)
+			pthread_cond_wait(&bench.Completion, &bench.QueueLock);
+	}
+	pthread_mutex_unlock(&bench.QueueLock);
+	return NULL;
+}
+
+static void *
+timerThread(
+    void *Context
+    )
+{
+	struct timespec due;
+
+	UNREFERENCED_PARAMETER(Context);
+	clock_gettime(CLOCK_MONOTONIC, &due);
+	while (!bench.Stop) {
+		due.tv_nsec += bench.TimerMillis * 1000000L;
+		while (due.tv_nsec >= 1000000000L) {
+			due.tv_nsec -= 1000000000L;
+			due.tv_sec++;
+		}
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+			;
+		completeReadReport(!bench.Freshest);
+	}
+	return NULL;
+}
+
+static VOID
+writeFrames(
+    VOID
+    )
+/**
+ * The control device's side: submits numbered frames at the set rate until
+ * the time is up. Every frame moves the axes; every 64th changes the
+ * buttons, as a real pad would now and then. Frames that would fall in
+ * the idle part of each 100ms aren't sent.
+ */
+{
+	INPUT_DATA data;
+	LONGLONG start, end, due, now;
+	ULONG id = 0, slot = 0, window = max(bench.Rate / 10, 1);
+	NTSTATUS status;
+	struct timespec wait;
+
+	resetInputData(&data);
+	start = interruptTime();
+	end = start + (LONGLONG) bench.Seconds * 10000000;
+	for (now = start; now < end && id < MAX_FRAMES; now = interruptTime()) {
+		if (bench.Rate != 0) {
+			due = start + (LONGLONG) slot * 10000000 / bench.Rate;
+			if (due > now) {
+				wait.tv_sec = (time_t) ((due - now) / 10000000);
+				wait.tv_nsec = (long) ((due - now) % 10000000) * 100;
+				nanosleep(&wait, NULL);
+				continue;
+			}
+			if ((slot % window) * 100 >= (100 - bench.IdlePercent) * window) {
+				slot++;
+				continue;
+			}
+		}
+
+		data.axisX = (LONG) ((id * 97) % (JS_MAX_VALUE + 1));
+		data.axisY = (LONG) ((id * 89) % (JS_MAX_VALUE + 1));
+		data.axisZ = (LONG) (id & 0x7FFF);
+		data.axisRZ = (LONG) (id >> 15);
+		data.buttons = (LONG) ((id / 64) & 1);
+
+		pthread_mutex_lock(&bench.QueueLock);
+		bench.SubmitTimes[id] = interruptTime();
+		bench.Submitted = id + 1;
+		pthread_mutex_unlock(&bench.QueueLock);
+
+		pthread_mutex_lock(&bench.RingLock);
+		status = dpPipelineSubmit(&bench.Pipeline, &data, bench.SubmitTimes[id]);
+		pthread_mutex_unlock(&bench.RingLock);
+		if (!NT_SUCCESS(status)) {
+			// The ring is full of button changes; try the same frame again
+			pthread_mutex_lock(&bench.QueueLock);
+			bench.Submitted = id;
+			bench.Rejected++;
+			pthread_mutex_unlock(&bench.QueueLock);
+			sched_yield();
+			continue;
+		}
+		id++;
+		slot++;
+
+		if (bench.CompleteOnInput)
+			completeReadReport(FALSE);
+	}
+}
+
+static int
+compareLonglong(
+    const void *a,
+    const void *b
+    )
+{
+	LONGLONG x = *(const LONGLONG *) a, y = *(const LONGLONG *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double
+percentileMicros(
+    IN double Fraction
+    )
+/**
+ * A percentile of the sorted latencies, in microseconds.
+ */
+{
+	ULONG i;
+
+	if (bench.LatencyCount == 0)
+		return 0;
+	i = (ULONG) (Fraction * bench.LatencyCount);
+	if (i >= bench.LatencyCount)
+		i = bench.LatencyCount - 1;
+	return bench.Latencies[i] / 10.0;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+	struct timespec cpuStart, cpuEnd, wallStart, wallEnd;
+	pthread_t timer;
+	BOOLEAN csv = FALSE, header = TRUE;
+	double seconds, cpuNanos, p50, p99, p999, worst;
+	int option;
+	ULONG i;
+
+	bench.Rate = 1000;
+	bench.Readers = 2;
+	bench.TimerMillis = 2;	// The driver's shortest period
+	bench.CompleteOnInput = TRUE;
+	bench.Seconds = 5;
+
+	while ((option = getopt(argc, argv, "r:n:t:c:p:i:s:d:f:H")) != -1) {
+		switch (option) {
+		case 'r': bench.Rate = strtoul(optarg, NULL, 0); break;
+		case 'n': bench.Readers = strtoul(optarg, NULL, 0); break;
+		case 't': bench.TimerMillis = strtoul(optarg, NULL, 0); break;
+		case 'c': bench.CompleteOnInput = strtoul(optarg, NULL, 0) != 0; break;
+		case 'p': bench.Freshest = strtoul(optarg, NULL, 0) != 0; break;
+		case 'i': bench.IdlePercent = strtoul(optarg, NULL, 0); break;
+		case 's': bench.MaxStaleMillis = strtoul(optarg, NULL, 0); break;
+		case 'd': bench.Seconds = strtoul(optarg, NULL, 0); break;
+		case 'f': csv = strcmp(optarg, "csv") == 0; break;
+		case 'H': header = FALSE; break;
+		default:
+			fprintf(stderr, "usage: %s [-r rate] [-n readers] [-t millis] [-c 0|1] [-p 0|1] [-i percent] [-s millis]\n"
+				"    [-d seconds] [-f json|csv] [-H]\n",
+				argv[0]);
+			return 2;
+		}
+	}
+	if (bench.Readers == 0 || bench.Readers > MAX_READERS || bench.Seconds == 0 ||
+		(bench.TimerMillis == 0 && !bench.CompleteOnInput) || bench.IdlePercent > 99 ||
+		(bench.IdlePercent != 0 && bench.Rate == 0)) {
+		fprintf(stderr, "Need 1 to %u readers, a duration, a timer or CompleteOnInput, and a rate for an idle share under 100\n",
+			MAX_READERS);
+		return 2;
+	}
+
+	bench.SubmitTimes = calloc(MAX_FRAMES, sizeof(LONGLONG));
+	bench.Latencies = calloc(MAX_FRAMES, sizeof(LONGLONG));
+	if (bench.SubmitTimes == NULL || bench.Latencies == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	pthread_mutex_init(&bench.RingLock, NULL);
+	pthread_mutex_init(&bench.QueueLock, NULL);
+	pthread_cond_init(&bench.Completion, NULL);
+	dpInitPipeline(&bench.Pipeline);
+	dpLegacyReportLayout(&bench.Layout);
+	bench.DeliveredSequence = -1;
+	bench.DeliveredTime = interruptTime();
+
+	for (i = 0; i < bench.Readers; i++) {
+		bench.ReaderState[i].Index = i;
+		pthread_create(&bench.ReaderState[i].Thread, NULL, readerThread, &bench.ReaderState[i]);
+	}
+	if (bench.TimerMillis != 0)
+		pthread_create(&timer, NULL, timerThread, NULL);
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuStart);
+	clock_gettime(CLOCK_MONOTONIC, &wallStart);
+	writeFrames();
+	clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuEnd);
+
+	pthread_mutex_lock(&bench.QueueLock);
+	bench.Stop = TRUE;
+	pthread_cond_broadcast(&bench.Completion);
+	pthread_mutex_unlock(&bench.QueueLock);
+	for (i = 0; i < bench.Readers; i++)
+		pthread_join(bench.ReaderState[i].Thread, NULL);
+	if (bench.TimerMillis != 0)
+		pthread_join(timer, NULL);
+
+	seconds = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+	cpuNanos = (cpuEnd.tv_sec - cpuStart.tv_sec) * 1e9 + (cpuEnd.tv_nsec - cpuStart.tv_nsec);
+	qsort(bench.Latencies, bench.LatencyCount, sizeof(LONGLONG), compareLonglong);
+	p50 = percentileMicros(0.5);
+	p99 = percentileMicros(0.99);
+	p999 = percentileMicros(0.999);
+	worst = bench.LatencyCount ? bench.Latencies[bench.LatencyCount - 1] / 10.0 : 0;
+
+	if (csv) {
+		if (header)
+			printf("rate,readers,timer_ms,complete_on_input,read_policy,idle_percent,max_stale_ms,seconds,frames,rejected,"
+				"delivered,merged,reports,parked,suppressed,timed_out,frames_per_sec,reports_per_sec,"
+				"p50_us,p99_us,p999_us,max_us,cpu_ns_per_frame\n");
+		printf("%u,%u,%u,%u,%u,%u,%u,%.3f,%u,%u,%u,%u,%u,%u,%u,%u,%.0f,%.0f,%.1f,%.1f,%.1f,%.1f,%.0f\n",
+			bench.Rate, bench.Readers, bench.TimerMillis, bench.CompleteOnInput, bench.Freshest,
+			bench.IdlePercent, bench.MaxStaleMillis, seconds,
+			bench.Submitted, bench.Rejected, bench.LatencyCount, bench.Merged, bench.ReportsDelivered,
+			bench.ReadsParked, bench.ReportsSuppressed, bench.ReadsTimedOut,
+			bench.Submitted / seconds, bench.ReportsDelivered / seconds,
+			p50, p99, p999, worst, bench.Submitted ? cpuNanos / bench.Submitted : 0);
+	} else {
+		printf("{\"rate\": %u, \"readers\": %u, \"timer_ms\": %u, \"complete_on_input\": %u, \"read_policy\": %u,\n"
+			" \"idle_percent\": %u, \"max_stale_ms\": %u,\n"
+			" \"seconds\": %.3f, \"frames\": %u, \"rejected\": %u, \"delivered\": %u, \"merged\": %u,\n"
+			" \"reports\": %u, \"parked\": %u, \"suppressed\": %u, \"timed_out\": %u,\n"
+			" \"frames_per_sec\": %.0f, \"reports_per_sec\": %.0f,\n"
+			" \"latency_us\": {\"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f},\n"
+			" \"cpu_ns_per_frame\": %.0f}\n",
+			bench.Rate, bench.Readers, bench.TimerMillis, bench.CompleteOnInput, bench.Freshest,
+			bench.IdlePercent, bench.MaxStaleMillis, seconds,
+			bench.Submitted, bench.Rejected, bench.LatencyCount, bench.Merged, bench.ReportsDelivered,
+			bench.ReadsParked, bench.ReportsSuppressed, bench.ReadsTimedOut,
+			bench.Submitted / seconds, bench.ReportsDelivered / seconds,
+			p50, p99, p999, worst, bench.Submitted ? cpuNanos / bench.Submitted : 0);
+	}
+	return 0;
+}
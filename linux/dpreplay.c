@@ -0,0 +1,284 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dpreplay.c
+
+Abstract:
+
+    Replays a capture log (see CAPTURE_RECORD in defs.h) through the core's
+    report pipeline. Each captured frame of input is submitted at its
+    timestamp and each captured report is built again at its own, and
+    compared with what was sent. Prints a summary with the longest gaps
+    between input frames and between reports, which is usually where
+    stutter shows.
+
+    The pipeline is set up with the pad settings in the log's header, so
+    calibration, filters, remapping, turbo buttons and interpolation all
+    apply as they did. Settings changed while capturing can't be followed;
+    reports after the first change may differ.
+
+    Input from before the capture started isn't in the log, so reports
+    until InterpolateDelayMillis after the first captured input, which are
+    made partly from it, aren't compared. Filters carry some of it a little
+    longer, so their axes may differ by a few units at the start.
+
+    The log is mapped rather than read, so even a long session is just a
+    walk through memory.
+
+    Build from the top of the tree with
+
+        cc -std=gnu99 -O2 -DDP_PORTABLE -Iinc -Iinc/portable \
+            -o dpreplay linux/dpreplay.c core/state.c core/pipeline.c \
+            core/pack.c core/layout.c core/calibrate.c core/filter.c \
+            core/interpolate.c core/jitter.c core/turbo.c core/remap.c \
+            core/capture.c
+
+    dpreplay [-r] [-i millis] [-e millis] [-v] log
+
+        -r  Replay in real time, rather than as fast as possible.
+        -i  InterpolateDelayMillis, instead of the one in the log.
+        -e  ExtrapolateMillis, instead of the one in the log.
+        -v  Print each report that differs.
+
+Author:
+
+
+Environment:
+
+    user mode, Linux
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct _REPLAY_GAP {
+    LONGLONG Length;
+    LONGLONG At;		// Since the first record
+} REPLAY_GAP;
+
+static BOOLEAN
+sameReport(
+    IN PINPUT_DATA A,
+    IN PINPUT_DATA B
+    )
+{
+	return A->axisX == B->axisX && A->axisY == B->axisY && A->axisZ == B->axisZ &&
+		A->axisRX == B->axisRX && A->axisRY == B->axisRY && A->axisRZ == B->axisRZ &&
+		A->buttons == B->buttons;
+}
+
+static VOID
+copyReportData(
+    IN PHID_INPUT_REPORT Report,
+    OUT PINPUT_DATA      Data
+    )
+/**
+ * Puts a report in the form it's captured in, as dpCaptureReport does.
+ */
+{
+	Data->axisX = Report->inputs.axisX;
+	Data->axisY = Report->inputs.axisY;
+	Data->axisZ = Report->inputs.axisZ;
+	Data->axisRX = Report->inputs.axisRX;
+	Data->axisRY = Report->inputs.axisRY;
+	Data->axisRZ = Report->inputs.axisRZ;
+	Data->buttons = (LONG) (Report->inputs.buttons | ((ULONG) Report->inputs.hats << 16));
+}
+
+static VOID
+waitUntil(
+    IN struct timespec *Start,
+    IN LONGLONG        Offset
+    )
+/**
+ * Sleeps until Offset (100ns units) after Start.
+ */
+{
+	struct timespec due = *Start;
+
+	due.tv_sec += (time_t) (Offset / 10000000);
+	due.tv_nsec += (long) (Offset % 10000000) * 100;
+	if (due.tv_nsec >= 1000000000L) {
+		due.tv_nsec -= 1000000000L;
+		due.tv_sec++;
+	}
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+}
+
+static VOID
+noteGap(
+    IN OUT REPLAY_GAP *Gap,
+    IN OUT LONGLONG   *Last,
+    IN LONGLONG       Timestamp,
+    IN LONGLONG       First
+    )
+{
+	if (*Last != 0 && Timestamp - *Last > Gap->Length) {
+		Gap->Length = Timestamp - *Last;
+		Gap->At = *Last - First;
+	}
+	*Last = Timestamp;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+	static REPORT_PIPELINE pipeline;
+	BOOLEAN realTime = FALSE, verbose = FALSE;
+	PCAPTURE_FILE_HEADER header;
+	PCAPTURE_RECORD record;
+	HID_INPUT_REPORT report;
+	INPUT_DATA replayed;
+	struct timespec start, end;
+	struct stat info;
+	REPLAY_GAP inputGap = { 0, 0 }, reportGap = { 0, 0 };
+	LONGLONG first = 0, lastInput = 0, lastReport = 0, last = 0, settle = MAXLONGLONG;
+	LONG interpolateMillis = -1, extrapolateMillis = -1;
+	unsigned long records, i, inputs = 0, reports = 0, differ = 0, dropped = 0, rejected = 0, changes = 0, unsettled = 0;
+	const UCHAR *map;
+	double seconds;
+	int option, fd;
+
+	while ((option = getopt(argc, argv, "ri:e:v")) != -1) {
+		switch (option) {
+		case 'r': realTime = TRUE; break;
+		case 'i': interpolateMillis = (LONG) strtoul(optarg, NULL, 0); break;
+		case 'e': extrapolateMillis = (LONG) strtoul(optarg, NULL, 0); break;
+		case 'v': verbose = TRUE; break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "usage: %s [-r] [-i millis] [-e millis] [-v] log\n", argv[0]);
+		return 2;
+	}
+
+	fd = open(argv[optind], O_RDONLY);
+	if (fd < 0 || fstat(fd, &info) < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if ((size_t) info.st_size < sizeof(CAPTURE_FILE_HEADER)) {
+		fprintf(stderr, "%s: too short for a capture log\n", argv[optind]);
+		return 1;
+	}
+	map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	madvise((void *) map, info.st_size, MADV_SEQUENTIAL);
+
+	header = (PCAPTURE_FILE_HEADER) map;
+	if (header->magic != CAPTURE_MAGIC || header->version != CAPTURE_VERSION ||
+		header->recordSize < sizeof(CAPTURE_RECORD)) {
+		fprintf(stderr, "%s: not a version %u capture log\n", argv[optind], CAPTURE_VERSION);
+		return 1;
+	}
+	// A record still being written when the log was copied is left out
+	records = (info.st_size - sizeof(CAPTURE_FILE_HEADER)) / header->recordSize;
+
+	dpInitPipeline(&pipeline);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < records; i++) {
+		record = (PCAPTURE_RECORD) (map + sizeof(CAPTURE_FILE_HEADER) + i * header->recordSize);
+		if (i == 0) {
+			first = record->timestamp;
+			// Set up as the pad was when capture started
+			if (!dpApplyPadSettings(&pipeline, &header->settings, first)) {
+				fprintf(stderr, "%s: the pad settings in the header don't make sense\n", argv[optind]);
+				return 1;
+			}
+			if (interpolateMillis >= 0)
+				pipeline.InterpolateDelay = (LONGLONG) interpolateMillis * 10000;
+			if (extrapolateMillis >= 0)
+				pipeline.ExtrapolateLimit = (LONGLONG) extrapolateMillis * 10000;
+		}
+		last = record->timestamp;
+		dropped += record->dropped;
+		if (realTime)
+			waitUntil(&start, record->timestamp - first);
+
+		switch (record->type) {
+		case CAPTURE_INPUT:
+			if (inputs++ == 0)
+				settle = record->timestamp + pipeline.InterpolateDelay;
+			noteGap(&inputGap, &lastInput, record->timestamp, first);
+			if (!NT_SUCCESS(dpPipelineSubmit(&pipeline, &record->data, record->timestamp)))
+				rejected++;
+			break;
+		case CAPTURE_REPORT:
+			reports++;
+			noteGap(&reportGap, &lastReport, record->timestamp, first);
+			dpPipelineNext(&pipeline, record->timestamp, &report);
+			copyReportData(&report, &replayed);
+			if (record->timestamp < settle) {
+				unsettled++;
+			} else if (!sameReport(&replayed, &record->data)) {
+				differ++;
+				if (verbose)
+					printf("%.3f ms: sent %d %d %d %d %d %d %08x, replayed %d %d %d %d %d %d %08x\n",
+						(record->timestamp - first) / 10000.0,
+						record->data.axisX, record->data.axisY, record->data.axisZ,
+						record->data.axisRX, record->data.axisRY, record->data.axisRZ, record->data.buttons,
+						replayed.axisX, replayed.axisY, replayed.axisZ,
+						replayed.axisRX, replayed.axisRY, replayed.axisRZ, replayed.buttons);
+			}
+			break;
+		case CAPTURE_SETTINGS:
+			if (changes++ == 0)
+				printf("%.3f ms: settings changed, so later reports may differ\n",
+					(record->timestamp - first) / 10000.0);
+			break;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("%lu records over %.3f s of pad %u: %lu inputs, %lu reports, %lu dropped while capturing\n",
+		records, (last - first) / 1e7, header->pad, inputs, reports, dropped);
+	printf("%lu reports differ on replay, %lu made from input before the capture, %lu inputs rejected, %lu settings changes\n",
+		differ, unsettled, rejected, changes);
+	printf("Longest gap between inputs %.3f ms at %.3f s, between reports %.3f ms at %.3f s\n",
+		inputGap.Length / 10000.0, inputGap.At / 1e7, reportGap.Length / 10000.0, reportGap.At / 1e7);
+	printf("Replayed in %.3f s (%.0f records/s)\n", seconds, seconds > 0 ? records / seconds : 0);
+
+	munmap((void *) map, info.st_size);
+	close(fd);
+	return differ != 0;
+}
@@ -0,0 +1,316 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dpshared.c
+
+Abstract:
+
+    Benchmark of the shared input page (see dpshared.h). A producer thread
+    publishes numbered frames to a page the way a client does, and a
+    consumer thread polls it the way the driver's report path does, so the
+    protocol runs under real contention. Every frame is checked for having
+    been read torn, frames replaced before they were read are counted as
+    superseded, and polls that found a frame still being written as busy. Latency from publishing a frame to it being picked up,
+    frames per second and the producer's CPU time per frame are printed as
+    JSON, or CSV for collecting many runs.
+
+    Build from the top of the tree with
+
+        cc -std=gnu99 -O2 -pthread -DDP_PORTABLE -Iinc -Iinc/portable \
+            -o dpshared linux/dpshared.c
+
+    dpshared [-r rate] [-p micros] [-d seconds] [-f json|csv] [-H]
+
+        -r  Frames per second from the producer, 0 for as fast as it can
+            (default 1000).
+        -p  How often the consumer polls, in microseconds, 0 to spin
+            (default 0).
+        -d  How long to run for (default 5).
+        -f  Output format (default json). csv prints a header line first
+            unless -H is also given.
+
+Author:
+
+
+Environment:
+
+    user mode, Linux
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define MAX_FRAMES		(1 << 24)
+
+typedef struct _SHARED_BENCH {
+    // Settings
+    ULONG      Rate;
+    ULONG      PollMicros;
+    ULONG      Seconds;
+
+    PSHARED_INPUT Page;
+    volatile int Stop;
+
+    // When each frame was published, by the producer, and the latencies of
+    // the ones picked up, by the consumer
+    LONGLONG   *PublishTimes;
+    LONGLONG   *Latencies;
+    ULONG      LatencyCount;
+    volatile ULONG Published;
+    ULONG      Superseded;
+    ULONG      Torn;
+    ULONG      Busy;
+    double     ProducerCpuNanos;
+} SHARED_BENCH, *PSHARED_BENCH;
+
+static SHARED_BENCH bench;
+
+static LONGLONG
+interruptTime(
+    VOID
+    )
+/**
+ * The monotonic clock in the driver's units, 100ns.
+ */
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (LONGLONG) now.tv_sec * 10000000 + now.tv_nsec / 100;
+}
+
+static VOID
+makeFrame(
+    IN ULONG        Id,
+    OUT PINPUT_DATA Data
+    )
+/**
+ * A frame whose every field is worked out from its number, so a frame
+ * read torn doesn't add up.
+ */
+{
+	Data->axisX = (LONG) (Id & 0x7FFF);
+	Data->axisY = (LONG) ((Id >> 15) & 0x7FFF);
+	Data->axisZ = (LONG) ((Id * 97) & 0x7FFF);
+	Data->axisRX = (LONG) ((Id * 89) & 0x7FFF);
+	Data->axisRY = (LONG) ((Id * 83) & 0x7FFF);
+	Data->axisRZ = (LONG) ((Id * 79) & 0x7FFF);
+	Data->buttons = (LONG) Id;
+}
+
+static void *
+producerThread(
+    void *Context
+    )
+/**
+ * The client's side: publishes numbered frames at the set rate until told
+ * to stop.
+ */
+{
+	struct timespec cpuStart, cpuEnd, wait;
+	INPUT_DATA data;
+	LONGLONG start, due, now;
+	ULONG id;
+
+	UNREFERENCED_PARAMETER(Context);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuStart);
+	start = interruptTime();
+	for (id = 0; !bench.Stop && id < MAX_FRAMES; id++) {
+		if (bench.Rate != 0) {
+			due = start + (LONGLONG) id * 10000000 / bench.Rate;
+			now = interruptTime();
+			if (due > now) {
+				wait.tv_sec = (time_t) ((due - now) / 10000000);
+				wait.tv_nsec = (long) ((due - now) % 10000000) * 100;
+				nanosleep(&wait, NULL);
+			}
+		}
+
+		makeFrame(id, &data);
+		bench.PublishTimes[id] = interruptTime();
+		dpSharedInputPublish(bench.Page, &data);
+		bench.Published = id + 1;
+	}
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuEnd);
+	bench.ProducerCpuNanos = (cpuEnd.tv_sec - cpuStart.tv_sec) * 1e9 + (cpuEnd.tv_nsec - cpuStart.tv_nsec);
+	return NULL;
+}
+
+static void *
+consumerThread(
+    void *Context
+    )
+/**
+ * The driver's side: polls the page, checks every frame it picks up and
+ * works out how long it took to get there.
+ */
+{
+	struct timespec wait;
+	INPUT_DATA data, expected;
+	LONG last = 0, sequence;
+	ULONG id, next = 0;
+	LONGLONG now;
+
+	UNREFERENCED_PARAMETER(Context);
+	wait.tv_sec = bench.PollMicros / 1000000;
+	wait.tv_nsec = (long) (bench.PollMicros % 1000000) * 1000;
+	while (!bench.Stop) {
+		if (!dpSharedInputRead(bench.Page, last, &data, &sequence)) {
+			if (bench.Page->sequence != last)
+				bench.Busy++;	// Being written; picked up on a later poll
+		} else {
+			now = interruptTime();
+			last = sequence;
+			id = (ULONG) data.buttons;
+			makeFrame(id, &expected);
+			if (id >= MAX_FRAMES || id < next || memcmp(&data, &expected, sizeof(INPUT_DATA)) != 0) {
+				bench.Torn++;
+			} else {
+				bench.Superseded += id - next;
+				bench.Latencies[bench.LatencyCount++] = now - bench.PublishTimes[id];
+				next = id + 1;
+			}
+		}
+		if (bench.PollMicros != 0)
+			nanosleep(&wait, NULL);
+	}
+	return NULL;
+}
+
+static int
+compareLonglong(
+    const void *a,
+    const void *b
+    )
+{
+	LONGLONG x = *(const LONGLONG *) a, y = *(const LONGLONG *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double
+percentileMicros(
+    IN double Fraction
+    )
+/**
+ * A percentile of the sorted latencies, in microseconds.
+ */
+{
+	ULONG i;
+
+	if (bench.LatencyCount == 0)
+		return 0;
+	i = (ULONG) (Fraction * bench.LatencyCount);
+	if (i >= bench.LatencyCount)
+		i = bench.LatencyCount - 1;
+	return bench.Latencies[i] / 10.0;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+	struct timespec wallStart, wallEnd;
+	pthread_t producer, consumer;
+	BOOLEAN csv = FALSE, header = TRUE;
+	double seconds, p50, p99, p999, worst;
+	int option;
+
+	bench.Rate = 1000;
+	bench.Seconds = 5;
+
+	while ((option = getopt(argc, argv, "r:p:d:f:H")) != -1) {
+		switch (option) {
+		case 'r': bench.Rate = strtoul(optarg, NULL, 0); break;
+		case 'p': bench.PollMicros = strtoul(optarg, NULL, 0); break;
+		case 'd': bench.Seconds = strtoul(optarg, NULL, 0); break;
+		case 'f': csv = strcmp(optarg, "csv") == 0; break;
+		case 'H': header = FALSE; break;
+		default:
+			fprintf(stderr, "usage: %s [-r rate] [-p micros] [-d seconds] [-f json|csv] [-H]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (bench.Seconds == 0) {
+		fprintf(stderr, "Need a duration\n");
+		return 2;
+	}
+
+	// As the driver sets it up in dpMapSharedInput
+	bench.Page = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (bench.Page == MAP_FAILED)
+		bench.Page = NULL;
+	bench.PublishTimes = calloc(MAX_FRAMES, sizeof(LONGLONG));
+	bench.Latencies = calloc(MAX_FRAMES, sizeof(LONGLONG));
+	if (bench.Page == NULL || bench.PublishTimes == NULL || bench.Latencies == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	bench.Page->magic = SHARED_INPUT_MAGIC;
+	bench.Page->version = SHARED_INPUT_VERSION;
+
+	clock_gettime(CLOCK_MONOTONIC, &wallStart);
+	pthread_create(&consumer, NULL, consumerThread, NULL);
+	pthread_create(&producer, NULL, producerThread, NULL);
+	sleep(bench.Seconds);
+	bench.Stop = TRUE;
+	pthread_join(producer, NULL);
+	pthread_join(consumer, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+
+	seconds = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+	qsort(bench.Latencies, bench.LatencyCount, sizeof(LONGLONG), compareLonglong);
+	p50 = percentileMicros(0.5);
+	p99 = percentileMicros(0.99);
+	p999 = percentileMicros(0.999);
+	worst = bench.LatencyCount ? bench.Latencies[bench.LatencyCount - 1] / 10.0 : 0;
+
+	if (csv) {
+		if (header)
+			printf("rate,poll_us,seconds,frames,picked_up,superseded,torn,busy,frames_per_sec,"
+				"p50_us,p99_us,p999_us,max_us,producer_ns_per_frame\n");
+		printf("%u,%u,%.3f,%u,%u,%u,%u,%u,%.0f,%.1f,%.1f,%.1f,%.1f,%.0f\n",
+			bench.Rate, bench.PollMicros, seconds, bench.Published, bench.LatencyCount, bench.Superseded,
+			bench.Torn, bench.Busy, bench.Published / seconds, p50, p99, p999, worst,
+			bench.Published ? bench.ProducerCpuNanos / bench.Published : 0);
+	} else {
+		printf("{\"rate\": %u, \"poll_us\": %u, \"seconds\": %.3f, \"frames\": %u, \"picked_up\": %u,\n"
+			" \"superseded\": %u, \"torn\": %u, \"busy\": %u, \"frames_per_sec\": %.0f,\n"
+			" \"latency_us\": {\"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f},\n"
+			" \"producer_ns_per_frame\": %.0f}\n",
+			bench.Rate, bench.PollMicros, seconds, bench.Published, bench.LatencyCount, bench.Superseded,
+			bench.Torn, bench.Busy, bench.Published / seconds, p50, p99, p999, worst,
+			bench.Published ? bench.ProducerCpuNanos / bench.Published : 0);
+	}
+	return bench.Torn != 0;
+}
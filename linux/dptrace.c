@@ -0,0 +1,184 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dptrace.c
+
+Abstract:
+
+    Formats a trace log (see DP_TRACE_RECORD in defs.h) read from the
+    driver's binary trace rings. The driver only records each message's
+    index and arguments; the formats live in dptrace.h, which this is built
+    against, so build it from the same tree as the driver. Records from
+    all CPUs are merged in time order, with times in milliseconds since
+    the first record.
+
+    Build from the top of the tree with
+
+        cc -std=gnu99 -O2 -DDP_PORTABLE -Iinc -Iinc/portable \
+            -o dptrace linux/dptrace.c
+
+    dptrace [-l level] [-a] log
+
+        -l  Only print messages at this TRACE_LEVEL_* or more severe
+            (default 5, everything).
+        -a  Print interrupt times in seconds, rather than relative times.
+
+Author:
+
+
+Environment:
+
+    user mode, Linux
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DP_TRACE_MESSAGE_LEVEL(Name, Level, Format)	Level,
+#define DP_TRACE_MESSAGE_FORMAT(Name, Level, Format)	Format,
+
+static const ULONG traceLevels[] = { DP_TRACE_MESSAGES(DP_TRACE_MESSAGE_LEVEL) };
+static const char *traceFormats[] = { DP_TRACE_MESSAGES(DP_TRACE_MESSAGE_FORMAT) };
+
+static const char *levelNames[] = { "NONE", "FATAL", "ERROR", "WARNING", "INFO", "VERBOSE" };
+
+static int
+compareRecords(
+    const void *A,
+    const void *B
+    )
+/**
+ * Orders by time, then by place in the log, which keeps each CPU's records
+ * in the order they were written when the clock hasn't moved on.
+ */
+{
+	PDP_TRACE_RECORD a = *(PDP_TRACE_RECORD *) A, b = *(PDP_TRACE_RECORD *) B;
+
+	if (a->timestamp != b->timestamp)
+		return a->timestamp < b->timestamp ? -1 : 1;
+	return a < b ? -1 : a > b;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+	BOOLEAN absolute = FALSE;
+	ULONG maxLevel = TRACE_LEVEL_VERBOSE, level;
+	PDP_TRACE_FILE_HEADER header;
+	PDP_TRACE_RECORD record, *sorted;
+	struct stat info;
+	unsigned long records, i, printed = 0, lost = 0, unknown = 0;
+	const UCHAR *map;
+	int option, fd;
+
+	while ((option = getopt(argc, argv, "l:a")) != -1) {
+		switch (option) {
+		case 'l': maxLevel = strtoul(optarg, NULL, 0); break;
+		case 'a': absolute = TRUE; break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "usage: %s [-l level] [-a] log\n", argv[0]);
+		return 2;
+	}
+
+	fd = open(argv[optind], O_RDONLY);
+	if (fd < 0 || fstat(fd, &info) < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if ((size_t) info.st_size < sizeof(DP_TRACE_FILE_HEADER)) {
+		fprintf(stderr, "%s: too short for a trace log\n", argv[optind]);
+		return 1;
+	}
+	map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	header = (PDP_TRACE_FILE_HEADER) map;
+	if (header->magic != DP_TRACE_MAGIC || header->version != DP_TRACE_VERSION ||
+		header->recordSize < sizeof(DP_TRACE_RECORD)) {
+		fprintf(stderr, "%s: not a version %u trace log\n", argv[optind], DP_TRACE_VERSION);
+		return 1;
+	}
+	records = (info.st_size - sizeof(DP_TRACE_FILE_HEADER)) / header->recordSize;
+
+	sorted = malloc((records ? records : 1) * sizeof(PDP_TRACE_RECORD));
+	if (sorted == NULL) {
+		perror("malloc");
+		return 1;
+	}
+	for (i = 0; i < records; i++)
+		sorted[i] = (PDP_TRACE_RECORD) (map + sizeof(DP_TRACE_FILE_HEADER) + i * header->recordSize);
+	qsort(sorted, records, sizeof(PDP_TRACE_RECORD), compareRecords);
+
+	for (i = 0; i < records; i++) {
+		record = sorted[i];
+		if (record->message == DPT_LOST)
+			lost += record->args[0];
+
+		if (record->message >= DP_TRACE_MESSAGE_COUNT) {
+			// From a newer driver than this was built against
+			unknown++;
+			continue;
+		}
+		level = traceLevels[record->message];
+		if (level > maxLevel)
+			continue;
+
+		if (absolute)
+			printf("%.7f", record->timestamp / 1e7);
+		else
+			printf("%12.4f", (record->timestamp - sorted[0]->timestamp) / 10000.0);
+		printf(" cpu%-2u %-7s ", record->cpu, levelNames[level]);
+		printf(traceFormats[record->message], record->args[0], record->args[1], record->args[2]);
+		printed++;
+	}
+
+	fprintf(stderr, "%lu of %lu records printed, %lu lost before they were read",
+		printed, records, lost);
+	if (unknown != 0)
+		fprintf(stderr, ", %lu with messages newer than this build", unknown);
+	fprintf(stderr, "\n");
+
+	free(sorted);
+	munmap((void *) map, info.st_size);
+	close(fd);
+	return 0;
+}
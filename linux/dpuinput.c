@@ -0,0 +1,454 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    dpuinput.c
+
+Abstract:
+
+    Linux backend for DroidPad's joystick. Reads INPUT_DATA frames, exactly
+    as sent to the Windows driver with IOCTL_DP_SEND_INPUT_DATA, from stdin
+    or a Unix socket, and publishes them as an evdev joystick through
+    uinput. Each frame is turned into events for whatever changed and a
+    single SYN_REPORT; all the frames from one read go out in one write().
+
+    Build from the top of the tree with
+
+        cc -std=gnu99 -O2 -DDP_PORTABLE -Iinc -Iinc/portable \
+            -o dpuinput linux/dpuinput.c core/pack.c
+
+    dpuinput [-s socket] [-o sink] [-b frames] [-v]
+
+        -s  Listen on a Unix stream socket at this path instead of reading
+            stdin. One client at a time, all driving the same device.
+        -o  Write the events to this file instead of creating a uinput
+            device, e.g. /dev/null where there's no /dev/uinput.
+        -b  Don't read any input; time this many generated frames through
+            the same path and print the frames per second.
+        -v  When the input ends, print how many frames came in how many
+            reads, and how many events went out in how many writes.
+
+Author:
+
+
+Environment:
+
+    user mode, Linux
+
+Revision History:
+
+--*/
+
+#include <dpcore.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/uinput.h>
+
+// Frames taken from one read, and so sent in one write
+#define FRAMES_PER_READ		64
+
+// Events one frame can produce: the axes, the buttons, both axes of each
+// hat switch, and the SYN_REPORT
+#define MAX_FRAME_EVENTS	(MAX_REPORT_AXES + MAX_REPORT_BUTTONS + 2 * MAX_REPORT_HATS + 1)
+
+typedef struct _UINPUT_PAD {
+    HID_INPUT_REPORT Last;	// First, as it's packed and its axes are read as LONGs
+    int              Fd;
+    BOOLEAN          IsUinput;	// FALSE for a stand-in sink
+    BOOLEAN          Primed;	// Last is what the device was last sent
+    size_t           Count;
+    unsigned long    FramesRead, Reads, EventsWritten, Writes;	// For -v
+    struct input_event Events[FRAMES_PER_READ * MAX_FRAME_EVENTS];
+} UINPUT_PAD, *PUINPUT_PAD;
+
+static const USHORT axisCodes[MAX_REPORT_AXES] = {
+    ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ
+};
+
+// Hat switch values, 0 for centred then N, NE, E, ..., NW, as evdev axes
+static const int hatX[9] = { 0,  0,  1, 1, 1, 0, -1, -1, -1 };
+static const int hatY[9] = { 0, -1, -1, 0, 1, 1,  1,  0, -1 };
+
+static int
+openUinput(
+    VOID
+    )
+/**
+ * Creates the joystick: six axes with the driver's range, 16 buttons
+ * (BTN_TRIGGER to BTN_DEAD) and four hat switches. Returns the uinput file
+ * descriptor, or -1.
+ */
+{
+	struct uinput_setup setup;
+	struct uinput_abs_setup abs;
+	int fd, i;
+
+	fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+	if (fd < 0) {
+		perror("/dev/uinput");
+		return -1;
+	}
+
+	if (ioctl(fd, UI_SET_EVBIT, EV_KEY) < 0 || ioctl(fd, UI_SET_EVBIT, EV_ABS) < 0)
+		goto fail;
+	for (i = 0; i < MAX_REPORT_BUTTONS; i++) {
+		if (ioctl(fd, UI_SET_KEYBIT, BTN_TRIGGER + i) < 0)
+			goto fail;
+	}
+
+	memset(&abs, 0, sizeof(abs));
+	abs.absinfo.minimum = 0;
+	abs.absinfo.maximum = JS_MAX_VALUE;
+	for (i = 0; i < MAX_REPORT_AXES; i++) {
+		abs.code = axisCodes[i];
+		abs.absinfo.value = JS_RESTING_PLACE;
+		if (ioctl(fd, UI_SET_ABSBIT, abs.code) < 0 || ioctl(fd, UI_ABS_SETUP, &abs) < 0)
+			goto fail;
+	}
+	abs.absinfo.minimum = -1;
+	abs.absinfo.maximum = 1;
+	abs.absinfo.value = 0;
+	for (i = 0; i < 2 * MAX_REPORT_HATS; i++) {
+		abs.code = ABS_HAT0X + i;
+		if (ioctl(fd, UI_SET_ABSBIT, abs.code) < 0 || ioctl(fd, UI_ABS_SETUP, &abs) < 0)
+			goto fail;
+	}
+
+	memset(&setup, 0, sizeof(setup));
+	setup.id.bustype = BUS_VIRTUAL;
+	setup.id.vendor = VENDOR_N_ID;
+	setup.id.product = PRODUCT_N_ID;
+	setup.id.version = VERSION_N;
+	strcpy(setup.name, "DroidPad Joystick");
+	if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0)
+		goto fail;
+	return fd;
+
+fail:
+	perror("uinput setup");
+	close(fd);
+	return -1;
+}
+
+static __forceinline VOID
+putEvent(
+    IN OUT PUINPUT_PAD Pad,
+    IN USHORT          Type,
+    IN USHORT          Code,
+    IN LONG            Value
+    )
+{
+	struct input_event *event = &Pad->Events[Pad->Count++];
+
+	// uinput stamps the events itself
+	event->time.tv_sec = 0;
+	event->time.tv_usec = 0;
+	event->type = Type;
+	event->code = Code;
+	event->value = Value;
+}
+
+static VOID
+encodeFrame(
+    IN OUT PUINPUT_PAD Pad,
+    IN PINPUT_DATA     Data
+    )
+/**
+ * Queues the events for one frame: everything that differs from the last
+ * frame sent, then a SYN_REPORT. A frame that changes nothing queues
+ * nothing, as evdev would drop it anyway.
+ */
+{
+	HID_INPUT_REPORT report;
+	const LONG *axes = &report.inputs.axisX;
+	const LONG *lastAxes = &Pad->Last.inputs.axisX;
+	size_t first = Pad->Count;
+	ULONG changed;
+	int i, hat, lastHat;
+
+	copyInputData(Data, &report);
+
+	for (i = 0; i < MAX_REPORT_AXES; i++) {
+		if (!Pad->Primed || axes[i] != lastAxes[i])
+			putEvent(Pad, EV_ABS, axisCodes[i], axes[i]);
+	}
+
+	changed = Pad->Primed ? (ULONG) (report.inputs.buttons ^ Pad->Last.inputs.buttons) : 0xFFFF;
+	for (i = 0; changed != 0; i++, changed >>= 1) {
+		if (changed & 1)
+			putEvent(Pad, EV_KEY, (USHORT) (BTN_TRIGGER + i), (report.inputs.buttons >> i) & 1);
+	}
+
+	for (i = 0; i < MAX_REPORT_HATS; i++) {
+		hat = (report.inputs.hats >> (4 * i)) & 0xF;
+		lastHat = Pad->Primed ? (Pad->Last.inputs.hats >> (4 * i)) & 0xF : -1;
+		if (hat == lastHat)
+			continue;
+		if (hat > 8)
+			hat = 0;	// Out of range, so centred
+		if (lastHat < 0 || lastHat > 8 || hatX[hat] != hatX[lastHat])
+			putEvent(Pad, EV_ABS, (USHORT) (ABS_HAT0X + 2 * i), hatX[hat]);
+		if (lastHat < 0 || lastHat > 8 || hatY[hat] != hatY[lastHat])
+			putEvent(Pad, EV_ABS, (USHORT) (ABS_HAT0Y + 2 * i), hatY[hat]);
+	}
+
+	if (Pad->Count != first)
+		putEvent(Pad, EV_SYN, SYN_REPORT, 0);
+	Pad->Last = report;
+	Pad->Primed = TRUE;
+}
+
+static BOOLEAN
+flushEvents(
+    IN OUT PUINPUT_PAD Pad
+    )
+/**
+ * Writes the queued events in one go. uinput takes whole arrays of events;
+ * a stand-in sink might take less, so the rest is written after it.
+ */
+{
+	const char *buffer = (const char *) Pad->Events;
+	size_t length = Pad->Count * sizeof(struct input_event);
+	ssize_t written;
+
+	Pad->EventsWritten += Pad->Count;
+	Pad->Count = 0;
+	while (length > 0) {
+		Pad->Writes++;
+		written = write(Pad->Fd, buffer, length);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("write");
+			return FALSE;
+		}
+		buffer += written;
+		length -= written;
+	}
+	return TRUE;
+}
+
+static BOOLEAN
+pumpInput(
+    IN OUT PUINPUT_PAD Pad,
+    IN int             Fd
+    )
+/**
+ * Reads frames from Fd until it's closed, passing each whole one on. Frames
+ * may arrive split across reads. When the input ends the joystick is put
+ * back at rest, so nothing is left held down.
+ */
+{
+	static INPUT_DATA frames[FRAMES_PER_READ];
+	INPUT_DATA rest;
+	size_t have = 0, count, i;
+	ssize_t got;
+
+	for (;;) {
+		got = read(Fd, (char *) frames + have, sizeof(frames) - have);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			break;
+		have += got;
+		count = have / sizeof(INPUT_DATA);
+		Pad->Reads++;
+		Pad->FramesRead += count;
+		for (i = 0; i < count; i++)
+			encodeFrame(Pad, &frames[i]);
+		if (Pad->Count > 0 && !flushEvents(Pad))
+			return FALSE;
+		// Keep the start of a frame that hasn't all arrived yet
+		have -= count * sizeof(INPUT_DATA);
+		memmove(frames, &frames[count], have);
+	}
+	if (got < 0)
+		perror("read");
+
+	resetInputData(&rest);
+	encodeFrame(Pad, &rest);
+	return flushEvents(Pad) && got == 0;
+}
+
+static int
+serveSocket(
+    IN OUT PUINPUT_PAD Pad,
+    IN const char      *Path
+    )
+/**
+ * Accepts clients on a Unix stream socket at Path, one at a time, forever.
+ */
+{
+	struct sockaddr_un address;
+	int listener, client;
+
+	if (strlen(Path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "%s: path too long\n", Path);
+		return 1;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, Path);
+
+	listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		perror("socket");
+		return 1;
+	}
+	unlink(Path);
+	if (bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(listener, 1) < 0) {
+		perror(Path);
+		close(listener);
+		return 1;
+	}
+
+	for (;;) {
+		client = accept(listener, NULL, NULL);
+		if (client < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			break;
+		}
+		pumpInput(Pad, client);
+		close(client);
+	}
+	close(listener);
+	return 1;
+}
+
+static int
+benchmark(
+    IN OUT PUINPUT_PAD Pad,
+    IN unsigned long   Frames
+    )
+/**
+ * Times Frames generated frames through encodeFrame and flushEvents, in
+ * batches of FRAMES_PER_READ as if they'd been read. Every frame moves the
+ * axes and every eighth one changes the buttons, much like a phone's input.
+ */
+{
+	static INPUT_DATA frames[FRAMES_PER_READ];
+	struct timespec start, end;
+	unsigned long done, events = 0;
+	double seconds;
+	size_t i, batch;
+	LONG *axes;
+	int axis;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (done = 0; done < Frames; done += batch) {
+		batch = min(Frames - done, (unsigned long) FRAMES_PER_READ);
+		for (i = 0; i < batch; i++) {
+			axes = &frames[i].axisX;
+			for (axis = 0; axis < MAX_REPORT_AXES; axis++)
+				axes[axis] = (LONG) (((done + i) * (97 + axis)) % (JS_MAX_VALUE + 1));
+			frames[i].buttons = (LONG) (((done + i) / 8) & 0xFFF);
+		}
+		for (i = 0; i < batch; i++)
+			encodeFrame(Pad, &frames[i]);
+		events += Pad->Count;
+		if (!flushEvents(Pad))
+			return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("%lu frames in %.3f s: %.0f frames/s, %.1f events/frame, %.0f ns/frame\n",
+		Frames, seconds, Frames / seconds, (double) events / Frames, seconds * 1e9 / Frames);
+	return 0;
+}
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+	static UINPUT_PAD pad;
+	const char *socketPath = NULL, *sinkPath = NULL;
+	unsigned long benchFrames = 0;
+	BOOLEAN verbose = FALSE;
+	int option, status;
+
+	while ((option = getopt(argc, argv, "s:o:b:v")) != -1) {
+		switch (option) {
+		case 's':
+			socketPath = optarg;
+			break;
+		case 'o':
+			sinkPath = optarg;
+			break;
+		case 'b':
+			benchFrames = strtoul(optarg, NULL, 0);
+			if (benchFrames == 0) {
+				fprintf(stderr, "-b needs a number of frames\n");
+				return 2;
+			}
+			break;
+		case 'v':
+			verbose = TRUE;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-s socket] [-o sink] [-b frames] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	// A client going away mid-write shouldn't take the device with it
+	signal(SIGPIPE, SIG_IGN);
+
+	if (sinkPath != NULL) {
+		pad.Fd = open(sinkPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (pad.Fd < 0) {
+			perror(sinkPath);
+			return 1;
+		}
+	} else {
+		pad.Fd = openUinput();
+		if (pad.Fd < 0)
+			return 1;
+		pad.IsUinput = TRUE;
+	}
+
+	if (benchFrames != 0)
+		status = benchmark(&pad, benchFrames);
+	else if (socketPath != NULL)
+		status = serveSocket(&pad, socketPath);
+	else
+		status = pumpInput(&pad, STDIN_FILENO) ? 0 : 1;
+	if (verbose)
+		printf("%lu frames in %lu reads, %lu events in %lu writes\n", pad.FramesRead, pad.Reads, pad.EventsWritten, pad.Writes);
+
+	if (pad.IsUinput)
+		ioctl(pad.Fd, UI_DEV_DESTROY);
+	close(pad.Fd);
+	return status;
+}
@@ -1,496 +1,941 @@
-/*++
-
- * This file is part of DroidPad.
- * DroidPad lets you use an Android mobile to control a joystick or mouse
- * on a Windows or Linux computer.
- * This program is the driver for DroidPad's Joystick.
- *
- * DroidPad is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * DroidPad is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with DroidPad, in the file COPYING.
- * If not, see <http://www.gnu.org/licenses/>.
-
-Module Name:
-
-    driver.c
-
-Abstract:
-
-    Code for main entry point of KMDF driver
-
-Author:
-
-
-Environment:
-
-    kernel mode only
-
-Revision History:
-
---*/
-
-#include <droidpad.h>
-
-#if defined(EVENT_TRACING)
-//
-// The trace message header (.tmh) file must be included in a source file
-// before any WPP macro calls and after defining a WPP_CONTROL_GUIDS
-// macro (defined in toaster.h). During the compilation, WPP scans the source
-// files for DoTraceMessage() calls and builds a .tmh file which stores a unique
-// data GUID for each message, the text resource string for each message,
-// and the data types of the variables passed in for each message.  This file
-// is automatically generated and used during post-processing.
-//
-#include "driver.tmh"
-#else
-ULONG DebugLevel = TRACE_LEVEL_INFORMATION;
-ULONG DebugFlag = 0xff;
-#endif
-
-#ifdef ALLOC_PRAGMA
-    #pragma alloc_text( INIT, DriverEntry )
-    #pragma alloc_text( PAGE, dpEvtDeviceAdd)
-    // #pragma alloc_text( PAGE, dpEvtDriverContextCleanup)
-    // #pragma alloc_text( PAGE, dpEvtTimerFunction)
-    // #pragma alloc_text( PAGE, copyHidReport)
-#endif
-
-NTSTATUS
-DriverEntry (
-    __in PDRIVER_OBJECT  DriverObject,
-    __in PUNICODE_STRING RegistryPath
-    )
-/*++
-
-Routine Description:
-
-    Installable driver initialization entry point.
-    This entry point is called directly by the I/O system.
-
-Arguments:
-
-    DriverObject - pointer to the driver object
-
-    RegistryPath - pointer to a unicode string representing the path,
-                   to driver-specific key in the registry.
-
-Return Value:
-
-    STATUS_SUCCESS if successful,
-    STATUS_UNSUCCESSFUL otherwise.
-
---*/
-{
-    NTSTATUS               status = STATUS_SUCCESS;
-    WDF_DRIVER_CONFIG      config;
-    WDF_OBJECT_ATTRIBUTES  attributes;
-
-    //
-    // Initialize WPP Tracing
-    //
-    WPP_INIT_TRACING( DriverObject, RegistryPath );
-
-    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT,
-        "DroidPad Driver Built %s %s\n", __DATE__, __TIME__);
-
-    WDF_DRIVER_CONFIG_INIT(&config, dpEvtDeviceAdd);
-
-    // Since there is only one control-device for all the instances
-    // of the physical device, we need an ability to get to particular instance
-    // of the device in our FilterEvtIoDeviceControlForControl. For that we
-    // will create a collection object and store filter device objects.        
-    // The collection object has the driver object as a default parent.
-    //
-    status = WdfCollectionCreate(WDF_NO_OBJECT_ATTRIBUTES, &deviceCollection);
-    if (!NT_SUCCESS(status))
-    {
-        KdPrint( ("WdfCollectionCreate failed with status 0x%x\n", status));
-        return status;
-    }
-
-    //
-    // Register a cleanup callback so that we can call WPP_CLEANUP when
-    // the framework driver object is deleted during driver unload.
-    //
-    WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
-    attributes.EvtCleanupCallback = dpEvtDriverContextCleanup;
-
-    //
-    // Create a framework driver object to represent our driver.
-    //
-    status = WdfDriverCreate(DriverObject,
-                             RegistryPath,
-                             &attributes,      // Driver Attributes
-                             &config,          // Driver Config Info
-                             WDF_NO_HANDLE
-                             );
-
-    if (!NT_SUCCESS(status)) {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_INIT,
-            "WdfDriverCreate failed with status 0x%x\n", status);
-        
-        WPP_CLEANUP(DriverObject);
-    }
-
-    status = WdfWaitLockCreate(WDF_NO_OBJECT_ATTRIBUTES, &deviceCollectionLock);
-    if (!NT_SUCCESS(status))
-    {
-		TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "WdfWaitLockCreate(deviceCollectionLock) failed with status 0x%x\n", status);
-        return status;
-    }
-
-    status = WdfWaitLockCreate(WDF_NO_OBJECT_ATTRIBUTES, &deviceCounterLock);
-    if (!NT_SUCCESS(status))
-    {
-		TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "WdfWaitLockCreate(deviceCounterLock) failed with status 0x%x\n", status);
-        return status;
-    }
-
-	// Reset device counter to 0
-	if (!deviceCounterReset())
-	{
-		TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "device counter initialization failed\n");
-		return STATUS_DRIVER_INTERNAL_ERROR;
-	}
-
-    return status;
-}
-
-
-NTSTATUS
-dpEvtDeviceAdd(
-    IN WDFDRIVER       Driver,
-    IN PWDFDEVICE_INIT DeviceInit
-    )
-/*++
-Routine Description:
-
-    dpEvtDeviceAdd is called by the framework in response to AddDevice
-    call from the PnP manager. We create and initialize a WDF device object to
-    represent a new instance of toaster device.
-
-Arguments:
-
-    Driver - Handle to a framework driver object created in DriverEntry
-
-    DeviceInit - Pointer to a framework-allocated WDFDEVICE_INIT structure.
-
-Return Value:
-
-    NTSTATUS
-
---*/
-{
-    NTSTATUS                      status = STATUS_SUCCESS;
-    WDF_IO_QUEUE_CONFIG           queueConfig;
-    WDF_OBJECT_ATTRIBUTES         attributes;
-    WDFDEVICE                     hDevice;
-    PDEVICE_EXTENSION             devContext = NULL;
-    WDFQUEUE                      queue;
-	DECLARE_CONST_UNICODE_STRING(CompatId, COMPATIBLE_DEVICE_ID);
-    WDF_TIMER_CONFIG              timerConfig;
-    WDFTIMER                      timerHandle;
-	LONG						  serialNumber;
-
-    UNREFERENCED_PARAMETER(Driver);
-
-    PAGED_CODE();
-
-    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_PNP,
-        "dpEvtDeviceAdd called\n");
-
-	serialNumber = deviceCounterIncrement();
-	if (-1 > serialNumber)
-	{
-		TraceEvents(TRACE_LEVEL_WARNING, DBG_PNP, "DeviceCount Failed- vJoyEvtDeviceAdd aborting\n");
-		return STATUS_UNSUCCESSFUL;
-	}
-	if (serialNumber>0)
-	{
-		TraceEvents(TRACE_LEVEL_WARNING, DBG_PNP, "DeviceCount returned Serial Number %d- vJoyEvtDeviceAdd aborting\n", serialNumber);
-		deviceCounterDecrement();
-		return STATUS_UNSUCCESSFUL;
-	}
-
-    //
-    // Tell framework this is a filter driver. Filter drivers by default are  
-    // not power policy owners. This works well for this driver because
-    // HIDclass driver is the power policy owner for HID minidrivers.
-    //
-    WdfFdoInitSetFilter(DeviceInit);
-
-	// Child device's compatible ID is "hid_device_system_game"
-	// Additional ones may be added below
-	WdfPdoInitAddCompatibleID(DeviceInit, &CompatId);
-
-    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&attributes, DEVICE_EXTENSION);
-	attributes.EvtCleanupCallback = dpEvtDeviceContextCleanup;
-
-    //
-    // Create a framework device object.This call will in turn create
-    // a WDM device object, attach to the lower stack, and set the
-    // appropriate flags and attributes.
-    //
-    status = WdfDeviceCreate(&DeviceInit, &attributes, &hDevice);
-    if (!NT_SUCCESS(status)) {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP,
-            "WdfDeviceCreate failed with status code 0x%x\n", status);
-        return status;
-    }
-
-    devContext = GetDeviceContext(hDevice);
-
-	///////////  Add this device to the FilterDevice collection. /////////////
-    // 
-    //
-    WdfWaitLockAcquire(deviceCollectionLock, NULL);
-    //
-    // WdfCollectionAdd takes a reference on the item object and removes
-    // it when you call WdfCollectionRemove.
-    //
-    status = WdfCollectionAdd(deviceCollection, hDevice);
-    if (!NT_SUCCESS(status)) 
-	{
-        KdPrint( ("WdfCollectionAdd failed with status code 0x%x\n", status));
-		return status;
-    }
-
-    WdfWaitLockRelease(deviceCollectionLock);
-	/////////////////////////////////////////////////////////////////////////
-
-	// Set all JS values to sane ones
-	resetHidReport(&(devContext->inputs));
-
-	/////////// Create a control device /////////////////////////////////////
-    status = dpCreateControlDevice(hDevice);
-    if (!NT_SUCCESS(status))
-	{
-        KdPrint( ("dpCreateControlDevice failed with status 0x%x\n", status));
-		return status;
-    }
-	/////////////////////////////////////////////////////////////////////////
-    
-    WDF_IO_QUEUE_CONFIG_INIT_DEFAULT_QUEUE(&queueConfig, WdfIoQueueDispatchParallel);
-    queueConfig.EvtIoInternalDeviceControl = dpEvtInternalDeviceControl;
-
-    status = WdfIoQueueCreate(hDevice,
-                              &queueConfig,
-                              WDF_NO_OBJECT_ATTRIBUTES,
-                              &queue
-                              );
-    if (!NT_SUCCESS (status)) {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP,
-            "WdfIoQueueCreate failed 0x%x\n", status);
-        return status;
-    }
-
-    //
-    // Register a manual I/O queue for handling Interrupt Message Read Requests.
-    // This queue will be used for storing Requests that need to wait for an
-    // interrupt to occur before they can be completed.
-    //
-    WDF_IO_QUEUE_CONFIG_INIT(&queueConfig, WdfIoQueueDispatchManual);
-
-    //
-    // This queue is used for requests that dont directly access the device. The
-    // requests in this queue are serviced only when the device is in a fully
-    // powered state and sends an interrupt. So we can use a non-power managed
-    // queue to park the requests since we dont care whether the device is idle
-    // or fully powered up.
-    //
-    queueConfig.PowerManaged = WdfFalse;
-
-    status = WdfIoQueueCreate(hDevice,
-                              &queueConfig,
-                              WDF_NO_OBJECT_ATTRIBUTES,
-                              &devContext->TimerMsgQueue
-                              );
-
-    if (!NT_SUCCESS(status)) {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP,
-            "WdfIoQueueCreate failed 0x%x\n", status);
-        return status;
-    }
-
-    //	Create a timer that completes IOCTL_HID_READ_REPORT pending requests
-	//	Calback function will be called by this timer every READ_REPORT_MILLIS
-    WDF_TIMER_CONFIG_INIT(&timerConfig, dpEvtTimerFunction);
-    timerConfig.AutomaticSerialization = FALSE;
-	timerConfig.Period = READ_REPORT_MILLIS;
-
-    WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
-    attributes.ParentObject = hDevice;
-    status = WdfTimerCreate( &timerConfig,&attributes,&timerHandle);
-    if (!NT_SUCCESS(status)) 
-	{
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "WdfTimerCreate failed status:0x%x\n", status);
-        return status;
-    }
-	WdfTimerStart(timerHandle, 100);
- 	/////////////////////////////////////////////////////////////////////////////////////////
-
-    // devContext->DebounceTimer = timerHandle;
-    return status;
-}
-
-
-VOID
-dpEvtDriverContextCleanup(
-    IN WDFDRIVER Driver
-    )
-/*++
-Routine Description:
-
-    Free resources allocated in DriverEntry that are not automatically
-    cleaned up framework.
-
-Arguments:
-
-    Driver - handle to a WDF Driver object.
-
-Return Value:
-
-    VOID.
-
---*/
-{
-    UNREFERENCED_PARAMETER(Driver);
-
-    // TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Exit dpEvtDriverContextCleanup\n");
-
-    WPP_CLEANUP( WdfDriverWdmGetDriverObject( Driver ));
-
-}
-
-/**
- * Timer call for IOCTL_HID_READ_REPORT
- */
-VOID
-dpEvtTimerFunction(
-    IN WDFTIMER  Timer
-    )
-{
-	NTSTATUS status = STATUS_SUCCESS;
-	PDEVICE_EXTENSION devContext = GetDeviceContext(WdfTimerGetParentObject(Timer));
-	WDFREQUEST request;
-
-	// Check for requests, then get if there is one
-	if(NT_SUCCESS(WdfIoQueueRetrieveNextRequest(devContext->TimerMsgQueue, &request))) {
-		size_t bytesReturned;
-		PHID_INPUT_REPORT hidReport = NULL;
-        status = WdfRequestRetrieveOutputBuffer(request, sizeof(HID_INPUT_REPORT), &hidReport, &bytesReturned);
-        if (!NT_SUCCESS(status)) 
-		{
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL,
-                "WdfRequestRetrieveOutputBuffer failed with status: 0x%x\n", status);
-        } else {
-			// Copy the input report values from the dev context to the buffer.
-			copyHidReport(&devContext->inputs, hidReport);
-		}
-
-        WdfRequestCompleteWithInformation(request, status, bytesReturned);
-
-    } else if (status != STATUS_NO_MORE_ENTRIES)
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL,"WdfIoQueueRetrieveNextRequest status %08x\n", status);
-
-    return;
-}
-
-/**
- * Copies the value of an hid report.
- */
-VOID copyHidReport(
-				IN PHID_INPUT_REPORT from,
-				OUT PHID_INPUT_REPORT to)
-{
-		if(from == NULL || to == NULL) {
-				TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL, "copyHidReport received a null argument\n");
-				return;
-		}
-		to->inputs.axisX = from->inputs.axisX;
-		to->inputs.axisY = from->inputs.axisY;
-		to->inputs.axisZ = from->inputs.axisZ;
-		to->inputs.axisRX = from->inputs.axisRX;
-		to->inputs.axisRY = from->inputs.axisRY;
-		to->inputs.axisRZ = from->inputs.axisRZ;
-		to->inputs.buttons = from->inputs.buttons;
-		return;
-}
-
-#if !defined(EVENT_TRACING)
-
-VOID
-TraceEvents    (
-    IN ULONG   TraceEventsLevel,
-    IN ULONG   TraceEventsFlag,
-    IN PCCHAR  DebugMessage,
-    ...
-    )
-
-/*++
-
-Routine Description:
-
-    Debug print for the sample driver.
-
-Arguments:
-
-    TraceEventsLevel - print level between 0 and 3, with 3 the most verbose
-
-Return Value:
-
-    None.
-
- --*/
- {
-#if DBG
-#define     TEMP_BUFFER_SIZE        512
-    va_list    list;
-    CHAR       debugMessageBuffer[TEMP_BUFFER_SIZE];
-    NTSTATUS   status;
-
-    va_start(list, DebugMessage);
-
-    if (DebugMessage) {
-
-        //
-        // Using new safe string functions instead of _vsnprintf.
-        // This function takes care of NULL terminating if the message
-        // is longer than the buffer.
-        //
-        status = RtlStringCbVPrintfA( debugMessageBuffer,
-                                      sizeof(debugMessageBuffer),
-                                      DebugMessage,
-                                      list );
-        if(!NT_SUCCESS(status)) {
-
-            DbgPrint (_DRIVER_NAME_": RtlStringCbVPrintfA failed 0x%x\n", status);
-            return;
-        }
-        if (TraceEventsLevel <= TRACE_LEVEL_ERROR ||
-            (TraceEventsLevel <= DebugLevel &&
-             ((TraceEventsFlag & DebugFlag) == TraceEventsFlag))) {
-            DbgPrint("%s%s", _DRIVER_NAME_, debugMessageBuffer);
-        }
-    }
-    va_end(list);
-
-    return;
-#else
-    UNREFERENCED_PARAMETER(TraceEventsLevel);
-    UNREFERENCED_PARAMETER(TraceEventsFlag);
-    UNREFERENCED_PARAMETER(DebugMessage);
-#endif
-}
-
-#endif
-
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    driver.c
+
+Abstract:
+
+    Code for main entry point of KMDF driver
+
+Author:
+
+
+Environment:
+
+    kernel mode only
+
+Revision History:
+
+--*/
+
+#include <droidpad.h>
+
+#if defined(EVENT_TRACING)
+//
+// The trace message header (.tmh) file must be included in a source file
+// before any WPP macro calls and after defining a WPP_CONTROL_GUIDS
+// macro (defined in toaster.h). During the compilation, WPP scans the source
+// files for DoTraceMessage() calls and builds a .tmh file which stores a unique
+// data GUID for each message, the text resource string for each message,
+// and the data types of the variables passed in for each message.  This file
+// is automatically generated and used during post-processing.
+//
+#include "driver.tmh"
+#else
+ULONG DebugLevel = TRACE_LEVEL_INFORMATION;
+ULONG DebugFlag = 0xff;
+#endif
+
+// The binary trace, one ring per CPU. NULL if it couldn't be allocated, in
+// which case dpTrace only prints.
+static PDP_TRACE_RING traceRings = NULL;
+static ULONG traceRingCount = 0;
+
+#if DBG && !defined(EVENT_TRACING)
+#define DP_TRACE_MESSAGE_LEVEL(Name, Level, Format)	Level,
+#define DP_TRACE_MESSAGE_FORMAT(Name, Level, Format)	Format,
+
+static const ULONG traceLevels[] = { DP_TRACE_MESSAGES(DP_TRACE_MESSAGE_LEVEL) };
+static const PCCHAR traceFormats[] = { DP_TRACE_MESSAGES(DP_TRACE_MESSAGE_FORMAT) };
+#endif
+
+#ifdef ALLOC_PRAGMA
+    #pragma alloc_text( INIT, DriverEntry )
+    #pragma alloc_text( PAGE, dpEvtDeviceAdd)
+    #pragma alloc_text( PAGE, dpReadDeviceParameter)
+    // #pragma alloc_text( PAGE, dpEvtDriverContextCleanup)
+    // #pragma alloc_text( PAGE, dpEvtTimerFunction)
+    // #pragma alloc_text( PAGE, copyHidReport)
+#endif
+
+NTSTATUS
+DriverEntry (
+    __in PDRIVER_OBJECT  DriverObject,
+    __in PUNICODE_STRING RegistryPath
+    )
+/*++
+
+Routine Description:
+
+    Installable driver initialization entry point.
+    This entry point is called directly by the I/O system.
+
+Arguments:
+
+    DriverObject - pointer to the driver object
+
+    RegistryPath - pointer to a unicode string representing the path,
+                   to driver-specific key in the registry.
+
+Return Value:
+
+    STATUS_SUCCESS if successful,
+    STATUS_UNSUCCESSFUL otherwise.
+
+--*/
+{
+    NTSTATUS               status = STATUS_SUCCESS;
+    WDF_DRIVER_CONFIG      config;
+    WDF_OBJECT_ATTRIBUTES  attributes;
+
+    //
+    // Initialize WPP Tracing
+    //
+    WPP_INIT_TRACING( DriverObject, RegistryPath );
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT,
+        "DroidPad Driver Built %s %s\n", __DATE__, __TIME__);
+
+    WDF_DRIVER_CONFIG_INIT(&config, dpEvtDeviceAdd);
+
+    // Since there is only one control-device for all the instances
+    // of the physical device, we need an ability to get to particular instance
+    // of the device in our FilterEvtIoDeviceControlForControl. For that we
+    // will create a collection object and store filter device objects.        
+    // The collection object has the driver object as a default parent.
+    //
+    status = WdfCollectionCreate(WDF_NO_OBJECT_ATTRIBUTES, &deviceCollection);
+    if (!NT_SUCCESS(status))
+    {
+        KdPrint( ("WdfCollectionCreate failed with status 0x%x\n", status));
+        return status;
+    }
+
+    //
+    // Register a cleanup callback so that we can call WPP_CLEANUP when
+    // the framework driver object is deleted during driver unload.
+    //
+    WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
+    attributes.EvtCleanupCallback = dpEvtDriverContextCleanup;
+
+    //
+    // Create a framework driver object to represent our driver.
+    //
+    status = WdfDriverCreate(DriverObject,
+                             RegistryPath,
+                             &attributes,      // Driver Attributes
+                             &config,          // Driver Config Info
+                             WDF_NO_HANDLE
+                             );
+
+    if (!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_INIT,
+            "WdfDriverCreate failed with status 0x%x\n", status);
+        
+        WPP_CLEANUP(DriverObject);
+    }
+
+	// Without it tracing just isn't recorded, so carry on
+	traceRings = ExAllocatePoolWithTag(NonPagedPool,
+		KeNumberProcessors * sizeof(DP_TRACE_RING), DROIDPAD_POOL_TAG);
+	if (traceRings != NULL) {
+		for (traceRingCount = 0; traceRingCount < (ULONG) KeNumberProcessors; traceRingCount++)
+			dpInitTraceRing(&traceRings[traceRingCount], (UCHAR) traceRingCount);
+	} else {
+		TraceEvents(TRACE_LEVEL_WARNING, DBG_INIT, "Couldn't allocate trace rings\n");
+	}
+
+    status = WdfWaitLockCreate(WDF_NO_OBJECT_ATTRIBUTES, &deviceCollectionLock);
+    if (!NT_SUCCESS(status))
+    {
+		TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "WdfWaitLockCreate(deviceCollectionLock) failed with status 0x%x\n", status);
+        return status;
+    }
+
+    status = WdfWaitLockCreate(WDF_NO_OBJECT_ATTRIBUTES, &deviceCounterLock);
+    if (!NT_SUCCESS(status))
+    {
+		TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "WdfWaitLockCreate(deviceCounterLock) failed with status 0x%x\n", status);
+        return status;
+    }
+
+	// Reset device counter to 0
+	if (!deviceCounterReset())
+	{
+		TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "device counter initialization failed\n");
+		return STATUS_DRIVER_INTERNAL_ERROR;
+	}
+
+    return status;
+}
+
+
+NTSTATUS
+dpEvtDeviceAdd(
+    IN WDFDRIVER       Driver,
+    IN PWDFDEVICE_INIT DeviceInit
+    )
+/*++
+Routine Description:
+
+    dpEvtDeviceAdd is called by the framework in response to AddDevice
+    call from the PnP manager. We create and initialize a WDF device object to
+    represent a new instance of toaster device.
+
+Arguments:
+
+    Driver - Handle to a framework driver object created in DriverEntry
+
+    DeviceInit - Pointer to a framework-allocated WDFDEVICE_INIT structure.
+
+Return Value:
+
+    NTSTATUS
+
+--*/
+{
+    NTSTATUS                      status = STATUS_SUCCESS;
+    WDF_IO_QUEUE_CONFIG           queueConfig;
+    WDF_OBJECT_ATTRIBUTES         attributes;
+    WDFDEVICE                     hDevice;
+    PDEVICE_EXTENSION             devContext = NULL;
+    WDFQUEUE                      queue;
+	DECLARE_CONST_UNICODE_STRING(CompatId, COMPATIBLE_DEVICE_ID);
+    WDF_TIMER_CONFIG              timerConfig;
+    WDFTIMER                      timerHandle;
+	LONG						  serialNumber;
+	ULONG						  padIndex;
+	REPORT_SPEC					  reportSpec;
+
+    UNREFERENCED_PARAMETER(Driver);
+
+    PAGED_CODE();
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_PNP,
+        "dpEvtDeviceAdd called\n");
+
+	serialNumber = deviceCounterIncrement();
+	if (-1 > serialNumber)
+	{
+		TraceEvents(TRACE_LEVEL_WARNING, DBG_PNP, "DeviceCount Failed- vJoyEvtDeviceAdd aborting\n");
+		return STATUS_UNSUCCESSFUL;
+	}
+	if (serialNumber >= DP_MAX_PADS)
+	{
+		TraceEvents(TRACE_LEVEL_WARNING, DBG_PNP, "DeviceCount returned Serial Number %d- vJoyEvtDeviceAdd aborting\n", serialNumber);
+		deviceCounterDecrement();
+		return STATUS_UNSUCCESSFUL;
+	}
+
+    //
+    // Tell framework this is a filter driver. Filter drivers by default are  
+    // not power policy owners. This works well for this driver because
+    // HIDclass driver is the power policy owner for HID minidrivers.
+    //
+    WdfFdoInitSetFilter(DeviceInit);
+
+	// Child device's compatible ID is "hid_device_system_game"
+	// Additional ones may be added below
+	WdfPdoInitAddCompatibleID(DeviceInit, &CompatId);
+
+    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&attributes, DEVICE_EXTENSION);
+	attributes.EvtCleanupCallback = dpEvtDeviceContextCleanup;
+
+    //
+    // Create a framework device object.This call will in turn create
+    // a WDM device object, attach to the lower stack, and set the
+    // appropriate flags and attributes.
+    //
+    status = WdfDeviceCreate(&DeviceInit, &attributes, &hDevice);
+    if (!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP,
+            "WdfDeviceCreate failed with status code 0x%x\n", status);
+        return status;
+    }
+
+    devContext = GetDeviceContext(hDevice);
+	devContext->PadIndex = DP_MAX_PADS;
+	ExInitializeRundownProtection(&devContext->PadRundown);
+
+	devContext->CompleteOnInput = (BOOLEAN) (dpReadDeviceParameter(hDevice, REG_COMPLETE_ON_INPUT, TRUE) != 0);
+	devContext->ReadPolicy = (dpReadDeviceParameter(hDevice, REG_READ_POLICY, ReadPolicyFanOut) == ReadPolicyFreshest) ?
+		ReadPolicyFreshest : ReadPolicyFanOut;
+	devContext->MaxStaleMillis = dpReadDeviceParameter(hDevice, REG_MAX_STALE_MILLIS, 0);
+	devContext->Pipeline.InterpolateDelay = (LONGLONG) dpReadDeviceParameter(hDevice, REG_INTERPOLATE_DELAY_MILLIS, 0) * 10000;
+	devContext->Pipeline.ExtrapolateLimit = (LONGLONG) dpReadDeviceParameter(hDevice, REG_EXTRAPOLATE_MILLIS, 0) * 10000;
+	devContext->Pipeline.Jitter.MaxDelay = (LONGLONG) dpReadDeviceParameter(hDevice, REG_JITTER_BUFFER_MAX_MILLIS, 0) * 10000;
+	devContext->Settings.interpolateDelayMillis = (ULONG) (devContext->Pipeline.InterpolateDelay / 10000);
+	devContext->Settings.extrapolateMillis = (ULONG) (devContext->Pipeline.ExtrapolateLimit / 10000);
+	devContext->DeliveredSequence = -1;	// Older than the sequence dpInitPipeline leaves behind
+
+	// Shape of the reports HIDCLASS will be told about
+	switch (dpReadDeviceParameter(hDevice, REG_REPORT_LAYOUT, ReportLayoutLegacy)) {
+	case ReportLayoutCustom:
+		reportSpec.Axes = dpReadDeviceParameter(hDevice, REG_REPORT_AXES, 6);
+		reportSpec.AxisBits = dpReadDeviceParameter(hDevice, REG_REPORT_AXIS_BITS, 16);
+		reportSpec.Buttons = dpReadDeviceParameter(hDevice, REG_REPORT_BUTTONS, 12);
+		reportSpec.Hats = dpReadDeviceParameter(hDevice, REG_REPORT_HATS, 0);
+		if (!NT_SUCCESS(dpBuildReportLayout(&reportSpec, &devContext->Layout))) {
+			TraceEvents(TRACE_LEVEL_WARNING, DBG_PNP,
+				"Invalid report spec: %u axes of %u bits, %u buttons, %u hats; using the default report layout instead\n",
+				reportSpec.Axes, reportSpec.AxisBits, reportSpec.Buttons, reportSpec.Hats);
+			dpLegacyReportLayout(&devContext->Layout);
+			break;
+		}
+		TraceEvents(TRACE_LEVEL_INFORMATION, DBG_PNP, "Built %u byte report descriptor for %u byte reports\n",
+			devContext->Layout.ReportDescriptorLength, devContext->Layout.ReportLength);
+		break;
+	case ReportLayoutCompact:
+		dpCompactReportLayout(&devContext->Layout);
+		break;
+	default:
+		dpLegacyReportLayout(&devContext->Layout);
+		break;
+	}
+
+    WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
+    attributes.ParentObject = hDevice;
+    status = WdfSpinLockCreate(&attributes, &devContext->RingLock);
+    if (!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP,
+            "WdfSpinLockCreate failed with status code 0x%x\n", status);
+        return status;
+    }
+
+	///////////  Add this device to the FilterDevice collection. /////////////
+    // 
+    //
+    WdfWaitLockAcquire(deviceCollectionLock, NULL);
+    //
+    // WdfCollectionAdd takes a reference on the item object and removes
+    // it when you call WdfCollectionRemove.
+    //
+    status = WdfCollectionAdd(deviceCollection, hDevice);
+    if (!NT_SUCCESS(status)) 
+	{
+        KdPrint( ("WdfCollectionAdd failed with status code 0x%x\n", status));
+		WdfWaitLockRelease(deviceCollectionLock);
+		return status;
+    }
+
+    WdfWaitLockRelease(deviceCollectionLock);
+	/////////////////////////////////////////////////////////////////////////
+
+	// Set all JS values to sane ones
+	dpInitPipeline(&devContext->Pipeline);
+
+	/////////// Create a control device /////////////////////////////////////
+    status = dpCreateControlDevice(hDevice);
+    if (!NT_SUCCESS(status))
+	{
+        KdPrint( ("dpCreateControlDevice failed with status 0x%x\n", status));
+		return status;
+    }
+	/////////////////////////////////////////////////////////////////////////
+    
+    WDF_IO_QUEUE_CONFIG_INIT_DEFAULT_QUEUE(&queueConfig, WdfIoQueueDispatchParallel);
+    queueConfig.EvtIoInternalDeviceControl = dpEvtInternalDeviceControl;
+
+    status = WdfIoQueueCreate(hDevice,
+                              &queueConfig,
+                              WDF_NO_OBJECT_ATTRIBUTES,
+                              &queue
+                              );
+    if (!NT_SUCCESS (status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP,
+            "WdfIoQueueCreate failed 0x%x\n", status);
+        return status;
+    }
+
+    //
+    // Register a manual I/O queue for handling Interrupt Message Read Requests.
+    // This queue will be used for storing Requests that need to wait for an
+    // interrupt to occur before they can be completed.
+    //
+    WDF_IO_QUEUE_CONFIG_INIT(&queueConfig, WdfIoQueueDispatchManual);
+
+    //
+    // This queue is used for requests that dont directly access the device. The
+    // requests in this queue are serviced only when the device is in a fully
+    // powered state and sends an interrupt. So we can use a non-power managed
+    // queue to park the requests since we dont care whether the device is idle
+    // or fully powered up.
+    //
+    queueConfig.PowerManaged = WdfFalse;
+
+    status = WdfIoQueueCreate(hDevice,
+                              &queueConfig,
+                              WDF_NO_OBJECT_ATTRIBUTES,
+                              &devContext->TimerMsgQueue
+                              );
+
+    if (!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP,
+            "WdfIoQueueCreate failed 0x%x\n", status);
+        return status;
+    }
+
+    //	Create a timer that completes IOCTL_HID_READ_REPORT pending requests
+	//	It is one-shot, and armed by dpKickReportTimer when a read is parked
+	//	or input arrives; the callback re-arms it while reads are waiting.
+    WDF_TIMER_CONFIG_INIT(&timerConfig, dpEvtTimerFunction);
+    timerConfig.AutomaticSerialization = FALSE;
+
+    WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
+    attributes.ParentObject = hDevice;
+    status = WdfTimerCreate( &timerConfig,&attributes,&timerHandle);
+    if (!NT_SUCCESS(status)) 
+	{
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "WdfTimerCreate failed status:0x%x\n", status);
+        return status;
+    }
+	devContext->ReportTimer = timerHandle;
+	devContext->ReportTimerMillis = REPORT_TIMER_MIN_MILLIS;
+ 	/////////////////////////////////////////////////////////////////////////////////////////
+
+	///////////  Give the device a pad index so input can reach it //////////
+    WdfWaitLockAcquire(deviceCollectionLock, NULL);
+	for (padIndex = 0; padIndex < DP_MAX_PADS; padIndex++) {
+		if (padDevices[padIndex] == NULL) {
+			padDevices[padIndex] = hDevice;
+			devContext->PadIndex = padIndex;
+			break;
+		}
+	}
+    WdfWaitLockRelease(deviceCollectionLock);
+
+	if (padIndex == DP_MAX_PADS) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "No free pad index\n");
+        return STATUS_UNSUCCESSFUL;
+	}
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_PNP, "Device added as pad %u\n", padIndex);
+	/////////////////////////////////////////////////////////////////////////
+
+    // devContext->DebounceTimer = timerHandle;
+    return status;
+}
+
+
+ULONG
+dpReadDeviceParameter(
+    IN WDFDEVICE Device,
+    IN PCWSTR    ValueName,
+    IN ULONG     DefaultValue
+    )
+/*++
+Routine Description:
+
+    Reads a DWORD value from the device's hardware key (the HKR key that
+    droidpad.inx adds its parameters to).
+
+Arguments:
+
+    Device - Handle to the framework device object.
+
+    ValueName - Name of the registry value.
+
+    DefaultValue - Returned if the key or value can't be read.
+
+Return Value:
+
+    The value read, or DefaultValue.
+
+--*/
+{
+    NTSTATUS        status;
+    WDFKEY          key;
+    UNICODE_STRING  valueName;
+    ULONG           value = DefaultValue;
+
+    PAGED_CODE();
+
+    status = WdfDeviceOpenRegistryKey(Device,
+                                      PLUGPLAY_REGKEY_DEVICE,
+                                      KEY_READ,
+                                      WDF_NO_OBJECT_ATTRIBUTES,
+                                      &key);
+    if (!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_WARNING, DBG_PNP,
+            "WdfDeviceOpenRegistryKey failed with status 0x%x\n", status);
+        return DefaultValue;
+    }
+
+    RtlInitUnicodeString(&valueName, ValueName);
+    status = WdfRegistryQueryULong(key, &valueName, &value);
+    if (!NT_SUCCESS(status)) {
+        value = DefaultValue;
+    }
+
+    WdfRegistryClose(key);
+    return value;
+}
+
+
+VOID
+dpEvtDriverContextCleanup(
+    IN WDFDRIVER Driver
+    )
+/*++
+Routine Description:
+
+    Free resources allocated in DriverEntry that are not automatically
+    cleaned up framework.
+
+Arguments:
+
+    Driver - handle to a WDF Driver object.
+
+Return Value:
+
+    VOID.
+
+--*/
+{
+    UNREFERENCED_PARAMETER(Driver);
+
+    // TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Exit dpEvtDriverContextCleanup\n");
+
+	if (traceRings != NULL) {
+		ExFreePoolWithTag(traceRings, DROIDPAD_POOL_TAG);
+		traceRings = NULL;
+		traceRingCount = 0;
+	}
+
+    WPP_CLEANUP( WdfDriverWdmGetDriverObject( Driver ));
+
+}
+
+/**
+ * How many IOCTL_HID_READ_REPORT requests are parked.
+ */
+static ULONG
+readsParked(
+    IN PDEVICE_EXTENSION DevContext
+    )
+{
+	ULONG queued = 0, driverOwned = 0;
+
+	WdfIoQueueGetState(DevContext->TimerMsgQueue, &queued, &driverOwned);
+	return queued;
+}
+
+/**
+ * Whether reports are being interpolated and would still be moving, even
+ * without new input.
+ */
+static BOOLEAN
+interpolating(
+    IN PDEVICE_EXTENSION DevContext
+    )
+{
+	BOOLEAN result;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	result = dpPipelineInterpolating(&DevContext->Pipeline, KeQueryInterruptTime());
+	WdfSpinLockRelease(DevContext->RingLock);
+	return result;
+}
+
+/**
+ * Whether smoothed axes are still catching up with the last input, so the
+ * report would move without new input.
+ */
+static BOOLEAN
+settling(
+    IN PDEVICE_EXTENSION DevContext
+    )
+{
+	BOOLEAN result;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	result = dpPipelineSettling(&DevContext->Pipeline);
+	WdfSpinLockRelease(DevContext->RingLock);
+	return result;
+}
+
+/**
+ * Whether the input has changed since a read was last completed, or the
+ * last report is older than MaxStaleMillis (if set), so a parked read
+ * should be completed now. Stale is set if the report is only due because
+ * of MaxStaleMillis.
+ */
+BOOLEAN
+dpReportDue(
+    IN PDEVICE_EXTENSION DevContext,
+    OUT PBOOLEAN         Stale
+    )
+{
+	BOOLEAN due;
+	LONGLONG now;
+
+	*Stale = FALSE;
+	now = KeQueryInterruptTime();
+
+	// A frame on the shared input page is only picked up by dpNextReport, so
+	// look for one here too. The lock keeps the page from being unmapped.
+	WdfSpinLockAcquire(DevContext->RingLock);
+	due = dpPipelineReportDue(&DevContext->Pipeline, DevContext->DeliveredSequence, now) ||
+		(DevContext->SharedInput != NULL &&
+		DevContext->SharedInput->sequence != DevContext->SharedInputSequence);
+	WdfSpinLockRelease(DevContext->RingLock);
+	if (due)
+		return TRUE;
+
+	if (DevContext->MaxStaleMillis != 0 &&
+		now - (LONGLONG) DevContext->DeliveredTime >= (LONGLONG) DevContext->MaxStaleMillis * 10000) {
+		*Stale = TRUE;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * Whether the report timer has anything to do for parked reads: a report is
+ * due, or could come due without new input, from the jitter buffer,
+ * interpolation, smoothing, a turbo or macro edge, the shared input page or
+ * the MaxStaleMillis heartbeat.
+ */
+static BOOLEAN
+reportTimerNeeded(
+    IN PDEVICE_EXTENSION DevContext
+    )
+{
+	BOOLEAN stale;
+
+	// Counts read unlocked; input arriving meanwhile kicks the timer itself
+	return DevContext->MaxStaleMillis != 0 || DevContext->SharedInput != NULL ||
+		DevContext->Pipeline.Jitter.Count != 0 || interpolating(DevContext) ||
+		settling(DevContext) ||
+		DevContext->Pipeline.Buttons.NextEdge != NO_BUTTON_EDGE || dpReportDue(DevContext, &stale);
+}
+
+static VOID
+startReportTimer(
+    IN PDEVICE_EXTENSION DevContext,
+    IN ULONG             Millis
+    )
+{
+	DevContext->ReportTimerDue = (ULONG) KeQueryInterruptTime() + Millis * 10000;
+	WdfTimerStart(DevContext->ReportTimer, WDF_REL_TIMEOUT_IN_MS(Millis));
+}
+
+/**
+ * Timer call for IOCTL_HID_READ_REPORT. Completes parked reads, then picks
+ * the next period: the shortest one if the input changed since the last
+ * tick, reports or timed input are still waiting or interpolated or
+ * smoothed axes are still moving, otherwise double the last one, up to the
+ * heartbeat. Lets the timer stop if no reads are left parked, if the input
+ * is idle and there is no heartbeat to send, or if CompleteOnInput already
+ * delivered everything there is.
+ */
+VOID
+dpEvtTimerFunction(
+    IN WDFTIMER  Timer
+    )
+{
+	WDFDEVICE device = WdfTimerGetParentObject(Timer);
+	PDEVICE_EXTENSION devContext = GetDeviceContext(device);
+	LONG sequence;
+	ULONG millis, idleMillis, edgeMillis;
+	LONGLONG edge;
+
+	// Not due again until this sets it, so input arriving meanwhile still
+	// restarts the timer
+	devContext->ReportTimerDue = (ULONG) KeQueryInterruptTime() + MAXLONG;
+
+	dpCompleteReadReport(device, devContext->ReadPolicy == ReadPolicyFanOut);
+
+	// Unlocked reads of the sequence and counts; a stale value only costs
+	// one tick at the wrong period.
+	sequence = devContext->Pipeline.State.Sequence;
+	if (devContext->SharedInput != NULL) {
+		// Frames on the page ring no doorbell, so keep polling it
+		idleMillis = REPORT_TIMER_MIN_MILLIS;
+	} else if (devContext->MaxStaleMillis != 0) {
+		idleMillis = min(devContext->MaxStaleMillis, REPORT_TIMER_IDLE_MILLIS);
+	} else {
+		// Unchanged reads are held until input arrives, which restarts the timer
+		idleMillis = 0;
+	}
+	if (devContext->CompleteOnInput && !reportTimerNeeded(devContext)) {
+		// Input completes the reads itself, and has nothing left over
+		millis = 0;
+	} else if (sequence != devContext->ReportTimerSequence || devContext->Pipeline.Ring.Count != 0 ||
+		devContext->Pipeline.Jitter.Count != 0 || interpolating(devContext) ||
+		settling(devContext)) {
+		millis = REPORT_TIMER_MIN_MILLIS;
+	} else {
+		millis = min(devContext->ReportTimerMillis * 2, idleMillis);
+	}
+	devContext->ReportTimerSequence = sequence;
+	devContext->ReportTimerMillis = max(millis, REPORT_TIMER_MIN_MILLIS);
+
+	// Wake up in time for the next turbo or macro edge, whatever else is going on
+	edge = devContext->Pipeline.Buttons.NextEdge;
+	if (edge != NO_BUTTON_EDGE) {
+		edge = max(edge - (LONGLONG) KeQueryInterruptTime(), 0);
+		edgeMillis = (ULONG) max((edge + 9999) / 10000, REPORT_TIMER_MIN_MILLIS);
+		millis = millis == 0 ? edgeMillis : min(millis, edgeMillis);
+	}
+
+	if (millis == 0 || !readsParked(devContext)) {
+		// Disarm, then look again in case a read was parked in between and
+		// saw the timer still armed.
+		InterlockedExchange(&devContext->ReportTimerArmed, FALSE);
+		if (millis == 0 || !readsParked(devContext) ||
+			InterlockedCompareExchange(&devContext->ReportTimerArmed, TRUE, FALSE) != FALSE)
+			return;
+	}
+
+	startReportTimer(devContext, millis);
+}
+
+/**
+ * Makes sure the report timer is running after a read is parked, or after
+ * new input arrives, in which case it is brought forward to the shortest
+ * period. With CompleteOnInput, leaves it alone if it would find nothing to
+ * do, as when the input was already handed to a read.
+ */
+VOID
+dpKickReportTimer(
+    IN PDEVICE_EXTENSION DevContext,
+    IN BOOLEAN           NewInput
+    )
+{
+	if (NewInput)
+		DevContext->ReportTimerMillis = REPORT_TIMER_MIN_MILLIS;
+	if (DevContext->CompleteOnInput && !reportTimerNeeded(DevContext))
+		return;
+
+	if (NewInput) {
+		if (!readsParked(DevContext))
+			return;
+
+		// Restarting an armed timer moves its due time, later as well as
+		// sooner, so one already due within the shortest period is left be.
+		// Otherwise input faster than that would hold the timer off for good.
+		if (InterlockedExchange(&DevContext->ReportTimerArmed, TRUE) != FALSE &&
+			(LONG) (DevContext->ReportTimerDue - (ULONG) KeQueryInterruptTime()) <=
+			REPORT_TIMER_MIN_MILLIS * 10000)
+			return;
+	} else if (InterlockedCompareExchange(&DevContext->ReportTimerArmed, TRUE, FALSE) != FALSE) {
+		return;
+	}
+
+	startReportTimer(DevContext, DevContext->ReportTimerMillis);
+}
+
+/**
+ * Completes parked IOCTL_HID_READ_REPORT requests, oldest first, with the
+ * reports waiting in the ring, then with the current input state once the
+ * ring is empty, if a report is due. Only the oldest request is completed
+ * unless DrainAll is set, in which case every request parked at the time
+ * is, including those after the first that the report it got made current.
+ * Called from the report timer, and from the control device as soon as new
+ * input arrives when CompleteOnInput is set.
+ * Returns the number of requests completed.
+ */
+ULONG
+dpCompleteReadReport(
+    WDFDEVICE Device,
+    BOOLEAN   DrainAll
+    )
+{
+	NTSTATUS status;
+	PDEVICE_EXTENSION devContext = GetDeviceContext(Device);
+	WDFREQUEST request;
+	HID_INPUT_REPORT report;
+	ULONG completed = 0, queued;
+	LONG sequence;
+	ULONG toComplete;
+	LONGLONG arrival, now;
+	BOOLEAN found, stale;
+
+	if (!dpReportDue(devContext, &stale))
+		return 0;
+
+	// Reads parked after this point wait for the next change
+	toComplete = DrainAll ? readsParked(devContext) : 1;
+	while (completed < toComplete) {
+		size_t bytesReturned = 0;
+		PUCHAR hidReport = NULL;
+
+		status = WdfIoQueueRetrieveNextRequest(devContext->TimerMsgQueue, &request);
+		if (!NT_SUCCESS(status)) {
+			if (status != STATUS_NO_MORE_ENTRIES)
+				dpTrace(DPT_READ_RETRIEVE_FAILED, status, 0, 0);
+			break;
+		}
+
+        status = WdfRequestRetrieveOutputBuffer(request, devContext->Layout.ReportLength, &hidReport, NULL);
+        if (!NT_SUCCESS(status)) 
+		{
+            InterlockedIncrement(&devContext->OutputBufferFailures);
+            dpTrace(DPT_READ_BUFFER_FAILED, status, 0, 0);
+        } else {
+			// Copy the next report's values to the buffer. The report is the
+			// state at sequence unless more are queued, so it's safe to hold
+			// reads until the state moves on from it.
+			found = dpNextReport(devContext, &report, &arrival, &queued, &sequence);
+			dpPackReport(&devContext->Layout, &report, hidReport);
+			bytesReturned = devContext->Layout.ReportLength;
+
+			now = KeQueryInterruptTime();
+			devContext->DeliveredSequence = sequence;
+			devContext->DeliveredTime = now;
+			InterlockedIncrement(&devContext->ReportsDelivered);
+			if (stale)
+				InterlockedIncrement(&devContext->ReadsTimedOut);
+			// Reports made from the state rather than new input have no latency
+			if (found)
+				dpHistogramAdd(&devContext->LatencyHistogram, (ULONG) min(max(now - arrival, 0) / 10, MAXULONG));
+			dpHistogramAdd(&devContext->QueueDepthHistogram, queued);
+			dpTrace(DPT_READ_COMPLETED, devContext->PadIndex, (ULONG) sequence, 0);
+		}
+
+        WdfRequestCompleteWithInformation(request, status, bytesReturned);
+		completed++;
+    }
+
+    return completed;
+}
+
+/**
+ * Records one of the messages in dptrace.h in the current CPU's trace ring,
+ * without formatting it. Debug builds also print it, as TraceEvents would.
+ * Callable at up to DISPATCH_LEVEL.
+ */
+VOID
+dpTrace(
+    IN USHORT Message,
+    IN ULONG  Arg0,
+    IN ULONG  Arg1,
+    IN ULONG  Arg2
+    )
+{
+	KIRQL oldIrql;
+
+	if (traceRings != NULL) {
+		// Stay on this CPU, so its ring only sees one writer at a time
+		KeRaiseIrql(DISPATCH_LEVEL, &oldIrql);
+		dpTraceWrite(&traceRings[KeGetCurrentProcessorNumber() % traceRingCount],
+			Message, KeQueryInterruptTime(), Arg0, Arg1, Arg2);
+		KeLowerIrql(oldIrql);
+	}
+
+#if DBG && !defined(EVENT_TRACING)
+	TraceEvents(traceLevels[Message], DBG_IOCTL, traceFormats[Message], Arg0, Arg1, Arg2);
+#endif
+}
+
+/**
+ * Fills Records with up to MaxRecords records from the trace rings, a CPU
+ * at a time. Only called from the control device's queue, which is
+ * sequential, so each ring only has one reader.
+ * Returns the number of records filled in.
+ */
+ULONG
+dpReadTrace(
+    OUT PDP_TRACE_RECORD Records,
+    IN ULONG             MaxRecords
+    )
+{
+	ULONG cpu, count = 0;
+
+	for (cpu = 0; cpu < traceRingCount && count < MaxRecords; cpu++)
+		count += dpTraceDrain(&traceRings[cpu], Records + count, MaxRecords - count);
+	return count;
+}
+
+#if !defined(EVENT_TRACING)
+
+VOID
+TraceEvents    (
+    IN ULONG   TraceEventsLevel,
+    IN ULONG   TraceEventsFlag,
+    IN PCCHAR  DebugMessage,
+    ...
+    )
+
+/*++
+
+Routine Description:
+
+    Debug print for the sample driver.
+
+Arguments:
+
+    TraceEventsLevel - print level between 0 and 3, with 3 the most verbose
+
+Return Value:
+
+    None.
+
+ --*/
+ {
+#if DBG
+#define     TEMP_BUFFER_SIZE        512
+    va_list    list;
+    CHAR       debugMessageBuffer[TEMP_BUFFER_SIZE];
+    NTSTATUS   status;
+
+    // Only pay for formatting messages that will be printed
+    if (TraceEventsLevel > TRACE_LEVEL_ERROR &&
+        (TraceEventsLevel > DebugLevel ||
+         ((TraceEventsFlag & DebugFlag) != TraceEventsFlag))) {
+        return;
+    }
+
+    va_start(list, DebugMessage);
+
+    if (DebugMessage) {
+
+        //
+        // Using new safe string functions instead of _vsnprintf.
+        // This function takes care of NULL terminating if the message
+        // is longer than the buffer.
+        //
+        status = RtlStringCbVPrintfA( debugMessageBuffer,
+                                      sizeof(debugMessageBuffer),
+                                      DebugMessage,
+                                      list );
+        if(!NT_SUCCESS(status)) {
+
+            DbgPrint (_DRIVER_NAME_": RtlStringCbVPrintfA failed 0x%x\n", status);
+            va_end(list);
+            return;
+        }
+        DbgPrint("%s%s", _DRIVER_NAME_, debugMessageBuffer);
+    }
+    va_end(list);
+
+    return;
+#else
+    UNREFERENCED_PARAMETER(TraceEventsLevel);
+    UNREFERENCED_PARAMETER(TraceEventsFlag);
+    UNREFERENCED_PARAMETER(DebugMessage);
+#endif
+}
+
+#endif
+
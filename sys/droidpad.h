@@ -1,329 +1,498 @@
-/*++
-
- * This file is part of DroidPad.
- * DroidPad lets you use an Android mobile to control a joystick or mouse
- * on a Windows or Linux computer.
- * This program is the driver for DroidPad's Joystick.
- *
- * DroidPad is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * DroidPad is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with DroidPad, in the file COPYING.
- * If not, see <http://www.gnu.org/licenses/>.
-
-Module Name:
-
-    droidpad.h
-    
-Abstract:
-
-    common header file
-
-Author:
-
-
-Environment:
-
-    kernel mode only
-
-Notes:
-
-
-Revision History:
-
-
---*/
-#ifndef _DROIDPAD_DRIVER_H_
-
-#define _DROIDPAD_DRIVER_H_
-
-#pragma warning(disable:4200)  // suppress nameless struct/union warning
-#pragma warning(disable:4201)  // suppress nameless struct/union warning
-#pragma warning(disable:4214)  // suppress bit field types other than int warning
-#include <initguid.h>
-#include <wdm.h>
-#include "usbdi.h"
-#include "usbdlib.h"
-
-#pragma warning(default:4200)
-#pragma warning(default:4201)
-#pragma warning(default:4214)
-#include <wdf.h>
-#include "wdfusb.h"
-
-#pragma warning(disable:4201)  // suppress nameless struct/union warning
-#pragma warning(disable:4214)  // suppress bit field types other than int warning
-#include <hidport.h>
-
-#define NTSTRSAFE_LIB
-#include <ntstrsafe.h>
-
-#include "trace.h"
-
-#include "../inc/defs.h"
-
-#define _DRIVER_NAME_                 "DroidPad: "
-#define COMPATIBLE_DEVICE_ID		  L"hid_device_system_game"
-
-#define READ_REPORT_MILLIS			50
-
-WDFCOLLECTION deviceCollection;
-WDFWAITLOCK deviceCollectionLock;
-extern WDFDEVICE controlDevice;
-
-static int deviceCounter;
-WDFWAITLOCK deviceCounterLock;
-
-typedef struct _CONTROL_DEVICE_EXTENSION {
-
-    PVOID   ControlData;
-    WDFDEVICE hParentDevice;
-
-} CONTROL_DEVICE_EXTENSION, *PCONTROL_DEVICE_EXTENSION;
-
-WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(CONTROL_DEVICE_EXTENSION, ControlGetData)
-
-typedef UCHAR HID_REPORT_DESCRIPTOR, *PHID_REPORT_DESCRIPTOR;
-
-// HID descriptor of a 6-axis 12-button JS, which DroidPad uses.
-
-// Halfway on each axis
-#define JS_RESTING_PLACE 16384
-
-#ifdef USE_HARDCODED_HID_REPORT_DESCRIPTOR 
-
-CONST  HID_REPORT_DESCRIPTOR       G_DefaultReportDescriptor[79] = {
-    0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
-    0x15, 0x00,                    // LOGICAL_MINIMUM (0)
-    0x09, 0x04,                    // USAGE (Joystick)
-    0xa1, 0x01,                    // COLLECTION (Application)
-    0x05, 0x01,                    //   USAGE_PAGE (Generic Desktop)
-    0x09, 0x01,                    //   USAGE (Pointer)
-    0x15, 0x00, 	               //   LOGICAL_MINIMUM (0)
-    0x26, 0xff, 0x7f,              //   LOGICAL_MAXIMUM (32767)
-    0x75, 0x20,                    //   REPORT_SIZE (32)
-    0x95, 0x01,                    //   REPORT_COUNT (1)
-    0xa1, 0x00,                    //   COLLECTION (Physical)
-    0x09, 0x30,                    //     USAGE (X)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs) -- CHANGED TO SEQUENTIAL
-    0x09, 0x31,                    //     USAGE (Y)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-    0x09, 0x32,                    //     USAGE (Rx)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-    0x09, 0x33,                    //     USAGE (Ry)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-    0x09, 0x34,                    //     USAGE (Slider)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-    0x09, 0x35,                    //     USAGE (Dial)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-    0x81, 0x01,                    //     INPUT (Cnst,Ary,Abs)
-    0x81, 0x01,                    //     INPUT (Cnst,Ary,Abs)
-    0xc0,                          //   END_COLLECTION
-    0x05, 0x09,                    //   USAGE_PAGE (Button)
-    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
-    0x25, 0x01,                    //   LOGICAL_MAXIMUM (1)
-    0x75, 0x01,                    //   REPORT_SIZE (1)
-    0x55, 0x00,                    //   UNIT_EXPONENT (0)
-    0x65, 0x00,                    //   UNIT (None)
-    0x19, 0x01,                    //   USAGE_MINIMUM (Button 1)
-    0x29, 0x0c,                    //   USAGE_MAXIMUM (Button 12)
-    0x95, 0x0c,                    //   REPORT_COUNT (12)
-    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
-    0x95, 0x01,                    //   REPORT_COUNT (1)
-    0x75, 0x14,                    //   REPORT_SIZE (20)
-    0x81, 0x01,                    //   INPUT (Cnst,Ary,Abs)
-    0xc0                           // END_COLLECTION
-};
-
-//
-// This is the default HID descriptor returned by the mini driver
-// in response to IOCTL_HID_GET_DEVICE_DESCRIPTOR. The size
-// of report descriptor is currently the size of G_DefaultReportDescriptor.
-//
-CONST HID_DESCRIPTOR G_DefaultHidDescriptor = {
-    0x09,   // length of HID descriptor
-    0x21,   // descriptor type == HID  0x21
-    0x0100, // hid spec release
-    0x00,   // country code == Not Specified
-    0x01,   // number of HID class descriptors
-    { 0x22,   // descriptor type 
-    sizeof(G_DefaultReportDescriptor) }  // total length of report descriptor
-};
-
-#endif  // USE_HARDCODED_HID_REPORT_DESCRIPTOR
-
-#include <pshpack1.h>
-typedef struct _HID_INPUT_REPORT {
-	union {
-		struct {
-			LONG	axisX;
-			LONG	axisY;
-			LONG	axisZ;
-			LONG	axisRX;
-			LONG	axisRY;
-			LONG	axisRZ;
-			LONG	_u1; // Unused
-			LONG	_u2;
-			USHORT	buttons;	// 16 Buttons (12 used)
-			USHORT	_unused1;
-		} inputs;
-		UCHAR raw[36];
-	};
-} HID_INPUT_REPORT, *PHID_INPUT_REPORT;
-#include <poppack.h>
-
-
-typedef struct _DEVICE_EXTENSION{
-
-    //
-    // This variable stores state for the swicth that got toggled most recently
-    // (the device returns the state of all the switches and not just the 
-    // one that got toggled).
-    // TODO: Delete this?
-    UCHAR    LatestToggledSwitch;
-
-    //
-    // WDF Queue for timed IOCTL responses
-    //
-    WDFQUEUE   TimerMsgQueue;
-
-    // HID report, which will be already filled in. Values must be copied from one to the other.
-    HID_INPUT_REPORT inputs;
-
-} DEVICE_EXTENSION, * PDEVICE_EXTENSION;
-
-WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(DEVICE_EXTENSION, GetDeviceContext)
-
-//
-// driver routine declarations
-//
-// This type of function declaration is for Prefast for drivers. 
-// Because this declaration specifies the function type, PREfast for Drivers
-// does not need to infer the type or to report an inference. The declaration
-// also prevents PREfast for Drivers from misinterpreting the function type 
-// and applying inappropriate rules to the function. For example, PREfast for
-// Drivers would not apply rules for completion routines to functions of type
-// DRIVER_CANCEL. The preferred way to avoid Warning 28101 is to declare the
-// function type explicitly. In the following example, the DriverEntry function
-// is declared to be of type DRIVER_INITIALIZE.
-//
-DRIVER_INITIALIZE DriverEntry;
-
-EVT_WDF_DRIVER_DEVICE_ADD dpEvtDeviceAdd;
-
-EVT_WDF_IO_QUEUE_IO_INTERNAL_DEVICE_CONTROL dpEvtInternalDeviceControl;
-
-NTSTATUS
-dpGetHidDescriptor(
-    IN WDFDEVICE Device,
-    IN WDFREQUEST Request
-    );
-
-NTSTATUS
-dpGetReportDescriptor(
-    IN WDFDEVICE Device,
-    IN WDFREQUEST Request
-    );
-
-
-NTSTATUS
-dpGetDeviceAttributes(
-    IN WDFREQUEST Request
-    );
-
-NTSTATUS
-dpConfigContReaderForInterruptEndPoint(
-    PDEVICE_EXTENSION DeviceContext
-    );
-
-EVT_WDF_USB_READER_COMPLETION_ROUTINE dpEvtUsbInterruptPipeReadComplete;
-
-VOID
-dpCompleteReadReport(
-    WDFDEVICE Device
-    );
-
-EVT_WDF_OBJECT_CONTEXT_CLEANUP dpEvtDriverContextCleanup;
-
-EVT_WDF_TIMER dpEvtTimerFunction;
-
-VOID copyHidReport(
-    IN PHID_INPUT_REPORT from,
-    OUT PHID_INPUT_REPORT to);
-
-NTSTATUS
-dpCreateControlDevice(
-    WDFDEVICE Device
-    );
-VOID
-dpDeleteControlDevice(
-    WDFDEVICE Device
-    );
-
-EVT_WDF_OBJECT_CONTEXT_CLEANUP dpEvtDeviceContextCleanup;
-
-int deviceCounterChange(int difference);
-#define deviceCounterIncrement() deviceCounterChange(1)
-#define deviceCounterDecrement() deviceCounterChange(-1)
-int deviceCounterReset();
-/**
- * Gets the device count from the registry
- */
-ULONG loadDeviceCount(PWSTR RegistryPath);
-
-/**
- * gets the current device count
- */
-int getDeviceCount();
-
-EVT_WDF_IO_QUEUE_IO_DEVICE_CONTROL dpEvtIoDeviceControl;
-
-PCHAR
-DbgHidInternalIoctlString(
-    IN ULONG        IoControlCode
-    );
-
-VOID
-copyInputData(
-    IN PINPUT_DATA from,
-    OUT PHID_INPUT_REPORT to
-     );
-VOID
-resetHidReport(
-				OUT PHID_INPUT_REPORT report
-			  );
-
-#if (OSVER(NTDDI_VERSION) > NTDDI_WIN2K)
-
-NTSTATUS
-dpSendIdleNotification(
-    IN WDFREQUEST Request
-    );
-
-#endif  //(OSVER(NTDDI_VERSION) > NTDDI_WIN2K)
-
-NTSTATUS
-dpSetFeature(
-    IN WDFREQUEST Request
-    );
-
-EVT_WDF_IO_QUEUE_IO_CANCELED_ON_QUEUE dpEvtIoCanceledOnQueue;
-
-NTSTATUS
-SendVendorCommand(
-    IN WDFDEVICE Device,
-    IN UCHAR VendorCommand,
-    IN PUCHAR CommandData
-    );
-
-#endif   //_DROIDPAD_DRIVER_H_
-
-
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    droidpad.h
+    
+Abstract:
+
+    common header file
+
+Author:
+
+
+Environment:
+
+    kernel mode only
+
+Notes:
+
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_DRIVER_H_
+
+#define _DROIDPAD_DRIVER_H_
+
+#pragma warning(disable:4200)  // suppress nameless struct/union warning
+#pragma warning(disable:4201)  // suppress nameless struct/union warning
+#pragma warning(disable:4214)  // suppress bit field types other than int warning
+#include <initguid.h>
+#include <wdm.h>
+#include "usbdi.h"
+#include "usbdlib.h"
+
+#pragma warning(default:4200)
+#pragma warning(default:4201)
+#pragma warning(default:4214)
+#include <wdf.h>
+#include "wdfusb.h"
+
+#pragma warning(disable:4201)  // suppress nameless struct/union warning
+#pragma warning(disable:4214)  // suppress bit field types other than int warning
+#include <hidport.h>
+
+#define NTSTRSAFE_LIB
+#include <ntstrsafe.h>
+
+#include "trace.h"
+
+#include <dpcore.h>
+
+#define _DRIVER_NAME_                 "DroidPad: "
+#define COMPATIBLE_DEVICE_ID		  L"hid_device_system_game"
+
+// Bounds of the report timer's period. The timer runs at the shortest period
+// while input is changing, doubles it each tick the input stays the same,
+// and stops while no reads are parked. The longest period is only a
+// heartbeat; new input restarts the timer at the shortest one. Nothing
+// restarts it for a frame on a shared input page, so while one is mapped
+// the timer stays at the shortest period.
+#define REPORT_TIMER_MIN_MILLIS		2
+#define REPORT_TIMER_IDLE_MILLIS	1000
+
+#define DROIDPAD_POOL_TAG			'PdrD'
+
+// Registry values read from the device's hardware key in dpEvtDeviceAdd
+#define REG_COMPLETE_ON_INPUT		L"CompleteOnInput"
+#define REG_READ_POLICY				L"ReadPolicy"
+#define REG_MAX_STALE_MILLIS		L"MaxStaleMillis"
+#define REG_INTERPOLATE_DELAY_MILLIS	L"InterpolateDelayMillis"
+#define REG_EXTRAPOLATE_MILLIS		L"ExtrapolateMillis"
+#define REG_JITTER_BUFFER_MAX_MILLIS	L"JitterBufferMaxMillis"
+#define REG_REPORT_LAYOUT			L"ReportLayout"
+#define REG_REPORT_AXES				L"ReportAxes"
+#define REG_REPORT_AXIS_BITS		L"ReportAxisBits"
+#define REG_REPORT_BUTTONS			L"ReportButtons"
+#define REG_REPORT_HATS				L"ReportHats"
+
+WDFCOLLECTION deviceCollection;
+WDFWAITLOCK deviceCollectionLock;
+extern WDFDEVICE controlDevice;
+
+// Devices by pad index, for the control device to find them. Protected by deviceCollectionLock.
+extern WDFDEVICE padDevices[DP_MAX_PADS];
+
+static int deviceCounter;
+WDFWAITLOCK deviceCounterLock;
+
+typedef struct _CONTROL_DEVICE_EXTENSION {
+
+    PVOID   ControlData;
+
+} CONTROL_DEVICE_EXTENSION, *PCONTROL_DEVICE_EXTENSION;
+
+WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(CONTROL_DEVICE_EXTENSION, ControlGetData)
+
+//
+// Context of a handle opened on the control device. Holds the shared input
+// page mapped into the process that asked for it, if any. SharedInputClaimed
+// is set by the one IOCTL_DP_MAP_SHARED_INPUT allowed to fill in the rest,
+// which can't rely on the queue to keep maps on the handle apart.
+//
+typedef struct _FILE_EXTENSION {
+
+    volatile LONG SharedInputClaimed;
+    PSHARED_INPUT SharedInput;  // Kernel address of the page
+    ULONG         SharedInputPad;
+    PMDL          SharedInputMdl;
+    PVOID         SharedInputUserAddress;
+    PEPROCESS     SharedInputProcess;  // Referenced; the mapping is in its address space
+
+} FILE_EXTENSION, *PFILE_EXTENSION;
+
+WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(FILE_EXTENSION, GetFileContext)
+
+//
+// What the report timer does with the IOCTL_HID_READ_REPORT requests that
+// have been parked since the last tick.
+//
+typedef enum _READ_POLICY {
+    ReadPolicyFanOut = 0,   // Complete every parked read with the current state
+    ReadPolicyFreshest = 1  // Complete one read per tick, leave the rest for newer state
+} READ_POLICY;
+
+typedef struct _DEVICE_EXTENSION{
+
+    //
+    // This variable stores state for the swicth that got toggled most recently
+    // (the device returns the state of all the switches and not just the 
+    // one that got toggled).
+    // TODO: Delete this?
+    UCHAR    LatestToggledSwitch;
+
+    //
+    // WDF Queue for timed IOCTL responses
+    //
+    WDFQUEUE   TimerMsgQueue;
+
+    //
+    // One-shot timer which completes the reads parked in TimerMsgQueue, its
+    // current period, whether it is armed and when it is due (the low part
+    // of the interrupt time), and the State sequence it saw last, to tell
+    // whether the input has changed since.
+    //
+    WDFTIMER   ReportTimer;
+    ULONG      ReportTimerMillis;
+    volatile LONG ReportTimerArmed;
+    volatile ULONG ReportTimerDue;
+    LONG       ReportTimerSequence;
+
+    //
+    // Index in padDevices, which the control device's IOCTLs refer to.
+    // DP_MAX_PADS until the device is ready for input. PadRundown is held
+    // by each IOCTL using the pad, so removal can wait for them to finish.
+    //
+    ULONG      PadIndex;
+    EX_RUNDOWN_REF PadRundown;
+
+    //
+    // If set, a parked IOCTL_HID_READ_REPORT is completed as soon as new
+    // input arrives through the control device, rather than on the next
+    // timer tick.
+    //
+    BOOLEAN    CompleteOnInput;
+
+    READ_POLICY ReadPolicy;
+
+    //
+    // Parked reads are only completed once the input has changed since the
+    // last one, or, if MaxStaleMillis isn't 0, once that report is older
+    // than MaxStaleMillis. DeliveredSequence is the State sequence the last
+    // completed read was at least as new as, and DeliveredTime when it was
+    // completed (interrupt time). ReportsSuppressed counts reads that were
+    // parked while no report was due, so had to be held, once each. The
+    // counts are reported by IOCTL_DP_GET_STATS, with ReadsTimedOut below.
+    //
+    ULONG      MaxStaleMillis;
+    LONG       DeliveredSequence;
+    ULONGLONG  DeliveredTime;
+    volatile LONG ReportsDelivered;
+    volatile LONG ReportsSuppressed;
+
+    //
+    // More counts for IOCTL_DP_GET_PERF_STATS, along with the ones above:
+    // frames of input taken from any source, frames turned away (malformed,
+    // or the ring was full), reads parked, reads completed only because
+    // MaxStaleMillis passed, and reads failed because their buffer was too
+    // small. The histograms are of how
+    // long after its input arrived each report was read (microseconds), and
+    // of how many reports were queued when it was.
+    //
+    volatile LONG InputsReceived;
+    volatile LONG InputsRejected;
+    volatile LONG ReadsParked;
+    volatile LONG ReadsTimedOut;
+    volatile LONG OutputBufferFailures;
+    DP_HISTOGRAM  LatencyHistogram;
+    DP_HISTOGRAM  QueueDepthHistogram;
+
+    // What the pad was last set up with, for IOCTL_DP_GET_PAD_SETTINGS.
+    // Protected by RingLock.
+    PAD_SETTINGS  Settings;
+
+    // Everything input goes through on its way into a report, and the last
+    // report published. Protected by RingLock, apart from the report timer's
+    // unlocked looks at State.Sequence and the ring, jitter and button edge
+    // fields, where a stale value only costs a tick at the wrong period.
+    REPORT_PIPELINE Pipeline;
+
+    // Shape of the reports sent to HIDCLASS. Fixed once the device is added.
+    REPORT_LAYOUT Layout;
+
+    // Lock over Pipeline and the shared input page. Named for the ring of
+    // reports not yet delivered to a read, which Pipeline holds.
+    WDFSPINLOCK  RingLock;
+
+    // Shared input page mapped by a client, or NULL, and the last sequence
+    // number read from it. Protected by RingLock.
+    PSHARED_INPUT SharedInput;
+    LONG          SharedInputSequence;
+
+} DEVICE_EXTENSION, * PDEVICE_EXTENSION;
+
+WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(DEVICE_EXTENSION, GetDeviceContext)
+
+//
+// driver routine declarations
+//
+// This type of function declaration is for Prefast for drivers. 
+// Because this declaration specifies the function type, PREfast for Drivers
+// does not need to infer the type or to report an inference. The declaration
+// also prevents PREfast for Drivers from misinterpreting the function type 
+// and applying inappropriate rules to the function. For example, PREfast for
+// Drivers would not apply rules for completion routines to functions of type
+// DRIVER_CANCEL. The preferred way to avoid Warning 28101 is to declare the
+// function type explicitly. In the following example, the DriverEntry function
+// is declared to be of type DRIVER_INITIALIZE.
+//
+DRIVER_INITIALIZE DriverEntry;
+
+EVT_WDF_DRIVER_DEVICE_ADD dpEvtDeviceAdd;
+
+EVT_WDF_IO_QUEUE_IO_INTERNAL_DEVICE_CONTROL dpEvtInternalDeviceControl;
+
+NTSTATUS
+dpGetHidDescriptor(
+    IN WDFDEVICE Device,
+    IN WDFREQUEST Request
+    );
+
+NTSTATUS
+dpGetReportDescriptor(
+    IN WDFDEVICE Device,
+    IN WDFREQUEST Request
+    );
+
+
+NTSTATUS
+dpGetDeviceAttributes(
+    IN WDFREQUEST Request
+    );
+
+NTSTATUS
+dpConfigContReaderForInterruptEndPoint(
+    PDEVICE_EXTENSION DeviceContext
+    );
+
+EVT_WDF_USB_READER_COMPLETION_ROUTINE dpEvtUsbInterruptPipeReadComplete;
+
+BOOLEAN
+dpReportDue(
+    IN PDEVICE_EXTENSION DevContext,
+    OUT PBOOLEAN         Stale
+    );
+
+ULONG
+dpCompleteReadReport(
+    WDFDEVICE Device,
+    BOOLEAN   DrainAll
+    );
+
+EVT_WDF_OBJECT_CONTEXT_CLEANUP dpEvtDriverContextCleanup;
+
+EVT_WDF_TIMER dpEvtTimerFunction;
+
+VOID
+dpKickReportTimer(
+    IN PDEVICE_EXTENSION DevContext,
+    IN BOOLEAN           NewInput
+    );
+
+VOID
+dpTrace(
+    IN USHORT Message,
+    IN ULONG  Arg0,
+    IN ULONG  Arg1,
+    IN ULONG  Arg2
+    );
+
+ULONG
+dpReadTrace(
+    OUT PDP_TRACE_RECORD Records,
+    IN ULONG             MaxRecords
+    );
+
+NTSTATUS
+dpCreateControlDevice(
+    WDFDEVICE Device
+    );
+VOID
+dpDeleteControlDevice(
+    WDFDEVICE Device
+    );
+
+EVT_WDF_OBJECT_CONTEXT_CLEANUP dpEvtDeviceContextCleanup;
+
+int deviceCounterChange(int difference);
+#define deviceCounterIncrement() deviceCounterChange(1)
+#define deviceCounterDecrement() deviceCounterChange(-1)
+int deviceCounterReset();
+/**
+ * Gets the device count from the registry
+ */
+ULONG loadDeviceCount(PWSTR RegistryPath);
+
+/**
+ * gets the current device count
+ */
+int getDeviceCount();
+
+/**
+ * Reads a DWORD parameter from the device's hardware key, or returns
+ * DefaultValue if it isn't there.
+ */
+ULONG
+dpReadDeviceParameter(
+    IN WDFDEVICE Device,
+    IN PCWSTR    ValueName,
+    IN ULONG     DefaultValue
+    );
+
+EVT_WDF_IO_QUEUE_IO_DEVICE_CONTROL dpEvtIoDeviceControl;
+
+PDEVICE_EXTENSION
+dpAcquirePad(
+    IN ULONG Pad
+    );
+
+VOID
+dpReleasePad(
+    IN PDEVICE_EXTENSION DevContext
+    );
+
+EVT_WDF_IO_IN_CALLER_CONTEXT dpEvtIoInCallerContext;
+
+EVT_WDF_FILE_CLEANUP dpEvtFileCleanup;
+
+NTSTATUS
+dpMapSharedInput(
+    IN WDFDEVICE  ControlDevice,
+    IN WDFREQUEST Request
+    );
+
+PCHAR
+DbgHidInternalIoctlString(
+    IN ULONG        IoControlCode
+    );
+
+NTSTATUS
+dpSubmitInput(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PINPUT_DATA       Data,
+    IN LONGLONG          Timestamp
+    );
+
+NTSTATUS
+dpSubmitInputUpdate(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PINPUT_UPDATE     Update,
+    IN size_t            Size,
+    IN LONGLONG          Timestamp
+    );
+
+NTSTATUS
+dpSetAxisTransforms(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PCALIBRATION      Calibration,
+    IN PAXIS_TRANSFORM   Transforms
+    );
+
+VOID
+dpSetAxisFilters(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PFILTER_CONFIG    Config
+    );
+
+NTSTATUS
+dpSubmitTimedInput(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PTIMED_INPUT_DATA Input,
+    IN LONGLONG          Arrival
+    );
+
+NTSTATUS
+dpSetRemap(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PREMAP_CONFIG     Config,
+    IN PREMAP            Remap
+    );
+
+VOID
+dpSetTurbo(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PTURBO_CONFIG     Config
+    );
+
+VOID
+dpRunMacro(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PMACRO            Macro
+    );
+
+PCAPTURE_RING
+dpSetCapture(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PCAPTURE_RING     Ring
+    );
+
+VOID
+dpGetPadSettings(
+    IN PDEVICE_EXTENSION DevContext,
+    OUT PPAD_SETTINGS    Settings
+    );
+
+NTSTATUS
+dpReadCapture(
+    IN PDEVICE_EXTENSION DevContext,
+    OUT PCAPTURE_RECORD  Records,
+    IN ULONG             MaxRecords,
+    OUT PULONG           Count
+    );
+
+BOOLEAN
+dpNextReport(
+    IN PDEVICE_EXTENSION DevContext,
+    OUT PHID_INPUT_REPORT Report,
+    OUT PLONGLONG         Arrival,
+    OUT PULONG            Queued,
+    OUT PLONG             Sequence
+    );
+
+#if (OSVER(NTDDI_VERSION) > NTDDI_WIN2K)
+
+NTSTATUS
+dpSendIdleNotification(
+    IN WDFREQUEST Request
+    );
+
+#endif  //(OSVER(NTDDI_VERSION) > NTDDI_WIN2K)
+
+NTSTATUS
+dpSetFeature(
+    IN WDFREQUEST Request
+    );
+
+EVT_WDF_IO_QUEUE_IO_CANCELED_ON_QUEUE dpEvtIoCanceledOnQueue;
+
+NTSTATUS
+SendVendorCommand(
+    IN WDFDEVICE Device,
+    IN UCHAR VendorCommand,
+    IN PUCHAR CommandData
+    );
+
+#endif   //_DROIDPAD_DRIVER_H_
+
+
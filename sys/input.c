@@ -1,437 +1,866 @@
-/*++
-
- * This file is part of DroidPad.
- * DroidPad lets you use an Android mobile to control a joystick or mouse
- * on a Windows or Linux computer.
- * This program is the driver for DroidPad's Joystick.
- *
- * DroidPad is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
- *
- * DroidPad is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with DroidPad, in the file COPYING.
- * If not, see <http://www.gnu.org/licenses/>.
-
-Module Name:
-
-    input.c
-
-Abstract:
-
-    Code for handling inputs via control device from userland.
-    This file is the only entirely new file, not based off code from hidusbfx2
-
-Author:
-
-
-Environment:
-
-    kernel mode only
-
-Revision History:
-
---*/
-
-#include <droidpad.h>
-
-#if defined(EVENT_TRACING)
-#include "input.tmh"
-#endif
-
-#ifdef ALLOC_PRAGMA
-    #pragma alloc_text( PAGE, dpCreateControlDevice)
-    #pragma alloc_text( PAGE, dpDeleteControlDevice)
-    #pragma alloc_text( PAGE, dpEvtDeviceContextCleanup)
-    #pragma alloc_text( PAGE, dpEvtIoDeviceControl)
-#endif
-
-WDFDEVICE controlDevice;
-
-NTSTATUS
-dpCreateControlDevice(
-    WDFDEVICE Device
-    )
-/*++
-
-Routine Description:
-
-    This routine is called to create a control device object so that application
-    can talk to the filter driver directly instead of going through the entire
-    device stack. This kind of control device object is useful if the filter
-    driver is underneath another driver which prevents ioctls not known to it
-    or if the driver's dispatch routine is owned by some other (port/class)
-    driver and it doesn't allow any custom ioctls.
-
-    NOTE: Since the control device is global to the driver and accessible to
-    all instances of the device this filter is attached to, we create only once
-    when the first instance of the device is started and delete it when the
-    last instance gets removed.
-
-Arguments:
-
-    Device - Handle to a filter device object.
-
-Return Value:
-
-    WDF status code
-
---*/
-{
-	PCONTROL_DEVICE_EXTENSION	ConDevContext = NULL;
-    PWDFDEVICE_INIT             pInit = NULL;
-    WDF_OBJECT_ATTRIBUTES       controlAttributes;
-    WDF_IO_QUEUE_CONFIG         ioQueueConfig;
-    NTSTATUS                    status;
-    WDFQUEUE                    queue;
-	UNICODE_STRING				ntDeviceName, symbolicLinkName;
-	ANSI_STRING					ntDeviceNameA, symbolicLinkNameA;
-
-	DECLARE_CONST_UNICODE_STRING(SDDL_DEVOBJ_SYS_ALL_ADM_RWX_WORLD_RW_RES_R, L"D:P(A;;GA;;;SY)(A;;GRGWGX;;;BA)(A;;GRGW;;;WD)(A;;GR;;;RC)");
-
-    PAGED_CODE();
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Entering dpCreateControlDevice\n");
-
-    //
-    // First find out whether any Control Device has been created. If the
-    // collection has more than one device then we know somebody has already
-    // created or in the process of creating the device.
-    //
-    WdfWaitLockAcquire(deviceCollectionLock, NULL);
-
-    if(WdfCollectionGetCount(deviceCollection) != 1) {
-		TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Device already exists, not recreating\n");
-		WdfWaitLockRelease(deviceCollectionLock);
-		return STATUS_SUCCESS; // No need to recreate
-    }
-    WdfWaitLockRelease(deviceCollectionLock);
-
-
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Creating Control Device\n");
-
-    //
-    //
-    // In order to create a control device, we first need to allocate a
-    // WDFDEVICE_INIT structure and set all properties.
-    //
-	    
-
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "dpCreateControlDevice: Calling WdfControlDeviceInitAllocate\n");
-    pInit = WdfControlDeviceInitAllocate( WdfDeviceGetDriver(Device), &SDDL_DEVOBJ_SYS_ALL_ADM_RWX_WORLD_RW_RES_R);
-
-    if (pInit == NULL) {
-        status = STATUS_INSUFFICIENT_RESOURCES;
-        goto Error;
-    }
-
-    //
-    // Set exclusive to false so that more than one app can talk to the
-    // control device simultaneously.
-    //
-    WdfDeviceInitSetExclusive(pInit, FALSE);
-
-	//
-	// Assign a name to the Control Device
-	// It has to be a UNICODE name hence the conversions
-	//
-	RtlInitAnsiString(&ntDeviceNameA, TEXT(NTDEVICE_NAME_STRING));
-	status = RtlAnsiStringToUnicodeString(&ntDeviceName, &ntDeviceNameA, TRUE);
-    if (!NT_SUCCESS(status)) 
-        goto Error;
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "dpCreateControlDevice: Calling WdfDeviceInitAssignName\n");
-    status = WdfDeviceInitAssignName(pInit, &ntDeviceName);
-    if (!NT_SUCCESS(status)) 
-        goto Error;
-	RtlFreeUnicodeString(&ntDeviceName);
-
-
-    //
-    // Specify the size of device context & create the Control Device
-    //
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "dpCreateControlDevice: Creating Control Device\n");
-    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&controlAttributes, CONTROL_DEVICE_EXTENSION);
-    status = WdfDeviceCreate(&pInit, &controlAttributes, &controlDevice);
-    if (!NT_SUCCESS(status))
-        goto Error;
-
-    //
-    // Create a symbolic link for the control object so that usermode can open
-    // the device.
-    //
- 	// It has to be a UNICODE name hence the conversions
-	//
-	RtlInitAnsiString(&symbolicLinkNameA, TEXT(SYMBOLIC_NAME_STRING));
-	status = RtlAnsiStringToUnicodeString(&symbolicLinkName, &symbolicLinkNameA, TRUE);
-    if (!NT_SUCCESS(status)) 
-        goto Error;
-	status = WdfDeviceCreateSymbolicLink(controlDevice, &symbolicLinkName);
-    if (!NT_SUCCESS(status))
-	{
-		TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL, "Failed to create symbolic link (Native)\n");
-        goto Error;
-	}
-	RtlFreeUnicodeString(&symbolicLinkName);
-
-    //
-    // Configure the default queue associated with the control device object
-    // to be Serial so that request passed to EvtIoDeviceControl are serialized.
-    //
-
-    WDF_IO_QUEUE_CONFIG_INIT_DEFAULT_QUEUE(&ioQueueConfig, WdfIoQueueDispatchSequential);
-
-    ioQueueConfig.EvtIoDeviceControl = dpEvtIoDeviceControl;
-
-
-    //
-    // Framework by default creates non-power managed queues for
-    // filter drivers.
-    //
-    status = WdfIoQueueCreate(controlDevice, &ioQueueConfig, WDF_NO_OBJECT_ATTRIBUTES, &queue);
-    if (!NT_SUCCESS(status))
-        goto Error;
-
-
-	ConDevContext = ControlGetData(controlDevice);
-	ConDevContext->hParentDevice = Device;
-
-
-    //
-    // Control devices must notify WDF when they are done initializing.   I/O is
-    // rejected until this call is made.
-    //
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "dpCreateControlDevice: Calling WdfControlFinishInitializing\n");
-    WdfControlFinishInitializing(controlDevice);
-
-    return STATUS_SUCCESS;
-
-Error:
-
-    if (pInit != NULL) {
-        WdfDeviceInitFree(pInit);
-    }
-
-    if (controlDevice != NULL) {
-        //
-        // Release the reference on the newly created object, since
-        // we couldn't initialize it.
-        //
-        WdfObjectDelete(controlDevice);
-        controlDevice = NULL;
-    }
-
-    return status;
-}
-
-
-
-VOID
-dpDeleteControlDevice(
-    WDFDEVICE Device
-    )
-/*++
-
-Routine Description:
-
-    This routine deletes the control by doing a simple dereference.
-
-Arguments:
-
-    Device - Handle to a framework filter device object.
-
-Return Value:
-
-    WDF status code
-
---*/
-{
-    UNREFERENCED_PARAMETER(Device);
-
-    PAGED_CODE();
-
-	if (!controlDevice)
-	{
-		TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL, "No Control Device to delete\n");
-		return;
-	}
-
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Control Device: Purging queue\n");
-	WdfIoQueuePurge(WdfDeviceGetDefaultQueue(controlDevice), WDF_NO_EVENT_CALLBACK, WDF_NO_CONTEXT);
-
-
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Control Device: Deleting\n");
-
-    if (controlDevice) {
-		TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Control Device: Deleting (Just before WdfObjectDelete)\n");
-        WdfObjectDelete(controlDevice);
-        //WdfObjectDelete(Device);
-		TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Control Device: Deleting (Just after WdfObjectDelete)\n");
-       controlDevice = NULL;
-    }
-}
-
-VOID
-dpEvtDeviceContextCleanup(
-    IN WDFDEVICE Device
-    )
-/**
- * Cleans up device context on remove
- */
-{
-    ULONG   count;
-
-    PAGED_CODE();
-
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Entered FilterEvtDeviceContextCleanup\n");
-
-	count = deviceCounterDecrement();
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Device Count before decrementing is %d\n", count);
-	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Device Count after decrementing is %d\n", getDeviceCount());
-
-    WdfWaitLockAcquire(deviceCollectionLock, NULL);
-
-    if(WdfCollectionGetCount(deviceCollection) == 1)
-	{
-		// Delete control device if this is last instance
-		dpDeleteControlDevice(Device);
-    }
-
-    WdfCollectionRemove(deviceCollection, Device);
-
-    WdfWaitLockRelease(deviceCollectionLock);
-}
-
-// Device counter modifiers - each one acquires and releases the lock.
-
-// Returns the old value
-int
-deviceCounterChange(int difference)
-{
-	NTSTATUS status = WdfWaitLockAcquire(deviceCounterLock, NULL);
-	int old;
-	if(!NT_SUCCESS(status)) {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "deviceCounterChange failed with status code 0x%x\n", status);
-        return -1;
-	}
-	old = deviceCounter;
-	deviceCounter += difference;
-	WdfWaitLockRelease(deviceCounterLock);
-	return old;
-}
-// Returns 0 on failure (similar to boolean type)
-int deviceCounterReset()
-{
-	NTSTATUS status = WdfWaitLockAcquire(deviceCounterLock, NULL);
-	if(!NT_SUCCESS(status)) {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "deviceCounterReset failed with status code 0x%x\n", status);
-        return 0;
-	}
-	deviceCounter = 0;
-	WdfWaitLockRelease(deviceCounterLock);
-	return 1;
-}
-
-/**
- * gets the current device count
- */
-int getDeviceCount() {
-	NTSTATUS status = WdfWaitLockAcquire(deviceCounterLock, NULL);
-	int val;
-	if(!NT_SUCCESS(status)) {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "getDeviceCount failed with status code 0x%x\n", status);
-        return -1;
-	}
-	val = deviceCounter;
-	WdfWaitLockRelease(deviceCounterLock);
-	return val;
-}
-
-VOID
-dpEvtIoDeviceControl(
-    IN WDFQUEUE     Queue,
-    IN WDFREQUEST   Request,
-    IN size_t       OutputBufferLength,
-    IN size_t       InputBufferLength,
-    IN ULONG        IoControlCode
-    )
-/**
- * This is called when an IOCTL is received from the control device created above.
- * It is used to receive signals & messages from userland applications (namely DroidPad).
- */
-{
-    NTSTATUS             status= STATUS_SUCCESS;
-    WDFDEVICE            hDevice = WdfIoQueueGetDevice(Queue);
-    PCONTROL_DEVICE_EXTENSION			 ControlDevContext = ControlGetData(hDevice);
-    PDEVICE_EXTENSION    pDevContext = NULL;
-    PVOID  buffer;
-    size_t  bufSize;
-	PINPUT_DATA jsData;
-	size_t	bytesReturned = 0;
-
-	UNREFERENCED_PARAMETER(OutputBufferLength);
-	UNREFERENCED_PARAMETER(InputBufferLength);
-
-	// KdPrint(("dpEvtIoDeviceControl called\n"));
-
-	PAGED_CODE();
-
-	switch (IoControlCode) {
-
-	case IOCTL_DP_SEND_INPUT_DATA:
-		status = WdfRequestRetrieveInputBuffer( Request, sizeof(INPUT_DATA), &buffer, &bufSize);
-		if(!NT_SUCCESS(status)) break;
-
-		jsData = buffer;
-		pDevContext = GetDeviceContext(ControlDevContext->hParentDevice);
-		copyInputData(jsData, &(pDevContext->inputs));
-		break;
-	default:
-		status = STATUS_INVALID_DEVICE_REQUEST;
-    }
-
-    WdfRequestCompleteWithInformation(Request, status, bytesReturned);
-
-}
-
-VOID
-copyInputData(
-    IN PINPUT_DATA from,
-    OUT PHID_INPUT_REPORT to
-     )
-/**
- * Copies input data from the given input data into the HID input report.
- * Currently these data structures are the same, but they may change in the future.
- */
-{
-	if(!from || !to) {
-		TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL, "copyInputData received a null argument\n");
-		return;
-	}
-	to->inputs.axisX = from->axisX;
-	to->inputs.axisY = from->axisY;
-	to->inputs.axisZ = from->axisZ;
-	to->inputs.axisRX = from->axisRX;
-	to->inputs.axisRY = from->axisRY;
-	to->inputs.axisRZ = from->axisRZ;
-	to->inputs.buttons = from->buttons & 0xFFFF; // First 16 buttons only
-	return;
-}
-
-VOID
-resetHidReport(
-				OUT PHID_INPUT_REPORT report
-			  )
-{
-	report->inputs.axisX = JS_RESTING_PLACE;
-	report->inputs.axisY = JS_RESTING_PLACE;
-	report->inputs.axisZ = JS_RESTING_PLACE;
-	report->inputs.axisRX = JS_RESTING_PLACE;
-	report->inputs.axisRY = JS_RESTING_PLACE;
-	report->inputs.axisRZ = JS_RESTING_PLACE;
-	report->inputs.buttons = 0x0;
-}
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    input.c
+
+Abstract:
+
+    Code for handling inputs via control device from userland.
+    This file is the only entirely new file, not based off code from hidusbfx2
+
+Author:
+
+
+Environment:
+
+    kernel mode only
+
+Revision History:
+
+--*/
+
+#include <droidpad.h>
+
+#if defined(EVENT_TRACING)
+#include "input.tmh"
+#endif
+
+#ifdef ALLOC_PRAGMA
+    #pragma alloc_text( PAGE, dpCreateControlDevice)
+    #pragma alloc_text( PAGE, dpDeleteControlDevice)
+    #pragma alloc_text( PAGE, dpEvtDeviceContextCleanup)
+    #pragma alloc_text( PAGE, dpEvtIoDeviceControl)
+    #pragma alloc_text( PAGE, dpAcquirePad)
+    #pragma alloc_text( PAGE, dpReleasePad)
+#endif
+
+WDFDEVICE controlDevice;
+WDFDEVICE padDevices[DP_MAX_PADS];
+
+NTSTATUS
+dpCreateControlDevice(
+    WDFDEVICE Device
+    )
+/*++
+
+Routine Description:
+
+    This routine is called to create a control device object so that application
+    can talk to the filter driver directly instead of going through the entire
+    device stack. This kind of control device object is useful if the filter
+    driver is underneath another driver which prevents ioctls not known to it
+    or if the driver's dispatch routine is owned by some other (port/class)
+    driver and it doesn't allow any custom ioctls.
+
+    NOTE: Since the control device is global to the driver and accessible to
+    all instances of the device this filter is attached to, we create only once
+    when the first instance of the device is started and delete it when the
+    last instance gets removed.
+
+Arguments:
+
+    Device - Handle to a filter device object.
+
+Return Value:
+
+    WDF status code
+
+--*/
+{
+    PWDFDEVICE_INIT             pInit = NULL;
+    WDF_OBJECT_ATTRIBUTES       controlAttributes;
+    WDF_IO_QUEUE_CONFIG         ioQueueConfig;
+    WDF_FILEOBJECT_CONFIG       fileConfig;
+    WDF_OBJECT_ATTRIBUTES       fileAttributes;
+    NTSTATUS                    status;
+    WDFQUEUE                    queue;
+	UNICODE_STRING				ntDeviceName, symbolicLinkName;
+	ANSI_STRING					ntDeviceNameA, symbolicLinkNameA;
+
+	DECLARE_CONST_UNICODE_STRING(SDDL_DEVOBJ_SYS_ALL_ADM_RWX_WORLD_RW_RES_R, L"D:P(A;;GA;;;SY)(A;;GRGWGX;;;BA)(A;;GRGW;;;WD)(A;;GR;;;RC)");
+
+    PAGED_CODE();
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Entering dpCreateControlDevice\n");
+
+    //
+    // First find out whether any Control Device has been created. If the
+    // collection has more than one device then we know somebody has already
+    // created or in the process of creating the device.
+    //
+    WdfWaitLockAcquire(deviceCollectionLock, NULL);
+
+    if(WdfCollectionGetCount(deviceCollection) != 1) {
+		TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Device already exists, not recreating\n");
+		WdfWaitLockRelease(deviceCollectionLock);
+		return STATUS_SUCCESS; // No need to recreate
+    }
+    WdfWaitLockRelease(deviceCollectionLock);
+
+
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Creating Control Device\n");
+
+    //
+    //
+    // In order to create a control device, we first need to allocate a
+    // WDFDEVICE_INIT structure and set all properties.
+    //
+	    
+
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "dpCreateControlDevice: Calling WdfControlDeviceInitAllocate\n");
+    pInit = WdfControlDeviceInitAllocate( WdfDeviceGetDriver(Device), &SDDL_DEVOBJ_SYS_ALL_ADM_RWX_WORLD_RW_RES_R);
+
+    if (pInit == NULL) {
+        status = STATUS_INSUFFICIENT_RESOURCES;
+        goto Error;
+    }
+
+    //
+    // Set exclusive to false so that more than one app can talk to the
+    // control device simultaneously.
+    //
+    WdfDeviceInitSetExclusive(pInit, FALSE);
+
+    //
+    // IOCTL_DP_MAP_SHARED_INPUT has to map its page into the calling process,
+    // so requests are looked at in the caller's context before being queued.
+    // The page is unmapped when the handle it was mapped through is closed.
+    //
+    WdfDeviceInitSetIoInCallerContextCallback(pInit, dpEvtIoInCallerContext);
+
+    WDF_FILEOBJECT_CONFIG_INIT(&fileConfig, WDF_NO_EVENT_CALLBACK, WDF_NO_EVENT_CALLBACK, dpEvtFileCleanup);
+    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&fileAttributes, FILE_EXTENSION);
+    WdfDeviceInitSetFileObjectConfig(pInit, &fileConfig, &fileAttributes);
+
+	//
+	// Assign a name to the Control Device
+	// It has to be a UNICODE name hence the conversions
+	//
+	RtlInitAnsiString(&ntDeviceNameA, TEXT(NTDEVICE_NAME_STRING));
+	status = RtlAnsiStringToUnicodeString(&ntDeviceName, &ntDeviceNameA, TRUE);
+    if (!NT_SUCCESS(status)) 
+        goto Error;
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "dpCreateControlDevice: Calling WdfDeviceInitAssignName\n");
+    status = WdfDeviceInitAssignName(pInit, &ntDeviceName);
+    if (!NT_SUCCESS(status)) 
+        goto Error;
+	RtlFreeUnicodeString(&ntDeviceName);
+
+
+    //
+    // Specify the size of device context & create the Control Device
+    //
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "dpCreateControlDevice: Creating Control Device\n");
+    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&controlAttributes, CONTROL_DEVICE_EXTENSION);
+    status = WdfDeviceCreate(&pInit, &controlAttributes, &controlDevice);
+    if (!NT_SUCCESS(status))
+        goto Error;
+
+    //
+    // Create a symbolic link for the control object so that usermode can open
+    // the device.
+    //
+ 	// It has to be a UNICODE name hence the conversions
+	//
+	RtlInitAnsiString(&symbolicLinkNameA, TEXT(SYMBOLIC_NAME_STRING));
+	status = RtlAnsiStringToUnicodeString(&symbolicLinkName, &symbolicLinkNameA, TRUE);
+    if (!NT_SUCCESS(status)) 
+        goto Error;
+	status = WdfDeviceCreateSymbolicLink(controlDevice, &symbolicLinkName);
+    if (!NT_SUCCESS(status))
+	{
+		TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL, "Failed to create symbolic link (Native)\n");
+        goto Error;
+	}
+	RtlFreeUnicodeString(&symbolicLinkName);
+
+    //
+    // Configure the default queue associated with the control device object
+    // to be Serial so that request passed to EvtIoDeviceControl are serialized.
+    //
+
+    WDF_IO_QUEUE_CONFIG_INIT_DEFAULT_QUEUE(&ioQueueConfig, WdfIoQueueDispatchSequential);
+
+    ioQueueConfig.EvtIoDeviceControl = dpEvtIoDeviceControl;
+
+
+    //
+    // Framework by default creates non-power managed queues for
+    // filter drivers.
+    //
+    status = WdfIoQueueCreate(controlDevice, &ioQueueConfig, WDF_NO_OBJECT_ATTRIBUTES, &queue);
+    if (!NT_SUCCESS(status))
+        goto Error;
+
+
+    //
+    // Control devices must notify WDF when they are done initializing.   I/O is
+    // rejected until this call is made.
+    //
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "dpCreateControlDevice: Calling WdfControlFinishInitializing\n");
+    WdfControlFinishInitializing(controlDevice);
+
+    return STATUS_SUCCESS;
+
+Error:
+
+    if (pInit != NULL) {
+        WdfDeviceInitFree(pInit);
+    }
+
+    if (controlDevice != NULL) {
+        //
+        // Release the reference on the newly created object, since
+        // we couldn't initialize it.
+        //
+        WdfObjectDelete(controlDevice);
+        controlDevice = NULL;
+    }
+
+    return status;
+}
+
+
+
+VOID
+dpDeleteControlDevice(
+    WDFDEVICE Device
+    )
+/*++
+
+Routine Description:
+
+    This routine deletes the control by doing a simple dereference.
+
+Arguments:
+
+    Device - Handle to a framework filter device object.
+
+Return Value:
+
+    WDF status code
+
+--*/
+{
+    UNREFERENCED_PARAMETER(Device);
+
+    PAGED_CODE();
+
+	if (!controlDevice)
+	{
+		TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL, "No Control Device to delete\n");
+		return;
+	}
+
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Control Device: Purging queue\n");
+	WdfIoQueuePurge(WdfDeviceGetDefaultQueue(controlDevice), WDF_NO_EVENT_CALLBACK, WDF_NO_CONTEXT);
+
+
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Control Device: Deleting\n");
+
+    if (controlDevice) {
+		TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Control Device: Deleting (Just before WdfObjectDelete)\n");
+        WdfObjectDelete(controlDevice);
+        //WdfObjectDelete(Device);
+		TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Control Device: Deleting (Just after WdfObjectDelete)\n");
+       controlDevice = NULL;
+    }
+}
+
+VOID
+dpEvtDeviceContextCleanup(
+    IN WDFDEVICE Device
+    )
+/**
+ * Cleans up device context on remove
+ */
+{
+    ULONG   count;
+    PDEVICE_EXTENSION pDevContext;
+    BOOLEAN lastInstance;
+
+    PAGED_CODE();
+
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Entered FilterEvtDeviceContextCleanup\n");
+
+	count = deviceCounterDecrement();
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Device Count before decrementing is %d\n", count);
+	TraceEvents(TRACE_LEVEL_INFORMATION, DBG_INIT, "Device Count after decrementing is %d\n", getDeviceCount());
+
+    WdfWaitLockAcquire(deviceCollectionLock, NULL);
+
+	// No more input for this pad
+	pDevContext = GetDeviceContext(Device);
+	if (pDevContext->PadIndex < DP_MAX_PADS)
+		padDevices[pDevContext->PadIndex] = NULL;
+
+    lastInstance = WdfCollectionGetCount(deviceCollection) == 1;
+    WdfCollectionRemove(deviceCollection, Device);
+
+    WdfWaitLockRelease(deviceCollectionLock);
+
+	// Let any control device IOCTL that found the pad before it was taken
+	// out finish with it. After that the control device can't reach the
+	// pad, and the report path has stopped with the device, so nothing
+	// else uses the capture ring.
+	ExWaitForRundownProtectionRelease(&pDevContext->PadRundown);
+	if (pDevContext->Pipeline.Capture != NULL) {
+		ExFreePoolWithTag(pDevContext->Pipeline.Capture, DROIDPAD_POOL_TAG);
+		pDevContext->Pipeline.Capture = NULL;
+	}
+
+	// Delete control device if this is last instance. Not under the lock,
+	// which an IOCTL the deletion waits for may be trying to take.
+    if (lastInstance)
+		dpDeleteControlDevice(Device);
+}
+
+// Device counter modifiers - each one acquires and releases the lock.
+
+// Returns the old value
+int
+deviceCounterChange(int difference)
+{
+	NTSTATUS status = WdfWaitLockAcquire(deviceCounterLock, NULL);
+	int old;
+	if(!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "deviceCounterChange failed with status code 0x%x\n", status);
+        return -1;
+	}
+	old = deviceCounter;
+	deviceCounter += difference;
+	WdfWaitLockRelease(deviceCounterLock);
+	return old;
+}
+// Returns 0 on failure (similar to boolean type)
+int deviceCounterReset()
+{
+	NTSTATUS status = WdfWaitLockAcquire(deviceCounterLock, NULL);
+	if(!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "deviceCounterReset failed with status code 0x%x\n", status);
+        return 0;
+	}
+	deviceCounter = 0;
+	WdfWaitLockRelease(deviceCounterLock);
+	return 1;
+}
+
+/**
+ * gets the current device count
+ */
+int getDeviceCount() {
+	NTSTATUS status = WdfWaitLockAcquire(deviceCounterLock, NULL);
+	int val;
+	if(!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_PNP, "getDeviceCount failed with status code 0x%x\n", status);
+        return -1;
+	}
+	val = deviceCounter;
+	WdfWaitLockRelease(deviceCounterLock);
+	return val;
+}
+
+PDEVICE_EXTENSION
+dpAcquirePad(
+    IN ULONG Pad
+    )
+/**
+ * Finds the device for a pad index given to the control device.
+ * Returns NULL if there's no such pad. Otherwise the pad can't be removed
+ * until dpReleasePad is called. The pad is referenced under the lock, but
+ * used without it, so IOCTLs for different pads don't wait on each other.
+ */
+{
+	PDEVICE_EXTENSION devContext = NULL;
+
+	PAGED_CODE();
+
+	if (Pad >= DP_MAX_PADS)
+		return NULL;
+
+	WdfWaitLockAcquire(deviceCollectionLock, NULL);
+	if (padDevices[Pad] != NULL) {
+		devContext = GetDeviceContext(padDevices[Pad]);
+		WdfObjectReference(padDevices[Pad]);
+		// Can't fail: removal only starts once the pad is out of padDevices
+		ExAcquireRundownProtection(&devContext->PadRundown);
+	}
+	WdfWaitLockRelease(deviceCollectionLock);
+
+	return devContext;
+}
+
+VOID
+dpReleasePad(
+    IN PDEVICE_EXTENSION DevContext
+    )
+/**
+ * Releases a pad returned by dpAcquirePad.
+ */
+{
+	PAGED_CODE();
+
+	ExReleaseRundownProtection(&DevContext->PadRundown);
+	WdfObjectDereference(WdfObjectContextGetObject(DevContext));
+}
+
+static NTSTATUS
+applyInputBatch(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PINPUT_BATCH      Batch,
+    IN size_t            Size
+    )
+/**
+ * Applies every frame of an IOCTL_DP_SEND_INPUT_BATCH in order.
+ * Frame timestamps are in the sender's clock, so they are taken relative to
+ * the last frame, which is treated as arriving now. Stops at the first frame
+ * that can't be queued; the frames before it stay applied.
+ */
+{
+	NTSTATUS status = STATUS_SUCCESS;
+	LONGLONG now = KeQueryInterruptTime();
+	LONGLONG last, timestamp;
+	ULONG i;
+
+	if (Batch->frameCount == 0 || Batch->frameCount > INPUT_BATCH_MAX_FRAMES ||
+		Size < INPUT_BATCH_SIZE(Batch->frameCount)) {
+		dpTrace(DPT_INVALID_BATCH, Batch->frameCount, (ULONG) Size, 0);
+		return STATUS_INVALID_PARAMETER;
+	}
+
+	last = Batch->frames[Batch->frameCount - 1].timestamp;
+	for (i = 0; i < Batch->frameCount; i++) {
+		timestamp = now;
+		if (last != 0 && Batch->frames[i].timestamp != 0 && Batch->frames[i].timestamp < last)
+			timestamp = now - (last - Batch->frames[i].timestamp);
+
+		status = dpSubmitInput(DevContext, &Batch->frames[i].data, timestamp);
+		if (!NT_SUCCESS(status))
+			break;
+	}
+	return status;
+}
+
+static NTSTATUS
+setCalibration(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PCALIBRATION      Calibration
+    )
+/**
+ * Checks and applies a new calibration for all of a pad's axes.
+ */
+{
+	NTSTATUS status = STATUS_SUCCESS;
+	PAXIS_TRANSFORM transforms;
+	ULONG i;
+
+	// Too big for the stack
+	transforms = ExAllocatePoolWithTag(NonPagedPool,
+		AXIS_TRANSFORM_COUNT * sizeof(AXIS_TRANSFORM), DROIDPAD_POOL_TAG);
+	if (transforms == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		if (!dpBuildAxisTransform(&Calibration->axes[i], &transforms[i])) {
+			dpTrace(DPT_INVALID_CALIBRATION, i, 0, 0);
+			status = STATUS_INVALID_PARAMETER;
+			break;
+		}
+	}
+
+	if (NT_SUCCESS(status))
+		status = dpSetAxisTransforms(DevContext, Calibration, transforms);
+
+	ExFreePoolWithTag(transforms, DROIDPAD_POOL_TAG);
+	return status;
+}
+
+// getStats fills in a DP_STATS as the start of a DP_PERF_STATS
+C_ASSERT(FIELD_OFFSET(DP_PERF_STATS, inputsReceived) == sizeof(DP_STATS));
+
+static NTSTATUS
+getStats(
+    IN WDFREQUEST     Request,
+    OUT PDP_PERF_STATS Stats,
+    IN size_t         Size
+    )
+/**
+ * Fills in the counters for the pad named by the request's optional input:
+ * the DP_STATS ones, and the rest and the histograms if Size is that of
+ * DP_PERF_STATS.
+ */
+{
+	PDEVICE_EXTENSION devContext;
+	PULONG padIndex;
+	ULONG pad = 0;
+
+	// Both buffers are the same system buffer, so read the input first
+	if (NT_SUCCESS(WdfRequestRetrieveInputBuffer(Request, sizeof(ULONG), &padIndex, NULL)))
+		pad = *padIndex;
+
+	devContext = dpAcquirePad(pad);
+	if (devContext == NULL)
+		return STATUS_NO_SUCH_DEVICE;
+
+	RtlZeroMemory(Stats, Size);
+	Stats->pad = pad;
+	Stats->reportsDelivered = devContext->ReportsDelivered;
+	Stats->reportsSuppressed = devContext->ReportsSuppressed;
+	Stats->readsTimedOut = devContext->ReadsTimedOut;
+	if (Size >= sizeof(DP_PERF_STATS)) {
+		Stats->inputsReceived = devContext->InputsReceived;
+		Stats->inputsRejected = devContext->InputsRejected;
+		Stats->readsParked = devContext->ReadsParked;
+		Stats->outputBufferFailures = devContext->OutputBufferFailures;
+		dpHistogramRead(&devContext->LatencyHistogram, Stats->latency);
+		dpHistogramRead(&devContext->QueueDepthHistogram, Stats->queueDepth);
+	}
+
+	dpReleasePad(devContext);
+	return STATUS_SUCCESS;
+}
+
+static NTSTATUS
+getPadSettings(
+    IN WDFREQUEST     Request,
+    OUT PPAD_SETTINGS Settings
+    )
+/**
+ * Fills in the settings of the pad named by the request's optional input.
+ */
+{
+	PDEVICE_EXTENSION devContext;
+	PULONG padIndex;
+	ULONG pad = 0;
+
+	// Both buffers are the same system buffer, so read the input first
+	if (NT_SUCCESS(WdfRequestRetrieveInputBuffer(Request, sizeof(ULONG), &padIndex, NULL)))
+		pad = *padIndex;
+
+	devContext = dpAcquirePad(pad);
+	if (devContext == NULL)
+		return STATUS_NO_SUCH_DEVICE;
+
+	dpGetPadSettings(devContext, Settings);
+	Settings->pad = pad;
+
+	dpReleasePad(devContext);
+	return STATUS_SUCCESS;
+}
+
+static NTSTATUS
+setCapture(
+    IN PCAPTURE_CONFIG Config
+    )
+/**
+ * Turns capture on or off for a pad.
+ */
+{
+	PDEVICE_EXTENSION devContext;
+	PCAPTURE_RING ring = NULL;
+
+	if (Config->enable) {
+		ring = ExAllocatePoolWithTag(NonPagedPool, sizeof(CAPTURE_RING), DROIDPAD_POOL_TAG);
+		if (ring == NULL)
+			return STATUS_INSUFFICIENT_RESOURCES;
+		RtlZeroMemory(ring, sizeof(CAPTURE_RING));
+	}
+
+	devContext = dpAcquirePad(Config->pad);
+	if (devContext == NULL) {
+		if (ring != NULL)
+			ExFreePoolWithTag(ring, DROIDPAD_POOL_TAG);
+		return STATUS_NO_SUCH_DEVICE;
+	}
+	ring = dpSetCapture(devContext, ring);
+	dpReleasePad(devContext);
+
+	if (ring != NULL)
+		ExFreePoolWithTag(ring, DROIDPAD_POOL_TAG);
+	return STATUS_SUCCESS;
+}
+
+static NTSTATUS
+readCapture(
+    IN WDFREQUEST       Request,
+    OUT PCAPTURE_RECORD Records,
+    IN size_t           Size,
+    OUT size_t          *BytesReturned
+    )
+/**
+ * Fills the output with records captured from the pad named by the
+ * request's optional input.
+ */
+{
+	PDEVICE_EXTENSION devContext;
+	NTSTATUS status;
+	PULONG padIndex;
+	ULONG pad = 0, count;
+
+	// Both buffers are the same system buffer, so read the input first
+	if (NT_SUCCESS(WdfRequestRetrieveInputBuffer(Request, sizeof(ULONG), &padIndex, NULL)))
+		pad = *padIndex;
+
+	devContext = dpAcquirePad(pad);
+	if (devContext == NULL)
+		return STATUS_NO_SUCH_DEVICE;
+
+	status = dpReadCapture(devContext, Records, (ULONG) (Size / sizeof(CAPTURE_RECORD)), &count);
+	*BytesReturned = count * sizeof(CAPTURE_RECORD);
+
+	dpReleasePad(devContext);
+	return status;
+}
+
+VOID
+dpEvtIoDeviceControl(
+    IN WDFQUEUE     Queue,
+    IN WDFREQUEST   Request,
+    IN size_t       OutputBufferLength,
+    IN size_t       InputBufferLength,
+    IN ULONG        IoControlCode
+    )
+/**
+ * This is called when an IOCTL is received from the control device created above.
+ * It is used to receive signals & messages from userland applications (namely DroidPad).
+ */
+{
+    NTSTATUS             status= STATUS_SUCCESS;
+    PDEVICE_EXTENSION    pDevContext = NULL;
+    PVOID  buffer;
+    size_t  bufSize;
+	PINPUT_DATA jsData;
+	PPAD_INPUT_DATA padData;
+	size_t	bytesReturned = 0;
+	size_t	statsSize;
+	ULONG	i;
+	REMAP	remap;
+	BOOLEAN	changed = FALSE;	// Whether the pad has something new to report
+
+	UNREFERENCED_PARAMETER(Queue);
+	UNREFERENCED_PARAMETER(OutputBufferLength);
+	UNREFERENCED_PARAMETER(InputBufferLength);
+
+	// KdPrint(("dpEvtIoDeviceControl called\n"));
+
+	PAGED_CODE();
+
+	switch (IoControlCode) {
+
+	case IOCTL_DP_SEND_INPUT_DATA:
+		// From clients that only know about one pad
+		status = WdfRequestRetrieveInputBuffer( Request, sizeof(INPUT_DATA), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		jsData = buffer;
+		pDevContext = dpAcquirePad(0);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		status = dpSubmitInput(pDevContext, jsData, KeQueryInterruptTime());
+		changed = NT_SUCCESS(status);
+		break;
+	case IOCTL_DP_SEND_PAD_INPUT_DATA:
+		status = WdfRequestRetrieveInputBuffer( Request, sizeof(PAD_INPUT_DATA), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		padData = buffer;
+		pDevContext = dpAcquirePad(padData->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		status = dpSubmitInput(pDevContext, &padData->data, KeQueryInterruptTime());
+		changed = NT_SUCCESS(status);
+		break;
+	case IOCTL_DP_SEND_TIMED_INPUT_DATA:
+		status = WdfRequestRetrieveInputBuffer( Request, sizeof(TIMED_INPUT_DATA), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		pDevContext = dpAcquirePad(((PTIMED_INPUT_DATA) buffer)->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		status = dpSubmitTimedInput(pDevContext, buffer, KeQueryInterruptTime());
+		changed = NT_SUCCESS(status);
+		break;
+	case IOCTL_DP_SEND_INPUT_BATCH:
+		status = WdfRequestRetrieveInputBuffer( Request, INPUT_BATCH_SIZE(1), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		pDevContext = dpAcquirePad(((PINPUT_BATCH) buffer)->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		status = applyInputBatch(pDevContext, buffer, bufSize);
+		changed = NT_SUCCESS(status);
+		break;
+	case IOCTL_DP_SEND_INPUT_UPDATE:
+		status = WdfRequestRetrieveInputBuffer( Request, INPUT_UPDATE_SIZE(1), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		pDevContext = dpAcquirePad(((PINPUT_UPDATE) buffer)->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		status = dpSubmitInputUpdate(pDevContext, buffer, bufSize, KeQueryInterruptTime());
+		changed = NT_SUCCESS(status);
+		break;
+	case IOCTL_DP_SET_CALIBRATION:
+		status = WdfRequestRetrieveInputBuffer( Request, sizeof(CALIBRATION), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		pDevContext = dpAcquirePad(((PCALIBRATION) buffer)->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		status = setCalibration(pDevContext, buffer);
+		changed = NT_SUCCESS(status);
+		break;
+	case IOCTL_DP_SET_FILTER:
+		status = WdfRequestRetrieveInputBuffer( Request, sizeof(FILTER_CONFIG), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+			if (!dpCheckAxisFilter(&((PFILTER_CONFIG) buffer)->axes[i])) {
+				dpTrace(DPT_INVALID_FILTER, i, 0, 0);
+				status = STATUS_INVALID_PARAMETER;
+				break;
+			}
+		}
+		if(!NT_SUCCESS(status)) break;
+
+		pDevContext = dpAcquirePad(((PFILTER_CONFIG) buffer)->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		dpSetAxisFilters(pDevContext, buffer);
+		break;
+	case IOCTL_DP_SET_REMAP:
+		status = WdfRequestRetrieveInputBuffer( Request, sizeof(REMAP_CONFIG), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		if (!dpBuildRemap(buffer, &remap)) {
+			dpTrace(DPT_INVALID_REMAP, 0, 0, 0);
+			status = STATUS_INVALID_PARAMETER;
+			break;
+		}
+		pDevContext = dpAcquirePad(((PREMAP_CONFIG) buffer)->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		status = dpSetRemap(pDevContext, buffer, &remap);
+		changed = NT_SUCCESS(status);
+		break;
+	case IOCTL_DP_SET_TURBO:
+		status = WdfRequestRetrieveInputBuffer( Request, sizeof(TURBO_CONFIG), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		pDevContext = dpAcquirePad(((PTURBO_CONFIG) buffer)->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		dpSetTurbo(pDevContext, buffer);
+		changed = TRUE;
+		break;
+	case IOCTL_DP_RUN_MACRO:
+		status = WdfRequestRetrieveInputBuffer( Request, MACRO_SIZE(0), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		if (((PMACRO) buffer)->stepCount > MACRO_MAX_STEPS ||
+			bufSize < MACRO_SIZE(((PMACRO) buffer)->stepCount)) {
+			status = STATUS_INVALID_PARAMETER;
+			break;
+		}
+		pDevContext = dpAcquirePad(((PMACRO) buffer)->pad);
+		if (pDevContext == NULL) {
+			status = STATUS_NO_SUCH_DEVICE;
+			break;
+		}
+		dpRunMacro(pDevContext, buffer);
+		changed = TRUE;
+		break;
+	case IOCTL_DP_GET_STATS:
+	case IOCTL_DP_GET_PERF_STATS:
+		statsSize = IoControlCode == IOCTL_DP_GET_STATS ? sizeof(DP_STATS) : sizeof(DP_PERF_STATS);
+		status = WdfRequestRetrieveOutputBuffer( Request, statsSize, &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		status = getStats(Request, buffer, statsSize);
+		if (NT_SUCCESS(status))
+			bytesReturned = statsSize;
+		break;
+	case IOCTL_DP_GET_PAD_SETTINGS:
+		status = WdfRequestRetrieveOutputBuffer( Request, sizeof(PAD_SETTINGS), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		status = getPadSettings(Request, buffer);
+		if (NT_SUCCESS(status))
+			bytesReturned = sizeof(PAD_SETTINGS);
+		break;
+	case IOCTL_DP_SET_CAPTURE:
+		status = WdfRequestRetrieveInputBuffer( Request, sizeof(CAPTURE_CONFIG), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		status = setCapture(buffer);
+		break;
+	case IOCTL_DP_READ_CAPTURE:
+		status = WdfRequestRetrieveOutputBuffer( Request, sizeof(CAPTURE_RECORD), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		status = readCapture(Request, buffer, bufSize, &bytesReturned);
+		break;
+	case IOCTL_DP_READ_TRACE:
+		status = WdfRequestRetrieveOutputBuffer( Request, sizeof(DP_TRACE_RECORD), &buffer, &bufSize);
+		if(!NT_SUCCESS(status)) break;
+
+		bytesReturned = dpReadTrace(buffer, (ULONG) (bufSize / sizeof(DP_TRACE_RECORD))) * sizeof(DP_TRACE_RECORD);
+		break;
+	default:
+		status = STATUS_INVALID_DEVICE_REQUEST;
+    }
+
+	if (pDevContext != NULL) {
+		// Only input, and settings that change the reports, wake the reads;
+		// a refused frame or a new filter leaves the timer as it was.
+		if (changed) {
+			// Hand the new state straight to a waiting read rather than leaving
+			// it for the next timer tick.
+			if (pDevContext->CompleteOnInput)
+				dpCompleteReadReport(WdfObjectContextGetObject(pDevContext), FALSE);
+			// Whatever is left (the rest of a batch, other reads) goes out soon
+			dpKickReportTimer(pDevContext, TRUE);
+		}
+		dpReleasePad(pDevContext);
+	}
+
+    WdfRequestCompleteWithInformation(Request, status, bytesReturned);
+
+}
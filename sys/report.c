@@ -0,0 +1,373 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    report.c
+
+Abstract:
+
+    Code for handing input state from the control device to the report
+    path (the report timer and IOCTL_HID_READ_REPORT completion).
+
+Author:
+
+
+Environment:
+
+    kernel mode only
+
+Revision History:
+
+--*/
+
+#include <droidpad.h>
+
+#if defined(EVENT_TRACING)
+#include "report.tmh"
+#endif
+
+static VOID
+countInput(
+    IN PDEVICE_EXTENSION DevContext,
+    IN NTSTATUS          Status
+    )
+/**
+ * Counts a frame from userland as taken or turned away, for
+ * IOCTL_DP_GET_PERF_STATS.
+ */
+{
+	if (NT_SUCCESS(Status))
+		InterlockedIncrement(&DevContext->InputsReceived);
+	else
+		InterlockedIncrement(&DevContext->InputsRejected);
+}
+
+static VOID
+settingsChanged(
+    IN PDEVICE_EXTENSION DevContext
+    )
+/**
+ * Marks a change to the pad's settings in the capture, if it's on, as a
+ * replay of it can't follow. Called with RingLock held.
+ */
+{
+	if (DevContext->Pipeline.Capture != NULL)
+		dpCaptureRecord(DevContext->Pipeline.Capture, CAPTURE_SETTINGS, KeQueryInterruptTime(),
+			&DevContext->Pipeline.lastInput);
+}
+
+NTSTATUS
+dpSubmitInput(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PINPUT_DATA       Data,
+    IN LONGLONG          Timestamp
+    )
+/**
+ * Applies a frame of input from userland: merges it into the state, queues
+ * the report for the report path and makes it the current state.
+ * Returns STATUS_DEVICE_BUSY, leaving the state alone, if the ring is full
+ * of button changes that haven't been read yet.
+ */
+{
+	NTSTATUS status;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	status = dpPipelineSubmit(&DevContext->Pipeline, Data, Timestamp);
+	WdfSpinLockRelease(DevContext->RingLock);
+
+	if (status == STATUS_DEVICE_BUSY)
+		dpTrace(DPT_INPUT_REJECTED, DevContext->PadIndex, 0, 0);
+	countInput(DevContext, status);
+	return status;
+}
+
+NTSTATUS
+dpSubmitInputUpdate(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PINPUT_UPDATE     Update,
+    IN size_t            Size,
+    IN LONGLONG          Timestamp
+    )
+/**
+ * Applies a partial update from userland to the last full frame of input
+ * and submits the result like dpSubmitInput.
+ */
+{
+	NTSTATUS status;
+	INPUT_DATA data;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	data = DevContext->Pipeline.lastInput;
+	status = dpDecodeInputUpdate(Update, Size, &data);
+	if (NT_SUCCESS(status))
+		status = dpPipelineSubmit(&DevContext->Pipeline, &data, Timestamp);
+	WdfSpinLockRelease(DevContext->RingLock);
+
+	countInput(DevContext, status);
+	return status;
+}
+
+NTSTATUS
+dpSetAxisTransforms(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PCALIBRATION      Calibration,
+    IN PAXIS_TRANSFORM   Transforms
+    )
+/**
+ * Replaces the calibration of all the axes with Transforms, built from
+ * Calibration, and submits the last input again so the current state is
+ * calibrated the new way.
+ */
+{
+	NTSTATUS status;
+	INPUT_DATA data;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	settingsChanged(DevContext);
+	DevContext->Settings.calibration = *Calibration;
+	RtlCopyMemory(DevContext->Pipeline.Transforms, Transforms, sizeof(DevContext->Pipeline.Transforms));
+	data = DevContext->Pipeline.lastInput;
+	status = dpPipelineSubmit(&DevContext->Pipeline, &data, KeQueryInterruptTime());
+	WdfSpinLockRelease(DevContext->RingLock);
+
+	return status;
+}
+
+VOID
+dpSetAxisFilters(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PFILTER_CONFIG    Config
+    )
+/**
+ * Replaces the smoothing filters of all the axes with checked ones, which
+ * start from the next input.
+ */
+{
+	ULONG i;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	settingsChanged(DevContext);
+	DevContext->Settings.filter = *Config;
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++) {
+		dpInitAxisFilter(&Config->axes[i], &DevContext->Pipeline.Filters[i]);
+	}
+	WdfSpinLockRelease(DevContext->RingLock);
+}
+
+NTSTATUS
+dpSetRemap(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PREMAP_CONFIG     Config,
+    IN PREMAP            Remap
+    )
+/**
+ * Replaces the remapping with Remap, built from Config, and submits the last
+ * input again so the current state is remapped the new way.
+ */
+{
+	NTSTATUS status;
+	INPUT_DATA data;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	settingsChanged(DevContext);
+	DevContext->Settings.remap = *Config;
+	DevContext->Pipeline.Remap = *Remap;
+	data = DevContext->Pipeline.lastInput;
+	status = dpPipelineSubmit(&DevContext->Pipeline, &data, KeQueryInterruptTime());
+	WdfSpinLockRelease(DevContext->RingLock);
+
+	return status;
+}
+
+VOID
+dpSetTurbo(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PTURBO_CONFIG     Config
+    )
+/**
+ * Replaces the turbo periods of all the buttons.
+ */
+{
+	WdfSpinLockAcquire(DevContext->RingLock);
+	settingsChanged(DevContext);
+	DevContext->Settings.turbo = *Config;
+	dpButtonEngineSetTurbo(&DevContext->Pipeline.Buttons, Config, DevContext->Pipeline.inputs.inputs.buttons,
+		KeQueryInterruptTime());
+	WdfSpinLockRelease(DevContext->RingLock);
+}
+
+VOID
+dpRunMacro(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PMACRO            Macro
+    )
+/**
+ * Starts a checked macro now.
+ */
+{
+	WdfSpinLockAcquire(DevContext->RingLock);
+	dpButtonEngineRunMacro(&DevContext->Pipeline.Buttons, Macro, KeQueryInterruptTime());
+	WdfSpinLockRelease(DevContext->RingLock);
+}
+
+PCAPTURE_RING
+dpSetCapture(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PCAPTURE_RING     Ring
+    )
+/**
+ * Starts capturing into Ring, or stops capturing if Ring is NULL. If
+ * capture is already on it carries on into the ring it has.
+ * Returns the ring left unused, for the caller to free, or NULL.
+ */
+{
+	PCAPTURE_RING unused;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	if (Ring != NULL && DevContext->Pipeline.Capture != NULL) {
+		unused = Ring;
+	} else {
+		unused = DevContext->Pipeline.Capture;
+		DevContext->Pipeline.Capture = Ring;
+	}
+	WdfSpinLockRelease(DevContext->RingLock);
+
+	return unused;
+}
+
+VOID
+dpGetPadSettings(
+    IN PDEVICE_EXTENSION DevContext,
+    OUT PPAD_SETTINGS    Settings
+    )
+/**
+ * Copies out the pad's settings, all from the same moment.
+ */
+{
+	WdfSpinLockAcquire(DevContext->RingLock);
+	*Settings = DevContext->Settings;
+	WdfSpinLockRelease(DevContext->RingLock);
+}
+
+NTSTATUS
+dpReadCapture(
+    IN PDEVICE_EXTENSION DevContext,
+    OUT PCAPTURE_RECORD  Records,
+    IN ULONG             MaxRecords,
+    OUT PULONG           Count
+    )
+/**
+ * Moves up to MaxRecords captured records out, oldest first.
+ * Returns STATUS_INVALID_DEVICE_STATE if capture isn't on.
+ */
+{
+	NTSTATUS status = STATUS_SUCCESS;
+
+	*Count = 0;
+	WdfSpinLockAcquire(DevContext->RingLock);
+	if (DevContext->Pipeline.Capture != NULL)
+		*Count = dpCaptureDrain(DevContext->Pipeline.Capture, Records, MaxRecords);
+	else
+		status = STATUS_INVALID_DEVICE_STATE;
+	WdfSpinLockRelease(DevContext->RingLock);
+
+	return status;
+}
+
+static VOID
+pollSharedInput(
+    IN PDEVICE_EXTENSION DevContext
+    )
+/**
+ * Picks up a frame written to the shared input page since the last poll,
+ * if one is mapped. A frame the ring can't take yet is picked up again on
+ * a later poll, unless a newer one replaces it. The caller holds RingLock.
+ */
+{
+	PSHARED_INPUT shared = DevContext->SharedInput;
+	INPUT_DATA data;
+	LONG sequence;
+
+	if (shared == NULL || !dpSharedInputRead(shared, DevContext->SharedInputSequence, &data, &sequence))
+		return;
+
+	// If the ring is full, leave the frame to be taken again once a read
+	// has made room
+	if (NT_SUCCESS(dpPipelineSubmit(&DevContext->Pipeline, &data, KeQueryInterruptTime()))) {
+		DevContext->SharedInputSequence = sequence;
+		InterlockedIncrement(&DevContext->InputsReceived);
+	}
+}
+
+NTSTATUS
+dpSubmitTimedInput(
+    IN PDEVICE_EXTENSION DevContext,
+    IN PTIMED_INPUT_DATA Input,
+    IN LONGLONG          Arrival
+    )
+/**
+ * Applies a frame of timestamped input from userland, through the jitter
+ * buffer if the device has one, otherwise like dpSubmitInput.
+ */
+{
+	NTSTATUS status;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	status = dpPipelineSubmitTimed(&DevContext->Pipeline, Input, Arrival);
+	WdfSpinLockRelease(DevContext->RingLock);
+
+	countInput(DevContext, status);
+	return status;
+}
+
+BOOLEAN
+dpNextReport(
+    IN PDEVICE_EXTENSION DevContext,
+    OUT PHID_INPUT_REPORT Report,
+    OUT PLONGLONG         Arrival,
+    OUT PULONG            Queued,
+    OUT PLONG             Sequence
+    )
+/**
+ * Takes the next report to send, after picking up any new frame on the
+ * shared input page. See dpPipelineNext. Queued is set to the number of
+ * reports that were waiting in the ring, including this one, or 0 if the
+ * report was made from the current state. Sequence is set to the State
+ * sequence once the report is taken, counting the frame picked up and any
+ * smoothing step; the report is that state unless more are still queued.
+ * Returns TRUE if the report came from the ring, and sets Arrival to when
+ * its input arrived.
+ */
+{
+	BOOLEAN found;
+
+	WdfSpinLockAcquire(DevContext->RingLock);
+	pollSharedInput(DevContext);
+	found = dpPipelineNext(&DevContext->Pipeline, KeQueryInterruptTime(), Report);
+	*Sequence = DevContext->Pipeline.State.Sequence;
+	// Counted after any timed input due was released into the ring
+	*Queued = found ? DevContext->Pipeline.Ring.Count + 1 : 0;
+	*Arrival = found ? DevContext->Pipeline.LastArrival : 0;
+	WdfSpinLockRelease(DevContext->RingLock);
+
+	return found;
+}
@@ -0,0 +1,256 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    shared.c
+
+Abstract:
+
+    Code for the shared input page, which lets a userland client publish
+    input with plain memory writes instead of an IOCTL per frame.
+
+Author:
+
+
+Environment:
+
+    kernel mode only
+
+Revision History:
+
+--*/
+
+#include <droidpad.h>
+
+#if defined(EVENT_TRACING)
+#include "shared.tmh"
+#endif
+
+#ifdef ALLOC_PRAGMA
+    #pragma alloc_text( PAGE, dpEvtIoInCallerContext)
+    #pragma alloc_text( PAGE, dpEvtFileCleanup)
+    #pragma alloc_text( PAGE, dpMapSharedInput)
+#endif
+
+VOID
+dpEvtIoInCallerContext(
+    IN WDFDEVICE  Device,
+    IN WDFREQUEST Request
+    )
+/**
+ * Called for every request to the control device, in the context of the
+ * process that sent it. IOCTL_DP_MAP_SHARED_INPUT is handled here, since it
+ * needs that process; everything else goes on to the queue as normal.
+ */
+{
+    NTSTATUS               status;
+    WDF_REQUEST_PARAMETERS params;
+
+    PAGED_CODE();
+
+    WDF_REQUEST_PARAMETERS_INIT(&params);
+    WdfRequestGetParameters(Request, &params);
+
+    if (params.Type == WdfRequestTypeDeviceControl &&
+        params.Parameters.DeviceIoControl.IoControlCode == IOCTL_DP_MAP_SHARED_INPUT) {
+        status = dpMapSharedInput(Device, Request);
+        WdfRequestComplete(Request, status);
+        return;
+    }
+
+    status = WdfDeviceEnqueueRequest(Device, Request);
+    if (!NT_SUCCESS(status)) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL,
+            "WdfDeviceEnqueueRequest failed with status 0x%x\n", status);
+        WdfRequestComplete(Request, status);
+    }
+}
+
+NTSTATUS
+dpMapSharedInput(
+    IN WDFDEVICE  ControlDevice,
+    IN WDFREQUEST Request
+    )
+/**
+ * Allocates a shared input page, maps it into the calling process and
+ * starts reading input for a pad from it. Only one page can be mapped per
+ * pad at a time, and only one per handle.
+ */
+{
+    NTSTATUS              status;
+    PFILE_EXTENSION       fileContext = GetFileContext(WdfRequestGetFileObject(Request));
+    PDEVICE_EXTENSION     devContext;
+    PULONG                padIndex;
+    ULONG                 pad = 0;
+    PSHARED_INPUT_MAPPING mapping;
+    PSHARED_INPUT         shared;
+    PMDL                  mdl;
+    PVOID                 userAddress = NULL;
+    BOOLEAN               inUse;
+
+    UNREFERENCED_PARAMETER(ControlDevice);
+
+    PAGED_CODE();
+
+    // Only a process has a user address space to map into
+    if (WdfRequestGetRequestorMode(Request) != UserMode)
+        return STATUS_INVALID_DEVICE_REQUEST;
+
+    status = WdfRequestRetrieveOutputBuffer(Request, sizeof(SHARED_INPUT_MAPPING), &mapping, NULL);
+    if (!NT_SUCCESS(status))
+        return status;
+
+    // The pad index is optional; without one the page is for pad 0
+    if (NT_SUCCESS(WdfRequestRetrieveInputBuffer(Request, sizeof(ULONG), &padIndex, NULL)))
+        pad = *padIndex;
+
+    // Handled outside the sequential queue, so two maps on one handle can
+    // race; only the one that claims the handle goes on
+    if (InterlockedCompareExchange(&fileContext->SharedInputClaimed, TRUE, FALSE) != FALSE)
+        return STATUS_SHARING_VIOLATION;
+
+    shared = ExAllocatePoolWithTag(NonPagedPoolNx, PAGE_SIZE, DROIDPAD_POOL_TAG);
+    if (shared == NULL) {
+        InterlockedExchange(&fileContext->SharedInputClaimed, FALSE);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    RtlZeroMemory(shared, PAGE_SIZE);
+    shared->magic = SHARED_INPUT_MAGIC;
+    shared->version = SHARED_INPUT_VERSION;
+
+    mdl = IoAllocateMdl(shared, PAGE_SIZE, FALSE, FALSE, NULL);
+    if (mdl == NULL) {
+        ExFreePoolWithTag(shared, DROIDPAD_POOL_TAG);
+        InterlockedExchange(&fileContext->SharedInputClaimed, FALSE);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    MmBuildMdlForNonPagedPool(mdl);
+
+    // Mapping into user mode raises an exception rather than returning NULL.
+    // The page only ever holds data, so neither side can run it.
+    __try {
+        userAddress = MmMapLockedPagesSpecifyCache(mdl, UserMode, MmCached, NULL, FALSE,
+            NormalPagePriority | MdlMappingNoExecute);
+    } __except(EXCEPTION_EXECUTE_HANDLER) {
+        userAddress = NULL;
+    }
+    if (userAddress == NULL) {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_IOCTL, "Couldn't map shared input page into process\n");
+        IoFreeMdl(mdl);
+        ExFreePoolWithTag(shared, DROIDPAD_POOL_TAG);
+        InterlockedExchange(&fileContext->SharedInputClaimed, FALSE);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    devContext = dpAcquirePad(pad);
+    if (devContext == NULL) {
+        inUse = TRUE;
+        status = STATUS_NO_SUCH_DEVICE;
+    } else {
+        WdfSpinLockAcquire(devContext->RingLock);
+        inUse = devContext->SharedInput != NULL;
+        if (!inUse) {
+            devContext->SharedInput = shared;
+            devContext->SharedInputSequence = 0;
+        }
+        WdfSpinLockRelease(devContext->RingLock);
+        dpReleasePad(devContext);
+        if (inUse)
+            status = STATUS_SHARING_VIOLATION;
+    }
+
+    if (inUse) {
+        MmUnmapLockedPages(userAddress, mdl);
+        IoFreeMdl(mdl);
+        ExFreePoolWithTag(shared, DROIDPAD_POOL_TAG);
+        InterlockedExchange(&fileContext->SharedInputClaimed, FALSE);
+        return status;
+    }
+
+    // The handle can be duplicated into another process, which may be the
+    // one that closes it, so remember whose address space the mapping is in
+    fileContext->SharedInputProcess = PsGetCurrentProcess();
+    ObReferenceObject(fileContext->SharedInputProcess);
+    fileContext->SharedInput = shared;
+    fileContext->SharedInputPad = pad;
+    fileContext->SharedInputMdl = mdl;
+    fileContext->SharedInputUserAddress = userAddress;
+
+    mapping->address = (ULONGLONG) (ULONG_PTR) userAddress;
+    mapping->size = PAGE_SIZE;
+    mapping->reserved = 0;
+    WdfRequestSetInformation(Request, sizeof(SHARED_INPUT_MAPPING));
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_IOCTL, "Mapped shared input page for pad %u at %p\n", pad, userAddress);
+    return STATUS_SUCCESS;
+}
+
+VOID
+dpEvtFileCleanup(
+    IN WDFFILEOBJECT FileObject
+    )
+/**
+ * Called when the last handle to a file object on the control device is
+ * closed, in whichever process closed it. Stops reading from and unmaps its
+ * shared input page, if it has one, from the process it was mapped into.
+ */
+{
+    PFILE_EXTENSION   fileContext = GetFileContext(FileObject);
+    PDEVICE_EXTENSION devContext;
+    KAPC_STATE        apcState;
+    BOOLEAN           attached = FALSE;
+
+    PAGED_CODE();
+
+    if (fileContext->SharedInput == NULL)
+        return;
+
+    // Once this is cleared under the lock the report path can't be using the page.
+    // If the pad has gone, so has its report path.
+    devContext = dpAcquirePad(fileContext->SharedInputPad);
+    if (devContext != NULL) {
+        WdfSpinLockAcquire(devContext->RingLock);
+        if (devContext->SharedInput == fileContext->SharedInput)
+            devContext->SharedInput = NULL;
+        WdfSpinLockRelease(devContext->RingLock);
+        dpReleasePad(devContext);
+    }
+
+    // A user mode mapping can only be undone from its own address space
+    if (PsGetCurrentProcess() != fileContext->SharedInputProcess) {
+        KeStackAttachProcess((PRKPROCESS) fileContext->SharedInputProcess, &apcState);
+        attached = TRUE;
+    }
+    MmUnmapLockedPages(fileContext->SharedInputUserAddress, fileContext->SharedInputMdl);
+    if (attached)
+        KeUnstackDetachProcess(&apcState);
+    ObDereferenceObject(fileContext->SharedInputProcess);
+
+    IoFreeMdl(fileContext->SharedInputMdl);
+    ExFreePoolWithTag(fileContext->SharedInput, DROIDPAD_POOL_TAG);
+
+    fileContext->SharedInput = NULL;
+    fileContext->SharedInputMdl = NULL;
+    fileContext->SharedInputUserAddress = NULL;
+    fileContext->SharedInputProcess = NULL;
+    InterlockedExchange(&fileContext->SharedInputClaimed, FALSE);
+}
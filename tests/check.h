@@ -0,0 +1,79 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    check.h
+
+Abstract:
+
+    The little the tests need to check things: CHECK notes a failure and
+    carries on, so one run reports every check that failed, and
+    checkResult() is what main returns.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_CHECK_H_
+
+#define _DROIDPAD_CHECK_H_
+
+#include <stdio.h>
+
+static int checkFailures;
+
+#define CHECK(e) \
+	do { \
+		if (!(e)) { \
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #e); \
+			checkFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(a, b) \
+	do { \
+		long long _a = (long long) (a), _b = (long long) (b); \
+		if (_a != _b) { \
+			fprintf(stderr, "%s:%d: CHECK_EQUAL(%s, %s) failed: %lld != %lld\n", \
+				__FILE__, __LINE__, #a, #b, _a, _b); \
+			checkFailures++; \
+		} \
+	} while (0)
+
+static int
+checkResult(
+    void
+    )
+{
+	if (checkFailures != 0)
+		fprintf(stderr, "%d checks failed\n", checkFailures);
+	return checkFailures != 0;
+}
+
+#endif   //_DROIDPAD_CHECK_H_
@@ -0,0 +1,1540 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    core.c
+
+Abstract:
+
+    Checks of the portable core in core/, one test per stage a frame of
+    input goes through on its way into a report.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dpcore.h>
+#include "check.h"
+
+static double
+seconds(
+    VOID
+    )
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+#define MILLIS(m)	((LONGLONG) (m) * 10000)
+
+static REPORT_PIPELINE pipeline;
+
+static VOID
+resetPipeline(
+    VOID
+    )
+{
+	RtlZeroMemory(&pipeline, sizeof(pipeline));
+	dpInitPipeline(&pipeline);
+}
+
+static INPUT_DATA
+inputFrame(
+    IN LONG Axis,
+    IN LONG Buttons
+    )
+{
+	INPUT_DATA data;
+
+	data.axisX = data.axisY = data.axisZ = Axis;
+	data.axisRX = data.axisRY = data.axisRZ = Axis;
+	data.buttons = Buttons;
+	return data;
+}
+
+static NTSTATUS
+submit(
+    IN LONG     Axis,
+    IN LONG     Buttons,
+    IN LONGLONG Timestamp
+    )
+{
+	INPUT_DATA data = inputFrame(Axis, Buttons);
+
+	return dpPipelineSubmit(&pipeline, &data, Timestamp);
+}
+
+//
+// The state handed from input to the report path
+//
+static VOID
+testReportState(
+    VOID
+    )
+{
+	REPORT_STATE state = { 0 };
+	HID_INPUT_REPORT report, copy;
+
+	// Each report published moves the sequence on, and reads copy out the last
+	resetHidReport(&report);
+	report.inputs.axisX = 1000;
+	dpPublishReport(&state, &report);
+	CHECK_EQUAL(state.Sequence, 1);
+	report.inputs.axisX = 2000;
+	report.inputs.buttons = 0x5;
+	dpPublishReport(&state, &report);
+	CHECK_EQUAL(state.Sequence, 2);
+	dpReadReport(&state, &copy);
+	CHECK(RtlEqualMemory(&copy, &report, sizeof(report)));
+}
+
+//
+// The queue of reports between input and reads
+//
+static VOID
+testReportRing(
+    VOID
+    )
+{
+	AXIS_FILTER_CONFIG filterConfig = { AXIS_FILTER_ENABLED, 100, 0, 100 };
+	TURBO_CONFIG turbo = { 0, { 0, 100 } };
+	AXIS_FILTER filters[AXIS_TRANSFORM_COUNT];
+	BUTTON_ENGINE buttons;
+	HID_INPUT_REPORT report;
+	LONG sequence;
+	ULONG i;
+
+	// A tap between two reads is two reports, then the state is current
+	resetPipeline();
+	CHECK_EQUAL(submit(100, 1, MILLIS(1)), STATUS_SUCCESS);
+	CHECK_EQUAL(submit(200, 0, MILLIS(2)), STATUS_SUCCESS);
+	CHECK(dpPipelineNext(&pipeline, MILLIS(3), &report));
+	CHECK_EQUAL(report.inputs.buttons, 1);
+	CHECK_EQUAL(pipeline.LastArrival, MILLIS(1));
+	CHECK(dpPipelineNext(&pipeline, MILLIS(3), &report));
+	CHECK_EQUAL(report.inputs.buttons, 0);
+	CHECK_EQUAL(report.inputs.axisX, 200);
+	CHECK(!dpPipelineNext(&pipeline, MILLIS(3), &report));
+	CHECK_EQUAL(report.inputs.axisX, 200);
+
+	// Once full, axis moves are merged into the newest entry, which keeps
+	// its timestamp
+	resetPipeline();
+	for (i = 0; i < REPORT_RING_SIZE + 10; i++)
+		CHECK_EQUAL(submit(i, 0, MILLIS(i)), STATUS_SUCCESS);
+	CHECK_EQUAL(pipeline.Ring.Count, REPORT_RING_SIZE);
+	for (i = 0; i + 1 < REPORT_RING_SIZE; i++) {
+		CHECK(dpPipelineNext(&pipeline, MILLIS(100), &report));
+		CHECK_EQUAL(report.inputs.axisX, i);
+	}
+	CHECK(dpPipelineNext(&pipeline, MILLIS(100), &report));
+	CHECK_EQUAL(report.inputs.axisX, REPORT_RING_SIZE + 9);
+	CHECK_EQUAL(pipeline.LastArrival, MILLIS(REPORT_RING_SIZE - 1));
+
+	// A button change makes room by dropping the oldest entry whose buttons
+	// the next one repeats, which here is the first
+	resetPipeline();
+	CHECK_EQUAL(submit(1000, 0, 0), STATUS_SUCCESS);
+	CHECK_EQUAL(submit(1001, 0, 0), STATUS_SUCCESS);
+	for (i = 2; i < REPORT_RING_SIZE; i++)
+		CHECK_EQUAL(submit(i, i, 0), STATUS_SUCCESS);
+	CHECK_EQUAL(submit(2000, 0, 0), STATUS_SUCCESS);
+	CHECK(dpPipelineNext(&pipeline, 0, &report));
+	CHECK_EQUAL(report.inputs.buttons, 0);
+	CHECK_EQUAL(report.inputs.axisX, 1001);
+	for (i = 2; i < REPORT_RING_SIZE; i++) {
+		CHECK(dpPipelineNext(&pipeline, 0, &report));
+		CHECK_EQUAL(report.inputs.buttons, i);
+	}
+	CHECK(dpPipelineNext(&pipeline, 0, &report));
+	CHECK_EQUAL(report.inputs.axisX, 2000);
+
+	// A ring full of button changes turns a frame away, and leaves the
+	// filters, the turbo buttons and the state as they were
+	resetPipeline();
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++)
+		dpInitAxisFilter(&filterConfig, &pipeline.Filters[i]);
+	dpButtonEngineSetTurbo(&pipeline.Buttons, &turbo, 0, 0);
+	for (i = 0; i < REPORT_RING_SIZE; i++)
+		CHECK_EQUAL(submit(i * 100, i & 1 ? 0 : 3, MILLIS(i)), STATUS_SUCCESS);
+	RtlCopyMemory(filters, pipeline.Filters, sizeof(filters));
+	buttons = pipeline.Buttons;
+	sequence = pipeline.State.Sequence;
+	CHECK_EQUAL(submit(30000, 2, MILLIS(50)), STATUS_DEVICE_BUSY);
+	CHECK(memcmp(filters, pipeline.Filters, sizeof(filters)) == 0);
+	CHECK(memcmp(&buttons, &pipeline.Buttons, sizeof(buttons)) == 0);
+	CHECK_EQUAL(pipeline.State.Sequence, sequence);
+
+	// And takes it once a read has made room
+	CHECK(dpPipelineNext(&pipeline, MILLIS(50), &report));
+	CHECK_EQUAL(submit(30000, 2, MILLIS(50)), STATUS_SUCCESS);
+	CHECK(memcmp(filters, pipeline.Filters, sizeof(filters)) != 0);
+	CHECK_EQUAL(pipeline.Buttons.PressTime[1], MILLIS(50));
+}
+
+//
+// Partial input updates
+//
+#define FUZZ_ROUNDS	200000
+
+static ULONG randomState = 1;
+
+static ULONG
+randomNumber(
+    VOID
+    )
+{
+	// xorshift32, so every run sees the same numbers
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+/**
+ * What dpDecodeInputUpdate should make of Values under Mask, worked out
+ * the long way.
+ */
+static VOID
+applyUpdate(
+    IN ULONG           Mask,
+    IN const LONG     *Values,
+    IN OUT PINPUT_DATA Data
+    )
+{
+	LONG *fields[6] = { &Data->axisX, &Data->axisY, &Data->axisZ, &Data->axisRX, &Data->axisRY, &Data->axisRZ };
+	ULONG i;
+
+	for (i = 0; i < 6; i++) {
+		if (Mask & (1 << i))
+			*fields[i] = *Values++;
+	}
+	if (Mask & INPUT_UPDATE_BUTTONS)
+		Data->buttons = *Values++;
+	if (Mask & INPUT_UPDATE_BUTTONS_SET)
+		Data->buttons = Data->buttons | *Values++;
+	if (Mask & INPUT_UPDATE_BUTTONS_CLEAR)
+		Data->buttons = Data->buttons & ~*Values++;
+}
+
+static VOID
+testInputUpdate(
+    VOID
+    )
+{
+	UCHAR buffer[INPUT_UPDATE_SIZE(16)];
+	PINPUT_UPDATE update = (PINPUT_UPDATE) buffer;
+	INPUT_DATA data, expected;
+	ULONG round, mask, count, size, i;
+	PUCHAR copy;
+
+	// Only the fields in the mask change; buttons are replaced, set, cleared
+	resetInputData(&data);
+	update->mask = INPUT_UPDATE_AXIS_Y | INPUT_UPDATE_BUTTONS | INPUT_UPDATE_BUTTONS_CLEAR;
+	update->values[0] = 123;
+	update->values[1] = 0x0f;
+	update->values[2] = 0x03;
+	CHECK_EQUAL(dpDecodeInputUpdate(update, INPUT_UPDATE_SIZE(3), &data), STATUS_SUCCESS);
+	CHECK_EQUAL(data.axisX, JS_RESTING_PLACE);
+	CHECK_EQUAL(data.axisY, 123);
+	CHECK_EQUAL(data.buttons, 0x0c);
+	update->mask = INPUT_UPDATE_BUTTONS_SET;
+	update->values[0] = 0x100;
+	CHECK_EQUAL(dpDecodeInputUpdate(update, INPUT_UPDATE_SIZE(1), &data), STATUS_SUCCESS);
+	CHECK_EQUAL(data.buttons, 0x10c);
+
+	// Updates with no fields, unknown bits or too few values are refused
+	expected = data;
+	update->mask = 0;
+	CHECK_EQUAL(dpDecodeInputUpdate(update, INPUT_UPDATE_SIZE(0), &data), STATUS_INVALID_PARAMETER);
+	update->mask = 0x200 | INPUT_UPDATE_AXIS_X;
+	CHECK_EQUAL(dpDecodeInputUpdate(update, INPUT_UPDATE_SIZE(2), &data), STATUS_INVALID_PARAMETER);
+	update->mask = INPUT_UPDATE_AXIS_X | INPUT_UPDATE_AXIS_Z;
+	CHECK_EQUAL(dpDecodeInputUpdate(update, INPUT_UPDATE_SIZE(2) - 1, &data), STATUS_INVALID_PARAMETER);
+	CHECK_EQUAL(dpDecodeInputUpdate(update, 3, &data), STATUS_INVALID_PARAMETER);
+	CHECK(memcmp(&data, &expected, sizeof(data)) == 0);
+
+	// Fuzz: random masks and sizes, each decoded from a buffer of exactly
+	// that size, so reading past it shows up under a sanitizer. Whatever is
+	// refused must leave the frame alone.
+	for (round = 0; round < FUZZ_ROUNDS; round++) {
+		mask = randomNumber() & (round & 1 ? 0x3ff : INPUT_UPDATE_ALL);
+		for (count = 0, i = mask; i != 0; i &= i - 1)
+			count++;
+		size = INPUT_UPDATE_SIZE(count);
+		if (round % 4 == 0)
+			size = randomNumber() % (INPUT_UPDATE_SIZE(10) + 1);
+
+		update->mask = mask;
+		for (i = 0; i < 16; i++)
+			update->values[i] = (LONG) randomNumber();
+		copy = malloc(size ? size : 1);
+		memcpy(copy, buffer, size);
+
+		data = inputFrame((LONG) randomNumber(), (LONG) randomNumber());
+		expected = data;
+		if (mask != 0 && (mask & ~INPUT_UPDATE_ALL) == 0 && size >= INPUT_UPDATE_SIZE(count)) {
+			applyUpdate(mask, update->values, &expected);
+			CHECK_EQUAL(dpDecodeInputUpdate((PINPUT_UPDATE) copy, size, &data), STATUS_SUCCESS);
+		} else {
+			CHECK_EQUAL(dpDecodeInputUpdate((PINPUT_UPDATE) copy, size, &data), STATUS_INVALID_PARAMETER);
+		}
+		CHECK(memcmp(&data, &expected, sizeof(data)) == 0);
+		free(copy);
+	}
+}
+
+//
+// Report descriptors and layouts
+//
+#define MAX_FIELDS	64
+
+typedef struct _HID_FIELD {
+    ULONG    UsagePage;
+    ULONG    Usage;		// 0 for padding
+    ULONG    BitOffset;
+    ULONG    Bits;
+    ULONG    LogicalMaximum;
+} HID_FIELD, *PHID_FIELD;
+
+typedef struct _PARSED_DESCRIPTOR {
+    ULONG     FieldCount;
+    HID_FIELD Fields[MAX_FIELDS];
+    ULONG     ReportBits;
+    BOOLEAN   Valid;
+} PARSED_DESCRIPTOR, *PPARSED_DESCRIPTOR;
+
+/**
+ * Parses a report descriptor the way a host would, as far as DroidPad's
+ * use of it goes: short items, one report without an ID, INPUT items only.
+ * Each value an INPUT item declares becomes a field.
+ */
+static VOID
+parseDescriptor(
+    IN PHID_REPORT_DESCRIPTOR Descriptor,
+    IN ULONG                  Length,
+    OUT PPARSED_DESCRIPTOR    Parsed
+    )
+{
+	ULONG usagePage = 0, logicalMaximum = 0, reportSize = 0, reportCount = 0;
+	ULONG usages[MAX_FIELDS], usageCount = 0, usageMinimum = 0, usageMaximum = 0;
+	ULONG i = 0, j, n, data, depth = 0;
+	PHID_FIELD field;
+	UCHAR prefix;
+
+	RtlZeroMemory(Parsed, sizeof(*Parsed));
+	Parsed->Valid = TRUE;
+	while (i < Length) {
+		prefix = Descriptor[i++];
+		n = (prefix & 3) == 3 ? 4 : (prefix & 3);
+		if (prefix == 0xfe || i + n > Length) {
+			Parsed->Valid = FALSE;	// Long items aren't used
+			return;
+		}
+		for (data = 0, j = 0; j < n; j++)
+			data |= (ULONG) Descriptor[i++] << (8 * j);
+
+		switch (prefix & 0xfc) {
+		case 0x04: usagePage = data; break;
+		case 0x24: logicalMaximum = data; break;
+		case 0x74: reportSize = data; break;
+		case 0x94: reportCount = data; break;
+		case 0x84: Parsed->Valid = FALSE; break;	// No report IDs
+		case 0x08:
+			if (usageCount < MAX_FIELDS)
+				usages[usageCount++] = data;
+			break;
+		case 0x18: usageMinimum = data; break;
+		case 0x28: usageMaximum = data; break;
+		case 0xa0: depth++; break;
+		case 0xc0:
+			if (depth-- == 0)
+				Parsed->Valid = FALSE;
+			break;
+		case 0x80:
+			for (j = 0; j < reportCount; j++) {
+				if (Parsed->FieldCount == MAX_FIELDS) {
+					Parsed->Valid = FALSE;
+					return;
+				}
+				field = &Parsed->Fields[Parsed->FieldCount++];
+				field->UsagePage = usagePage;
+				field->BitOffset = Parsed->ReportBits;
+				field->Bits = reportSize;
+				field->LogicalMaximum = logicalMaximum;
+				if (data & 1)	// Constant
+					field->Usage = 0;
+				else if (usageCount > 0)
+					field->Usage = usages[min(j, usageCount - 1)];
+				else if (usageMinimum + j <= usageMaximum)
+					field->Usage = usageMinimum + j;
+				else
+					Parsed->Valid = FALSE;
+				Parsed->ReportBits += reportSize;
+			}
+			break;
+		}
+		// Local items only last until the next main item
+		if ((prefix & 0x0c) == 0) {
+			usageCount = 0;
+			usageMinimum = usageMaximum = 0;
+		}
+	}
+	if (depth != 0)
+		Parsed->Valid = FALSE;
+}
+
+static PHID_FIELD
+findField(
+    IN PPARSED_DESCRIPTOR Parsed,
+    IN ULONG              UsagePage,
+    IN ULONG              Usage,
+    IN ULONG              Index		// Of several with the same usage
+    )
+{
+	ULONG i;
+
+	for (i = 0; i < Parsed->FieldCount; i++) {
+		if (Parsed->Fields[i].UsagePage == UsagePage && Parsed->Fields[i].Usage == Usage && Index-- == 0)
+			return &Parsed->Fields[i];
+	}
+	return NULL;
+}
+
+static ULONG
+getBits(
+    IN PUCHAR Buffer,
+    IN ULONG  BitOffset,
+    IN ULONG  Bits
+    )
+{
+	ULONG value = 0, i;
+
+	for (i = 0; i < Bits; i++, BitOffset++)
+		value |= (ULONG) ((Buffer[BitOffset / 8] >> (BitOffset % 8)) & 1) << i;
+	return value;
+}
+
+/**
+ * Parses a layout's descriptor and checks it describes the reports
+ * dpPackReport writes for it: the same length, and each axis, button and
+ * hat switch found where the descriptor says, with the value packed.
+ */
+static VOID
+checkLayout(
+    IN PREPORT_LAYOUT Layout
+    )
+{
+	PARSED_DESCRIPTOR parsed;
+	HID_INPUT_REPORT report;
+	UCHAR buffer[sizeof(HID_INPUT_REPORT)];
+	PLONG axes = &report.inputs.axisX;
+	PHID_FIELD field;
+	ULONG i, value;
+
+	parseDescriptor(Layout->ReportDescriptor, Layout->ReportDescriptorLength, &parsed);
+	CHECK(parsed.Valid);
+	CHECK_EQUAL(parsed.ReportBits, Layout->ReportLength * 8);
+	CHECK_EQUAL(Layout->HidDescriptor.DescriptorList[0].wReportLength, Layout->ReportDescriptorLength);
+	CHECK(Layout->ReportLength <= sizeof(buffer));
+
+	for (i = 0; i < 6; i++)
+		axes[i] = (LONG) (i * 5000 + 123);
+	// Out of range values are clamped, other than in the legacy report,
+	// which is sent as it is
+	if (Layout->Type != ReportLayoutLegacy)
+		axes[5] = 40000;
+	report.inputs.buttons = 0xa5c3;
+	report.inputs.hats = 0x4381;
+	RtlZeroMemory(buffer, sizeof(buffer));
+	dpPackReport(Layout, &report, buffer);
+
+	for (i = 0; i < Layout->Spec.Axes; i++) {
+		field = findField(&parsed, 0x01, 0x30 + i, 0);
+		CHECK(field != NULL);
+		if (field == NULL)
+			continue;
+		CHECK_EQUAL(field->Bits, Layout->Spec.AxisBits);
+		value = (ULONG) min(axes[i], JS_MAX_VALUE);
+		if (Layout->Spec.AxisBits == 8)
+			value >>= 7;
+		CHECK(value <= field->LogicalMaximum);
+		CHECK_EQUAL(getBits(buffer, field->BitOffset, field->Bits), value);
+	}
+	CHECK(findField(&parsed, 0x01, 0x30 + Layout->Spec.Axes, 0) == NULL);
+
+	for (i = 0; i < Layout->Spec.Buttons; i++) {
+		field = findField(&parsed, 0x09, i + 1, 0);
+		CHECK(field != NULL);
+		if (field == NULL)
+			continue;
+		CHECK_EQUAL(field->BitOffset, Layout->ButtonBitOffset + i);
+		CHECK_EQUAL(getBits(buffer, field->BitOffset, 1), (report.inputs.buttons >> i) & 1);
+	}
+	CHECK(findField(&parsed, 0x09, Layout->Spec.Buttons + 1, 0) == NULL);
+
+	for (i = 0; i < Layout->Spec.Hats; i++) {
+		field = findField(&parsed, 0x01, 0x39, i);
+		CHECK(field != NULL);
+		if (field == NULL)
+			continue;
+		CHECK_EQUAL(field->BitOffset, Layout->HatBitOffset + 4 * i);
+		CHECK_EQUAL(getBits(buffer, field->BitOffset, 4), (report.inputs.hats >> (4 * i)) & 0xf);
+	}
+	CHECK(findField(&parsed, 0x01, 0x39, Layout->Spec.Hats) == NULL);
+}
+
+static VOID
+testReportLayouts(
+    VOID
+    )
+{
+	static const ULONG axisBits[] = { 8, 16, 32 };
+	REPORT_LAYOUT layout;
+	REPORT_SPEC spec;
+	ULONG i, layouts = 0;
+
+	// Every spec the registry can ask for
+	for (spec.Axes = 0; spec.Axes <= MAX_REPORT_AXES; spec.Axes++) {
+		for (i = 0; i < 3; i++) {
+			spec.AxisBits = axisBits[i];
+			for (spec.Buttons = 0; spec.Buttons <= MAX_REPORT_BUTTONS; spec.Buttons++) {
+				for (spec.Hats = 0; spec.Hats <= MAX_REPORT_HATS; spec.Hats++) {
+					if (spec.Axes + spec.Buttons + spec.Hats == 0) {
+						CHECK_EQUAL(dpBuildReportLayout(&spec, &layout), STATUS_INVALID_PARAMETER);
+						continue;
+					}
+					CHECK_EQUAL(dpBuildReportLayout(&spec, &layout), STATUS_SUCCESS);
+					checkLayout(&layout);
+					layouts++;
+				}
+			}
+		}
+	}
+	CHECK_EQUAL(layouts, 7 * 3 * 17 * 5 - 3);
+
+	spec.Axes = 7;
+	spec.AxisBits = 16;
+	spec.Buttons = spec.Hats = 0;
+	CHECK_EQUAL(dpBuildReportLayout(&spec, &layout), STATUS_INVALID_PARAMETER);
+	spec.Axes = 6;
+	spec.AxisBits = 12;
+	CHECK_EQUAL(dpBuildReportLayout(&spec, &layout), STATUS_INVALID_PARAMETER);
+	spec.AxisBits = 16;
+	spec.Buttons = 17;
+	CHECK_EQUAL(dpBuildReportLayout(&spec, &layout), STATUS_INVALID_PARAMETER);
+	spec.Buttons = 0;
+	spec.Hats = 5;
+	CHECK_EQUAL(dpBuildReportLayout(&spec, &layout), STATUS_INVALID_PARAMETER);
+
+	// The hand written descriptor agrees with HID_INPUT_REPORT
+	dpLegacyReportLayout(&layout);
+	checkLayout(&layout);
+	CHECK_EQUAL(layout.ReportLength, sizeof(HID_INPUT_REPORT));
+}
+
+static VOID
+testCompactLayout(
+    VOID
+    )
+{
+	REPORT_LAYOUT legacy, compact;
+	PARSED_DESCRIPTOR legacyFields, compactFields;
+	UCHAR legacyBuffer[sizeof(HID_INPUT_REPORT)], compactBuffer[sizeof(HID_INPUT_REPORT)];
+	HID_INPUT_REPORT report;
+	PLONG axes = &report.inputs.axisX;
+	PHID_FIELD a, b;
+	ULONG round, i;
+
+	dpLegacyReportLayout(&legacy);
+	dpCompactReportLayout(&compact);
+	CHECK_EQUAL(compact.ReportLength, sizeof(COMPACT_HID_INPUT_REPORT));
+	checkLayout(&compact);
+	parseDescriptor(legacy.ReportDescriptor, legacy.ReportDescriptorLength, &legacyFields);
+	parseDescriptor(compact.ReportDescriptor, compact.ReportDescriptorLength, &compactFields);
+
+	// A host reading either report gets the same axes and buttons
+	for (round = 0; round < 10000; round++) {
+		RtlZeroMemory(&report, sizeof(report));
+		for (i = 0; i < 6; i++)
+			axes[i] = (LONG) (randomNumber() % (JS_MAX_VALUE + 1));
+		report.inputs.buttons = (USHORT) randomNumber();
+		dpPackReport(&legacy, &report, legacyBuffer);
+		dpPackReport(&compact, &report, compactBuffer);
+
+		for (i = 0; i < 6; i++) {
+			a = findField(&legacyFields, 0x01, 0x30 + i, 0);
+			b = findField(&compactFields, 0x01, 0x30 + i, 0);
+			CHECK(a != NULL && b != NULL);
+			if (a != NULL && b != NULL)
+				CHECK_EQUAL(getBits(legacyBuffer, a->BitOffset, a->Bits),
+					getBits(compactBuffer, b->BitOffset, b->Bits));
+		}
+		// The legacy report declares 12 of its 16 buttons
+		for (i = 0; i < 12; i++) {
+			a = findField(&legacyFields, 0x09, i + 1, 0);
+			b = findField(&compactFields, 0x09, i + 1, 0);
+			CHECK(a != NULL && b != NULL);
+			if (a != NULL && b != NULL)
+				CHECK_EQUAL(getBits(legacyBuffer, a->BitOffset, 1), getBits(compactBuffer, b->BitOffset, 1));
+		}
+	}
+}
+
+//
+// Calibration
+//
+static LONG
+transformOne(
+    IN PAXIS_TRANSFORM Transform,
+    IN LONG            Value
+    )
+{
+	AXIS_TRANSFORM transforms[AXIS_TRANSFORM_COUNT];
+	HID_INPUT_REPORT report;
+
+	RtlZeroMemory(transforms, sizeof(transforms));
+	transforms[0] = *Transform;
+	report.inputs.axisX = Value;
+	dpTransformAxes(transforms, &report);
+	return report.inputs.axisX;
+}
+
+/**
+ * Runs every raw value through a calibration and checks the result never
+ * goes backwards, reaches both ends, and rests at Centre. Returns the
+ * largest step between two neighbouring raw values.
+ */
+static LONG
+checkCalibration(
+    IN USHORT Centre,
+    IN USHORT Inner,
+    IN USHORT Outer,
+    IN USHORT Curve
+    )
+{
+	AXIS_CALIBRATION calibration = { AXIS_CALIBRATION_ENABLED, Centre, Inner, Outer, Curve };
+	AXIS_TRANSFORM transform;
+	LONG value, out, last = 0, step = 0;
+
+	CHECK(dpBuildAxisTransform(&calibration, &transform));
+	CHECK_EQUAL(transformOne(&transform, 0), 0);
+	CHECK_EQUAL(transformOne(&transform, JS_MAX_VALUE), JS_MAX_VALUE);
+	CHECK_EQUAL(transformOne(&transform, Centre), JS_RESTING_PLACE);
+	CHECK_EQUAL(transformOne(&transform, -100), 0);
+	CHECK_EQUAL(transformOne(&transform, JS_MAX_VALUE + 100), JS_MAX_VALUE);
+	for (value = 0; value <= JS_MAX_VALUE; value++) {
+		out = transformOne(&transform, value);
+		CHECK(out >= last);
+		step = max(step, out - last);
+		last = out;
+	}
+	return step;
+}
+
+static VOID
+testCalibration(
+    VOID
+    )
+{
+	AXIS_CALIBRATION calibration = { 0, 0, 0, 0, 0 };
+	AXIS_TRANSFORM transforms[AXIS_TRANSFORM_COUNT];
+	HID_INPUT_REPORT report;
+	LONG value, step;
+	double start, elapsed;
+	ULONG i;
+
+	// Turned off, an axis is left as it is
+	CHECK(dpBuildAxisTransform(&calibration, &transforms[0]));
+	CHECK(!transforms[0].Enabled);
+
+	// Nonsense is refused
+	calibration.flags = AXIS_CALIBRATION_ENABLED;
+	CHECK(!dpBuildAxisTransform(&calibration, &transforms[0]));
+	calibration.centre = JS_MAX_VALUE;
+	CHECK(!dpBuildAxisTransform(&calibration, &transforms[0]));
+	calibration.centre = JS_RESTING_PLACE;
+	calibration.innerDeadzone = 20000;
+	calibration.outerDeadzone = 12767;
+	CHECK(!dpBuildAxisTransform(&calibration, &transforms[0]));
+	calibration.innerDeadzone = calibration.outerDeadzone = 0;
+	calibration.curve = JS_MAX_VALUE + 1;
+	CHECK(!dpBuildAxisTransform(&calibration, &transforms[0]));
+
+	// Linear and centred is the identity, give or take rounding
+	step = checkCalibration(JS_RESTING_PLACE, 0, 0, 0);
+	CHECK(step <= 2);
+	calibration.curve = 0;
+	dpBuildAxisTransform(&calibration, &transforms[0]);
+	for (value = 0; value <= JS_MAX_VALUE; value += 7)
+		CHECK(abs(transformOne(&transforms[0], value) - value) <= 1);
+
+	// Off centre, each side is stretched to its half of the scale
+	checkCalibration(10000, 0, 0, 0);
+	checkCalibration(30000, 0, 0, 0);
+
+	// Deadzones: rest inside the inner one, full deflection past the outer
+	// one, and no jump at either edge. Travel is measured on the full
+	// scale, so at the centre 2 raw units make about 4 of travel.
+	step = checkCalibration(JS_RESTING_PLACE, 4000, 2000, 0);
+	CHECK(step <= 3);
+	calibration.innerDeadzone = 4000;
+	calibration.outerDeadzone = 2000;
+	dpBuildAxisTransform(&calibration, &transforms[0]);
+	CHECK_EQUAL(transformOne(&transforms[0], JS_RESTING_PLACE + 1990), JS_RESTING_PLACE);
+	CHECK_EQUAL(transformOne(&transforms[0], JS_RESTING_PLACE - 1990), JS_RESTING_PLACE);
+	CHECK(transformOne(&transforms[0], JS_RESTING_PLACE + 2010) > JS_RESTING_PLACE);
+	CHECK_EQUAL(transformOne(&transforms[0], JS_MAX_VALUE - 990), JS_MAX_VALUE);
+	CHECK(transformOne(&transforms[0], JS_MAX_VALUE - 1010) < JS_MAX_VALUE);
+
+	// The cubic curve is gentler near the centre, and as steep as it gets
+	// at the ends
+	checkCalibration(JS_RESTING_PLACE, 0, 0, JS_MAX_VALUE);
+	calibration.innerDeadzone = calibration.outerDeadzone = 0;
+	calibration.curve = JS_MAX_VALUE;
+	dpBuildAxisTransform(&calibration, &transforms[0]);
+	value = transformOne(&transforms[0], JS_RESTING_PLACE + JS_RESTING_PLACE / 2);
+	CHECK(abs(value - (JS_RESTING_PLACE + JS_RESTING_PLACE / 8)) <= 64);
+	calibration.curve = JS_RESTING_PLACE;
+	dpBuildAxisTransform(&calibration, &transforms[0]);
+	CHECK(transformOne(&transforms[0], JS_RESTING_PLACE + JS_RESTING_PLACE / 2) < JS_RESTING_PLACE + JS_RESTING_PLACE / 2);
+	CHECK(transformOne(&transforms[0], JS_RESTING_PLACE + JS_RESTING_PLACE / 2) > value);
+
+	// What it costs a report, all six axes calibrated
+	calibration.centre = 15000;
+	calibration.innerDeadzone = 1000;
+	calibration.outerDeadzone = 500;
+	for (i = 0; i < AXIS_TRANSFORM_COUNT; i++)
+		dpBuildAxisTransform(&calibration, &transforms[i]);
+	start = seconds();
+	for (value = 0; value < 1000000; value++) {
+		report.inputs.axisX = report.inputs.axisY = report.inputs.axisZ = value & JS_MAX_VALUE;
+		report.inputs.axisRX = report.inputs.axisRY = report.inputs.axisRZ = JS_MAX_VALUE - (value & JS_MAX_VALUE);
+		dpTransformAxes(transforms, &report);
+		__asm__ __volatile__("" : : "m" (report));
+	}
+	elapsed = seconds() - start;
+	printf("calibration: %.1f ns a report of six axes\n", elapsed * 1e9 / 1000000);
+}
+
+//
+// Smoothing
+//
+#define FILTER_SAMPLE_MILLIS	10	// A phone's sensors at 100 Hz
+#define FILTER_NOISE		300
+
+typedef struct _FILTER_RESULT {
+    double   Jitter;		// RMS of the output around the noiseless signal, while still
+    double   LagMillis;		// From a step to 90% of the way there
+    double   Nanoseconds;	// Per sample
+} FILTER_RESULT, *PFILTER_RESULT;
+
+static LONG
+noise(
+    VOID
+    )
+{
+	return (LONG) (randomNumber() % (2 * FILTER_NOISE + 1)) - FILTER_NOISE;
+}
+
+static LONG
+filterOne(
+    IN OUT PAXIS_FILTER Filter,
+    IN LONG             Value,
+    IN LONGLONG         Timestamp
+    )
+{
+	AXIS_FILTER filters[AXIS_TRANSFORM_COUNT];
+	HID_INPUT_REPORT report;
+
+	RtlZeroMemory(filters, sizeof(filters));
+	filters[0] = *Filter;
+	report.inputs.axisX = Value;
+	dpFilterAxes(filters, &report, Timestamp);
+	*Filter = filters[0];
+	return report.inputs.axisX;
+}
+
+/**
+ * Feeds a filter a trace like a phone held still, then tilted sharply and
+ * held again, with sensor noise throughout.
+ */
+static VOID
+runFilter(
+    IN PAXIS_FILTER_CONFIG Config,
+    OUT PFILTER_RESULT     Result
+    )
+{
+	AXIS_FILTER filter;
+	LONGLONG time = 0;
+	double squares = 0;
+	LONG out, i, stepAt = -1;
+	double start;
+
+	dpInitAxisFilter(Config, &filter);
+	Result->LagMillis = -1;
+
+	start = seconds();
+	for (i = 0; i < 400; i++, time += MILLIS(FILTER_SAMPLE_MILLIS)) {
+		if (i < 200) {
+			out = filterOne(&filter, 10000 + noise(), time);
+			// Once it has settled
+			if (i >= 100)
+				squares += (double) (out - 10000) * (out - 10000);
+		} else {
+			out = filterOne(&filter, 20000 + noise(), time);
+			if (stepAt < 0 && out >= 19000)
+				stepAt = i;
+		}
+	}
+	Result->Nanoseconds = (seconds() - start) * 1e9 / 400;
+	Result->Jitter = sqrt(squares / 100);
+	if (stepAt >= 0)
+		Result->LagMillis = (stepAt - 200) * FILTER_SAMPLE_MILLIS;
+}
+
+static VOID
+testFilter(
+    VOID
+    )
+{
+	AXIS_FILTER_CONFIG config = { 0, 0, 0, 0 };
+	FILTER_RESULT none, ema, adaptive;
+	HID_INPUT_REPORT report;
+	AXIS_FILTER filter;
+	INPUT_DATA data;
+	LONGLONG now;
+	LONG last, sequence;
+
+	CHECK(dpCheckAxisFilter(&config));
+	config.flags = AXIS_FILTER_ENABLED;
+	CHECK(!dpCheckAxisFilter(&config));
+	config.minCutoff = 100;
+	CHECK(!dpCheckAxisFilter(&config));
+	config.speedCutoff = 100;
+	CHECK(dpCheckAxisFilter(&config));
+
+	// The first sample, and the first after a long gap, go straight through
+	dpInitAxisFilter(&config, &filter);
+	CHECK_EQUAL(filterOne(&filter, 5000, 0), 5000);
+	CHECK(filterOne(&filter, 6000, MILLIS(10)) < 6000);
+	CHECK_EQUAL(filterOne(&filter, 9000, MILLIS(2000)), 9000);
+
+	// Steady input stays put, and nothing leaves the scale
+	CHECK_EQUAL(filterOne(&filter, 9000, MILLIS(2010)), 9000);
+	CHECK_EQUAL(filterOne(&filter, 9000, MILLIS(2010)), 9000);
+	dpInitAxisFilter(&config, &filter);
+	CHECK_EQUAL(filterOne(&filter, -500, 0), 0);
+	CHECK(filterOne(&filter, 100000, MILLIS(10)) <= JS_MAX_VALUE);
+
+	// Plain moving average at 1 Hz, then the same with the cutoff rising
+	// with speed. Both take out most of the noise; only the adaptive one
+	// keeps up with the tilt.
+	config.flags = 0;
+	runFilter(&config, &none);
+	config.flags = AXIS_FILTER_ENABLED;
+	config.minCutoff = 100;
+	config.speedCutoff = 100;
+	config.beta = 0;
+	runFilter(&config, &ema);
+	config.beta = 20;
+	runFilter(&config, &adaptive);
+
+	printf("filter: %-10s jitter %6.1f  lag %4.0f ms  %.1f ns a sample\n", "none", none.Jitter, none.LagMillis, none.Nanoseconds);
+	printf("filter: %-10s jitter %6.1f  lag %4.0f ms  %.1f ns a sample\n", "1 Hz EMA", ema.Jitter, ema.LagMillis, ema.Nanoseconds);
+	printf("filter: %-10s jitter %6.1f  lag %4.0f ms  %.1f ns a sample\n", "1 euro", adaptive.Jitter, adaptive.LagMillis, adaptive.Nanoseconds);
+
+	CHECK_EQUAL(none.LagMillis, 0);
+	CHECK(ema.Jitter < none.Jitter / 3);
+	CHECK(adaptive.Jitter < none.Jitter / 2);
+	CHECK(ema.LagMillis > 200);
+	CHECK(adaptive.LagMillis >= 0 && adaptive.LagMillis < ema.LagMillis / 2);
+
+	// A step and then nothing: reports go on moving to where the input
+	// stopped, and are only due while they do
+	resetPipeline();
+	dpInitAxisFilter(&config, &pipeline.Filters[0]);
+	data = inputFrame(10000, 0);
+	CHECK(NT_SUCCESS(dpPipelineSubmit(&pipeline, &data, 0)));
+	data.axisX = 20000;
+	CHECK(NT_SUCCESS(dpPipelineSubmit(&pipeline, &data, MILLIS(10))));
+	while (dpPipelineNext(&pipeline, MILLIS(10), &report))
+		;
+	last = report.inputs.axisX;
+	CHECK(last > 10000 && last < 20000);
+	sequence = pipeline.State.Sequence;
+
+	// Reports made together don't each move it on
+	CHECK(!dpPipelineReportDue(&pipeline, sequence, MILLIS(10)));
+	dpPipelineNext(&pipeline, MILLIS(10), &report);
+	CHECK_EQUAL(report.inputs.axisX, last);
+	CHECK_EQUAL(pipeline.State.Sequence, sequence);
+
+	for (now = MILLIS(12); now <= MILLIS(1200) && last != 20000; now += MILLIS(2)) {
+		CHECK(dpPipelineSettling(&pipeline));
+		if (!dpPipelineReportDue(&pipeline, sequence, now))
+			continue;
+		CHECK(!dpPipelineNext(&pipeline, now, &report));
+		CHECK(report.inputs.axisX > last);
+		CHECK(pipeline.State.Sequence != sequence);
+		last = report.inputs.axisX;
+		sequence = pipeline.State.Sequence;
+	}
+	CHECK_EQUAL(last, 20000);
+	CHECK(now < MILLIS(1000));
+	CHECK(!dpPipelineSettling(&pipeline));
+	CHECK(!dpPipelineReportDue(&pipeline, sequence, now + MILLIS(100)));
+}
+
+//
+// Interpolation
+//
+static LONG
+renderAxis(
+    IN PINPUT_HISTORY History,
+    IN LONGLONG       RenderTime,
+    IN LONGLONG       ExtrapolateLimit
+    )
+{
+	HID_INPUT_REPORT report;
+
+	report.inputs.axisX = -1;
+	dpInterpolateAxes(History, RenderTime, ExtrapolateLimit, &report);
+	return report.inputs.axisX;
+}
+
+static VOID
+recordAxis(
+    IN OUT PINPUT_HISTORY History,
+    IN LONG               Axis,
+    IN LONGLONG           Timestamp
+    )
+{
+	INPUT_DATA data = inputFrame(Axis, 0);
+	HID_INPUT_REPORT report;
+
+	copyInputData(&data, &report);
+	dpRecordSample(History, &report, Timestamp);
+}
+
+/**
+ * Replays a stick moving at a steady 10 units a millisecond, sent at 30 Hz
+ * over Wi-Fi: each packet late by up to 20 ms, so some arrive almost
+ * together. Reports are read at 250 Hz, built for Delay ago. Returns the
+ * mean error, against the steady speed, of the step between two reports,
+ * and counts the reports that didn't move at all.
+ */
+static double
+replayPackets(
+    IN LONGLONG Delay,
+    OUT PULONG  Repeats
+    )
+{
+	INPUT_HISTORY history;
+	LONGLONG sent = 0, arrival = 0, now;
+	LONG value, last = -1;
+	double error = 0;
+	ULONG reports = 0;
+
+	RtlZeroMemory(&history, sizeof(history));
+	*Repeats = 0;
+	for (now = MILLIS(200); now < MILLIS(3000); now += MILLIS(4)) {
+		while (arrival <= now) {
+			if (sent != 0)
+				recordAxis(&history, (LONG) (sent / 1000), arrival);
+			sent += MILLIS(100) / 3;
+			arrival = max(arrival + MILLIS(1), sent + MILLIS(randomNumber() % 21));
+		}
+		if (Delay != 0)
+			value = renderAxis(&history, now - Delay, 0);
+		else
+			value = history.Samples[history.Latest].Axes[0];
+		if (last >= 0) {
+			error += fabs((double) (value - last) - 40);
+			*Repeats += value == last;
+			reports++;
+		}
+		last = value;
+	}
+	return error / reports;
+}
+
+static VOID
+testInterpolation(
+    VOID
+    )
+{
+	INPUT_HISTORY history;
+	HID_INPUT_REPORT report;
+	double rawError, smoothError;
+	ULONG rawRepeats, smoothRepeats;
+
+	RtlZeroMemory(&history, sizeof(history));
+	CHECK_EQUAL(renderAxis(&history, 0, 0), -1);
+	recordAxis(&history, 1000, MILLIS(10));
+	CHECK_EQUAL(renderAxis(&history, MILLIS(20), MILLIS(50)), 1000);
+	recordAxis(&history, 2000, MILLIS(20));
+	recordAxis(&history, 4000, MILLIS(30));
+
+	// On the line between the samples either side
+	CHECK_EQUAL(renderAxis(&history, MILLIS(15), 0), 1500);
+	CHECK_EQUAL(renderAxis(&history, MILLIS(25), 0), 3000);
+	CHECK_EQUAL(renderAxis(&history, MILLIS(5), 0), 1000);
+
+	// Carried on past the newest, up to the limit
+	CHECK_EQUAL(renderAxis(&history, MILLIS(35), 0), 4000);
+	CHECK_EQUAL(renderAxis(&history, MILLIS(35), MILLIS(20)), 5000);
+	CHECK_EQUAL(renderAxis(&history, MILLIS(100), MILLIS(20)), 8000);
+	CHECK(dpInterpolationActive(&history, MILLIS(45), MILLIS(20)));
+	CHECK(!dpInterpolationActive(&history, MILLIS(50), MILLIS(20)));
+
+	// But never off the scale, and not across a gap
+	recordAxis(&history, 30000, MILLIS(40));
+	CHECK_EQUAL(renderAxis(&history, MILLIS(60), MILLIS(20)), JS_MAX_VALUE);
+	recordAxis(&history, 100, MILLIS(40) + INTERPOLATE_MAX_GAP + 1);
+	CHECK_EQUAL(renderAxis(&history, MILLIS(50), 0), 30000);
+	CHECK_EQUAL(renderAxis(&history, MILLIS(40) + INTERPOLATE_MAX_GAP + MILLIS(10), MILLIS(20)), 100);
+
+	// Buttons are the latest, never interpolated
+	resetPipeline();
+	pipeline.InterpolateDelay = MILLIS(20);
+	submit(1000, 1, MILLIS(0));
+	submit(2000, 2, MILLIS(40));
+	while (dpPipelineNext(&pipeline, MILLIS(40), &report))
+		;
+	CHECK_EQUAL(report.inputs.buttons, 2);
+	CHECK_EQUAL(report.inputs.axisX, 1500);
+
+	// Sparse packets with bursty arrival come out as an even movement
+	rawError = replayPackets(0, &rawRepeats);
+	smoothError = replayPackets(MILLIS(60), &smoothRepeats);
+	printf("interpolation: 30 Hz in, 250 Hz out: step error %.1f, %u repeats; "
+		"interpolated 60 ms behind: step error %.1f, %u repeats\n",
+		rawError, rawRepeats, smoothError, smoothRepeats);
+	CHECK(rawRepeats > 500);
+	CHECK(smoothRepeats == 0);
+	CHECK(smoothError < rawError / 3);
+}
+
+//
+// The jitter buffer
+//
+#define SEND_MILLIS	10	// The phone sends at 100 Hz
+#define SENDER_CLOCK	123456789	// Where its clock is against ours
+
+typedef enum _JITTER_PROFILE {
+    JitterNone,		// 5 ms every time
+    JitterUniform,	// 5 to 20 ms
+    JitterSpikes	// 5 ms, but one packet in 20 takes 45 ms, holding up the rest
+} JITTER_PROFILE;
+
+typedef struct _JITTER_RESULT {
+    double   LatencyMillis;	// Mean, from being sent to being applied
+    double   PacingMillis;	// Mean error of the time between two frames being applied
+} JITTER_RESULT, *PJITTER_RESULT;
+
+static LONGLONG
+networkDelay(
+    IN JITTER_PROFILE Profile,
+    IN ULONG          Packet
+    )
+{
+	switch (Profile) {
+	case JitterUniform:
+		return MILLIS(5) + randomNumber() % MILLIS(15);
+	case JitterSpikes:
+		return Packet % 20 == 19 ? MILLIS(45) : MILLIS(5);
+	default:
+		return MILLIS(5);
+	}
+}
+
+/**
+ * Sends 1000 frames through a network with the given jitter and a jitter
+ * buffer of up to MaxDelay, applying each one the millisecond it's due.
+ */
+static VOID
+simulateJitter(
+    IN JITTER_PROFILE Profile,
+    IN LONGLONG       MaxDelay,
+    OUT PJITTER_RESULT Result
+    )
+{
+	JITTER_BUFFER buffer;
+	LONGLONG arrivals[1000], now, last = -1, latency = 0, pacing = 0;
+	ULONG sent, received = 0, applied = 0;
+	INPUT_DATA data;
+	PJITTER_FRAME frame;
+
+	// Packets are delivered in order, so a late one holds up the rest
+	for (sent = 0; sent < 1000; sent++) {
+		arrivals[sent] = MILLIS(SEND_MILLIS) * sent + networkDelay(Profile, sent);
+		if (sent > 0)
+			arrivals[sent] = max(arrivals[sent], arrivals[sent - 1]);
+	}
+
+	RtlZeroMemory(&buffer, sizeof(buffer));
+	buffer.MaxDelay = MaxDelay;
+	for (now = 0; applied < 1000; now += MILLIS(1)) {
+		while (received < 1000 && arrivals[received] <= now) {
+			data = inputFrame((LONG) received, 0);
+			CHECK(buffer.Count < JITTER_BUFFER_SIZE);
+			CHECK(dpJitterPush(&buffer, &data, SENDER_CLOCK + MILLIS(SEND_MILLIS) * received, now));
+			received++;
+		}
+		while ((frame = dpJitterPeek(&buffer, now)) != NULL) {
+			CHECK_EQUAL(frame->Data.axisX, applied);
+			latency += now - MILLIS(SEND_MILLIS) * applied;
+			if (last >= 0)
+				pacing += llabs(now - last - MILLIS(SEND_MILLIS));
+			last = now;
+			applied++;
+			dpJitterDrop(&buffer);
+		}
+	}
+	Result->LatencyMillis = latency / 1e4 / 1000;
+	Result->PacingMillis = pacing / 1e4 / 999;
+}
+
+static VOID
+testJitterBuffer(
+    VOID
+    )
+{
+	static const char *profiles[] = { "steady", "uniform", "spikes" };
+	JITTER_RESULT direct[3], buffered[3];
+	JITTER_BUFFER buffer;
+	INPUT_DATA data = inputFrame(0, 0);
+	ULONG i, slow;
+
+	// Frames no newer than one taken are dropped, unless the sender has
+	// clearly started again
+	RtlZeroMemory(&buffer, sizeof(buffer));
+	buffer.MaxDelay = MILLIS(50);
+	CHECK(dpJitterPush(&buffer, &data, MILLIS(100), MILLIS(1000)));
+	CHECK(!dpJitterPush(&buffer, &data, MILLIS(100), MILLIS(1010)));
+	CHECK(!dpJitterPush(&buffer, &data, MILLIS(90), MILLIS(1010)));
+	CHECK(dpJitterPush(&buffer, &data, MILLIS(100) - 20000000, MILLIS(1020)));
+	CHECK_EQUAL(buffer.Count, 2);
+
+	// The first frame is played out as it arrives, and nothing is due early
+	CHECK(dpJitterPeek(&buffer, MILLIS(999)) == NULL);
+	CHECK(dpJitterPeek(&buffer, MILLIS(1000)) != NULL);
+	dpJitterDrop(&buffer);
+
+	// Frames are never played out of order, nor more than MaxDelay behind
+	// the base transit time. Three frames in four are 200 ms slow; the base
+	// drops to the fastest transit (0) at once, and climbs by at most
+	// 1/256 of the difference for each slow frame since
+	RtlZeroMemory(&buffer, sizeof(buffer));
+	buffer.MaxDelay = MILLIS(20);
+	for (i = 0, slow = 0; i < JITTER_BUFFER_SIZE; i++) {
+		slow = (i % 4 != 0) ? slow + 1 : 0;
+		CHECK(dpJitterPush(&buffer, &data, MILLIS(10) * i, MILLIS(10) * i + (slow != 0 ? MILLIS(200) : 0)));
+		CHECK(buffer.Frames[i].PlayoutTime <= MILLIS(10) * i + buffer.BaseTransit + MILLIS(20) ||
+			(i > 0 && buffer.Frames[i].PlayoutTime == buffer.Frames[i - 1].PlayoutTime));
+		CHECK(buffer.BaseTransit >= 0);
+		CHECK(buffer.BaseTransit <= slow * (MILLIS(200) - 0) / 256);
+		if (slow != 0)
+			CHECK(buffer.BaseTransit > 0);
+		if (i > 0)
+			CHECK(buffer.Frames[i].PlayoutTime >= buffer.Frames[i - 1].PlayoutTime);
+	}
+
+	for (i = 0; i < 3; i++) {
+		simulateJitter((JITTER_PROFILE) i, 0, &direct[i]);
+		simulateJitter((JITTER_PROFILE) i, MILLIS(50), &buffered[i]);
+		printf("jitter buffer: %-8s as they arrive: latency %5.1f ms, pacing error %4.1f ms; "
+			"buffered: latency %5.1f ms, pacing error %4.1f ms\n", profiles[i],
+			direct[i].LatencyMillis, direct[i].PacingMillis,
+			buffered[i].LatencyMillis, buffered[i].PacingMillis);
+	}
+
+	// No jitter, no delay added; otherwise a few ms buy even pacing
+	CHECK(buffered[JitterNone].LatencyMillis <= direct[JitterNone].LatencyMillis + 0.5);
+	CHECK(buffered[JitterNone].PacingMillis < 0.1);
+	CHECK(buffered[JitterUniform].PacingMillis < direct[JitterUniform].PacingMillis / 2);
+	CHECK(buffered[JitterUniform].LatencyMillis < direct[JitterUniform].LatencyMillis + 20);
+	CHECK(buffered[JitterSpikes].PacingMillis < direct[JitterSpikes].PacingMillis);
+}
+
+//
+// Turbo and macro buttons
+//
+/**
+ * Holds a turbo button with a 100 ms period for a second and reads
+ * reports at RateHz, as the report timer would with nothing else going on.
+ * Returns the worst lateness of an edge seen in a report, against when it
+ * was due, and counts the edges seen.
+ */
+static LONGLONG
+turboAtRate(
+    IN ULONG  RateHz,
+    OUT PULONG Edges
+    )
+{
+	TURBO_CONFIG config = { 0, { 0 } };
+	BUTTON_ENGINE engine;
+	LONGLONG now, period = 10000000 / RateHz, worst = 0, due;
+	ULONG out, last = 1, i;
+
+	RtlZeroMemory(&engine, sizeof(engine));
+	config.periodMillis[3] = 100;
+	dpButtonEngineSetTurbo(&engine, &config, 0, 0);
+	dpButtonEngineInput(&engine, 1 << 3, MILLIS(7));
+
+	*Edges = 0;
+	for (i = 0; (now = MILLIS(7) + i * period) < MILLIS(1007); i++) {
+		out = dpButtonEngineApply(&engine, 1 << 3, now) >> 3;
+		if (out != last) {
+			// Pressed on even 50 ms halves from the press, so the edge
+			// seen was due at the last multiple of 50 ms
+			due = MILLIS(7) + (now - MILLIS(7)) / MILLIS(50) * MILLIS(50);
+			CHECK_EQUAL(out, (now - MILLIS(7)) / MILLIS(50) % 2 == 0);
+			worst = max(worst, now - due);
+			(*Edges)++;
+		}
+		last = out;
+	}
+	return worst;
+}
+
+static VOID
+testButtonEngine(
+    VOID
+    )
+{
+	static const ULONG rates[] = { 60, 120, 250 };
+	UCHAR macroBuffer[MACRO_SIZE(3)];
+	PMACRO macro = (PMACRO) macroBuffer;
+	TURBO_CONFIG config = { 0, { 0 } };
+	BUTTON_ENGINE engine;
+	LONGLONG worst;
+	ULONG edges, i;
+
+	// Waking at NextEdge, every edge lands exactly on time
+	RtlZeroMemory(&engine, sizeof(engine));
+	config.periodMillis[0] = 30;
+	config.periodMillis[2] = 8;
+	dpButtonEngineSetTurbo(&engine, &config, 0, 0);
+	dpButtonEngineInput(&engine, 0x3, MILLIS(100));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x3, MILLIS(100)), 0x3);
+	CHECK_EQUAL(engine.NextEdge, MILLIS(115));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x3, MILLIS(115)), 0x2);
+	CHECK_EQUAL(engine.NextEdge, MILLIS(130));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x3, MILLIS(130)), 0x3);
+
+	// A second button starts its own cycle when pressed; letting go of one
+	// stops it at once, and non-turbo buttons pass straight through
+	dpButtonEngineInput(&engine, 0x7, MILLIS(132));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x7, MILLIS(132)), 0x7);
+	CHECK_EQUAL(engine.NextEdge, MILLIS(136));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x7, MILLIS(136)), 0x3);
+	CHECK_EQUAL(engine.NextEdge, MILLIS(140));
+	dpButtonEngineInput(&engine, 0x6, MILLIS(137));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x6, MILLIS(137)), 0x2);
+	dpButtonEngineInput(&engine, 0x2, MILLIS(138));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x2, MILLIS(138)), 0x2);
+	CHECK_EQUAL(engine.NextEdge, NO_BUTTON_EDGE);
+
+	// A macro's steps come and go on time, on top of the buttons held
+	macro->stepCount = 3;
+	macro->steps[0].buttons = 0x10;
+	macro->steps[0].durationMillis = 20;
+	macro->steps[1].buttons = 0;
+	macro->steps[1].durationMillis = 5;
+	macro->steps[2].buttons = 0x30;
+	macro->steps[2].durationMillis = 40;
+	dpButtonEngineRunMacro(&engine, macro, MILLIS(200));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x2, MILLIS(200)), 0x12);
+	CHECK_EQUAL(engine.NextEdge, MILLIS(220));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x2, MILLIS(219)), 0x12);
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x2, MILLIS(220)), 0x2);
+	CHECK_EQUAL(engine.NextEdge, MILLIS(225));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x2, MILLIS(225)), 0x32);
+	CHECK_EQUAL(engine.NextEdge, MILLIS(265));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x2, MILLIS(265)), 0x2);
+	CHECK_EQUAL(engine.NextEdge, NO_BUTTON_EDGE);
+	CHECK_EQUAL(engine.MacroSteps, 0);
+
+	// Read at a fixed report rate instead, each edge shows up in the
+	// first report after it, and none is missed
+	for (i = 0; i < 3; i++) {
+		worst = turboAtRate(rates[i], &edges);
+		printf("turbo: 100 ms period read at %u Hz: %u edges, at worst %.2f ms late\n",
+			rates[i], edges, worst / 1e4);
+		CHECK(worst <= 10000000 / rates[i]);
+		CHECK(edges >= 19);
+	}
+
+	// Reconfiguring restarts a held turbo button's cycle, pressed
+	config.periodMillis[0] = 0;
+	config.periodMillis[1] = 20;
+	dpButtonEngineSetTurbo(&engine, &config, 0x2, MILLIS(300));
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x2, MILLIS(300)), 0x2);
+	CHECK_EQUAL(dpButtonEngineApply(&engine, 0x2, MILLIS(310)), 0);
+}
+
+//
+// Remapping
+//
+static VOID
+identityRemap(
+    OUT PREMAP_CONFIG Config
+    )
+{
+	ULONG i;
+
+	RtlZeroMemory(Config, sizeof(*Config));
+	Config->flags = REMAP_ENABLED;
+	for (i = 0; i < 6; i++)
+		Config->matrix[i][i] = REMAP_ONE;
+	Config->buttonPassMask = 0xffff;
+	for (i = 0; i < 16; i++)
+		Config->buttonAxes[i].axis = REMAP_NO_AXIS;
+}
+
+static HID_INPUT_REPORT
+remapped(
+    IN PREMAP_CONFIG Config,
+    IN LONG          Axis,
+    IN LONG          Buttons
+    )
+{
+	INPUT_DATA data = inputFrame(Axis, Buttons);
+	HID_INPUT_REPORT report;
+	REMAP remap;
+
+	CHECK(dpBuildRemap(Config, &remap));
+	copyInputData(&data, &report);
+	dpRemapReport(&remap, &report);
+	return report;
+}
+
+static VOID
+testRemap(
+    VOID
+    )
+{
+	REMAP_CONFIG config;
+	REMAP remap;
+	HID_INPUT_REPORT report;
+	PLONG axes = &report.inputs.axisX;
+	LONG in[6], expected;
+	double start, sum;
+	ULONG round, i, j;
+
+	// Off, or the identity, changes nothing
+	RtlZeroMemory(&config, sizeof(config));
+	CHECK(dpBuildRemap(&config, &remap));
+	CHECK(!remap.Enabled);
+	identityRemap(&config);
+	for (i = 0; i <= JS_MAX_VALUE; i += 97) {
+		report = remapped(&config, i, 0x5a5a);
+		for (j = 0; j < 6; j++)
+			CHECK_EQUAL(axes[j], i);
+		CHECK_EQUAL(report.inputs.buttons, 0x5a5a);
+	}
+
+	// Out of range weights and axes are refused
+	config.matrix[2][3] = REMAP_MAX_WEIGHT + 1;
+	CHECK(!dpBuildRemap(&config, &remap));
+	config.matrix[2][3] = -REMAP_MAX_WEIGHT - 1;
+	CHECK(!dpBuildRemap(&config, &remap));
+	config.matrix[2][3] = -REMAP_MAX_WEIGHT;
+	CHECK(dpBuildRemap(&config, &remap));
+	config.buttonAxes[4].axis = 6;
+	CHECK(!dpBuildRemap(&config, &remap));
+
+	// Tilt onto the right stick, inverted, and the left stick centred
+	identityRemap(&config);
+	config.matrix[0][0] = config.matrix[1][1] = 0;
+	config.matrix[3][0] = config.matrix[4][1] = -REMAP_ONE;
+	config.matrix[3][3] = config.matrix[4][4] = 0;
+	report = remapped(&config, JS_RESTING_PLACE + 1000, 0);
+	CHECK_EQUAL(report.inputs.axisX, JS_RESTING_PLACE);
+	CHECK_EQUAL(report.inputs.axisRX, JS_RESTING_PLACE - 1000);
+	CHECK_EQUAL(report.inputs.axisRY, JS_RESTING_PLACE - 1000);
+	CHECK_EQUAL(report.inputs.axisZ, JS_RESTING_PLACE + 1000);
+
+	// A mix is clamped to the scale
+	identityRemap(&config);
+	config.matrix[0][1] = REMAP_ONE;
+	report = remapped(&config, JS_MAX_VALUE, 0);
+	CHECK_EQUAL(report.inputs.axisX, JS_MAX_VALUE);
+	report = remapped(&config, 0, 0);
+	CHECK_EQUAL(report.inputs.axisX, 0);
+
+	// Buttons push axes to either end, and axes past a threshold press
+	// buttons; buttons left out of the pass mask are dropped
+	identityRemap(&config);
+	config.axisButtonsHigh[2] = 0x1;
+	config.axisButtonsLow[2] = 0x2;
+	config.buttonPassMask = 0x00ff;
+	config.buttonAxes[8].axis = 0;
+	config.buttonAxes[8].threshold = 8000;
+	config.buttonAxes[9].axis = 0;
+	config.buttonAxes[9].threshold = -8000;
+	report = remapped(&config, JS_RESTING_PLACE, 0x101);
+	CHECK_EQUAL(report.inputs.axisZ, JS_MAX_VALUE);
+	CHECK_EQUAL(report.inputs.buttons, 0x1);
+	report = remapped(&config, JS_RESTING_PLACE, 0x2);
+	CHECK_EQUAL(report.inputs.axisZ, 0);
+	report = remapped(&config, JS_RESTING_PLACE + 8001, 0);
+	CHECK_EQUAL(report.inputs.buttons, 0x100);
+	report = remapped(&config, JS_RESTING_PLACE + 8000, 0);
+	CHECK_EQUAL(report.inputs.buttons, 0);
+	report = remapped(&config, JS_RESTING_PLACE - 8001, 0);
+	CHECK_EQUAL(report.inputs.buttons, 0x200);
+
+	// Random matrices against the mix worked out the long way
+	for (round = 0; round < 10000; round++) {
+		RtlZeroMemory(&config, sizeof(config));
+		config.flags = REMAP_ENABLED;
+		for (i = 0; i < 16; i++)
+			config.buttonAxes[i].axis = REMAP_NO_AXIS;
+		for (i = 0; i < 6; i++) {
+			for (j = 0; j < 6; j++)
+				config.matrix[i][j] = (SHORT) ((LONG) (randomNumber() % (2 * REMAP_MAX_WEIGHT + 1)) - REMAP_MAX_WEIGHT);
+		}
+		CHECK(dpBuildRemap(&config, &remap));
+		for (j = 0; j < 6; j++) {
+			in[j] = (LONG) (randomNumber() % (JS_MAX_VALUE + 1));
+			axes[j] = in[j];
+		}
+		report.inputs.buttons = 0;
+		dpRemapReport(&remap, &report);
+		for (i = 0; i < 6; i++) {
+			for (sum = 0, j = 0; j < 6; j++)
+				sum += (double) config.matrix[i][j] * (in[j] - JS_RESTING_PLACE);
+			expected = (LONG) (sum / REMAP_ONE);
+			expected = min(max(expected, -JS_RESTING_PLACE), JS_MAX_VALUE - JS_RESTING_PLACE) + JS_RESTING_PLACE;
+			CHECK_EQUAL(axes[i], expected);
+		}
+	}
+
+	// What a report costs with a full matrix and every button mapped
+	for (i = 0; i < 16; i++) {
+		config.buttonAxes[i].axis = (UCHAR) (i % 6);
+		config.buttonAxes[i].threshold = (SHORT) (i & 1 ? 4000 : -4000);
+	}
+	dpBuildRemap(&config, &remap);
+	start = seconds();
+	for (round = 0; round < 1000000; round++) {
+		axes[round % 6] = round & JS_MAX_VALUE;
+		dpRemapReport(&remap, &report);
+		__asm__ __volatile__("" : : "m" (report));
+	}
+	printf("remap: %.1f ns a report\n", (seconds() - start) * 1e9 / 1000000);
+}
+
+static VOID
+testHistogram(
+    VOID
+    )
+{
+	DP_HISTOGRAM histogram;
+	ULONG buckets[DP_HISTOGRAM_BUCKETS];
+	ULONG i;
+
+	// Bucket n holds 2^(n-1) to 2^n - 1, and the last everything larger
+	CHECK_EQUAL(dpHistogramBucket(0), 0);
+	CHECK_EQUAL(dpHistogramBucket(1), 1);
+	CHECK_EQUAL(dpHistogramBucket(2), 2);
+	CHECK_EQUAL(dpHistogramBucket(3), 2);
+	CHECK_EQUAL(dpHistogramBucket(4), 3);
+	for (i = 1; i < DP_HISTOGRAM_BUCKETS - 1; i++) {
+		CHECK_EQUAL(dpHistogramBucket(1UL << (i - 1)), i);
+		CHECK_EQUAL(dpHistogramBucket((1UL << i) - 1), i);
+		CHECK_EQUAL(dpHistogramBucket(1UL << i), i + 1);
+	}
+	CHECK_EQUAL(dpHistogramBucket(1UL << 30), DP_HISTOGRAM_BUCKETS - 1);
+	CHECK_EQUAL(dpHistogramBucket(1UL << 31), DP_HISTOGRAM_BUCKETS - 1);
+	CHECK_EQUAL(dpHistogramBucket(0xffffffff), DP_HISTOGRAM_BUCKETS - 1);
+
+	// An empty histogram has every percentile at 0
+	RtlZeroMemory(&histogram, sizeof(histogram));
+	dpHistogramRead(&histogram, buckets);
+	for (i = 0; i < DP_HISTOGRAM_BUCKETS; i++)
+		CHECK_EQUAL(buckets[i], 0);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 50), 0);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 100), 0);
+
+	// 90 values of 0 to 89, 9 of 1000 and one overflow
+	for (i = 0; i < 90; i++)
+		dpHistogramAdd(&histogram, i);
+	for (i = 0; i < 9; i++)
+		dpHistogramAdd(&histogram, 1000);
+	dpHistogramAdd(&histogram, 0xffffffff);
+	dpHistogramRead(&histogram, buckets);
+	CHECK_EQUAL(buckets[0], 1);
+	CHECK_EQUAL(buckets[1], 1);
+	CHECK_EQUAL(buckets[2], 2);
+	CHECK_EQUAL(buckets[6], 32);
+	CHECK_EQUAL(buckets[7], 26);
+	CHECK_EQUAL(buckets[10], 9);
+	CHECK_EQUAL(buckets[DP_HISTOGRAM_BUCKETS - 1], 1);
+
+	// Percentiles give the top of their bucket
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 0), 0);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 1), 0);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 2), 1);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 50), 63);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 90), 127);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 91), 1023);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 99), 1023);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 100), MAXULONG);
+	CHECK_EQUAL(dpHistogramPercentile(buckets, 200), MAXULONG);
+}
+
+int
+main(
+    void
+    )
+{
+	testReportState();
+	testReportRing();
+	testInputUpdate();
+	testReportLayouts();
+	testCompactLayout();
+	testCalibration();
+	testFilter();
+	testInterpolation();
+	testJitterBuffer();
+	testButtonEngine();
+	testRemap();
+	testHistogram();
+	return checkResult();
+}
@@ -0,0 +1,961 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    driver.c
+
+Abstract:
+
+    Runs the driver's own code on the WDF shim in tests/wdf: the HID
+    IOCTLs, reads parked in the timer queue, the report timer and the
+    control device's IOCTLs, including the shared input page.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <droidpad.h>
+#include <wdfshim.h>
+#include "check.h"
+
+#define MILLIS(m)	((LONGLONG) (m) * 10000)
+
+static WDFDEVICE devices[DP_MAX_PADS];
+static ULONG deviceCount;
+static WDFFILEOBJECT file;
+static ULONG errorsBefore;
+
+/**
+ * Loads the driver with Pads devices and opens the control device.
+ */
+static VOID
+startDriver(
+    IN ULONG Pads
+    )
+{
+	errorsBefore = shimErrors();
+	CHECK_EQUAL(shimLoadDriver(), STATUS_SUCCESS);
+	for (deviceCount = 0; deviceCount < Pads; deviceCount++)
+		CHECK_EQUAL(shimAddDevice(&devices[deviceCount]), STATUS_SUCCESS);
+	CHECK(controlDevice != NULL);
+	file = shimOpenFile(controlDevice);
+}
+
+/**
+ * Undoes startDriver, and checks nothing was left behind or misused.
+ */
+static VOID
+stopDriver(
+    VOID
+    )
+{
+	shimCloseFile(file);
+	while (deviceCount > 0)
+		shimRemoveDevice(devices[--deviceCount]);
+	CHECK(controlDevice == NULL);
+	shimUnloadDriver();
+	shimClearParameters();
+	CHECK_EQUAL(shimPoolAllocations(), 0);
+	CHECK_EQUAL(shimErrors(), errorsBefore);
+}
+
+static NTSTATUS
+sendInput(
+    IN ULONG Pad,
+    IN LONG  AxisX
+    )
+{
+	PAD_INPUT_DATA input;
+
+	RtlZeroMemory(&input, sizeof(input));
+	input.pad = Pad;
+	input.data.axisX = AxisX;
+	return shimDeviceIoControl(file, IOCTL_DP_SEND_PAD_INPUT_DATA, &input, sizeof(input), NULL, 0, NULL);
+}
+
+static DP_PERF_STATS
+perfStats(
+    IN ULONG Pad
+    )
+{
+	DP_PERF_STATS stats;
+
+	RtlZeroMemory(&stats, sizeof(stats));
+	*(PULONG) &stats = Pad;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_PERF_STATS, &stats, sizeof(ULONG),
+		&stats, sizeof(stats), NULL), STATUS_SUCCESS);
+	return stats;
+}
+
+/**
+ * Whether Read has completed with a report, and if so with what X axis.
+ */
+static BOOLEAN
+readDone(
+    IN WDFREQUEST        Read,
+    IN PHID_INPUT_REPORT Report,
+    OUT PLONG            AxisX
+    )
+{
+	NTSTATUS status;
+	size_t information;
+
+	if (!shimRequestCompleted(Read, &status, &information))
+		return FALSE;
+	CHECK_EQUAL(status, STATUS_SUCCESS);
+	CHECK_EQUAL(information, sizeof(HID_INPUT_REPORT));
+	*AxisX = Report->inputs.axisX;
+	return TRUE;
+}
+
+static ULONG
+tracesOf(
+    IN USHORT Message
+    )
+{
+	DP_TRACE_RECORD records[256];
+	size_t bytes;
+	ULONG i, count = 0;
+
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_READ_TRACE, NULL, 0, records, sizeof(records), &bytes),
+		STATUS_SUCCESS);
+	for (i = 0; i < bytes / sizeof(DP_TRACE_RECORD); i++)
+		count += records[i].message == Message;
+	return count;
+}
+
+static VOID
+testHidIoctls(
+    VOID
+    )
+{
+	UCHAR buffer[512];
+	PHID_DEVICE_ATTRIBUTES attributes = (PHID_DEVICE_ATTRIBUTES) buffer;
+	WDFREQUEST request;
+	NTSTATUS status;
+	size_t information;
+
+	startDriver(1);
+
+	request = shimInternalIoctl(devices[0], IOCTL_HID_GET_DEVICE_DESCRIPTOR, buffer, sizeof(buffer));
+	CHECK(shimRequestCompleted(request, &status, &information));
+	CHECK_EQUAL(status, STATUS_SUCCESS);
+	CHECK_EQUAL(information, ((PHID_DESCRIPTOR) buffer)->bLength);
+	shimRequestFree(request);
+
+	request = shimInternalIoctl(devices[0], IOCTL_HID_GET_REPORT_DESCRIPTOR, buffer, sizeof(buffer));
+	CHECK(shimRequestCompleted(request, &status, &information));
+	CHECK_EQUAL(status, STATUS_SUCCESS);
+	CHECK_EQUAL(information, GetDeviceContext(devices[0])->Layout.ReportDescriptorLength);
+	shimRequestFree(request);
+
+	request = shimInternalIoctl(devices[0], IOCTL_HID_GET_DEVICE_ATTRIBUTES, buffer, sizeof(buffer));
+	CHECK(shimRequestCompleted(request, &status, &information));
+	CHECK_EQUAL(status, STATUS_SUCCESS);
+	CHECK_EQUAL(attributes->VendorID, VENDOR_N_ID);
+	CHECK_EQUAL(attributes->ProductID, PRODUCT_N_ID);
+	shimRequestFree(request);
+
+	request = shimInternalIoctl(devices[0], IOCTL_HID_WRITE_REPORT, buffer, sizeof(buffer));
+	CHECK(shimRequestCompleted(request, &status, NULL));
+	CHECK_EQUAL(status, STATUS_NOT_SUPPORTED);
+	shimRequestFree(request);
+
+	stopDriver();
+}
+
+static VOID
+testReadParking(
+    VOID
+    )
+{
+	HID_INPUT_REPORT report1, report2;
+	WDFREQUEST read1, read2;
+	PDEVICE_EXTENSION devContext;
+	DP_PERF_STATS stats;
+	FILTER_CONFIG filter;
+	INPUT_BATCH batch;
+	LONG axisX;
+
+	startDriver(1);
+	devContext = GetDeviceContext(devices[0]);
+
+	// Parked, then completed by the timer with the state nothing has read yet
+	read1 = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report1, sizeof(report1));
+	CHECK(!shimRequestCompleted(read1, NULL, NULL));
+	CHECK(shimTimerDue(devContext->ReportTimer) >= 0);
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(readDone(read1, &report1, &axisX));
+	CHECK_EQUAL(axisX, JS_RESTING_PLACE);
+	shimRequestFree(read1);
+
+	// Nothing has changed, so the next read is held, and counted once
+	read2 = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report2, sizeof(report2));
+	shimAdvance(MILLIS(1000));
+	CHECK(!shimRequestCompleted(read2, NULL, NULL));
+	CHECK_EQUAL(shimTimerDue(devContext->ReportTimer), -1);
+	stats = perfStats(0);
+	CHECK_EQUAL(stats.readsParked, 2);
+	CHECK_EQUAL(stats.reportsSuppressed, 1);
+	CHECK_EQUAL(stats.reportsDelivered, 1);
+
+	// Neither a refused frame nor a setting that doesn't change the
+	// report wakes it, or the timer
+	batch.pad = 0;
+	batch.frameCount = 0;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SEND_INPUT_BATCH, &batch, sizeof(batch), NULL, 0, NULL),
+		STATUS_INVALID_PARAMETER);
+	RtlZeroMemory(&filter, sizeof(filter));
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_FILTER, &filter, sizeof(filter), NULL, 0, NULL),
+		STATUS_SUCCESS);
+	CHECK(!shimRequestCompleted(read2, NULL, NULL));
+	CHECK_EQUAL(shimTimerDue(devContext->ReportTimer), -1);
+
+	// CompleteOnInput hands new input straight to it, leaving the timer
+	// nothing to do for the read parked after it
+	CHECK_EQUAL(sendInput(0, 1234), STATUS_SUCCESS);
+	CHECK(readDone(read2, &report2, &axisX));
+	CHECK_EQUAL(axisX, 1234);
+	shimRequestFree(read2);
+	read2 = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report2, sizeof(report2));
+	CHECK_EQUAL(shimTimerDue(devContext->ReportTimer), -1);
+	CHECK_EQUAL(sendInput(0, 1235), STATUS_SUCCESS);
+	CHECK(readDone(read2, &report2, &axisX));
+	CHECK_EQUAL(axisX, 1235);
+	shimRequestFree(read2);
+	CHECK_EQUAL(shimTimerDue(devContext->ReportTimer), -1);
+
+	stats = perfStats(0);
+	CHECK_EQUAL(stats.inputsReceived, 2);
+	CHECK_EQUAL(stats.reportsDelivered, 3);
+	CHECK_EQUAL(stats.reportsSuppressed, 2);
+
+	// Finding the queue empty isn't a failure
+	CHECK_EQUAL(tracesOf(DPT_READ_RETRIEVE_FAILED), 0);
+	CHECK_EQUAL(tracesOf(DPT_READ_COMPLETED), 0);	// Already read
+
+	stopDriver();
+}
+
+static VOID
+testFanOut(
+    VOID
+    )
+{
+	HID_INPUT_REPORT reports[3];
+	WDFREQUEST reads[3];
+	LONG axisX;
+	ULONG i;
+
+	shimSetParameter(REG_COMPLETE_ON_INPUT, 0);
+	shimSetParameter(REG_READ_POLICY, ReadPolicyFanOut);
+	startDriver(1);
+
+	for (i = 0; i < 3; i++)
+		reads[i] = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &reports[i], sizeof(reports[i]));
+	CHECK_EQUAL(sendInput(0, 77), STATUS_SUCCESS);
+	CHECK(!shimRequestCompleted(reads[0], NULL, NULL));
+
+	// One tick gives every read parked the same report
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	for (i = 0; i < 3; i++) {
+		CHECK(readDone(reads[i], &reports[i], &axisX));
+		CHECK_EQUAL(axisX, 77);
+		shimRequestFree(reads[i]);
+	}
+	CHECK_EQUAL(perfStats(0).reportsDelivered, 3);
+
+	stopDriver();
+}
+
+static VOID
+testFreshest(
+    VOID
+    )
+{
+	HID_INPUT_REPORT reports[2];
+	WDFREQUEST reads[2];
+	LONG axisX;
+	ULONG i;
+
+	shimSetParameter(REG_COMPLETE_ON_INPUT, 0);
+	shimSetParameter(REG_READ_POLICY, ReadPolicyFreshest);
+	startDriver(1);
+
+	for (i = 0; i < 2; i++)
+		reads[i] = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &reports[i], sizeof(reports[i]));
+
+	// One read per tick, and the second waits for something new
+	shimAdvance(MILLIS(100));
+	CHECK(readDone(reads[0], &reports[0], &axisX));
+	CHECK(!shimRequestCompleted(reads[1], NULL, NULL));
+
+	CHECK_EQUAL(sendInput(0, 5), STATUS_SUCCESS);
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(readDone(reads[1], &reports[1], &axisX));
+	CHECK_EQUAL(axisX, 5);
+	for (i = 0; i < 2; i++)
+		shimRequestFree(reads[i]);
+
+	stopDriver();
+}
+
+static VOID
+testMaxStale(
+    VOID
+    )
+{
+	HID_INPUT_REPORT report;
+	WDFREQUEST read;
+	DP_PERF_STATS stats;
+	LONG axisX;
+
+	shimSetParameter(REG_MAX_STALE_MILLIS, 50);
+	startDriver(1);
+
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(readDone(read, &report, &axisX));
+	shimRequestFree(read);
+
+	// Held until the last report is MaxStaleMillis old, then sent unchanged
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	shimAdvance(MILLIS(40));
+	CHECK(!shimRequestCompleted(read, NULL, NULL));
+	shimAdvance(MILLIS(80));
+	CHECK(readDone(read, &report, &axisX));
+	shimRequestFree(read);
+
+	stats = perfStats(0);
+	CHECK_EQUAL(stats.readsTimedOut, 1);
+	CHECK_EQUAL(stats.reportsSuppressed, 1);
+
+	stopDriver();
+}
+
+static VOID
+testFilterSettling(
+    VOID
+    )
+{
+	HID_INPUT_REPORT report;
+	FILTER_CONFIG filter;
+	WDFREQUEST read;
+	LONG axisX = 0;
+	ULONG reads = 0, ticks;
+
+	startDriver(1);
+	RtlZeroMemory(&filter, sizeof(filter));
+	filter.axes[0].flags = AXIS_FILTER_ENABLED;
+	filter.axes[0].minCutoff = 100;
+	filter.axes[0].speedCutoff = 100;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_FILTER, &filter, sizeof(filter), NULL, 0, NULL),
+		STATUS_SUCCESS);
+
+	// A step, then nothing more from the client: the smoothed axis is still
+	// carried the rest of the way by the report timer
+	CHECK_EQUAL(sendInput(0, 10000), STATUS_SUCCESS);
+	shimAdvance(MILLIS(10));
+	CHECK_EQUAL(sendInput(0, 20000), STATUS_SUCCESS);
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	for (ticks = 0; ticks < 1000 && axisX != 20000; ticks++) {
+		shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+		if (!readDone(read, &report, &axisX))
+			continue;
+		reads++;
+		shimRequestFree(read);
+		read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	}
+	CHECK_EQUAL(axisX, 20000);
+	CHECK(reads > 10);
+
+	// Then the read is held and the timer stops
+	shimAdvance(MILLIS(1000));
+	CHECK(!shimRequestCompleted(read, NULL, NULL));
+	CHECK_EQUAL(shimTimerDue(GetDeviceContext(devices[0])->ReportTimer), -1);
+
+	stopDriver();
+	shimRequestFree(read);
+}
+
+static VOID
+testControlIoctls(
+    VOID
+    )
+{
+	HID_INPUT_REPORT report;
+	WDFREQUEST read;
+	DP_PERF_STATS perf;
+	INPUT_DATA data;
+	DP_STATS stats;
+	ULONG pad = 5;
+	size_t bytes;
+	LONG axisX;
+
+	startDriver(2);
+
+	// Input only reaches its own pad
+	read = shimInternalIoctl(devices[1], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(readDone(read, &report, &axisX));
+	shimRequestFree(read);
+	read = shimInternalIoctl(devices[1], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	CHECK_EQUAL(sendInput(0, 10), STATUS_SUCCESS);
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(!shimRequestCompleted(read, NULL, NULL));
+	CHECK_EQUAL(sendInput(1, 20), STATUS_SUCCESS);
+	CHECK(readDone(read, &report, &axisX));
+	CHECK_EQUAL(axisX, 20);
+	shimRequestFree(read);
+
+	// IOCTL_DP_SEND_INPUT_DATA is for pad 0
+	RtlZeroMemory(&data, sizeof(data));
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SEND_INPUT_DATA, &data, sizeof(data), NULL, 0, NULL),
+		STATUS_SUCCESS);
+	CHECK_EQUAL(perfStats(0).inputsReceived, 2);
+	CHECK_EQUAL(perfStats(1).inputsReceived, 1);
+
+	CHECK_EQUAL(sendInput(2, 0), STATUS_NO_SUCH_DEVICE);
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_STATS, &pad, sizeof(pad), &stats, sizeof(stats), NULL),
+		STATUS_NO_SUCH_DEVICE);
+
+	// IOCTL_DP_GET_STATS returns the start of IOCTL_DP_GET_PERF_STATS
+	pad = 1;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_STATS, &pad, sizeof(pad), &stats, sizeof(stats), &bytes),
+		STATUS_SUCCESS);
+	CHECK_EQUAL(bytes, sizeof(DP_STATS));
+	perf = perfStats(1);
+	CHECK_EQUAL(stats.reportsDelivered, 2);
+	CHECK(memcmp(&stats, &perf, sizeof(stats)) == 0);
+
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SEND_PAD_INPUT_DATA, &data, sizeof(ULONG), NULL, 0, NULL),
+		STATUS_BUFFER_TOO_SMALL);
+	CHECK_EQUAL(shimDeviceIoControl(file, CTL_CODE(FILE_DEVICE_UNKNOWN, 0x7ff, METHOD_BUFFERED, FILE_ANY_ACCESS),
+		NULL, 0, NULL, 0, NULL), STATUS_INVALID_DEVICE_REQUEST);
+
+	stopDriver();
+}
+
+static VOID
+testSharedInput(
+    VOID
+    )
+{
+	SHARED_INPUT_MAPPING mapping, second;
+	HID_INPUT_REPORT report;
+	WDFFILEOBJECT other;
+	WDFREQUEST read;
+	INPUT_DATA data;
+	LONGLONG due;
+	ULONG pad = 0;
+	LONG axisX;
+
+	startDriver(1);
+
+	// Another driver has no user address space to map into
+	shimSetRequestorMode(KernelMode);
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_MAP_SHARED_INPUT, &pad, sizeof(pad),
+		&mapping, sizeof(mapping), NULL), STATUS_INVALID_DEVICE_REQUEST);
+	shimSetRequestorMode(UserMode);
+
+	shimSetProcess(1);
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_MAP_SHARED_INPUT, &pad, sizeof(pad),
+		&mapping, sizeof(mapping), NULL), STATUS_SUCCESS);
+	CHECK(mapping.address != 0);
+	CHECK_EQUAL(mapping.size, PAGE_SIZE);
+	CHECK_EQUAL(((PSHARED_INPUT) (ULONG_PTR) mapping.address)->magic, SHARED_INPUT_MAGIC);
+
+	// One page per handle, and one per pad
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_MAP_SHARED_INPUT, &pad, sizeof(pad),
+		&second, sizeof(second), NULL), STATUS_SHARING_VIOLATION);
+	other = shimOpenFile(controlDevice);
+	CHECK_EQUAL(shimDeviceIoControl(other, IOCTL_DP_MAP_SHARED_INPUT, &pad, sizeof(pad),
+		&second, sizeof(second), NULL), STATUS_SHARING_VIOLATION);
+	shimCloseFile(other);
+
+	// A frame published on the page is picked up by the next report
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(readDone(read, &report, &axisX));
+	shimRequestFree(read);
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	RtlZeroMemory(&data, sizeof(data));
+	data.axisX = 999;
+	dpSharedInputPublish((PSHARED_INPUT) (ULONG_PTR) mapping.address, &data);
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(readDone(read, &report, &axisX));
+	CHECK_EQUAL(axisX, 999);
+	shimRequestFree(read);
+
+	// Nothing kicks the timer for the page, so it must not back off while
+	// the input is idle: a frame published after a long quiet spell still
+	// goes out within the shortest period
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	shimAdvance(MILLIS(REPORT_TIMER_IDLE_MILLIS));
+	CHECK(!readDone(read, &report, &axisX));
+	due = shimTimerDue(GetDeviceContext(devices[0])->ReportTimer);
+	CHECK(due >= 0 && due - (LONGLONG) KeQueryInterruptTime() <= MILLIS(REPORT_TIMER_MIN_MILLIS));
+	data.axisX = 555;
+	dpSharedInputPublish((PSHARED_INPUT) (ULONG_PTR) mapping.address, &data);
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(readDone(read, &report, &axisX));
+	CHECK_EQUAL(axisX, 555);
+	shimRequestFree(read);
+
+	// Closed by another process the handle was passed to; the page is
+	// still unmapped from the one it was mapped into
+	shimSetProcess(2);
+	stopDriver();
+	shimSetProcess(0);
+}
+
+static VOID
+testRemoval(
+    VOID
+    )
+{
+	HID_INPUT_REPORT report;
+	WDFREQUEST read;
+	NTSTATUS status;
+	LONG axisX;
+
+	startDriver(2);
+
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(readDone(read, &report, &axisX));
+	shimRequestFree(read);
+
+	// A read still parked is cancelled with its device, and the pad goes
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	shimRemoveDevice(devices[0]);
+	CHECK(shimRequestCompleted(read, &status, NULL));
+	CHECK_EQUAL(status, STATUS_CANCELLED);
+	shimRequestFree(read);
+	CHECK_EQUAL(sendInput(0, 1), STATUS_NO_SUCH_DEVICE);
+	CHECK_EQUAL(sendInput(1, 1), STATUS_SUCCESS);
+
+	// The control device stays until the last pad goes
+	CHECK(controlDevice != NULL);
+	devices[0] = devices[1];
+	deviceCount = 1;
+	stopDriver();
+}
+
+static int
+compareLatency(
+    const void *a,
+    const void *b
+    )
+{
+	LONGLONG x = *(const LONGLONG *) a, y = *(const LONGLONG *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/**
+ * Sends input at random times, about every 20 ms, with a read always
+ * parked as HIDCLASS keeps one, and measures how long each input takes to
+ * reach a read. Times are taken every 100us, in simulated time.
+ */
+static VOID
+measureLatency(
+    IN BOOLEAN   CompleteOnInput,
+    OUT LONGLONG Latencies[],
+    IN ULONG     Count
+    )
+{
+	HID_INPUT_REPORT report;
+	WDFREQUEST read;
+	LONGLONG sentAt = 0, nextInput;
+	ULONG sent = 0, received = 0, seed = 12345;
+	BOOLEAN waiting = FALSE;
+	LONG axisX;
+
+	shimSetParameter(REG_COMPLETE_ON_INPUT, CompleteOnInput);
+	startDriver(1);
+
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	nextInput = (LONGLONG) KeQueryInterruptTime() + MILLIS(5);
+	while (received < Count) {
+		if (!waiting && (LONGLONG) KeQueryInterruptTime() >= nextInput) {
+			CHECK_EQUAL(sendInput(0, (LONG) ++sent), STATUS_SUCCESS);
+			sentAt = KeQueryInterruptTime();
+			waiting = TRUE;
+			seed = seed * 1103515245 + 12345;
+			nextInput = sentAt + MILLIS(1) + (seed >> 8) % MILLIS(38);
+		}
+		if (readDone(read, &report, &axisX)) {
+			if (waiting && axisX == (LONG) sent) {
+				Latencies[received++] = (LONGLONG) KeQueryInterruptTime() - sentAt;
+				waiting = FALSE;
+			}
+			shimRequestFree(read);
+			read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+			continue;
+		}
+		shimAdvance(1000);
+	}
+	// The read still parked is cancelled with the device
+	stopDriver();
+	shimRequestFree(read);
+	qsort(Latencies, Count, sizeof(LONGLONG), compareLatency);
+}
+
+static VOID
+testInputLatency(
+    VOID
+    )
+{
+	static LONGLONG onInput[1000], timer[1000];
+
+	measureLatency(TRUE, onInput, 1000);
+	measureLatency(FALSE, timer, 1000);
+	printf("input to read: CompleteOnInput median %.1f ms, 99%% %.1f ms, worst %.1f ms; "
+		"timer only median %.1f ms, 99%% %.1f ms, worst %.1f ms\n",
+		onInput[500] / 1e4, onInput[990] / 1e4, onInput[999] / 1e4,
+		timer[500] / 1e4, timer[990] / 1e4, timer[999] / 1e4);
+
+	// Straight through with CompleteOnInput; otherwise the timer, brought
+	// forward by the input, is never more than its shortest period away
+	CHECK_EQUAL(onInput[999], 0);
+	CHECK(timer[999] <= MILLIS(REPORT_TIMER_MIN_MILLIS));
+	CHECK(timer[500] > 0);
+}
+
+static NTSTATUS
+sendBatch(
+    IN PINPUT_BATCH Batch,
+    IN size_t       Size
+    )
+{
+	return shimDeviceIoControl(file, IOCTL_DP_SEND_INPUT_BATCH, Batch, Size, NULL, 0, NULL);
+}
+
+static VOID
+testInputBatch(
+    VOID
+    )
+{
+	static UCHAR buffer[INPUT_BATCH_SIZE(INPUT_BATCH_MAX_FRAMES + 1)];
+	PINPUT_BATCH batch = (PINPUT_BATCH) buffer;
+	HID_INPUT_REPORT report;
+	PREPORT_RING ring;
+	WDFREQUEST read;
+	LONGLONG now;
+	double start, single, batched;
+	struct timespec clock;
+	LONG axisX;
+	ULONG i, j;
+
+	shimSetParameter(REG_COMPLETE_ON_INPUT, 0);
+	startDriver(1);
+	ring = &GetDeviceContext(devices[0])->Pipeline.Ring;
+
+	// Frames are applied in order, each its own report, timed against
+	// the last one, which arrives now
+	RtlZeroMemory(buffer, sizeof(buffer));
+	batch->frameCount = 3;
+	for (i = 0; i < 3; i++) {
+		batch->frames[i].data.axisX = 100 + i;
+		batch->frames[i].data.buttons = i & 1;
+		batch->frames[i].timestamp = 5000000 + MILLIS(4) * i;
+	}
+	now = KeQueryInterruptTime();
+	CHECK_EQUAL(sendBatch(batch, INPUT_BATCH_SIZE(3)), STATUS_SUCCESS);
+	CHECK_EQUAL(perfStats(0).inputsReceived, 3);
+	CHECK_EQUAL(ring->Count, 3);
+	for (i = 0; i < 3; i++)
+		CHECK_EQUAL(ring->Entries[(ring->Head + i) % REPORT_RING_SIZE].Timestamp, now - MILLIS(8) + MILLIS(4) * i);
+	for (i = 0; i < 3; i++) {
+		read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+		shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+		CHECK(readDone(read, &report, &axisX));
+		CHECK_EQUAL(axisX, 100 + i);
+		CHECK_EQUAL(report.inputs.buttons, i & 1);
+		shimRequestFree(read);
+	}
+
+	// Empty, too big and cut short are all refused
+	batch->frameCount = 0;
+	CHECK_EQUAL(sendBatch(batch, INPUT_BATCH_SIZE(1)), STATUS_INVALID_PARAMETER);
+	batch->frameCount = INPUT_BATCH_MAX_FRAMES + 1;
+	CHECK_EQUAL(sendBatch(batch, INPUT_BATCH_SIZE(INPUT_BATCH_MAX_FRAMES + 1)), STATUS_INVALID_PARAMETER);
+	batch->frameCount = 3;
+	CHECK_EQUAL(sendBatch(batch, INPUT_BATCH_SIZE(3) - 1), STATUS_INVALID_PARAMETER);
+	batch->pad = 1;
+	CHECK_EQUAL(sendBatch(batch, INPUT_BATCH_SIZE(3)), STATUS_NO_SUCH_DEVICE);
+	batch->pad = 0;
+	CHECK_EQUAL(perfStats(0).inputsReceived, 3);
+
+	// What the dispatch costs per frame, one frame an IOCTL against 64.
+	// The shim has no user to kernel transition, so this is only the
+	// driver's side of the saving.
+	RtlZeroMemory(buffer, sizeof(buffer));
+	clock_gettime(CLOCK_MONOTONIC, &clock);
+	start = clock.tv_sec + clock.tv_nsec / 1e9;
+	for (i = 0; i < 64000; i++)
+		sendInput(0, i & JS_MAX_VALUE);
+	clock_gettime(CLOCK_MONOTONIC, &clock);
+	single = clock.tv_sec + clock.tv_nsec / 1e9 - start;
+	batch->frameCount = 64;
+	for (i = 0; i < 1000; i++) {
+		for (j = 0; j < 64; j++)
+			batch->frames[j].data.axisX = (i * 64 + j) & JS_MAX_VALUE;
+		sendBatch(batch, INPUT_BATCH_SIZE(64));
+	}
+	clock_gettime(CLOCK_MONOTONIC, &clock);
+	batched = clock.tv_sec + clock.tv_nsec / 1e9 - start - single;
+	printf("input batch: %.0f ns a frame sent one at a time, %.0f ns a frame in batches of 64\n",
+		single * 1e9 / 64000, batched * 1e9 / 64000);
+	CHECK_EQUAL(perfStats(0).inputsReceived, 3 + 2 * 64000);
+
+	stopDriver();
+}
+
+/**
+ * Whether two captures match, record for record, up to the first settings
+ * change in Sent. Reports before Settle are only matched by type and time.
+ */
+static BOOLEAN
+sameCapture(
+    IN PCAPTURE_RECORD Sent,
+    IN ULONG           SentCount,
+    IN PCAPTURE_RECORD Replayed,
+    IN ULONG           ReplayedCount,
+    IN LONGLONG        Settle
+    )
+{
+	ULONG i;
+
+	for (i = 0; i < SentCount && Sent[i].type != CAPTURE_SETTINGS; i++) {
+		if (i == ReplayedCount || Sent[i].type != Replayed[i].type || Sent[i].timestamp != Replayed[i].timestamp)
+			return FALSE;
+		if ((Sent[i].type != CAPTURE_REPORT || Sent[i].timestamp >= Settle) &&
+			memcmp(&Sent[i], &Replayed[i], sizeof(CAPTURE_RECORD)) != 0)
+			return FALSE;
+	}
+	return i == ReplayedCount;
+}
+
+/**
+ * Replays Records through a pipeline set up with Settings, or left as it
+ * is if Settings is NULL, as dpreplay does, and captures that too.
+ * Returns how many records the replay captured.
+ */
+static ULONG
+replayCapture(
+    IN PCAPTURE_RECORD Records,
+    IN ULONG           Count,
+    IN PPAD_SETTINGS   Settings,
+    OUT PCAPTURE_RECORD Replayed
+    )
+{
+	static REPORT_PIPELINE pipeline;
+	static CAPTURE_RING ring;
+	HID_INPUT_REPORT report;
+	ULONG i;
+
+	RtlZeroMemory(&pipeline, sizeof(pipeline));
+	RtlZeroMemory(&ring, sizeof(ring));
+	dpInitPipeline(&pipeline);
+	if (Settings != NULL)
+		CHECK(dpApplyPadSettings(&pipeline, Settings, Records[0].timestamp));
+	pipeline.Capture = &ring;
+
+	for (i = 0; i < Count && Records[i].type != CAPTURE_SETTINGS; i++) {
+		if (Records[i].type == CAPTURE_INPUT)
+			dpPipelineSubmit(&pipeline, &Records[i].data, Records[i].timestamp);
+		else
+			dpPipelineNext(&pipeline, Records[i].timestamp, &report);
+	}
+	return dpCaptureDrain(&ring, Replayed, CAPTURE_RING_SIZE);
+}
+
+static VOID
+testCapture(
+    VOID
+    )
+{
+	static CAPTURE_RECORD records[CAPTURE_RING_SIZE], replayed[CAPTURE_RING_SIZE];
+	CAPTURE_CONFIG capture = { 0, TRUE };
+	CALIBRATION calibration;
+	FILTER_CONFIG filter;
+	REMAP_CONFIG remap;
+	TURBO_CONFIG turbo;
+	PAD_SETTINGS settings;
+	PAD_INPUT_DATA input;
+	HID_INPUT_REPORT report;
+	WDFREQUEST read;
+	size_t bytes;
+	ULONG pad = 0, count, replayedCount, settingsAt, i, j;
+	LONGLONG settle;
+	LONG axisX;
+
+	shimSetParameter(REG_INTERPOLATE_DELAY_MILLIS, 8);
+	startDriver(1);
+
+	// Nothing set yet
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_PAD_SETTINGS, &pad, sizeof(pad),
+		&settings, sizeof(settings), &bytes), STATUS_SUCCESS);
+	CHECK_EQUAL(bytes, sizeof(settings));
+	CHECK_EQUAL(settings.interpolateDelayMillis, 8);
+	CHECK_EQUAL(settings.extrapolateMillis, 0);
+	CHECK_EQUAL(settings.calibration.axes[0].flags, 0);
+	CHECK_EQUAL(settings.remap.flags, 0);
+
+	// Every setting that shapes the reports
+	RtlZeroMemory(&calibration, sizeof(calibration));
+	calibration.axes[0].flags = AXIS_CALIBRATION_ENABLED;
+	calibration.axes[0].centre = JS_RESTING_PLACE;
+	calibration.axes[0].innerDeadzone = 2000;
+	calibration.axes[0].curve = 16000;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_CALIBRATION, &calibration, sizeof(calibration),
+		NULL, 0, NULL), STATUS_SUCCESS);
+	RtlZeroMemory(&remap, sizeof(remap));
+	remap.flags = REMAP_ENABLED;
+	for (i = 0; i < 6; i++)
+		remap.matrix[i][i] = REMAP_ONE;
+	remap.matrix[3][1] = -REMAP_ONE / 2;
+	remap.buttonPassMask = 0xffff;
+	for (i = 0; i < 16; i++)
+		remap.buttonAxes[i].axis = REMAP_NO_AXIS;
+	remap.buttonAxes[8].axis = 2;
+	remap.buttonAxes[8].threshold = 4000;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_REMAP, &remap, sizeof(remap), NULL, 0, NULL),
+		STATUS_SUCCESS);
+	RtlZeroMemory(&turbo, sizeof(turbo));
+	turbo.periodMillis[0] = 30;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_TURBO, &turbo, sizeof(turbo), NULL, 0, NULL),
+		STATUS_SUCCESS);
+	RtlZeroMemory(&filter, sizeof(filter));
+	filter.axes[1].flags = AXIS_FILTER_ENABLED;
+	filter.axes[1].minCutoff = 200;
+	filter.axes[1].beta = 100;
+	filter.axes[1].speedCutoff = 100;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_FILTER, &filter, sizeof(filter), NULL, 0, NULL),
+		STATUS_SUCCESS);
+
+	// Come back as they were sent
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_PAD_SETTINGS, NULL, 0,
+		&settings, sizeof(settings), NULL), STATUS_SUCCESS);
+	CHECK_EQUAL(settings.pad, 0);
+	CHECK(memcmp(&settings.calibration, &calibration, sizeof(calibration)) == 0);
+	CHECK(memcmp(&settings.filter, &filter, sizeof(filter)) == 0);
+	CHECK(memcmp(&settings.remap, &remap, sizeof(remap)) == 0);
+	CHECK(memcmp(&settings.turbo, &turbo, sizeof(turbo)) == 0);
+	pad = 1;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_PAD_SETTINGS, &pad, sizeof(pad),
+		&settings, sizeof(settings), NULL), STATUS_NO_SUCH_DEVICE);
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_PAD_SETTINGS, NULL, 0,
+		&settings, sizeof(ULONG), NULL), STATUS_BUFFER_TOO_SMALL);
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_PAD_SETTINGS, NULL, 0,
+		&settings, sizeof(settings), NULL), STATUS_SUCCESS);
+
+	// Deliver the reports calibration and remapping queued, so the capture
+	// starts from an empty ring, as a replay does
+	for (i = 0; i < 2; i++) {
+		read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+		shimAdvance(MILLIS(REPORT_TIMER_MIN_MILLIS));
+		CHECK(readDone(read, &report, &axisX));
+		shimRequestFree(read);
+	}
+
+	// A session with input at 250 Hz read at the timer's rate, with the
+	// turbo button held for a while
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_CAPTURE, &capture, sizeof(capture), NULL, 0, NULL),
+		STATUS_SUCCESS);
+	RtlZeroMemory(&input, sizeof(input));
+	read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+	for (i = 0; i < 200; i++) {
+		input.data.axisX = (LONG) (JS_RESTING_PLACE + (i % 50) * 300 - 7500);
+		input.data.axisY = (LONG) ((i * 997) % (JS_MAX_VALUE + 1));
+		input.data.axisZ = (LONG) (JS_RESTING_PLACE + (i % 20 < 10 ? 6000 : 0));
+		input.data.buttons = (i >= 50 && i < 150) ? 0x1 : 0;
+		CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SEND_PAD_INPUT_DATA, &input, sizeof(input), NULL, 0, NULL),
+			STATUS_SUCCESS);
+		for (j = 0; j < 4; j++) {
+			shimAdvance(MILLIS(1));
+			if (readDone(read, &report, &axisX)) {
+				shimRequestFree(read);
+				read = shimInternalIoctl(devices[0], IOCTL_HID_READ_REPORT, &report, sizeof(report));
+			}
+		}
+	}
+
+	// A change while capturing is marked
+	turbo.periodMillis[0] = 60;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_TURBO, &turbo, sizeof(turbo), NULL, 0, NULL),
+		STATUS_SUCCESS);
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_READ_CAPTURE, NULL, 0, records, sizeof(records), &bytes),
+		STATUS_SUCCESS);
+	count = (ULONG) (bytes / sizeof(CAPTURE_RECORD));
+	CHECK(count > 400);
+	for (settingsAt = 0; settingsAt < count && records[settingsAt].type != CAPTURE_SETTINGS; settingsAt++)
+		CHECK_EQUAL(records[settingsAt].dropped, 0);
+	CHECK(settingsAt > 400 && settingsAt < count);
+
+	// Replayed with the settings, every report comes out as it was sent,
+	// apart from those interpolated from input before the capture started;
+	// without them, the calibration, remapping, filter and turbo show
+	settle = records[0].timestamp + MILLIS(settings.interpolateDelayMillis);
+	replayedCount = replayCapture(records, count, &settings, replayed);
+	CHECK(sameCapture(records, count, replayed, replayedCount, settle));
+	replayedCount = replayCapture(records, count, NULL, replayed);
+	CHECK(!sameCapture(records, count, replayed, replayedCount, settle));
+
+	capture.enable = FALSE;
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SET_CAPTURE, &capture, sizeof(capture), NULL, 0, NULL),
+		STATUS_SUCCESS);
+	stopDriver();
+	shimRequestFree(read);
+}
+
+int
+main(
+    void
+    )
+{
+	testHidIoctls();
+	testReadParking();
+	testInputLatency();
+	testInputBatch();
+	testFanOut();
+	testFreshest();
+	testMaxStale();
+	testFilterSettling();
+	testControlIoctls();
+	testSharedInput();
+	testCapture();
+	testRemoval();
+	return checkResult();
+}
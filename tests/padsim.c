@@ -0,0 +1,303 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    padsim.c
+
+Abstract:
+
+    Drives DP_MAX_PADS pads at 1 kHz each through the driver on the WDF
+    shim, with two reads parked on every pad as HIDCLASS keeps them, and
+    reports each pad's latency from input to read in simulated time. It
+    checks every report reaches the pad its input was sent to, in order.
+
+        padsim [seconds]
+
+    Runs once with CompleteOnInput and once with reads left to the report
+    timer, then both again with the pads only moving for the first quarter
+    of every second, as pads mostly held still are. Each run prints how
+    often the report timer woke up, per pad and minute, and the 50th and
+    99th percentile latency.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#include <stdlib.h>
+#include <time.h>
+#include <droidpad.h>
+#include <wdfshim.h>
+#include "check.h"
+
+#define MILLIS(m)	((LONGLONG) (m) * 10000)
+#define INPUT_MICROS	1000	// 1 kHz per pad
+#define STEP_MICROS		100		// How finely completions are timed
+#define READS_PER_PAD	2
+#define MAX_INPUTS		0x8000	// Per pad and run
+
+typedef struct _SIM_PAD {
+    WDFDEVICE        Device;
+    WDFREQUEST       Reads[READS_PER_PAD];
+    HID_INPUT_REPORT Reports[READS_PER_PAD];
+    LONGLONG         SentAt[MAX_INPUTS];	// By axis X, which counts inputs
+    LONG             LastAxisX;
+    ULONG            Sent;
+    ULONG            Delivered;
+    LONGLONG         LatencyTotal;	// 100ns units
+    LONGLONG         LatencyMax;
+} SIM_PAD, *PSIM_PAD;
+
+static SIM_PAD pads[DP_MAX_PADS];
+static WDFFILEOBJECT file;
+static LONGLONG latencies[DP_MAX_PADS * MAX_INPUTS];	// Of every input delivered
+static ULONG latencyCount;
+
+static LONGLONG
+now(
+    VOID
+    )
+{
+	return (LONGLONG) KeQueryInterruptTime();
+}
+
+static VOID
+parkRead(
+    IN PSIM_PAD Pad,
+    IN ULONG    Slot
+    )
+{
+	Pad->Reads[Slot] = shimInternalIoctl(Pad->Device, IOCTL_HID_READ_REPORT,
+		&Pad->Reports[Slot], sizeof(Pad->Reports[Slot]));
+}
+
+/**
+ * Takes every read of Pad that has completed since the last call, and parks
+ * another in its place.
+ */
+static VOID
+collectReads(
+    IN ULONG Index
+    )
+{
+	PSIM_PAD pad = &pads[Index];
+	NTSTATUS status;
+	LONG axisX;
+	ULONG i;
+
+	for (i = 0; i < READS_PER_PAD; i++) {
+		if (!shimRequestCompleted(pad->Reads[i], &status, NULL))
+			continue;
+		CHECK_EQUAL(status, STATUS_SUCCESS);
+		axisX = pad->Reports[i].inputs.axisX;
+
+		// The first reads see the resting state, before any input
+		if (pad->Sent > 0 && axisX != JS_RESTING_PLACE) {
+			CHECK_EQUAL(pad->Reports[i].inputs.axisY, Index);
+			CHECK(axisX >= pad->LastAxisX);
+			if (axisX > pad->LastAxisX) {
+				LONGLONG latency = now() - pad->SentAt[axisX];
+
+				pad->Delivered++;
+				latencies[latencyCount++] = latency;
+				pad->LatencyTotal += latency;
+				pad->LatencyMax = max(pad->LatencyMax, latency);
+				pad->LastAxisX = axisX;
+			}
+		}
+		shimRequestFree(pad->Reads[i]);
+		parkRead(pad, i);
+	}
+}
+
+static VOID
+sendInput(
+    IN ULONG Index
+    )
+{
+	PSIM_PAD pad = &pads[Index];
+	PAD_INPUT_DATA input;
+
+	// Axis X counts the pad's inputs from 1, so a report says which it was
+	RtlZeroMemory(&input, sizeof(input));
+	input.pad = Index;
+	input.data.axisX = (LONG) ++pad->Sent;
+	input.data.axisY = (LONG) Index;
+	pad->SentAt[pad->Sent] = now();
+	CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_SEND_PAD_INPUT_DATA, &input, sizeof(input), NULL, 0, NULL),
+		STATUS_SUCCESS);
+}
+
+static int
+compareLatency(
+    const void *A,
+    const void *B
+    )
+{
+	LONGLONG a = *(const LONGLONG *) A, b = *(const LONGLONG *) B;
+
+	return a < b ? -1 : a > b;
+}
+
+static LONGLONG
+percentile(
+    IN ULONG Percent
+    )
+{
+	return latencyCount ? latencies[(latencyCount - 1) * Percent / 100] : 0;
+}
+
+/**
+ * Runs every pad for Seconds, sending input for the first ActivePercent of
+ * each second and nothing for the rest.
+ */
+static VOID
+simulate(
+    IN ULONG   Seconds,
+    IN BOOLEAN CompleteOnInput,
+    IN ULONG   ActivePercent
+    )
+{
+	ULONG errorsBefore = shimErrors();
+	ULONG ticks = Seconds * (1000000 / INPUT_MICROS), tick, step, i, j;
+	ULONG activeTicks = ActivePercent * (1000000 / INPUT_MICROS) / 100;
+	LONGLONG worst = 0, total = 0, delivered = 0, wakeups = 0;
+	struct timespec start, end;
+	double seconds;
+
+	shimSetParameter(REG_COMPLETE_ON_INPUT, CompleteOnInput);
+	CHECK_EQUAL(shimLoadDriver(), STATUS_SUCCESS);
+	RtlZeroMemory(pads, sizeof(pads));
+	latencyCount = 0;
+	for (i = 0; i < DP_MAX_PADS; i++) {
+		CHECK_EQUAL(shimAddDevice(&pads[i].Device), STATUS_SUCCESS);
+		for (j = 0; j < READS_PER_PAD; j++)
+			parkRead(&pads[i], j);
+	}
+	file = shimOpenFile(controlDevice);
+
+	// Pads send at the same rate, but spread out over each millisecond, and
+	// the last inputs are given a tick to get out
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (tick = 0; tick < ticks + REPORT_TIMER_MIN_MILLIS * 1000 / INPUT_MICROS; tick++) {
+		for (step = 0; step < INPUT_MICROS / STEP_MICROS; step++) {
+			for (i = 0; i < DP_MAX_PADS; i++) {
+				if (tick < ticks && tick % (1000000 / INPUT_MICROS) < activeTicks &&
+					i * INPUT_MICROS / DP_MAX_PADS / STEP_MICROS == step)
+					sendInput(i);
+				collectReads(i);
+			}
+			shimAdvance(STEP_MICROS * 10);
+		}
+	}
+	for (i = 0; i < DP_MAX_PADS; i++)
+		collectReads(i);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("CompleteOnInput %u, %u pads at %u Hz for %u s, moving %u%% of the time\n", CompleteOnInput,
+		DP_MAX_PADS, 1000000 / INPUT_MICROS, Seconds, ActivePercent);
+	printf("%4s %8s %10s %12s %12s %14s %10s\n", "pad", "inputs", "delivered", "mean (us)", "max (us)",
+		"p99 bound (us)", "suppressed");
+	for (i = 0; i < DP_MAX_PADS; i++) {
+		PSIM_PAD pad = &pads[i];
+		DP_PERF_STATS stats;
+
+		RtlZeroMemory(&stats, sizeof(stats));
+		stats.pad = i;
+		CHECK_EQUAL(shimDeviceIoControl(file, IOCTL_DP_GET_PERF_STATS, &stats, sizeof(ULONG),
+			&stats, sizeof(stats), NULL), STATUS_SUCCESS);
+		CHECK_EQUAL(stats.inputsReceived, pad->Sent);
+
+		// The last input always gets out
+		CHECK_EQUAL(pad->LastAxisX, pad->Sent);
+
+		// The driver's histogram only bounds the latency to a power of 2,
+		// but has to agree with what was measured here
+		CHECK(dpHistogramPercentile(stats.latency, 100) >= pad->LatencyMax / 10);
+		printf("%4u %8u %10u %12.1f %12.1f %14u %10u\n", i, pad->Sent, pad->Delivered,
+			pad->Delivered ? pad->LatencyTotal / 10.0 / pad->Delivered : 0.0,
+			pad->LatencyMax / 10.0, dpHistogramPercentile(stats.latency, 99), stats.reportsSuppressed);
+		worst = max(worst, pad->LatencyMax);
+		total += pad->LatencyTotal;
+		delivered += pad->Delivered;
+		wakeups += shimTimerFired(GetDeviceContext(pad->Device)->ReportTimer);
+	}
+	qsort(latencies, latencyCount, sizeof(LONGLONG), compareLatency);
+	printf("mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us; %.0f timer wakeups per pad per minute; "
+		"%.2f us of host time per input\n\n",
+		delivered ? total / 10.0 / delivered : 0.0, percentile(50) / 10.0, percentile(99) / 10.0,
+		worst / 10.0, wakeups * 60.0 / Seconds / DP_MAX_PADS,
+		seconds * 1e6 / ((double) activeTicks * Seconds / (1000000 / INPUT_MICROS) * DP_MAX_PADS));
+
+	// Straight through, or no later than the next tick
+	if (CompleteOnInput)
+		CHECK_EQUAL(worst, 0);
+	else
+		CHECK(worst <= MILLIS(REPORT_TIMER_MIN_MILLIS));
+
+	// With no heartbeat, the timer only runs while the pad is moving, plus a
+	// few ticks backing off after it stops. With CompleteOnInput it's only
+	// needed for the first reads, of the resting state.
+	if (CompleteOnInput)
+		CHECK(wakeups <= DP_MAX_PADS);
+	else
+		CHECK(wakeups <= (LONGLONG) DP_MAX_PADS * Seconds *
+			(activeTicks * INPUT_MICROS / 1000 / REPORT_TIMER_MIN_MILLIS + 16));
+
+	shimCloseFile(file);
+	for (i = DP_MAX_PADS; i > 0; i--)
+		shimRemoveDevice(pads[i - 1].Device);
+	for (i = 0; i < DP_MAX_PADS; i++) {
+		for (j = 0; j < READS_PER_PAD; j++)
+			shimRequestFree(pads[i].Reads[j]);
+	}
+	shimUnloadDriver();
+	shimClearParameters();
+	CHECK_EQUAL(shimPoolAllocations(), 0);
+	CHECK_EQUAL(shimErrors(), errorsBefore);
+}
+
+int
+main(
+    int   argc,
+    char *argv[]
+    )
+{
+	ULONG seconds = argc > 1 ? (ULONG) atoi(argv[1]) : 1;
+
+	if (seconds == 0 || seconds * (1000000 / INPUT_MICROS) >= MAX_INPUTS) {
+		fprintf(stderr, "usage: %s [seconds, 1 to 32]\n", argv[0]);
+		return 2;
+	}
+	simulate(seconds, TRUE, 100);
+	simulate(seconds, FALSE, 100);
+	simulate(seconds, TRUE, 25);
+	simulate(seconds, FALSE, 25);
+	return checkResult();
+}
@@ -0,0 +1,204 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+
+Module Name:
+
+    uinput.c
+
+Abstract:
+
+    Pipes known INPUT_DATA frames through dpuinput with a file sink, and
+    checks the events it writes: only what changed, each hat switch split
+    into its two axes, one SYN_REPORT per frame that changed anything, and
+    one write for each read of input.
+
+        test_uinput path/to/dpuinput
+
+Author:
+
+
+Environment:
+
+    user mode, Linux
+
+Revision History:
+
+
+--*/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <linux/input.h>
+#include <dpcore.h>
+#include "check.h"
+
+#define HAT(n, value)	((LONG) (value) << (16 + 4 * (n)))
+
+typedef struct _EXPECTED_EVENT {
+    USHORT Type;
+    USHORT Code;
+    LONG   Value;
+} EXPECTED_EVENT;
+
+static const EXPECTED_EVENT expected[] = {
+	// The first frame sets everything
+	{ EV_ABS, ABS_X, JS_RESTING_PLACE }, { EV_ABS, ABS_Y, JS_RESTING_PLACE },
+	{ EV_ABS, ABS_Z, JS_RESTING_PLACE }, { EV_ABS, ABS_RX, JS_RESTING_PLACE },
+	{ EV_ABS, ABS_RY, JS_RESTING_PLACE }, { EV_ABS, ABS_RZ, JS_RESTING_PLACE },
+	{ EV_KEY, BTN_TRIGGER + 0, 0 }, { EV_KEY, BTN_TRIGGER + 1, 0 }, { EV_KEY, BTN_TRIGGER + 2, 0 },
+	{ EV_KEY, BTN_TRIGGER + 3, 0 }, { EV_KEY, BTN_TRIGGER + 4, 0 }, { EV_KEY, BTN_TRIGGER + 5, 0 },
+	{ EV_KEY, BTN_TRIGGER + 6, 0 }, { EV_KEY, BTN_TRIGGER + 7, 0 }, { EV_KEY, BTN_TRIGGER + 8, 0 },
+	{ EV_KEY, BTN_TRIGGER + 9, 0 }, { EV_KEY, BTN_TRIGGER + 10, 0 }, { EV_KEY, BTN_TRIGGER + 11, 0 },
+	{ EV_KEY, BTN_TRIGGER + 12, 0 }, { EV_KEY, BTN_TRIGGER + 13, 0 }, { EV_KEY, BTN_TRIGGER + 14, 0 },
+	{ EV_KEY, BTN_TRIGGER + 15, 0 },
+	{ EV_ABS, ABS_HAT0X, 0 }, { EV_ABS, ABS_HAT0Y, 0 }, { EV_ABS, ABS_HAT1X, 0 }, { EV_ABS, ABS_HAT1Y, 0 },
+	{ EV_ABS, ABS_HAT2X, 0 }, { EV_ABS, ABS_HAT2Y, 0 }, { EV_ABS, ABS_HAT3X, 0 }, { EV_ABS, ABS_HAT3Y, 0 },
+	{ EV_SYN, SYN_REPORT, 0 },
+
+	// X moves and button 3 goes down
+	{ EV_ABS, ABS_X, 1000 }, { EV_KEY, BTN_TRIGGER + 3, 1 }, { EV_SYN, SYN_REPORT, 0 },
+	// The same again sends nothing, not even a SYN_REPORT
+	// Hat 1 goes to NE, moving both its axes
+	{ EV_ABS, ABS_HAT1X, 1 }, { EV_ABS, ABS_HAT1Y, -1 }, { EV_SYN, SYN_REPORT, 0 },
+	// Then to E, which only moves its Y axis
+	{ EV_ABS, ABS_HAT1Y, 0 }, { EV_SYN, SYN_REPORT, 0 },
+
+	// The input ending puts the pad back at rest
+	{ EV_ABS, ABS_X, JS_RESTING_PLACE }, { EV_KEY, BTN_TRIGGER + 3, 0 }, { EV_ABS, ABS_HAT1X, 0 },
+	{ EV_SYN, SYN_REPORT, 0 },
+};
+
+#define EXPECTED_EVENTS		(sizeof(expected) / sizeof(expected[0]))
+#define EXPECTED_SUMMARY	"6 frames in 3 reads, 43 events in 3 writes\n"
+
+static char sinkPath[] = "/tmp/dpuinput-XXXXXX";
+
+static off_t
+sinkSize(
+    VOID
+    )
+{
+	struct stat status;
+
+	return stat(sinkPath, &status) == 0 ? status.st_size : -1;
+}
+
+/**
+ * Writes Count frames to Fd in one go, so dpuinput takes them in one read,
+ * then waits for its events, if any, to reach the sink. Returns FALSE if
+ * they don't come within a few seconds.
+ */
+static BOOLEAN
+sendFrames(
+    IN int         Fd,
+    IN PINPUT_DATA Frames,
+    IN ULONG       Count,
+    IN ULONG       Events
+    )
+{
+	off_t expected = sinkSize() + Events * sizeof(struct input_event);
+	struct timespec pause = { 0, 1000000 };
+	int waited;
+
+	CHECK_EQUAL(write(Fd, Frames, Count * sizeof(INPUT_DATA)), Count * sizeof(INPUT_DATA));
+	for (waited = 0; sinkSize() < expected && waited < 5000; waited++)
+		nanosleep(&pause, NULL);
+	return sinkSize() == expected;
+}
+
+int
+main(
+    int   argc,
+    char *argv[]
+    )
+{
+	struct input_event events[2 * EXPECTED_EVENTS];
+	INPUT_DATA frames[4];
+	char summary[128];
+	int input[2], output[2], sink, status;
+	ssize_t got;
+	pid_t child;
+	ULONG i, count;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s path/to/dpuinput\n", argv[0]);
+		return 2;
+	}
+	sink = mkstemp(sinkPath);
+	CHECK(sink >= 0);
+	CHECK(pipe(input) == 0 && pipe(output) == 0);
+
+	child = fork();
+	if (child == 0) {
+		dup2(input[0], STDIN_FILENO);
+		dup2(output[1], STDOUT_FILENO);
+		close(input[1]);
+		close(output[0]);
+		execl(argv[1], argv[1], "-o", sinkPath, "-v", (char *) NULL);
+		perror(argv[1]);
+		_exit(127);
+	}
+	close(input[0]);
+	close(output[1]);
+
+	resetInputData(&frames[0]);
+	CHECK(sendFrames(input[1], frames, 1, 31));
+
+	// Four frames in one read: the third changes nothing
+	frames[0].axisX = 1000;
+	frames[0].buttons = 1 << 3;
+	frames[1] = frames[0];
+	frames[2] = frames[0];
+	frames[2].buttons |= HAT(1, 2);
+	frames[3] = frames[0];
+	frames[3].buttons |= HAT(1, 3);
+	CHECK(sendFrames(input[1], frames, 4, 8));
+
+	// A read with nothing new writes nothing
+	frames[0] = frames[3];
+	CHECK(sendFrames(input[1], frames, 1, 0));
+	close(input[1]);
+
+	got = read(output[0], summary, sizeof(summary) - 1);
+	summary[max(got, 0)] = '\0';
+	CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	CHECK(strcmp(summary, EXPECTED_SUMMARY) == 0);
+	if (strcmp(summary, EXPECTED_SUMMARY) != 0)
+		fprintf(stderr, "dpuinput printed %s", summary);
+
+	got = read(sink, events, sizeof(events));
+	CHECK_EQUAL(got, EXPECTED_EVENTS * sizeof(struct input_event));
+	count = (ULONG) (max(got, 0) / sizeof(struct input_event));
+	for (i = 0; i < count && i < EXPECTED_EVENTS; i++) {
+		CHECK_EQUAL(events[i].type, expected[i].Type);
+		CHECK_EQUAL(events[i].code, expected[i].Code);
+		CHECK_EQUAL(events[i].value, expected[i].Value);
+	}
+
+	close(sink);
+	close(output[0]);
+	unlink(sinkPath);
+	return checkResult();
+}
@@ -0,0 +1,73 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    hidport.h
+
+Abstract:
+
+    Stand-in for the WDK's hidport.h: the HID minidriver IOCTLs HIDCLASS
+    sends, and the device attributes they return. HID_DESCRIPTOR comes from
+    dpport.h.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_SHIM_HIDPORT_H_
+
+#define _DROIDPAD_SHIM_HIDPORT_H_
+
+#include <wdm.h>
+
+#define HID_CTL_CODE(Id)		CTL_CODE(FILE_DEVICE_KEYBOARD, (Id), METHOD_NEITHER, FILE_ANY_ACCESS)
+
+#define IOCTL_HID_GET_DEVICE_DESCRIPTOR		HID_CTL_CODE(0)
+#define IOCTL_HID_GET_REPORT_DESCRIPTOR		HID_CTL_CODE(1)
+#define IOCTL_HID_READ_REPORT			HID_CTL_CODE(2)
+#define IOCTL_HID_WRITE_REPORT			HID_CTL_CODE(3)
+#define IOCTL_HID_GET_STRING			HID_CTL_CODE(4)
+#define IOCTL_HID_ACTIVATE_DEVICE		HID_CTL_CODE(7)
+#define IOCTL_HID_DEACTIVATE_DEVICE		HID_CTL_CODE(8)
+#define IOCTL_HID_GET_DEVICE_ATTRIBUTES		HID_CTL_CODE(9)
+#define IOCTL_HID_SEND_IDLE_NOTIFICATION_REQUEST	HID_CTL_CODE(10)
+#define IOCTL_HID_GET_FEATURE			HID_CTL_CODE(100)
+#define IOCTL_HID_SET_FEATURE			HID_CTL_CODE(101)
+#define IOCTL_HID_GET_INPUT_REPORT		HID_CTL_CODE(104)
+#define IOCTL_HID_SET_OUTPUT_REPORT		HID_CTL_CODE(105)
+
+typedef struct _HID_DEVICE_ATTRIBUTES {
+    ULONG   Size;
+    USHORT  VendorID;
+    USHORT  ProductID;
+    USHORT  VersionNumber;
+    USHORT  Reserved[11];
+} HID_DEVICE_ATTRIBUTES, *PHID_DEVICE_ATTRIBUTES;
+
+#endif   //_DROIDPAD_SHIM_HIDPORT_H_
@@ -0,0 +1,51 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    ntstrsafe.h
+
+Abstract:
+
+    Stand-in for the WDK's ntstrsafe.h: the one safe string routine the
+    driver's debug output uses.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_SHIM_NTSTRSAFE_H_
+
+#define _DROIDPAD_SHIM_NTSTRSAFE_H_
+
+#include <wdm.h>
+
+#define RtlStringCbVPrintfA(Dest, Size, Format, Args) \
+	(vsnprintf((Dest), (Size), (Format), (Args)) < 0 ? STATUS_INVALID_PARAMETER : STATUS_SUCCESS)
+
+#endif   //_DROIDPAD_SHIM_NTSTRSAFE_H_
@@ -0,0 +1,302 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    wdf.h
+
+Abstract:
+
+    Stand-in for KMDF's wdf.h, so the driver in sys/ builds as a user mode
+    library for the tests. Every framework object is the same kind of
+    handle, with at most one context; wdfshim.c implements the objects and
+    routines the driver uses, and wdfshim.h what the tests drive them with.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_SHIM_WDF_H_
+
+#define _DROIDPAD_SHIM_WDF_H_
+
+#include <wdm.h>
+
+typedef struct _WDF_OBJECT *WDFOBJECT;
+typedef WDFOBJECT WDFDRIVER, WDFDEVICE, WDFQUEUE, WDFREQUEST, WDFTIMER, WDFSPINLOCK, WDFWAITLOCK,
+    WDFCOLLECTION, WDFMEMORY, WDFKEY, WDFFILEOBJECT, WDFIOTARGET;
+typedef struct _WDFDEVICE_INIT WDFDEVICE_INIT, *PWDFDEVICE_INIT;
+
+#define WDF_NO_OBJECT_ATTRIBUTES	NULL
+#define WDF_NO_HANDLE			NULL
+#define WDF_NO_EVENT_CALLBACK		NULL
+#define WDF_NO_CONTEXT			NULL
+
+// Relative due times are negative, in 100ns units
+#define WDF_REL_TIMEOUT_IN_MS(Millis)	((LONGLONG) (Millis) * -10000)
+
+typedef enum _WDF_TRI_STATE {
+    WdfFalse = FALSE,
+    WdfTrue = TRUE,
+    WdfUseDefault = 2
+} WDF_TRI_STATE;
+
+//
+// Objects and their contexts
+//
+typedef struct _WDF_OBJECT_CONTEXT_TYPE_INFO {
+    ULONG       Size;
+    const char *ContextName;
+    size_t      ContextSize;
+} WDF_OBJECT_CONTEXT_TYPE_INFO, *PWDF_OBJECT_CONTEXT_TYPE_INFO;
+typedef const WDF_OBJECT_CONTEXT_TYPE_INFO *PCWDF_OBJECT_CONTEXT_TYPE_INFO;
+
+typedef VOID EVT_WDF_OBJECT_CONTEXT_CLEANUP(IN WDFOBJECT Object);
+typedef EVT_WDF_OBJECT_CONTEXT_CLEANUP *PFN_WDF_OBJECT_CONTEXT_CLEANUP;
+
+typedef struct _WDF_OBJECT_ATTRIBUTES {
+    ULONG       Size;
+    PFN_WDF_OBJECT_CONTEXT_CLEANUP EvtCleanupCallback;
+    WDFOBJECT   ParentObject;
+    PCWDF_OBJECT_CONTEXT_TYPE_INFO ContextTypeInfo;
+} WDF_OBJECT_ATTRIBUTES, *PWDF_OBJECT_ATTRIBUTES;
+
+#define WDF_OBJECT_ATTRIBUTES_INIT(Attributes) \
+	(RtlZeroMemory((Attributes), sizeof(WDF_OBJECT_ATTRIBUTES)), \
+	 (Attributes)->Size = sizeof(WDF_OBJECT_ATTRIBUTES))
+#define WDF_GET_CONTEXT_TYPE_INFO(Type)	(&_WDF_##Type##_TYPE_INFO)
+#define WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(Attributes, Type) \
+	(WDF_OBJECT_ATTRIBUTES_INIT(Attributes), \
+	 (Attributes)->ContextTypeInfo = WDF_GET_CONTEXT_TYPE_INFO(Type))
+
+PVOID WdfObjectGetTypedContextWorker(IN WDFOBJECT Handle, IN PCWDF_OBJECT_CONTEXT_TYPE_INFO TypeInfo);
+WDFOBJECT WdfObjectContextGetObject(IN PVOID ContextPointer);
+
+#define WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(Type, Accessor) \
+	static const WDF_OBJECT_CONTEXT_TYPE_INFO _WDF_##Type##_TYPE_INFO __attribute__((unused)) = \
+		{ sizeof(WDF_OBJECT_CONTEXT_TYPE_INFO), #Type, sizeof(Type) }; \
+	static __inline Type * \
+	Accessor(WDFOBJECT Handle) \
+	{ \
+		return (Type *) WdfObjectGetTypedContextWorker(Handle, WDF_GET_CONTEXT_TYPE_INFO(Type)); \
+	}
+
+VOID WdfObjectDelete(IN WDFOBJECT Object);
+VOID WdfObjectReference(IN WDFOBJECT Handle);
+VOID WdfObjectDereference(IN WDFOBJECT Handle);
+
+//
+// Driver
+//
+typedef NTSTATUS EVT_WDF_DRIVER_DEVICE_ADD(IN WDFDRIVER Driver, IN PWDFDEVICE_INIT DeviceInit);
+typedef EVT_WDF_DRIVER_DEVICE_ADD *PFN_WDF_DRIVER_DEVICE_ADD;
+
+typedef struct _WDF_DRIVER_CONFIG {
+    ULONG       Size;
+    PFN_WDF_DRIVER_DEVICE_ADD EvtDriverDeviceAdd;
+} WDF_DRIVER_CONFIG, *PWDF_DRIVER_CONFIG;
+
+#define WDF_DRIVER_CONFIG_INIT(Config, DeviceAdd) \
+	(RtlZeroMemory((Config), sizeof(WDF_DRIVER_CONFIG)), \
+	 (Config)->Size = sizeof(WDF_DRIVER_CONFIG), (Config)->EvtDriverDeviceAdd = (DeviceAdd))
+
+NTSTATUS WdfDriverCreate(IN PDRIVER_OBJECT DriverObject, IN PUNICODE_STRING RegistryPath,
+    IN PWDF_OBJECT_ATTRIBUTES DriverAttributes, IN PWDF_DRIVER_CONFIG DriverConfig, OUT WDFDRIVER *Driver);
+PDRIVER_OBJECT WdfDriverWdmGetDriverObject(IN WDFDRIVER Driver);
+
+//
+// Requests and queues
+//
+typedef enum _WDF_REQUEST_TYPE {
+    WdfRequestTypeCreate,
+    WdfRequestTypeRead,
+    WdfRequestTypeWrite,
+    WdfRequestTypeDeviceControl,
+    WdfRequestTypeDeviceControlInternal
+} WDF_REQUEST_TYPE;
+
+typedef struct _WDF_REQUEST_PARAMETERS {
+    ULONG       Size;
+    WDF_REQUEST_TYPE Type;
+    union {
+        struct {
+            size_t  OutputBufferLength;
+            size_t  InputBufferLength;
+            ULONG   IoControlCode;
+            PVOID   Type3InputBuffer;
+        } DeviceIoControl;
+    } Parameters;
+} WDF_REQUEST_PARAMETERS, *PWDF_REQUEST_PARAMETERS;
+
+#define WDF_REQUEST_PARAMETERS_INIT(Parameters) \
+	(RtlZeroMemory((Parameters), sizeof(WDF_REQUEST_PARAMETERS)), \
+	 (Parameters)->Size = sizeof(WDF_REQUEST_PARAMETERS))
+
+VOID WdfRequestGetParameters(IN WDFREQUEST Request, OUT PWDF_REQUEST_PARAMETERS Parameters);
+NTSTATUS WdfRequestRetrieveInputBuffer(IN WDFREQUEST Request, IN size_t MinimumRequiredLength,
+    OUT PVOID *Buffer, OUT size_t *Length);
+NTSTATUS WdfRequestRetrieveOutputBuffer(IN WDFREQUEST Request, IN size_t MinimumRequiredSize,
+    OUT PVOID *Buffer, OUT size_t *Length);
+NTSTATUS WdfRequestRetrieveOutputMemory(IN WDFREQUEST Request, OUT WDFMEMORY *Memory);
+NTSTATUS WdfMemoryCopyFromBuffer(IN WDFMEMORY DestinationMemory, IN size_t DestinationOffset,
+    IN PVOID Buffer, IN size_t NumBytesToCopyFrom);
+VOID WdfRequestSetInformation(IN WDFREQUEST Request, IN ULONG_PTR Information);
+VOID WdfRequestComplete(IN WDFREQUEST Request, IN NTSTATUS Status);
+VOID WdfRequestCompleteWithInformation(IN WDFREQUEST Request, IN NTSTATUS Status, IN ULONG_PTR Information);
+NTSTATUS WdfRequestForwardToIoQueue(IN WDFREQUEST Request, IN WDFQUEUE DestinationQueue);
+WDFQUEUE WdfRequestGetIoQueue(IN WDFREQUEST Request);
+WDFFILEOBJECT WdfRequestGetFileObject(IN WDFREQUEST Request);
+KPROCESSOR_MODE WdfRequestGetRequestorMode(IN WDFREQUEST Request);
+
+// The driver passes typed pointers for the PVOID * buffers
+#define WdfRequestRetrieveInputBuffer(Request, Minimum, Buffer, Length) \
+	WdfRequestRetrieveInputBuffer((Request), (Minimum), (PVOID *) (Buffer), (Length))
+#define WdfRequestRetrieveOutputBuffer(Request, Minimum, Buffer, Length) \
+	WdfRequestRetrieveOutputBuffer((Request), (Minimum), (PVOID *) (Buffer), (Length))
+
+typedef enum _WDF_IO_QUEUE_DISPATCH_TYPE {
+    WdfIoQueueDispatchInvalid,
+    WdfIoQueueDispatchSequential,
+    WdfIoQueueDispatchParallel,
+    WdfIoQueueDispatchManual
+} WDF_IO_QUEUE_DISPATCH_TYPE;
+
+typedef VOID EVT_WDF_IO_QUEUE_IO_DEVICE_CONTROL(IN WDFQUEUE Queue, IN WDFREQUEST Request,
+    IN size_t OutputBufferLength, IN size_t InputBufferLength, IN ULONG IoControlCode);
+typedef EVT_WDF_IO_QUEUE_IO_DEVICE_CONTROL *PFN_WDF_IO_QUEUE_IO_DEVICE_CONTROL;
+typedef EVT_WDF_IO_QUEUE_IO_DEVICE_CONTROL EVT_WDF_IO_QUEUE_IO_INTERNAL_DEVICE_CONTROL;
+typedef EVT_WDF_IO_QUEUE_IO_INTERNAL_DEVICE_CONTROL *PFN_WDF_IO_QUEUE_IO_INTERNAL_DEVICE_CONTROL;
+typedef VOID EVT_WDF_IO_QUEUE_IO_CANCELED_ON_QUEUE(IN WDFQUEUE Queue, IN WDFREQUEST Request);
+typedef VOID EVT_WDF_IO_QUEUE_STATE(IN WDFQUEUE Queue, IN PVOID Context);
+typedef EVT_WDF_IO_QUEUE_STATE *PFN_WDF_IO_QUEUE_STATE;
+
+typedef struct _WDF_IO_QUEUE_CONFIG {
+    ULONG       Size;
+    WDF_IO_QUEUE_DISPATCH_TYPE DispatchType;
+    WDF_TRI_STATE PowerManaged;
+    BOOLEAN     DefaultQueue;
+    PFN_WDF_IO_QUEUE_IO_DEVICE_CONTROL EvtIoDeviceControl;
+    PFN_WDF_IO_QUEUE_IO_INTERNAL_DEVICE_CONTROL EvtIoInternalDeviceControl;
+} WDF_IO_QUEUE_CONFIG, *PWDF_IO_QUEUE_CONFIG;
+
+#define WDF_IO_QUEUE_CONFIG_INIT(Config, Dispatch) \
+	(RtlZeroMemory((Config), sizeof(WDF_IO_QUEUE_CONFIG)), \
+	 (Config)->Size = sizeof(WDF_IO_QUEUE_CONFIG), (Config)->DispatchType = (Dispatch), \
+	 (Config)->PowerManaged = WdfUseDefault)
+#define WDF_IO_QUEUE_CONFIG_INIT_DEFAULT_QUEUE(Config, Dispatch) \
+	(WDF_IO_QUEUE_CONFIG_INIT((Config), (Dispatch)), (Config)->DefaultQueue = TRUE)
+
+NTSTATUS WdfIoQueueCreate(IN WDFDEVICE Device, IN PWDF_IO_QUEUE_CONFIG Config,
+    IN PWDF_OBJECT_ATTRIBUTES QueueAttributes, OUT WDFQUEUE *Queue);
+NTSTATUS WdfIoQueueRetrieveNextRequest(IN WDFQUEUE Queue, OUT WDFREQUEST *OutRequest);
+ULONG WdfIoQueueGetState(IN WDFQUEUE Queue, OUT PULONG QueueRequests, OUT PULONG DriverRequests);
+WDFDEVICE WdfIoQueueGetDevice(IN WDFQUEUE Queue);
+VOID WdfIoQueuePurge(IN WDFQUEUE Queue, IN PFN_WDF_IO_QUEUE_STATE PurgeComplete, IN PVOID Context);
+
+//
+// Devices
+//
+typedef VOID EVT_WDF_IO_IN_CALLER_CONTEXT(IN WDFDEVICE Device, IN WDFREQUEST Request);
+typedef EVT_WDF_IO_IN_CALLER_CONTEXT *PFN_WDF_IO_IN_CALLER_CONTEXT;
+typedef VOID EVT_WDF_FILE_CLEANUP(IN WDFFILEOBJECT FileObject);
+typedef EVT_WDF_FILE_CLEANUP *PFN_WDF_FILE_CLEANUP;
+typedef VOID EVT_WDF_DEVICE_FILE_CREATE(IN WDFDEVICE Device, IN WDFREQUEST Request, IN WDFFILEOBJECT FileObject);
+typedef EVT_WDF_DEVICE_FILE_CREATE *PFN_WDF_DEVICE_FILE_CREATE;
+typedef VOID EVT_WDF_FILE_CLOSE(IN WDFFILEOBJECT FileObject);
+typedef EVT_WDF_FILE_CLOSE *PFN_WDF_FILE_CLOSE;
+
+typedef struct _WDF_FILEOBJECT_CONFIG {
+    ULONG       Size;
+    PFN_WDF_DEVICE_FILE_CREATE EvtDeviceFileCreate;
+    PFN_WDF_FILE_CLOSE EvtFileClose;
+    PFN_WDF_FILE_CLEANUP EvtFileCleanup;
+} WDF_FILEOBJECT_CONFIG, *PWDF_FILEOBJECT_CONFIG;
+
+#define WDF_FILEOBJECT_CONFIG_INIT(Config, Create, Close, Cleanup) \
+	(RtlZeroMemory((Config), sizeof(WDF_FILEOBJECT_CONFIG)), \
+	 (Config)->Size = sizeof(WDF_FILEOBJECT_CONFIG), (Config)->EvtDeviceFileCreate = (Create), \
+	 (Config)->EvtFileClose = (Close), (Config)->EvtFileCleanup = (Cleanup))
+
+VOID WdfFdoInitSetFilter(IN PWDFDEVICE_INIT DeviceInit);
+NTSTATUS WdfPdoInitAddCompatibleID(IN PWDFDEVICE_INIT DeviceInit, IN PCUNICODE_STRING CompatibleID);
+PWDFDEVICE_INIT WdfControlDeviceInitAllocate(IN WDFDRIVER Driver, IN PCUNICODE_STRING SDDLString);
+VOID WdfDeviceInitFree(IN PWDFDEVICE_INIT DeviceInit);
+VOID WdfDeviceInitSetExclusive(IN PWDFDEVICE_INIT DeviceInit, IN BOOLEAN IsExclusive);
+VOID WdfDeviceInitSetIoInCallerContextCallback(IN PWDFDEVICE_INIT DeviceInit,
+    IN PFN_WDF_IO_IN_CALLER_CONTEXT EvtIoInCallerContext);
+VOID WdfDeviceInitSetFileObjectConfig(IN PWDFDEVICE_INIT DeviceInit, IN PWDF_FILEOBJECT_CONFIG FileObjectConfig,
+    IN PWDF_OBJECT_ATTRIBUTES FileObjectAttributes);
+NTSTATUS WdfDeviceInitAssignName(IN PWDFDEVICE_INIT DeviceInit, IN PCUNICODE_STRING DeviceName);
+NTSTATUS WdfDeviceCreate(IN OUT PWDFDEVICE_INIT *DeviceInit, IN PWDF_OBJECT_ATTRIBUTES DeviceAttributes,
+    OUT WDFDEVICE *Device);
+NTSTATUS WdfDeviceCreateSymbolicLink(IN WDFDEVICE Device, IN PCUNICODE_STRING SymbolicLinkName);
+VOID WdfControlFinishInitializing(IN WDFDEVICE Device);
+WDFDRIVER WdfDeviceGetDriver(IN WDFDEVICE Device);
+WDFQUEUE WdfDeviceGetDefaultQueue(IN WDFDEVICE Device);
+NTSTATUS WdfDeviceEnqueueRequest(IN WDFDEVICE Device, IN WDFREQUEST Request);
+
+NTSTATUS WdfDeviceOpenRegistryKey(IN WDFDEVICE Device, IN ULONG DeviceInstanceKeyType, IN ACCESS_MASK DesiredAccess,
+    IN PWDF_OBJECT_ATTRIBUTES KeyAttributes, OUT WDFKEY *Key);
+NTSTATUS WdfRegistryQueryULong(IN WDFKEY Key, IN PCUNICODE_STRING ValueName, OUT PULONG Value);
+VOID WdfRegistryClose(IN WDFKEY Key);
+
+//
+// Timers, locks and collections
+//
+typedef VOID EVT_WDF_TIMER(IN WDFTIMER Timer);
+typedef EVT_WDF_TIMER *PFN_WDF_TIMER;
+
+typedef struct _WDF_TIMER_CONFIG {
+    ULONG       Size;
+    PFN_WDF_TIMER EvtTimerFunc;
+    ULONG       Period;
+    BOOLEAN     AutomaticSerialization;
+} WDF_TIMER_CONFIG, *PWDF_TIMER_CONFIG;
+
+#define WDF_TIMER_CONFIG_INIT(Config, Func) \
+	(RtlZeroMemory((Config), sizeof(WDF_TIMER_CONFIG)), \
+	 (Config)->Size = sizeof(WDF_TIMER_CONFIG), (Config)->EvtTimerFunc = (Func), \
+	 (Config)->AutomaticSerialization = TRUE)
+
+NTSTATUS WdfTimerCreate(IN PWDF_TIMER_CONFIG Config, IN PWDF_OBJECT_ATTRIBUTES Attributes, OUT WDFTIMER *Timer);
+BOOLEAN WdfTimerStart(IN WDFTIMER Timer, IN LONGLONG DueTime);
+WDFOBJECT WdfTimerGetParentObject(IN WDFTIMER Timer);
+
+NTSTATUS WdfSpinLockCreate(IN PWDF_OBJECT_ATTRIBUTES SpinLockAttributes, OUT WDFSPINLOCK *SpinLock);
+VOID WdfSpinLockAcquire(IN WDFSPINLOCK SpinLock);
+VOID WdfSpinLockRelease(IN WDFSPINLOCK SpinLock);
+NTSTATUS WdfWaitLockCreate(IN PWDF_OBJECT_ATTRIBUTES LockAttributes, OUT WDFWAITLOCK *Lock);
+NTSTATUS WdfWaitLockAcquire(IN WDFWAITLOCK Lock, IN PLONGLONG Timeout);
+VOID WdfWaitLockRelease(IN WDFWAITLOCK Lock);
+
+NTSTATUS WdfCollectionCreate(IN PWDF_OBJECT_ATTRIBUTES CollectionAttributes, OUT WDFCOLLECTION *Collection);
+NTSTATUS WdfCollectionAdd(IN WDFCOLLECTION Collection, IN WDFOBJECT Object);
+VOID WdfCollectionRemove(IN WDFCOLLECTION Collection, IN WDFOBJECT Item);
+ULONG WdfCollectionGetCount(IN WDFCOLLECTION Collection);
+
+#endif   //_DROIDPAD_SHIM_WDF_H_
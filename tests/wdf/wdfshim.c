@@ -0,0 +1,1737 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    wdfshim.c
+
+Abstract:
+
+    A user mode stand-in for the parts of KMDF and the kernel the driver
+    uses, enough to run driver.c, hid.c, input.c, report.c and shared.c on
+    a host: objects with contexts, parents and references, requests,
+    sequential, parallel and manual queues, one-shot timers on a clock the
+    tests move, spin and wait locks, collections and the registry values a
+    device reads. Anything the driver does that the framework would object
+    to is counted, so the tests can check none of it happened.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#include <pthread.h>
+#include <sched.h>
+#include "wdfshim.h"
+
+DRIVER_INITIALIZE DriverEntry;
+
+#define SHIM_MAX_ITEMS		64
+#define SHIM_MAX_PARAMETERS	32
+#define SHIM_MAX_PROCESSES	4
+#define SHIM_RUNDOWN_WAITING	0x40000000
+
+typedef enum _SHIM_OBJECT_TYPE {
+    ShimDriver,
+    ShimDevice,
+    ShimQueue,
+    ShimRequest,
+    ShimTimer,
+    ShimLock,
+    ShimCollection,
+    ShimMemory,
+    ShimKey,
+    ShimFile
+} SHIM_OBJECT_TYPE;
+
+//
+// Every handle is one of these, followed by its context, if it has one.
+//
+struct _WDF_OBJECT {
+    SHIM_OBJECT_TYPE Type;
+    volatile LONG    References;
+    BOOLEAN          Deleted;
+    PFN_WDF_OBJECT_CONTEXT_CLEANUP EvtCleanupCallback;
+    PCWDF_OBJECT_CONTEXT_TYPE_INFO ContextType;
+    WDFOBJECT        Parent;
+    WDFOBJECT        Children;   // Newest first
+    WDFOBJECT        Sibling;
+
+    union {
+        struct {
+            PDRIVER_OBJECT DriverObject;
+            PFN_WDF_DRIVER_DEVICE_ADD EvtDriverDeviceAdd;
+        } Driver;
+        struct {
+            WDFDRIVER  Driver;
+            WDFQUEUE   DefaultQueue;
+            BOOLEAN    Control;
+            BOOLEAN    Initialized;
+            PFN_WDF_IO_IN_CALLER_CONTEXT EvtIoInCallerContext;
+            PFN_WDF_FILE_CLEANUP EvtFileCleanup;
+            PCWDF_OBJECT_CONTEXT_TYPE_INFO FileContextType;
+        } Device;
+        struct {
+            WDFDEVICE  Device;
+            WDF_IO_QUEUE_CONFIG Config;
+            pthread_mutex_t Lock;       // Over the requests
+            pthread_mutex_t Dispatch;   // Held over a sequential queue's callback
+            WDFREQUEST Head, Tail;
+            ULONG      Count;
+        } Queue;
+        struct {
+            WDF_REQUEST_PARAMETERS Parameters;
+            PVOID      Input;           // Caller's buffers
+            PVOID      Output;
+            PVOID      System;          // METHOD_BUFFERED copy, or NULL
+            WDFQUEUE   Queue;
+            WDFREQUEST Next;            // In Queue
+            BOOLEAN    Queued;
+            WDFFILEOBJECT File;
+            KPROCESSOR_MODE RequestorMode;
+            WDFMEMORY  OutputMemory;
+            ULONG_PTR  Information;
+            NTSTATUS   Status;
+            volatile LONG Completed;
+        } Request;
+        struct {
+            PFN_WDF_TIMER EvtTimerFunc;
+            LONGLONG   Due;             // -1 unless armed
+            ULONG      Fired;           // Times EvtTimerFunc has run
+            WDFTIMER   Next;            // In timers
+        } Timer;
+        struct {
+            pthread_mutex_t Mutex;
+        } Lock;
+        struct {
+            WDFOBJECT  Items[SHIM_MAX_ITEMS];
+            ULONG      Count;
+        } Collection;
+        struct {
+            PVOID      Buffer;
+            size_t     Size;
+        } Memory;
+        struct {
+            WDFDEVICE  Device;
+        } File;
+    } u;
+} __attribute__((aligned(16)));
+
+struct _WDFDEVICE_INIT {
+    WDFDRIVER  Driver;
+    BOOLEAN    Control;
+    PFN_WDF_IO_IN_CALLER_CONTEXT EvtIoInCallerContext;
+    PFN_WDF_FILE_CLEANUP EvtFileCleanup;
+    PCWDF_OBJECT_CONTEXT_TYPE_INFO FileContextType;
+    WDFDEVICE  Created;
+};
+
+typedef struct _SHIM_PARAMETER {
+    WCHAR Name[64];
+    ULONG Value;
+} SHIM_PARAMETER;
+
+struct _KPROCESS {
+    ULONG Id;
+};
+
+struct _DRIVER_OBJECT {
+    ULONG Unused;
+};
+
+static pthread_mutex_t objectLock = PTHREAD_MUTEX_INITIALIZER;   // Parents, children and timers
+static WDFDRIVER driver;
+static WDFTIMER timers;
+static WDFOBJECT earlyObjects;   // Made by DriverEntry before the driver object
+static volatile LONGLONG interruptTime = 10000000;
+static SHIM_PARAMETER parameters[SHIM_MAX_PARAMETERS];
+static ULONG parameterCount;
+static struct _KPROCESS processes[SHIM_MAX_PROCESSES] = { { 0 }, { 1 }, { 2 }, { 3 } };
+static __thread PEPROCESS currentProcess = &processes[0];
+static __thread KPROCESSOR_MODE currentRequestorMode = UserMode;
+static __thread LONG processorNumber = -1;
+static volatile LONG processorCount;
+static volatile LONG errors;
+static volatile LONG poolAllocations;
+static struct _DRIVER_OBJECT driverObject;
+
+char KeNumberProcessors = 64;
+
+/**
+ * Notes something the driver did that the framework or kernel wouldn't
+ * allow.
+ */
+static VOID
+shimError(
+    IN const char *Format,
+    ...
+    )
+{
+	va_list args;
+
+	InterlockedIncrement(&errors);
+	va_start(args, Format);
+	fprintf(stderr, "wdfshim: ");
+	vfprintf(stderr, Format, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+}
+
+/**
+ * Makes an object with a context of the type Attributes give, if any, as
+ * a child of Attributes' parent or of DefaultParent. Holds one reference,
+ * dropped when the object is deleted.
+ */
+static WDFOBJECT
+objectCreate(
+    IN SHIM_OBJECT_TYPE       Type,
+    IN PWDF_OBJECT_ATTRIBUTES Attributes,
+    IN WDFOBJECT              DefaultParent
+    )
+{
+	WDFOBJECT object;
+	size_t contextSize = 0;
+
+	if (Attributes != NULL && Attributes->ContextTypeInfo != NULL)
+		contextSize = Attributes->ContextTypeInfo->ContextSize;
+
+	object = calloc(1, sizeof(struct _WDF_OBJECT) + contextSize);
+	if (object == NULL)
+		return NULL;
+	object->Type = Type;
+	object->References = 1;
+	if (Attributes != NULL) {
+		object->EvtCleanupCallback = Attributes->EvtCleanupCallback;
+		object->ContextType = Attributes->ContextTypeInfo;
+		if (Attributes->ParentObject != NULL)
+			DefaultParent = Attributes->ParentObject;
+	}
+
+	pthread_mutex_lock(&objectLock);
+	if (DefaultParent != NULL) {
+		object->Parent = DefaultParent;
+		object->Sibling = DefaultParent->Children;
+		DefaultParent->Children = object;
+	} else if ((Type == ShimCollection || Type == ShimLock) && driver == NULL) {
+		object->Sibling = earlyObjects;
+		earlyObjects = object;
+	}
+	pthread_mutex_unlock(&objectLock);
+	return object;
+}
+
+/**
+ * Frees what an object of each type holds, once nothing references it.
+ */
+static VOID
+objectFree(
+    IN WDFOBJECT Object
+    )
+{
+	switch (Object->Type) {
+	case ShimQueue:
+		pthread_mutex_destroy(&Object->u.Queue.Lock);
+		pthread_mutex_destroy(&Object->u.Queue.Dispatch);
+		break;
+	case ShimRequest:
+		free(Object->u.Request.System);
+		break;
+	case ShimLock:
+		pthread_mutex_destroy(&Object->u.Lock.Mutex);
+		break;
+	default:
+		break;
+	}
+	free(Object);
+}
+
+PVOID
+WdfObjectGetTypedContextWorker(
+    IN WDFOBJECT                      Handle,
+    IN PCWDF_OBJECT_CONTEXT_TYPE_INFO TypeInfo
+    )
+{
+	// Each source file has its own copy of the type info, so go by name
+	if (Handle == NULL || Handle->ContextType == NULL ||
+		strcmp(Handle->ContextType->ContextName, TypeInfo->ContextName) != 0) {
+		shimError("object %p has no %s context", (void *) Handle, TypeInfo->ContextName);
+		return NULL;
+	}
+	return Handle + 1;
+}
+
+WDFOBJECT
+WdfObjectContextGetObject(
+    IN PVOID ContextPointer
+    )
+{
+	return (WDFOBJECT) ContextPointer - 1;
+}
+
+VOID
+WdfObjectReference(
+    IN WDFOBJECT Handle
+    )
+{
+	InterlockedIncrement(&Handle->References);
+}
+
+VOID
+WdfObjectDereference(
+    IN WDFOBJECT Handle
+    )
+{
+	LONG references = InterlockedDecrement(&Handle->References);
+
+	if (references < 0)
+		shimError("object %p dereferenced too often", (void *) Handle);
+	else if (references == 0)
+		objectFree(Handle);
+}
+
+static VOID queuePurge(IN WDFQUEUE Queue);
+
+/**
+ * Deletes an object's children, newest first, then cleans it up and drops
+ * the reference it was created with.
+ */
+VOID
+WdfObjectDelete(
+    IN WDFOBJECT Object
+    )
+{
+	WDFOBJECT child, *link;
+	ULONG i;
+
+	pthread_mutex_lock(&objectLock);
+	if (Object->Deleted) {
+		pthread_mutex_unlock(&objectLock);
+		shimError("object %p deleted twice", (void *) Object);
+		return;
+	}
+	Object->Deleted = TRUE;
+	pthread_mutex_unlock(&objectLock);
+
+	for (;;) {
+		pthread_mutex_lock(&objectLock);
+		child = Object->Children;
+		if (child != NULL) {
+			Object->Children = child->Sibling;
+			child->Parent = NULL;
+		}
+		pthread_mutex_unlock(&objectLock);
+		if (child == NULL)
+			break;
+		WdfObjectDelete(child);
+	}
+
+	switch (Object->Type) {
+	case ShimQueue:
+		queuePurge(Object);
+		break;
+	case ShimTimer:
+		pthread_mutex_lock(&objectLock);
+		for (link = &timers; *link != NULL; link = &(*link)->u.Timer.Next) {
+			if (*link == Object) {
+				*link = Object->u.Timer.Next;
+				break;
+			}
+		}
+		pthread_mutex_unlock(&objectLock);
+		break;
+	case ShimRequest:
+		if (!Object->u.Request.Completed)
+			shimError("request %p deleted before it was completed", (void *) Object);
+		break;
+	default:
+		break;
+	}
+
+	if (Object->EvtCleanupCallback != NULL)
+		Object->EvtCleanupCallback(Object);
+
+	if (Object->Type == ShimCollection) {
+		for (i = 0; i < Object->u.Collection.Count; i++)
+			WdfObjectDereference(Object->u.Collection.Items[i]);
+		Object->u.Collection.Count = 0;
+	}
+
+	pthread_mutex_lock(&objectLock);
+	if (Object->Parent != NULL) {
+		for (link = &Object->Parent->Children; *link != NULL; link = &(*link)->Sibling) {
+			if (*link == Object) {
+				*link = Object->Sibling;
+				break;
+			}
+		}
+		Object->Parent = NULL;
+	}
+	pthread_mutex_unlock(&objectLock);
+
+	WdfObjectDereference(Object);
+}
+
+//
+// Kernel routines
+//
+
+VOID
+RtlInitUnicodeString(
+    OUT PUNICODE_STRING Destination,
+    IN PCWSTR           Source
+    )
+{
+	Destination->Buffer = (PWSTR) Source;
+	Destination->Length = (USHORT) (wcslen(Source) * sizeof(WCHAR));
+	Destination->MaximumLength = Destination->Length + sizeof(WCHAR);
+}
+
+VOID
+RtlInitAnsiString(
+    OUT PANSI_STRING Destination,
+    IN const char   *Source
+    )
+{
+	Destination->Buffer = (PCHAR) Source;
+	Destination->Length = (USHORT) strlen(Source);
+	Destination->MaximumLength = Destination->Length + 1;
+}
+
+NTSTATUS
+RtlAnsiStringToUnicodeString(
+    OUT PUNICODE_STRING Destination,
+    IN PANSI_STRING     Source,
+    IN BOOLEAN          AllocateDestination
+    )
+{
+	USHORT i;
+
+	if (!AllocateDestination)
+		return STATUS_NOT_SUPPORTED;
+	Destination->Buffer = ExAllocatePoolWithTag(PagedPool, (Source->Length + 1) * sizeof(WCHAR), 0);
+	if (Destination->Buffer == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+	for (i = 0; i < Source->Length; i++)
+		Destination->Buffer[i] = (UCHAR) Source->Buffer[i];
+	Destination->Buffer[i] = 0;
+	Destination->Length = Source->Length * sizeof(WCHAR);
+	Destination->MaximumLength = Destination->Length + sizeof(WCHAR);
+	return STATUS_SUCCESS;
+}
+
+VOID
+RtlFreeUnicodeString(
+    IN OUT PUNICODE_STRING String
+    )
+{
+	if (String->Buffer != NULL)
+		ExFreePoolWithTag(String->Buffer, 0);
+	String->Buffer = NULL;
+	String->Length = String->MaximumLength = 0;
+}
+
+PVOID
+ExAllocatePoolWithTag(
+    IN POOL_TYPE PoolType,
+    IN size_t    NumberOfBytes,
+    IN ULONG     Tag
+    )
+{
+	PVOID p = malloc(NumberOfBytes);
+
+	UNREFERENCED_PARAMETER(PoolType);
+	UNREFERENCED_PARAMETER(Tag);
+
+	if (p != NULL)
+		InterlockedIncrement(&poolAllocations);
+	return p;
+}
+
+VOID
+ExFreePoolWithTag(
+    IN PVOID P,
+    IN ULONG Tag
+    )
+{
+	UNREFERENCED_PARAMETER(Tag);
+
+	InterlockedDecrement(&poolAllocations);
+	free(P);
+}
+
+VOID
+ExInitializeRundownProtection(
+    OUT PEX_RUNDOWN_REF RunRef
+    )
+{
+	RunRef->Count = 0;
+}
+
+BOOLEAN
+ExAcquireRundownProtection(
+    IN OUT PEX_RUNDOWN_REF RunRef
+    )
+{
+	LONG count;
+
+	do {
+		count = RunRef->Count;
+		if (count & SHIM_RUNDOWN_WAITING)
+			return FALSE;
+	} while (InterlockedCompareExchange(&RunRef->Count, count + 1, count) != count);
+	return TRUE;
+}
+
+VOID
+ExReleaseRundownProtection(
+    IN OUT PEX_RUNDOWN_REF RunRef
+    )
+{
+	if ((InterlockedDecrement(&RunRef->Count) & ~SHIM_RUNDOWN_WAITING) < 0)
+		shimError("rundown protection released too often");
+}
+
+VOID
+ExWaitForRundownProtectionRelease(
+    IN OUT PEX_RUNDOWN_REF RunRef
+    )
+{
+	InterlockedExchangeAdd(&RunRef->Count, SHIM_RUNDOWN_WAITING);
+	while ((RunRef->Count & ~SHIM_RUNDOWN_WAITING) != 0)
+		sched_yield();
+}
+
+ULONGLONG
+KeQueryInterruptTime(
+    VOID
+    )
+{
+	return (ULONGLONG) __atomic_load_n(&interruptTime, __ATOMIC_SEQ_CST);
+}
+
+ULONG
+KeGetCurrentProcessorNumber(
+    VOID
+    )
+{
+	// A CPU per thread, so each trace ring still has one writer at a time
+	if (processorNumber < 0)
+		processorNumber = (InterlockedIncrement(&processorCount) - 1) % KeNumberProcessors;
+	return (ULONG) processorNumber;
+}
+
+PEPROCESS
+PsGetCurrentProcess(
+    VOID
+    )
+{
+	return currentProcess;
+}
+
+VOID
+KeStackAttachProcess(
+    IN PRKPROCESS    Process,
+    OUT PRKAPC_STATE ApcState
+    )
+{
+	ApcState->Process = currentProcess;
+	currentProcess = Process;
+}
+
+VOID
+KeUnstackDetachProcess(
+    IN PRKAPC_STATE ApcState
+    )
+{
+	currentProcess = ApcState->Process;
+}
+
+PMDL
+IoAllocateMdl(
+    IN PVOID   VirtualAddress,
+    IN ULONG   Length,
+    IN BOOLEAN SecondaryBuffer,
+    IN BOOLEAN ChargeQuota,
+    IN PVOID   Irp
+    )
+{
+	PMDL mdl = ExAllocatePoolWithTag(NonPagedPool, sizeof(MDL), 0);
+
+	UNREFERENCED_PARAMETER(SecondaryBuffer);
+	UNREFERENCED_PARAMETER(ChargeQuota);
+	UNREFERENCED_PARAMETER(Irp);
+
+	if (mdl != NULL) {
+		RtlZeroMemory(mdl, sizeof(MDL));
+		mdl->StartVa = VirtualAddress;
+		mdl->ByteCount = Length;
+	}
+	return mdl;
+}
+
+VOID
+IoFreeMdl(
+    IN PMDL Mdl
+    )
+{
+	if (Mdl->MappedVa != NULL)
+		shimError("MDL freed while still mapped");
+	ExFreePoolWithTag(Mdl, 0);
+}
+
+VOID
+MmBuildMdlForNonPagedPool(
+    IN OUT PMDL Mdl
+    )
+{
+	UNREFERENCED_PARAMETER(Mdl);
+}
+
+PVOID
+MmMapLockedPagesSpecifyCache(
+    IN PMDL                Mdl,
+    IN KPROCESSOR_MODE     AccessMode,
+    IN MEMORY_CACHING_TYPE CacheType,
+    IN PVOID               BaseAddress,
+    IN ULONG               BugCheckOnFailure,
+    IN ULONG               Priority
+    )
+{
+	UNREFERENCED_PARAMETER(CacheType);
+	UNREFERENCED_PARAMETER(BaseAddress);
+	UNREFERENCED_PARAMETER(BugCheckOnFailure);
+
+	if (AccessMode == UserMode && !(Priority & MdlMappingNoExecute))
+		shimError("user mode mapping of %p is executable", Mdl->StartVa);
+
+	// The process shares the kernel's address space here
+	Mdl->MappedVa = Mdl->StartVa;
+	Mdl->Process = currentProcess;
+	return Mdl->MappedVa;
+}
+
+VOID
+MmUnmapLockedPages(
+    IN PVOID BaseAddress,
+    IN PMDL  Mdl
+    )
+{
+	if (BaseAddress != Mdl->MappedVa)
+		shimError("unmapping %p, which the MDL doesn't map", BaseAddress);
+	else if (Mdl->Process != currentProcess)
+		shimError("unmapping from process %u, mapped in process %u", currentProcess->Id, Mdl->Process->Id);
+	Mdl->MappedVa = NULL;
+	Mdl->Process = NULL;
+}
+
+//
+// Driver and devices
+//
+
+NTSTATUS
+WdfDriverCreate(
+    IN PDRIVER_OBJECT         DriverObject,
+    IN PUNICODE_STRING        RegistryPath,
+    IN PWDF_OBJECT_ATTRIBUTES DriverAttributes,
+    IN PWDF_DRIVER_CONFIG     DriverConfig,
+    OUT WDFDRIVER            *Driver
+    )
+{
+	WDFOBJECT object;
+
+	UNREFERENCED_PARAMETER(RegistryPath);
+
+	driver = objectCreate(ShimDriver, DriverAttributes, NULL);
+	if (driver == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+
+	// Objects DriverEntry made before this one still belong to the driver
+	pthread_mutex_lock(&objectLock);
+	while ((object = earlyObjects) != NULL) {
+		earlyObjects = object->Sibling;
+		object->Parent = driver;
+		object->Sibling = driver->Children;
+		driver->Children = object;
+	}
+	pthread_mutex_unlock(&objectLock);
+	driver->u.Driver.DriverObject = DriverObject;
+	driver->u.Driver.EvtDriverDeviceAdd = DriverConfig->EvtDriverDeviceAdd;
+	if (Driver != NULL)
+		*Driver = driver;
+	return STATUS_SUCCESS;
+}
+
+PDRIVER_OBJECT
+WdfDriverWdmGetDriverObject(
+    IN WDFDRIVER Driver
+    )
+{
+	return Driver->u.Driver.DriverObject;
+}
+
+VOID
+WdfFdoInitSetFilter(
+    IN PWDFDEVICE_INIT DeviceInit
+    )
+{
+	UNREFERENCED_PARAMETER(DeviceInit);
+}
+
+NTSTATUS
+WdfPdoInitAddCompatibleID(
+    IN PWDFDEVICE_INIT  DeviceInit,
+    IN PCUNICODE_STRING CompatibleID
+    )
+{
+	UNREFERENCED_PARAMETER(DeviceInit);
+	UNREFERENCED_PARAMETER(CompatibleID);
+	return STATUS_SUCCESS;
+}
+
+PWDFDEVICE_INIT
+WdfControlDeviceInitAllocate(
+    IN WDFDRIVER        Driver,
+    IN PCUNICODE_STRING SDDLString
+    )
+{
+	PWDFDEVICE_INIT init = calloc(1, sizeof(WDFDEVICE_INIT));
+
+	UNREFERENCED_PARAMETER(SDDLString);
+
+	if (init != NULL) {
+		init->Driver = Driver;
+		init->Control = TRUE;
+	}
+	return init;
+}
+
+VOID
+WdfDeviceInitFree(
+    IN PWDFDEVICE_INIT DeviceInit
+    )
+{
+	free(DeviceInit);
+}
+
+VOID
+WdfDeviceInitSetExclusive(
+    IN PWDFDEVICE_INIT DeviceInit,
+    IN BOOLEAN         IsExclusive
+    )
+{
+	UNREFERENCED_PARAMETER(DeviceInit);
+	UNREFERENCED_PARAMETER(IsExclusive);
+}
+
+VOID
+WdfDeviceInitSetIoInCallerContextCallback(
+    IN PWDFDEVICE_INIT              DeviceInit,
+    IN PFN_WDF_IO_IN_CALLER_CONTEXT EvtIoInCallerContext
+    )
+{
+	DeviceInit->EvtIoInCallerContext = EvtIoInCallerContext;
+}
+
+VOID
+WdfDeviceInitSetFileObjectConfig(
+    IN PWDFDEVICE_INIT        DeviceInit,
+    IN PWDF_FILEOBJECT_CONFIG FileObjectConfig,
+    IN PWDF_OBJECT_ATTRIBUTES FileObjectAttributes
+    )
+{
+	DeviceInit->EvtFileCleanup = FileObjectConfig->EvtFileCleanup;
+	if (FileObjectAttributes != NULL)
+		DeviceInit->FileContextType = FileObjectAttributes->ContextTypeInfo;
+}
+
+NTSTATUS
+WdfDeviceInitAssignName(
+    IN PWDFDEVICE_INIT  DeviceInit,
+    IN PCUNICODE_STRING DeviceName
+    )
+{
+	UNREFERENCED_PARAMETER(DeviceInit);
+	UNREFERENCED_PARAMETER(DeviceName);
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+WdfDeviceCreate(
+    IN OUT PWDFDEVICE_INIT   *DeviceInit,
+    IN PWDF_OBJECT_ATTRIBUTES DeviceAttributes,
+    OUT WDFDEVICE            *Device
+    )
+{
+	PWDFDEVICE_INIT init = *DeviceInit;
+	WDFDEVICE device;
+
+	device = objectCreate(ShimDevice, DeviceAttributes, init->Driver);
+	if (device == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+	device->u.Device.Driver = init->Driver;
+	device->u.Device.Control = init->Control;
+	device->u.Device.EvtIoInCallerContext = init->EvtIoInCallerContext;
+	device->u.Device.EvtFileCleanup = init->EvtFileCleanup;
+	device->u.Device.FileContextType = init->FileContextType;
+
+	if (init->Control) {
+		// The framework frees a control device's init once it's used
+		free(init);
+		*DeviceInit = NULL;
+	} else {
+		init->Created = device;
+	}
+	*Device = device;
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+WdfDeviceCreateSymbolicLink(
+    IN WDFDEVICE        Device,
+    IN PCUNICODE_STRING SymbolicLinkName
+    )
+{
+	UNREFERENCED_PARAMETER(Device);
+	UNREFERENCED_PARAMETER(SymbolicLinkName);
+	return STATUS_SUCCESS;
+}
+
+VOID
+WdfControlFinishInitializing(
+    IN WDFDEVICE Device
+    )
+{
+	Device->u.Device.Initialized = TRUE;
+}
+
+WDFDRIVER
+WdfDeviceGetDriver(
+    IN WDFDEVICE Device
+    )
+{
+	return Device->u.Device.Driver;
+}
+
+WDFQUEUE
+WdfDeviceGetDefaultQueue(
+    IN WDFDEVICE Device
+    )
+{
+	return Device->u.Device.DefaultQueue;
+}
+
+NTSTATUS
+WdfDeviceOpenRegistryKey(
+    IN WDFDEVICE              Device,
+    IN ULONG                  DeviceInstanceKeyType,
+    IN ACCESS_MASK            DesiredAccess,
+    IN PWDF_OBJECT_ATTRIBUTES KeyAttributes,
+    OUT WDFKEY               *Key
+    )
+{
+	UNREFERENCED_PARAMETER(Device);
+	UNREFERENCED_PARAMETER(DeviceInstanceKeyType);
+	UNREFERENCED_PARAMETER(DesiredAccess);
+
+	*Key = objectCreate(ShimKey, KeyAttributes, NULL);
+	return *Key != NULL ? STATUS_SUCCESS : STATUS_INSUFFICIENT_RESOURCES;
+}
+
+NTSTATUS
+WdfRegistryQueryULong(
+    IN WDFKEY           Key,
+    IN PCUNICODE_STRING ValueName,
+    OUT PULONG          Value
+    )
+{
+	size_t length = ValueName->Length / sizeof(WCHAR);
+	ULONG i;
+
+	UNREFERENCED_PARAMETER(Key);
+
+	for (i = 0; i < parameterCount; i++) {
+		if (wcslen(parameters[i].Name) == length &&
+			wcsncmp(parameters[i].Name, ValueName->Buffer, length) == 0) {
+			*Value = parameters[i].Value;
+			return STATUS_SUCCESS;
+		}
+	}
+	return STATUS_OBJECT_NAME_NOT_FOUND;
+}
+
+VOID
+WdfRegistryClose(
+    IN WDFKEY Key
+    )
+{
+	WdfObjectDelete(Key);
+}
+
+//
+// Requests and queues
+//
+
+/**
+ * Hands a request to a queue: straight to its callback, unless the queue
+ * is manual, in which case it waits to be retrieved.
+ */
+static VOID
+queuePresent(
+    IN WDFQUEUE   Queue,
+    IN WDFREQUEST Request
+    )
+{
+	PWDF_IO_QUEUE_CONFIG config = &Queue->u.Queue.Config;
+	PWDF_REQUEST_PARAMETERS params = &Request->u.Request.Parameters;
+	PFN_WDF_IO_QUEUE_IO_DEVICE_CONTROL callback;
+
+	Request->u.Request.Queue = Queue;
+	if (config->DispatchType == WdfIoQueueDispatchManual) {
+		pthread_mutex_lock(&Queue->u.Queue.Lock);
+		Request->u.Request.Next = NULL;
+		if (Queue->u.Queue.Tail != NULL)
+			Queue->u.Queue.Tail->u.Request.Next = Request;
+		else
+			Queue->u.Queue.Head = Request;
+		Queue->u.Queue.Tail = Request;
+		Queue->u.Queue.Count++;
+		Request->u.Request.Queued = TRUE;
+		pthread_mutex_unlock(&Queue->u.Queue.Lock);
+		return;
+	}
+
+	callback = params->Type == WdfRequestTypeDeviceControl ?
+		config->EvtIoDeviceControl : config->EvtIoInternalDeviceControl;
+	if (callback == NULL) {
+		WdfRequestComplete(Request, STATUS_INVALID_DEVICE_REQUEST);
+		return;
+	}
+
+	if (config->DispatchType == WdfIoQueueDispatchSequential)
+		pthread_mutex_lock(&Queue->u.Queue.Dispatch);
+	callback(Queue, Request, params->Parameters.DeviceIoControl.OutputBufferLength,
+		params->Parameters.DeviceIoControl.InputBufferLength, params->Parameters.DeviceIoControl.IoControlCode);
+	if (config->DispatchType == WdfIoQueueDispatchSequential)
+		pthread_mutex_unlock(&Queue->u.Queue.Dispatch);
+}
+
+/**
+ * Takes the oldest request off a manual queue, or returns NULL.
+ */
+static WDFREQUEST
+queueRemove(
+    IN WDFQUEUE Queue
+    )
+{
+	WDFREQUEST request;
+
+	pthread_mutex_lock(&Queue->u.Queue.Lock);
+	request = Queue->u.Queue.Head;
+	if (request != NULL) {
+		Queue->u.Queue.Head = request->u.Request.Next;
+		if (Queue->u.Queue.Head == NULL)
+			Queue->u.Queue.Tail = NULL;
+		Queue->u.Queue.Count--;
+		request->u.Request.Next = NULL;
+		request->u.Request.Queued = FALSE;
+	}
+	pthread_mutex_unlock(&Queue->u.Queue.Lock);
+	return request;
+}
+
+/**
+ * Cancels every request waiting in a queue.
+ */
+static VOID
+queuePurge(
+    IN WDFQUEUE Queue
+    )
+{
+	WDFREQUEST request;
+
+	while ((request = queueRemove(Queue)) != NULL)
+		WdfRequestComplete(request, STATUS_CANCELLED);
+}
+
+NTSTATUS
+WdfIoQueueCreate(
+    IN WDFDEVICE              Device,
+    IN PWDF_IO_QUEUE_CONFIG   Config,
+    IN PWDF_OBJECT_ATTRIBUTES QueueAttributes,
+    OUT WDFQUEUE             *Queue
+    )
+{
+	WDFQUEUE queue;
+
+	if (Config->DefaultQueue && Device->u.Device.DefaultQueue != NULL) {
+		shimError("second default queue for device %p", (void *) Device);
+		return STATUS_INVALID_DEVICE_STATE;
+	}
+
+	queue = objectCreate(ShimQueue, QueueAttributes, Device);
+	if (queue == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+	queue->u.Queue.Device = Device;
+	queue->u.Queue.Config = *Config;
+	pthread_mutex_init(&queue->u.Queue.Lock, NULL);
+	pthread_mutex_init(&queue->u.Queue.Dispatch, NULL);
+	if (Config->DefaultQueue)
+		Device->u.Device.DefaultQueue = queue;
+	if (Queue != NULL)
+		*Queue = queue;
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+WdfIoQueueRetrieveNextRequest(
+    IN WDFQUEUE    Queue,
+    OUT WDFREQUEST *OutRequest
+    )
+{
+	if (Queue->u.Queue.Config.DispatchType != WdfIoQueueDispatchManual) {
+		shimError("retrieving from a queue that isn't manual");
+		return STATUS_INVALID_DEVICE_REQUEST;
+	}
+	*OutRequest = queueRemove(Queue);
+	return *OutRequest != NULL ? STATUS_SUCCESS : STATUS_NO_MORE_ENTRIES;
+}
+
+ULONG
+WdfIoQueueGetState(
+    IN WDFQUEUE Queue,
+    OUT PULONG  QueueRequests,
+    OUT PULONG  DriverRequests
+    )
+{
+	pthread_mutex_lock(&Queue->u.Queue.Lock);
+	if (QueueRequests != NULL)
+		*QueueRequests = Queue->u.Queue.Count;
+	pthread_mutex_unlock(&Queue->u.Queue.Lock);
+	if (DriverRequests != NULL)
+		*DriverRequests = 0;
+	return 0;
+}
+
+WDFDEVICE
+WdfIoQueueGetDevice(
+    IN WDFQUEUE Queue
+    )
+{
+	return Queue->u.Queue.Device;
+}
+
+VOID
+WdfIoQueuePurge(
+    IN WDFQUEUE               Queue,
+    IN PFN_WDF_IO_QUEUE_STATE PurgeComplete,
+    IN PVOID                  Context
+    )
+{
+	queuePurge(Queue);
+	if (PurgeComplete != NULL)
+		PurgeComplete(Queue, Context);
+}
+
+NTSTATUS
+WdfDeviceEnqueueRequest(
+    IN WDFDEVICE  Device,
+    IN WDFREQUEST Request
+    )
+{
+	if (Device->u.Device.DefaultQueue == NULL)
+		return STATUS_INVALID_DEVICE_STATE;
+	queuePresent(Device->u.Device.DefaultQueue, Request);
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+WdfRequestForwardToIoQueue(
+    IN WDFREQUEST Request,
+    IN WDFQUEUE   DestinationQueue
+    )
+{
+	if (DestinationQueue == Request->u.Request.Queue)
+		return STATUS_INVALID_DEVICE_REQUEST;
+	queuePresent(DestinationQueue, Request);
+	return STATUS_SUCCESS;
+}
+
+WDFQUEUE
+WdfRequestGetIoQueue(
+    IN WDFREQUEST Request
+    )
+{
+	return Request->u.Request.Queue;
+}
+
+WDFFILEOBJECT
+WdfRequestGetFileObject(
+    IN WDFREQUEST Request
+    )
+{
+	return Request->u.Request.File;
+}
+
+KPROCESSOR_MODE
+WdfRequestGetRequestorMode(
+    IN WDFREQUEST Request
+    )
+{
+	return Request->u.Request.RequestorMode;
+}
+
+VOID
+WdfRequestGetParameters(
+    IN WDFREQUEST               Request,
+    OUT PWDF_REQUEST_PARAMETERS Parameters
+    )
+{
+	*Parameters = Request->u.Request.Parameters;
+}
+
+#undef WdfRequestRetrieveInputBuffer
+#undef WdfRequestRetrieveOutputBuffer
+
+NTSTATUS
+WdfRequestRetrieveInputBuffer(
+    IN WDFREQUEST Request,
+    IN size_t     MinimumRequiredLength,
+    OUT PVOID    *Buffer,
+    OUT size_t   *Length
+    )
+{
+	size_t length = Request->u.Request.Parameters.Parameters.DeviceIoControl.InputBufferLength;
+
+	if (length == 0 || length < MinimumRequiredLength)
+		return STATUS_BUFFER_TOO_SMALL;
+	*Buffer = Request->u.Request.System != NULL ? Request->u.Request.System : Request->u.Request.Input;
+	if (Length != NULL)
+		*Length = length;
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+WdfRequestRetrieveOutputBuffer(
+    IN WDFREQUEST Request,
+    IN size_t     MinimumRequiredSize,
+    OUT PVOID    *Buffer,
+    OUT size_t   *Length
+    )
+{
+	size_t length = Request->u.Request.Parameters.Parameters.DeviceIoControl.OutputBufferLength;
+
+	if (length == 0 || length < MinimumRequiredSize)
+		return STATUS_BUFFER_TOO_SMALL;
+	*Buffer = Request->u.Request.System != NULL ? Request->u.Request.System : Request->u.Request.Output;
+	if (Length != NULL)
+		*Length = length;
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+WdfRequestRetrieveOutputMemory(
+    IN WDFREQUEST Request,
+    OUT WDFMEMORY *Memory
+    )
+{
+	WDFMEMORY memory = Request->u.Request.OutputMemory;
+	PVOID buffer;
+	size_t length;
+	NTSTATUS status;
+
+	if (memory == NULL) {
+		status = WdfRequestRetrieveOutputBuffer(Request, 0, &buffer, &length);
+		if (!NT_SUCCESS(status))
+			return status;
+		memory = objectCreate(ShimMemory, WDF_NO_OBJECT_ATTRIBUTES, Request);
+		if (memory == NULL)
+			return STATUS_INSUFFICIENT_RESOURCES;
+		memory->u.Memory.Buffer = buffer;
+		memory->u.Memory.Size = length;
+		Request->u.Request.OutputMemory = memory;
+	}
+	*Memory = memory;
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+WdfMemoryCopyFromBuffer(
+    IN WDFMEMORY DestinationMemory,
+    IN size_t    DestinationOffset,
+    IN PVOID     Buffer,
+    IN size_t    NumBytesToCopyFrom
+    )
+{
+	if (DestinationOffset + NumBytesToCopyFrom > DestinationMemory->u.Memory.Size)
+		return STATUS_BUFFER_TOO_SMALL;
+	RtlCopyMemory((PUCHAR) DestinationMemory->u.Memory.Buffer + DestinationOffset, Buffer, NumBytesToCopyFrom);
+	return STATUS_SUCCESS;
+}
+
+VOID
+WdfRequestSetInformation(
+    IN WDFREQUEST Request,
+    IN ULONG_PTR  Information
+    )
+{
+	Request->u.Request.Information = Information;
+}
+
+VOID
+WdfRequestComplete(
+    IN WDFREQUEST Request,
+    IN NTSTATUS   Status
+    )
+{
+	PWDF_REQUEST_PARAMETERS params = &Request->u.Request.Parameters;
+	size_t length;
+
+	if (Request->u.Request.Queued) {
+		shimError("request %p completed while still in a queue", (void *) Request);
+		return;
+	}
+	if (InterlockedExchange(&Request->u.Request.Completed, TRUE)) {
+		shimError("request %p completed twice", (void *) Request);
+		return;
+	}
+	Request->u.Request.Status = Status;
+
+	// Buffered output goes back to the caller, as far as the information says
+	if (Request->u.Request.System != NULL && NT_SUCCESS(Status)) {
+		length = min((size_t) Request->u.Request.Information, params->Parameters.DeviceIoControl.OutputBufferLength);
+		if (length != 0)
+			RtlCopyMemory(Request->u.Request.Output, Request->u.Request.System, length);
+	}
+}
+
+VOID
+WdfRequestCompleteWithInformation(
+    IN WDFREQUEST Request,
+    IN NTSTATUS   Status,
+    IN ULONG_PTR  Information
+    )
+{
+	WdfRequestSetInformation(Request, Information);
+	WdfRequestComplete(Request, Status);
+}
+
+//
+// Timers, locks and collections
+//
+
+NTSTATUS
+WdfTimerCreate(
+    IN PWDF_TIMER_CONFIG      Config,
+    IN PWDF_OBJECT_ATTRIBUTES Attributes,
+    OUT WDFTIMER             *Timer
+    )
+{
+	WDFTIMER timer;
+
+	if (Attributes == NULL || Attributes->ParentObject == NULL) {
+		shimError("timers need a parent");
+		return STATUS_INVALID_PARAMETER;
+	}
+	timer = objectCreate(ShimTimer, Attributes, NULL);
+	if (timer == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+	timer->u.Timer.EvtTimerFunc = Config->EvtTimerFunc;
+	timer->u.Timer.Due = -1;
+
+	pthread_mutex_lock(&objectLock);
+	timer->u.Timer.Next = timers;
+	timers = timer;
+	pthread_mutex_unlock(&objectLock);
+
+	*Timer = timer;
+	return STATUS_SUCCESS;
+}
+
+BOOLEAN
+WdfTimerStart(
+    IN WDFTIMER Timer,
+    IN LONGLONG DueTime
+    )
+{
+	BOOLEAN armed;
+
+	pthread_mutex_lock(&objectLock);
+	armed = Timer->u.Timer.Due >= 0;
+	Timer->u.Timer.Due = DueTime < 0 ? (LONGLONG) KeQueryInterruptTime() - DueTime : DueTime;
+	pthread_mutex_unlock(&objectLock);
+	return armed;
+}
+
+WDFOBJECT
+WdfTimerGetParentObject(
+    IN WDFTIMER Timer
+    )
+{
+	return Timer->Parent;
+}
+
+NTSTATUS
+WdfSpinLockCreate(
+    IN PWDF_OBJECT_ATTRIBUTES SpinLockAttributes,
+    OUT WDFSPINLOCK          *SpinLock
+    )
+{
+	*SpinLock = objectCreate(ShimLock, SpinLockAttributes, driver);
+	if (*SpinLock == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+	pthread_mutex_init(&(*SpinLock)->u.Lock.Mutex, NULL);
+	return STATUS_SUCCESS;
+}
+
+VOID
+WdfSpinLockAcquire(
+    IN WDFSPINLOCK SpinLock
+    )
+{
+	pthread_mutex_lock(&SpinLock->u.Lock.Mutex);
+}
+
+VOID
+WdfSpinLockRelease(
+    IN WDFSPINLOCK SpinLock
+    )
+{
+	pthread_mutex_unlock(&SpinLock->u.Lock.Mutex);
+}
+
+NTSTATUS
+WdfWaitLockCreate(
+    IN PWDF_OBJECT_ATTRIBUTES LockAttributes,
+    OUT WDFWAITLOCK          *Lock
+    )
+{
+	return WdfSpinLockCreate(LockAttributes, Lock);
+}
+
+NTSTATUS
+WdfWaitLockAcquire(
+    IN WDFWAITLOCK Lock,
+    IN PLONGLONG   Timeout
+    )
+{
+	UNREFERENCED_PARAMETER(Timeout);
+
+	pthread_mutex_lock(&Lock->u.Lock.Mutex);
+	return STATUS_SUCCESS;
+}
+
+VOID
+WdfWaitLockRelease(
+    IN WDFWAITLOCK Lock
+    )
+{
+	pthread_mutex_unlock(&Lock->u.Lock.Mutex);
+}
+
+NTSTATUS
+WdfCollectionCreate(
+    IN PWDF_OBJECT_ATTRIBUTES CollectionAttributes,
+    OUT WDFCOLLECTION        *Collection
+    )
+{
+	*Collection = objectCreate(ShimCollection, CollectionAttributes, driver);
+	return *Collection != NULL ? STATUS_SUCCESS : STATUS_INSUFFICIENT_RESOURCES;
+}
+
+NTSTATUS
+WdfCollectionAdd(
+    IN WDFCOLLECTION Collection,
+    IN WDFOBJECT     Object
+    )
+{
+	if (Collection->u.Collection.Count == SHIM_MAX_ITEMS)
+		return STATUS_INSUFFICIENT_RESOURCES;
+	WdfObjectReference(Object);
+	Collection->u.Collection.Items[Collection->u.Collection.Count++] = Object;
+	return STATUS_SUCCESS;
+}
+
+VOID
+WdfCollectionRemove(
+    IN WDFCOLLECTION Collection,
+    IN WDFOBJECT     Item
+    )
+{
+	ULONG i;
+
+	for (i = 0; i < Collection->u.Collection.Count; i++) {
+		if (Collection->u.Collection.Items[i] == Item) {
+			memmove(&Collection->u.Collection.Items[i], &Collection->u.Collection.Items[i + 1],
+				(Collection->u.Collection.Count - i - 1) * sizeof(WDFOBJECT));
+			Collection->u.Collection.Count--;
+			WdfObjectDereference(Item);
+			return;
+		}
+	}
+	shimError("object %p isn't in collection %p", (void *) Item, (void *) Collection);
+}
+
+ULONG
+WdfCollectionGetCount(
+    IN WDFCOLLECTION Collection
+    )
+{
+	return Collection->u.Collection.Count;
+}
+
+//
+// What the tests use
+//
+
+NTSTATUS
+shimLoadDriver(
+    VOID
+    )
+{
+	UNICODE_STRING registryPath;
+
+	RtlInitUnicodeString(&registryPath, L"\\Registry\\Machine\\System\\CurrentControlSet\\Services\\droidpad");
+	return DriverEntry(&driverObject, &registryPath);
+}
+
+VOID
+shimUnloadDriver(
+    VOID
+    )
+{
+	if (driver != NULL)
+		WdfObjectDelete(driver);
+	driver = NULL;
+}
+
+NTSTATUS
+shimAddDevice(
+    OUT WDFDEVICE *Device
+    )
+{
+	PWDFDEVICE_INIT init = calloc(1, sizeof(WDFDEVICE_INIT));
+	NTSTATUS status;
+
+	*Device = NULL;
+	if (init == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+	init->Driver = driver;
+
+	status = driver->u.Driver.EvtDriverDeviceAdd(driver, init);
+	if (NT_SUCCESS(status))
+		*Device = init->Created;
+	else if (init->Created != NULL)
+		WdfObjectDelete(init->Created);
+	free(init);
+	return status;
+}
+
+VOID
+shimRemoveDevice(
+    IN WDFDEVICE Device
+    )
+{
+	WdfObjectDelete(Device);
+}
+
+VOID
+shimSetParameter(
+    IN PCWSTR Name,
+    IN ULONG  Value
+    )
+{
+	ULONG i;
+
+	for (i = 0; i < parameterCount; i++) {
+		if (wcscmp(parameters[i].Name, Name) == 0)
+			break;
+	}
+	if (i == SHIM_MAX_PARAMETERS) {
+		shimError("too many parameters");
+		return;
+	}
+	wcsncpy(parameters[i].Name, Name, 63);
+	parameters[i].Value = Value;
+	if (i == parameterCount)
+		parameterCount++;
+}
+
+VOID
+shimClearParameters(
+    VOID
+    )
+{
+	parameterCount = 0;
+}
+
+WDFFILEOBJECT
+shimOpenFile(
+    IN WDFDEVICE Device
+    )
+{
+	WDF_OBJECT_ATTRIBUTES attributes;
+	WDFFILEOBJECT file;
+
+	WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
+	attributes.ContextTypeInfo = Device->u.Device.FileContextType;
+	attributes.ParentObject = Device;
+	file = objectCreate(ShimFile, &attributes, NULL);
+	if (file != NULL)
+		file->u.File.Device = Device;
+	return file;
+}
+
+VOID
+shimCloseFile(
+    IN WDFFILEOBJECT File
+    )
+{
+	WDFDEVICE device = File->u.File.Device;
+
+	if (device->u.Device.EvtFileCleanup != NULL)
+		device->u.Device.EvtFileCleanup(File);
+	WdfObjectDelete(File);
+}
+
+/**
+ * Makes a device control request, of either kind.
+ */
+static WDFREQUEST
+requestCreate(
+    IN WDF_REQUEST_TYPE Type,
+    IN ULONG            IoControlCode,
+    IN PVOID            Input,
+    IN size_t           InputLength,
+    IN PVOID            Output,
+    IN size_t           OutputLength
+    )
+{
+	WDFREQUEST request = objectCreate(ShimRequest, WDF_NO_OBJECT_ATTRIBUTES, NULL);
+	PWDF_REQUEST_PARAMETERS params;
+
+	if (request == NULL)
+		return NULL;
+	params = &request->u.Request.Parameters;
+	WDF_REQUEST_PARAMETERS_INIT(params);
+	params->Type = Type;
+	params->Parameters.DeviceIoControl.IoControlCode = IoControlCode;
+	params->Parameters.DeviceIoControl.InputBufferLength = InputLength;
+	params->Parameters.DeviceIoControl.OutputBufferLength = OutputLength;
+	request->u.Request.Input = Input;
+	request->u.Request.Output = Output;
+	return request;
+}
+
+NTSTATUS
+shimDeviceIoControl(
+    IN WDFFILEOBJECT File,
+    IN ULONG         IoControlCode,
+    IN PVOID         Input,
+    IN size_t        InputLength,
+    OUT PVOID        Output,
+    IN size_t        OutputLength,
+    OUT size_t      *BytesReturned
+    )
+{
+	WDFDEVICE device = File->u.File.Device;
+	WDFREQUEST request;
+	NTSTATUS status;
+	size_t length = max(InputLength, OutputLength);
+
+	if (BytesReturned != NULL)
+		*BytesReturned = 0;
+	if (!device->u.Device.Initialized)
+		return STATUS_INVALID_DEVICE_STATE;
+
+	request = requestCreate(WdfRequestTypeDeviceControl, IoControlCode, Input, InputLength, Output, OutputLength);
+	if (request == NULL)
+		return STATUS_INSUFFICIENT_RESOURCES;
+	request->u.Request.File = File;
+	request->u.Request.RequestorMode = currentRequestorMode;
+
+	// METHOD_BUFFERED: the input and output share one system buffer
+	request->u.Request.System = calloc(1, max(length, 1));
+	if (request->u.Request.System == NULL) {
+		request->u.Request.Completed = TRUE;
+		WdfObjectDelete(request);
+		return STATUS_INSUFFICIENT_RESOURCES;
+	}
+	if (InputLength != 0)
+		RtlCopyMemory(request->u.Request.System, Input, InputLength);
+
+	if (device->u.Device.EvtIoInCallerContext != NULL)
+		device->u.Device.EvtIoInCallerContext(device, request);
+	else
+		WdfDeviceEnqueueRequest(device, request);
+
+	if (!request->u.Request.Completed) {
+		shimError("control IOCTL 0x%x wasn't completed", IoControlCode);
+		request->u.Request.Completed = TRUE;
+		status = STATUS_PENDING;
+	} else {
+		status = request->u.Request.Status;
+		if (BytesReturned != NULL)
+			*BytesReturned = request->u.Request.Information;
+	}
+	WdfObjectDelete(request);
+	return status;
+}
+
+WDFREQUEST
+shimInternalIoctl(
+    IN WDFDEVICE Device,
+    IN ULONG     IoControlCode,
+    OUT PVOID    Output,
+    IN size_t    OutputLength
+    )
+{
+	WDFREQUEST request;
+
+	request = requestCreate(WdfRequestTypeDeviceControlInternal, IoControlCode, NULL, 0, Output, OutputLength);
+	if (request != NULL)
+		WdfDeviceEnqueueRequest(Device, request);
+	return request;
+}
+
+BOOLEAN
+shimRequestCompleted(
+    IN WDFREQUEST Request,
+    OUT NTSTATUS *Status,
+    OUT size_t   *Information
+    )
+{
+	if (!Request->u.Request.Completed)
+		return FALSE;
+	if (Status != NULL)
+		*Status = Request->u.Request.Status;
+	if (Information != NULL)
+		*Information = Request->u.Request.Information;
+	return TRUE;
+}
+
+VOID
+shimRequestFree(
+    IN WDFREQUEST Request
+    )
+{
+	if (!Request->u.Request.Completed) {
+		shimError("request %p freed before it was completed", (void *) Request);
+		return;
+	}
+	WdfObjectDelete(Request);
+}
+
+VOID
+shimAdvance(
+    IN LONGLONG Time
+    )
+{
+	LONGLONG end = (LONGLONG) KeQueryInterruptTime() + Time;
+	WDFTIMER timer, due;
+
+	for (;;) {
+		pthread_mutex_lock(&objectLock);
+		due = NULL;
+		for (timer = timers; timer != NULL; timer = timer->u.Timer.Next) {
+			if (timer->u.Timer.Due >= 0 && timer->u.Timer.Due <= end &&
+				(due == NULL || timer->u.Timer.Due < due->u.Timer.Due))
+				due = timer;
+		}
+		if (due != NULL) {
+			if (due->u.Timer.Due > interruptTime)
+				__atomic_store_n(&interruptTime, due->u.Timer.Due, __ATOMIC_SEQ_CST);
+			due->u.Timer.Due = -1;
+			due->u.Timer.Fired++;
+			WdfObjectReference(due);
+		}
+		pthread_mutex_unlock(&objectLock);
+		if (due == NULL)
+			break;
+
+		due->u.Timer.EvtTimerFunc(due);
+		WdfObjectDereference(due);
+	}
+	__atomic_store_n(&interruptTime, end, __ATOMIC_SEQ_CST);
+}
+
+LONGLONG
+shimTimerDue(
+    IN WDFTIMER Timer
+    )
+{
+	LONGLONG due;
+
+	pthread_mutex_lock(&objectLock);
+	due = Timer->u.Timer.Due;
+	pthread_mutex_unlock(&objectLock);
+	return due;
+}
+
+ULONG
+shimTimerFired(
+    IN WDFTIMER Timer
+    )
+{
+	ULONG fired;
+
+	pthread_mutex_lock(&objectLock);
+	fired = Timer->u.Timer.Fired;
+	pthread_mutex_unlock(&objectLock);
+	return fired;
+}
+
+VOID
+shimSetProcess(
+    IN ULONG Process
+    )
+{
+	currentProcess = &processes[Process % SHIM_MAX_PROCESSES];
+}
+
+VOID
+shimSetRequestorMode(
+    IN KPROCESSOR_MODE Mode
+    )
+{
+	currentRequestorMode = Mode;
+}
+
+ULONG
+shimErrors(
+    VOID
+    )
+{
+	return (ULONG) errors;
+}
+
+LONG
+shimPoolAllocations(
+    VOID
+    )
+{
+	return poolAllocations;
+}
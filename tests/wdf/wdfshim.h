@@ -0,0 +1,102 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    wdfshim.h
+
+Abstract:
+
+    What the tests drive the user mode WDF shim with: loading the driver,
+    adding and removing devices, sending it requests and moving its clock.
+    The shim runs the driver's own code in sys/ on a host, single threaded
+    unless a test starts threads of its own.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_SHIM_H_
+
+#define _DROIDPAD_SHIM_H_
+
+#include <wdf.h>
+
+//
+// The driver
+//
+NTSTATUS shimLoadDriver(VOID);   // Runs DriverEntry
+VOID shimUnloadDriver(VOID);     // Deletes the driver object and what it owns
+
+// Runs the driver's EvtDriverDeviceAdd for a new device, as PnP would; a
+// device the callback created is deleted again if it fails
+NTSTATUS shimAddDevice(OUT WDFDEVICE *Device);
+VOID shimRemoveDevice(IN WDFDEVICE Device);
+
+// Registry values every device reads from its hardware key
+VOID shimSetParameter(IN PCWSTR Name, IN ULONG Value);
+VOID shimClearParameters(VOID);
+
+//
+// I/O. Control IOCTLs are METHOD_BUFFERED and complete before returning;
+// internal ones are HIDCLASS's, and are returned to the caller, who polls
+// them for completion and frees them once completed.
+//
+WDFFILEOBJECT shimOpenFile(IN WDFDEVICE Device);
+VOID shimCloseFile(IN WDFFILEOBJECT File);   // Runs EvtFileCleanup
+
+NTSTATUS shimDeviceIoControl(IN WDFFILEOBJECT File, IN ULONG IoControlCode, IN PVOID Input,
+    IN size_t InputLength, OUT PVOID Output, IN size_t OutputLength, OUT size_t *BytesReturned);
+WDFREQUEST shimInternalIoctl(IN WDFDEVICE Device, IN ULONG IoControlCode, OUT PVOID Output,
+    IN size_t OutputLength);
+BOOLEAN shimRequestCompleted(IN WDFREQUEST Request, OUT NTSTATUS *Status, OUT size_t *Information);
+VOID shimRequestFree(IN WDFREQUEST Request);
+
+//
+// Time. The interrupt time only moves when a test moves it; timers that
+// come due on the way fire in order, on the caller's thread.
+//
+VOID shimAdvance(IN LONGLONG Time);    // 100ns units
+LONGLONG shimTimerDue(IN WDFTIMER Timer);   // -1 if not armed
+ULONG shimTimerFired(IN WDFTIMER Timer);    // Times it has gone off
+
+// Which of a few made up processes the calling thread is in (0 at first)
+VOID shimSetProcess(IN ULONG Process);
+
+// Whether control IOCTLs the calling thread sends come from user mode (at
+// first) or from another driver
+VOID shimSetRequestorMode(IN KPROCESSOR_MODE Mode);
+
+//
+// Misuse the shim caught (completing a request twice, unmapping from the
+// wrong process, ...), and pool allocations not yet freed.
+//
+ULONG shimErrors(VOID);
+LONG shimPoolAllocations(VOID);
+
+#endif   //_DROIDPAD_SHIM_H_
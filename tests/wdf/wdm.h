@@ -0,0 +1,221 @@
+/*++
+
+ * This file is part of DroidPad.
+ * DroidPad lets you use an Android mobile to control a joystick or mouse
+ * on a Windows or Linux computer.
+ * This program is the driver for DroidPad's Joystick.
+ *
+ * DroidPad is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * DroidPad is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DroidPad, in the file COPYING.
+ * If not, see <http://www.gnu.org/licenses/>.
+
+Module Name:
+
+    wdm.h
+
+Abstract:
+
+    Stand-in for the WDK's wdm.h, so the driver in sys/ builds as a user
+    mode library for the tests. Builds on inc/portable/dpport.h and adds the
+    kernel types and routines the driver uses, implemented in wdfshim.c.
+    Memory comes from the heap, the interrupt time is a clock the tests
+    move by hand (see wdfshim.h), and IRQLs, processes and MDLs are only
+    there to be passed around.
+
+Author:
+
+
+Environment:
+
+    user mode only
+
+Revision History:
+
+
+--*/
+#ifndef _DROIDPAD_SHIM_WDM_H_
+
+#define _DROIDPAD_SHIM_WDM_H_
+
+#include <dpport.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <wchar.h>
+
+typedef unsigned long ULONG_PTR, *PULONG_PTR;
+typedef const char *PCCHAR;
+typedef wchar_t WCHAR, *PWCHAR, *PWSTR;
+typedef const WCHAR *PCWSTR;
+typedef UCHAR KIRQL, *PKIRQL;
+typedef ULONG ACCESS_MASK;
+
+#define __in
+#define __out
+#define __inout
+#define TEXT(s)				s
+
+#define STATUS_UNSUCCESSFUL		((NTSTATUS) 0xC0000001L)
+#define STATUS_NOT_SUPPORTED		((NTSTATUS) 0xC00000BBL)
+#define STATUS_INVALID_DEVICE_REQUEST	((NTSTATUS) 0xC0000010L)
+#define STATUS_INVALID_DEVICE_STATE	((NTSTATUS) 0xC0000184L)
+#define STATUS_INSUFFICIENT_RESOURCES	((NTSTATUS) 0xC000009AL)
+#define STATUS_BUFFER_TOO_SMALL		((NTSTATUS) 0xC0000023L)
+#define STATUS_NO_SUCH_DEVICE		((NTSTATUS) 0xC000000EL)
+#define STATUS_NO_MORE_ENTRIES		((NTSTATUS) 0x8000001AL)
+#define STATUS_SHARING_VIOLATION	((NTSTATUS) 0xC0000043L)
+#define STATUS_DRIVER_INTERNAL_ERROR	((NTSTATUS) 0xC0000183L)
+#define STATUS_INFO_LENGTH_MISMATCH	((NTSTATUS) 0xC0000004L)
+#define STATUS_CANCELLED		((NTSTATUS) 0xC0000120L)
+#define STATUS_PENDING			((NTSTATUS) 0x00000103L)
+#define STATUS_OBJECT_NAME_NOT_FOUND	((NTSTATUS) 0xC0000034L)
+
+#define NTDDI_WIN2K			0x05000000
+#define NTDDI_VERSION			NTDDI_WIN2K	// Leaves out the USB idle notification
+#define OSVER(Version)			((Version) & 0xFFFF0000)
+
+#define CTL_CODE(DeviceType, Function, Method, Access) \
+	(((DeviceType) << 16) | ((Access) << 14) | ((Function) << 2) | (Method))
+#define FILE_DEVICE_KEYBOARD		0x0000000b
+#define FILE_DEVICE_UNKNOWN		0x00000022
+#define METHOD_BUFFERED			0
+#define METHOD_IN_DIRECT		1
+#define METHOD_OUT_DIRECT		2
+#define METHOD_NEITHER			3
+#define FILE_ANY_ACCESS			0
+#define FILE_READ_ACCESS		0x0001
+#define FILE_WRITE_ACCESS		0x0002
+
+#define PAGE_SIZE			4096
+#define DISPATCH_LEVEL			2
+#define KEY_READ			0x20019
+#define PLUGPLAY_REGKEY_DEVICE		1
+
+#define KdPrint(Args)
+#define DbgPrint			printf
+
+// No exceptions in user mode; what the driver guards never raises one here
+#define __try				if (1)
+#define __except(Filter)		else
+#define EXCEPTION_EXECUTE_HANDLER	1
+
+#define InterlockedDecrement(Addend)	__atomic_sub_fetch((Addend), 1, __ATOMIC_SEQ_CST)
+#define InterlockedExchange(Target, Value)	__atomic_exchange_n((Target), (Value), __ATOMIC_SEQ_CST)
+#define InterlockedExchangeAdd(Addend, Value)	__atomic_fetch_add((Addend), (Value), __ATOMIC_SEQ_CST)
+
+static __inline LONG
+InterlockedCompareExchange(
+    IN OUT volatile LONG *Destination,
+    IN LONG              Exchange,
+    IN LONG              Comparand
+    )
+{
+	__atomic_compare_exchange_n(Destination, &Comparand, Exchange, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return Comparand;
+}
+
+typedef struct _UNICODE_STRING {
+    USHORT  Length;
+    USHORT  MaximumLength;
+    PWSTR   Buffer;
+} UNICODE_STRING, *PUNICODE_STRING;
+typedef const UNICODE_STRING *PCUNICODE_STRING;
+
+typedef struct _STRING {
+    USHORT  Length;
+    USHORT  MaximumLength;
+    PCHAR   Buffer;
+} ANSI_STRING, *PANSI_STRING;
+
+#define DECLARE_CONST_UNICODE_STRING(Name, String) \
+	const WCHAR Name##_buffer[] = String; \
+	const UNICODE_STRING Name = { sizeof(String) - sizeof(WCHAR), sizeof(String), (PWSTR) Name##_buffer }
+
+VOID RtlInitUnicodeString(OUT PUNICODE_STRING Destination, IN PCWSTR Source);
+VOID RtlInitAnsiString(OUT PANSI_STRING Destination, IN const char *Source);
+NTSTATUS RtlAnsiStringToUnicodeString(OUT PUNICODE_STRING Destination, IN PANSI_STRING Source,
+    IN BOOLEAN AllocateDestination);
+VOID RtlFreeUnicodeString(IN OUT PUNICODE_STRING String);
+
+typedef enum _POOL_TYPE {
+    NonPagedPool,
+    PagedPool,
+    NonPagedPoolNx = 512
+} POOL_TYPE;
+
+PVOID ExAllocatePoolWithTag(IN POOL_TYPE PoolType, IN size_t NumberOfBytes, IN ULONG Tag);
+VOID ExFreePoolWithTag(IN PVOID P, IN ULONG Tag);
+
+// Rundown protection: the top bit is set once the wait has started
+typedef struct _EX_RUNDOWN_REF {
+    volatile LONG Count;
+} EX_RUNDOWN_REF, *PEX_RUNDOWN_REF;
+
+VOID ExInitializeRundownProtection(OUT PEX_RUNDOWN_REF RunRef);
+BOOLEAN ExAcquireRundownProtection(IN OUT PEX_RUNDOWN_REF RunRef);
+VOID ExReleaseRundownProtection(IN OUT PEX_RUNDOWN_REF RunRef);
+VOID ExWaitForRundownProtectionRelease(IN OUT PEX_RUNDOWN_REF RunRef);
+
+ULONGLONG KeQueryInterruptTime(VOID);
+extern char KeNumberProcessors;
+ULONG KeGetCurrentProcessorNumber(VOID);
+#define KeRaiseIrql(NewIrql, OldIrql)	(*(OldIrql) = (KIRQL) (NewIrql))
+#define KeLowerIrql(NewIrql)		((void) (NewIrql))
+
+typedef struct _KPROCESS *PEPROCESS, *PRKPROCESS;
+typedef struct _KAPC_STATE {
+    PRKPROCESS Process;
+} KAPC_STATE, *PKAPC_STATE, *PRKAPC_STATE;
+
+PEPROCESS PsGetCurrentProcess(VOID);
+VOID KeStackAttachProcess(IN PRKPROCESS Process, OUT PRKAPC_STATE ApcState);
+VOID KeUnstackDetachProcess(IN PRKAPC_STATE ApcState);
+#define ObReferenceObject(Object)	((void) (Object))
+#define ObDereferenceObject(Object)	((void) (Object))
+
+typedef struct _MDL {
+    PVOID     StartVa;
+    ULONG     ByteCount;
+    PVOID     MappedVa;
+    PEPROCESS Process;  // Whose address space MappedVa is in
+} MDL, *PMDL;
+
+typedef enum _MEMORY_CACHING_TYPE {
+    MmNonCached,
+    MmCached
+} MEMORY_CACHING_TYPE;
+
+typedef enum _MM_PAGE_PRIORITY {
+    LowPagePriority,
+    NormalPagePriority = 16,
+    HighPagePriority = 32
+} MM_PAGE_PRIORITY;
+
+#define MdlMappingNoExecute	0x40000000	// Or'd into the priority
+
+typedef enum _MODE {
+    KernelMode,
+    UserMode
+} KPROCESSOR_MODE;
+
+PMDL IoAllocateMdl(IN PVOID VirtualAddress, IN ULONG Length, IN BOOLEAN SecondaryBuffer,
+    IN BOOLEAN ChargeQuota, IN PVOID Irp);
+VOID IoFreeMdl(IN PMDL Mdl);
+VOID MmBuildMdlForNonPagedPool(IN OUT PMDL Mdl);
+PVOID MmMapLockedPagesSpecifyCache(IN PMDL Mdl, IN KPROCESSOR_MODE AccessMode, IN MEMORY_CACHING_TYPE CacheType,
+    IN PVOID BaseAddress, IN ULONG BugCheckOnFailure, IN ULONG Priority);
+VOID MmUnmapLockedPages(IN PVOID BaseAddress, IN PMDL Mdl);
+
+typedef struct _DRIVER_OBJECT *PDRIVER_OBJECT;
+typedef NTSTATUS DRIVER_INITIALIZE(IN PDRIVER_OBJECT DriverObject, IN PUNICODE_STRING RegistryPath);
+
+#endif   //_DROIDPAD_SHIM_WDM_H_